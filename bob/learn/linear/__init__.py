@@ -3,6 +3,11 @@ import bob.io.base
 import bob.math
 import bob.learn.activation
 import numpy
+import copy
+try:
+  import copyreg
+except ImportError: # python 2
+  import copy_reg as copyreg
 
 # import our own Library
 import bob.extension
@@ -26,6 +31,18 @@ def get_config():
 __all__ = [_ for _ in dir() if not _.startswith('_')]
 
 
+def _reduce_activation(activation):
+  """Pickles the activation functions, which are part of the pickled state
+  of a :py:class:`Machine`, through their constructor parameters"""
+  parameters = tuple(getattr(activation, p) for p in ('C', 'M') if hasattr(activation, p))
+  return type(activation), parameters
+
+for _activation in (bob.learn.activation.Identity, bob.learn.activation.Linear,
+    bob.learn.activation.Logistic, bob.learn.activation.HyperbolicTangent,
+    bob.learn.activation.MultipliedHyperbolicTangent):
+  copyreg.pickle(_activation, _reduce_activation)
+
+
 class Machine(_Machine_C):
     __doc__ = _Machine_C.__doc__
 
@@ -47,12 +64,24 @@ class Machine(_Machine_C):
         machine_data["weights"] = machine.weights
         return machine_data
 
-    def __getstate__(self):
-        d = dict(self.__dict__)
-        d.update(self.__class__.to_dict(self))
-        return d
+    def __setstate__(self, state):
+        if not isinstance(state, dict):
+            _Machine_C.__setstate__(self, state)
+            return
+        # machines pickled by older versions, see to_dict
+        self.__dict__ = state
+        self.__init__(numpy.asarray(state["weights"], dtype="float64"))
+        self.update_dict(state)
 
-    def __setstate__(self, d):
-        self.__dict__ = d        
-        self.__init__(numpy.array(d["weights"]))
-        self.update_dict(d)
+    def __copy__(self):
+        # the weights are shared with the copy until either is modified
+        machine = self.__class__(self)
+        machine.__dict__.update(self.__dict__)
+        return machine
+
+    def __deepcopy__(self, memo):
+        # shared weights are copied on write, so they need no deep copy
+        machine = self.__class__(self)
+        memo[id(self)] = machine
+        machine.__dict__.update(copy.deepcopy(self.__dict__, memo))
+        return machine
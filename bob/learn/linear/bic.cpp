@@ -8,12 +8,19 @@
  */
 
 #define BOB_LEARN_LINEAR_MODULE
+#include <utility>
 #include <bob.blitz/cppapi.h>
 #include <bob.blitz/cleanup.h>
 #include <bob.learn.linear/api.h>
 #include <bob.io.base/api.h>
 #include <bob.extension/documentation.h>
 
+// pickling helpers, see machine.cpp
+extern PyObject* PyBobLearnLinear_PickleArray(const blitz::Array<double,1>& array, int protocol);
+extern PyObject* PyBobLearnLinear_PickleArray(const blitz::Array<double,2>& array, int protocol);
+extern bool PyBobLearnLinear_UnpickleArray(PyObject* buffer, blitz::Array<double,1>& array, const char* name);
+extern bool PyBobLearnLinear_UnpickleArray(PyObject* buffer, blitz::Array<double,2>& array, const char* name);
+
 /******************************************************************/
 /************ Constructor Section *********************************/
 /******************************************************************/
@@ -237,13 +244,14 @@ static auto forward_doc = bob::extension::FunctionDoc(
   "forward",
   "Computes the BIC or IEC score for the given input vector, which results of a comparison vector of two (facial) images",
   "The resulting value is returned as a single float value. "
-  "The score itself is the log-likelihood score of the given input vector belonging to the intrapersonal class.\n\n"
+  "The score itself is the log-likelihood score of the given input vector belonging to the intrapersonal class. "
+  "If a 2D array is given, it is considered a set of vertically stacked input vectors (one per row), which are scored in a single call, and a 1D array with one score per row is returned.\n\n"
   ".. note:: the ``__call__`` method is an alias for this one",
   true
 )
 .add_prototype("input", "score")
-.add_parameter("input", "array_like (float, 1D)", "The input vector, which is the result of comparing to (facial) images")
-.add_return("score", "float", "The log-likelihood that the given ``input`` belongs to the intrapersonal class")
+.add_parameter("input", "array_like (float, 1D or 2D)", "The input vector, which is the result of comparing to (facial) images, or one input vector per row")
+.add_return("score", "float or array_like (float, 1D)", "The log-likelihood that the given ``input`` belongs to the intrapersonal class, or one log-likelihood per row of ``input``")
 ;
 
 static PyObject* PyBobLearnLinearBICMachine_forward(PyBobLearnLinearBICMachineObject* self, PyObject* args, PyObject* kwargs) {
@@ -254,13 +262,30 @@ BOB_TRY
   if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&", kwlist, &PyBlitzArray_Converter, &input)) return 0;
   auto input_ = make_safe(input);
 
-  if (input->ndim != 1 || input->type_num != NPY_FLOAT64){
-    PyErr_Format(PyExc_TypeError, "`%s' only supports 1D 64-bit float arrays for 'input'", Py_TYPE(self)->tp_name);
+  if (input->ndim < 1 || input->ndim > 2 || input->type_num != NPY_FLOAT64){
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 1D or 2D 64-bit float arrays for 'input'", Py_TYPE(self)->tp_name);
     return 0;
   }
 
-  double score = self->cxx->forward(*PyBlitzArrayCxx_AsBlitz<double,1>(input));
-  return Py_BuildValue("d", score);
+  if (input->ndim == 1) {
+    double score = self->cxx->forward(*PyBlitzArrayCxx_AsBlitz<double,1>(input));
+    return Py_BuildValue("d", score);
+  }
+
+  // scores all rows of the 2D input
+  Py_ssize_t osize[1] = {input->shape[0]};
+  PyBlitzArrayObject* output = (PyBlitzArrayObject*)PyBlitzArray_SimpleNew(NPY_FLOAT64, 1, osize);
+  if (!output) return 0;
+  auto output_ = make_safe(output);
+  auto bzin = PyBlitzArrayCxx_AsBlitz<double,2>(input);
+  auto bzout = PyBlitzArrayCxx_AsBlitz<double,1>(output);
+  blitz::Range all = blitz::Range::all();
+  for (int k=0; k<bzin->extent(0); ++k) {
+    blitz::Array<double,1> i_ = (*bzin)(k, all);
+    (*bzout)(k) = self->cxx->forward(i_);
+  }
+  Py_INCREF(output);
+  return PyBlitzArray_NUMPY_WRAP(reinterpret_cast<PyObject*>(output));
 BOB_CATCH_MEMBER("forward", 0)
 }
 
@@ -339,6 +364,103 @@ BOB_CATCH_MEMBER("save", 0)
 }
 
 
+/**
+ * Returns the pickled state of one class of the machine: the input length,
+ * mean and variances for IEC, plus the subspace dimension, the projection
+ * matrix and rho for BIC
+ */
+static PyObject* pickle_class(const bob::learn::linear::BICMachine& machine, bool clazz, int protocol) {
+  auto mean = make_xsafe(PyBobLearnLinear_PickleArray(machine.mean(clazz), protocol));
+  auto variances = make_xsafe(PyBobLearnLinear_PickleArray(machine.variances(clazz), protocol));
+  if (!mean || !variances) return 0;
+  if (!machine.project_data())
+    return Py_BuildValue("(nOO)", (Py_ssize_t)machine.mean(clazz).extent(0), mean.get(), variances.get());
+
+  const blitz::Array<double,2>& projection = machine.projection(clazz);
+  auto projection_ = make_xsafe(PyBobLearnLinear_PickleArray(projection, protocol));
+  if (!projection_) return 0;
+  return Py_BuildValue("(nnOOOd)", (Py_ssize_t)projection.extent(0), (Py_ssize_t)projection.extent(1),
+      mean.get(), variances.get(), projection_.get(), machine.rho(clazz));
+}
+
+/**
+ * Restores one class of the machine from the state returned by pickle_class()
+ */
+static bool unpickle_class(bob::learn::linear::BICMachine& machine, bool clazz, PyObject* state) {
+  Py_ssize_t n, m;
+  PyObject* mean,* variances,* projection;
+  double rho;
+  if (PyTuple_Check(state) && PyTuple_GET_SIZE(state) == 3) {
+    if (!PyArg_ParseTuple(state, "nOO:__setstate__", &n, &mean, &variances)) return false;
+    blitz::Array<double,1> mean_(n), variances_(n);
+    if (!PyBobLearnLinear_UnpickleArray(mean, mean_, "mean") ||
+        !PyBobLearnLinear_UnpickleArray(variances, variances_, "variances")) return false;
+    machine.setIEC(clazz, std::move(mean_), std::move(variances_));
+    return true;
+  }
+
+  if (!PyArg_ParseTuple(state, "nnOOOd:__setstate__", &n, &m, &mean, &variances, &projection, &rho)) return false;
+  blitz::Array<double,1> mean_(n), variances_(m);
+  blitz::Array<double,2> projection_(n, m);
+  if (!PyBobLearnLinear_UnpickleArray(mean, mean_, "mean") ||
+      !PyBobLearnLinear_UnpickleArray(variances, variances_, "variances") ||
+      !PyBobLearnLinear_UnpickleArray(projection, projection_, "projection")) return false;
+  machine.setBIC(clazz, std::move(mean_), std::move(variances_), std::move(projection_), rho);
+  return true;
+}
+
+static auto reduce_ex_doc = bob::extension::FunctionDoc(
+  "__reduce_ex__",
+  "Prepares the BIC machine for pickling",
+  "The state of the machine consists of the :py:attr:`use_DFFS` flag and the mean and variances of both classes, as well as their projection matrices and average residual eigenvalues for BIC. "
+  "With pickle protocol 5 or higher, the arrays are handed to :py:mod:`pickle` as :py:class:`pickle.PickleBuffer` objects that refer to the memory of this machine, so that they can be transferred out-of-band without being copied. "
+  "When unpickling, :py:meth:`__setstate__` copies the data once into memory owned by the new machine.",
+  true
+)
+.add_prototype("protocol", "reduced")
+.add_parameter("protocol", "int", "The pickle protocol")
+.add_return("reduced", "tuple", "The class of this machine, the (empty) arguments of its constructor and its state")
+;
+
+static PyObject* PyBobLearnLinearBICMachine_reduce_ex(PyBobLearnLinearBICMachineObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = reduce_ex_doc.kwlist();
+  int protocol;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "i", kwlist, &protocol)) return 0;
+
+  auto intra = make_xsafe(pickle_class(*self->cxx, false, protocol));
+  auto extra = make_xsafe(pickle_class(*self->cxx, true, protocol));
+  if (!intra || !extra) return 0;
+
+  return Py_BuildValue("O()(OOO)", Py_TYPE(self), self->cxx->use_DFFS() ? Py_True : Py_False, intra.get(), extra.get());
+BOB_CATCH_MEMBER("__reduce_ex__", 0)
+}
+
+static auto setstate_doc = bob::extension::FunctionDoc(
+  "__setstate__",
+  "Restores the BIC machine from the state that was pickled by :py:meth:`__reduce_ex__`",
+  0,
+  true
+)
+.add_prototype("state")
+.add_parameter("state", "tuple", "The state of the machine")
+;
+
+static PyObject* PyBobLearnLinearBICMachine_setstate(PyBobLearnLinearBICMachineObject* self, PyObject* state) {
+BOB_TRY
+  PyObject* dffs,* intra,* extra;
+  if (!PyArg_ParseTuple(state, "OOO:__setstate__", &dffs, &intra, &extra)) return 0;
+
+  // the arrays are handed over to a new machine without further copies
+  boost::shared_ptr<bob::learn::linear::BICMachine> machine(new bob::learn::linear::BICMachine());
+  machine->use_DFFS(PyObject_IsTrue(dffs));
+  if (!unpickle_class(*machine, false, intra) || !unpickle_class(*machine, true, extra)) return 0;
+  self->cxx = machine;
+
+  Py_RETURN_NONE;
+BOB_CATCH_MEMBER("__setstate__", 0)
+}
+
 
 static PyMethodDef PyBobLearnLinearBICMachine_methods[] = {
   {
@@ -365,6 +487,18 @@ static PyMethodDef PyBobLearnLinearBICMachine_methods[] = {
     METH_VARARGS|METH_KEYWORDS,
     save_doc.doc()
   },
+  {
+    reduce_ex_doc.name(),
+    (PyCFunction)PyBobLearnLinearBICMachine_reduce_ex,
+    METH_VARARGS|METH_KEYWORDS,
+    reduce_ex_doc.doc()
+  },
+  {
+    setstate_doc.name(),
+    (PyCFunction)PyBobLearnLinearBICMachine_setstate,
+    METH_O,
+    setstate_doc.doc()
+  },
   {0} /* Sentinel */
 };
 
@@ -373,12 +507,15 @@ static auto train_doc = bob::extension::FunctionDoc(
   "train",
   "Trains the given machine to classify intrapersonal (image) difference vectors vs. extrapersonal ones",
   "The given difference vectors might be the result of any (image) comparison function, e.g., the pixel difference of two images. "
-  "In any case, all distance vectors must have the same length.",
+  "In any case, all distance vectors must have the same length.\n\n"
+  "The intrapersonal and the extrapersonal classes are estimated concurrently. "
+  "For BIC, only the leading eigenvectors of each class are computed, and the average of the remaining eigenvalues (used for the DFFS) is derived from the trace of the covariance matrix.\n\n"
+  "Instead of the difference vectors, the statistics accumulated on them in two :py:class:`bob.learn.linear.ScatterAccumulator` objects can be given, e.g., after merging the statistics that were computed on different parts of the data.",
   true
 )
 .add_prototype("intra_differences, extra_differences, [machine]", "machine")
-.add_parameter("intra_differences", "array_like (float, 2D)", "The input vectors, which are the result of intrapersonal (facial image) comparisons, in shape ``(#features, length)``")
-.add_parameter("extra_differences", "array_like (float, 2D)", "The input vectors, which are the result of extrapersonal (facial image) comparisons, in shape ``(#features, length)``")
+.add_parameter("intra_differences", "array_like (float, 2D) or :py:class:`bob.learn.linear.ScatterAccumulator`", "The input vectors, which are the result of intrapersonal (facial image) comparisons, in shape ``(#features, length)``")
+.add_parameter("extra_differences", "array_like (float, 2D) or :py:class:`bob.learn.linear.ScatterAccumulator`", "The input vectors, which are the result of extrapersonal (facial image) comparisons, in shape ``(#features, length)``")
 .add_parameter("machine", ":py:class:`bob.learn.linear.BICMachine`", "The machine to be trained")
 .add_return("machine", ":py:class:`bob.learn.linear.BICMachine`", "A newly generated and trained BIC machine, where the `bob.lear.linear.BICMachine.use_DFFS` flag is set to ``False``")
 ;
@@ -387,12 +524,36 @@ static PyObject* PyBobLearnLinearBICTrainer_train(PyBobLearnLinearBICTrainerObje
 BOB_TRY
   char** kwlist = train_doc.kwlist();
 
-  PyBlitzArrayObject* intra,* extra;
+  PyObject* intra_object,* extra_object;
   PyBobLearnLinearBICMachineObject* machine = 0;
-  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&O&|O!", kwlist, &PyBlitzArray_Converter, &intra, &PyBlitzArray_Converter, &extra, &PyBobLearnLinearBICMachine_Type, &machine)) return 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|O!", kwlist, &intra_object, &extra_object, &PyBobLearnLinearBICMachine_Type, &machine)) return 0;
 
-  auto intra_ = make_safe(intra), extra_ = make_safe(extra);
   boost::shared_ptr<PyBobLearnLinearBICMachineObject> machine_;
+  if (!machine){
+    // create machine if not given
+    machine = (PyBobLearnLinearBICMachineObject*)PyBobLearnLinearBICMachine_Type.tp_alloc(&PyBobLearnLinearBICMachine_Type, 0);
+    machine_ = make_safe(machine);
+    machine->cxx.reset(new bob::learn::linear::BICMachine());
+  }
+
+  bool intra_stats = PyBobLearnLinearScatterAccumulator_Check(intra_object), extra_stats = PyBobLearnLinearScatterAccumulator_Check(extra_object);
+  if (intra_stats != extra_stats){
+    PyErr_Format(PyExc_TypeError, "`%s' requires either arrays or accumulated statistics for both 'intra_differences' and 'extra_differences'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+  if (intra_stats){
+    // train from the accumulated statistics
+    auto intra = reinterpret_cast<PyBobLearnLinearScatterAccumulatorObject*>(intra_object);
+    auto extra = reinterpret_cast<PyBobLearnLinearScatterAccumulatorObject*>(extra_object);
+    self->cxx->train(*machine->cxx, *intra->cxx, *extra->cxx);
+    return Py_BuildValue("O", machine);
+  }
+
+  PyBlitzArrayObject* intra,* extra;
+  if (!PyBlitzArray_Converter(intra_object, &intra)) return 0;
+  auto intra_ = make_safe(intra);
+  if (!PyBlitzArray_Converter(extra_object, &extra)) return 0;
+  auto extra_ = make_safe(extra);
 
   if (intra->ndim != 2 || intra->type_num != NPY_FLOAT64){
     PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for 'intra_differences'", Py_TYPE(self)->tp_name);
@@ -407,13 +568,6 @@ BOB_TRY
     return 0;
   }
 
-  if (!machine){
-    // create machine if not given
-    machine = (PyBobLearnLinearBICMachineObject*)PyBobLearnLinearBICMachine_Type.tp_alloc(&PyBobLearnLinearBICMachine_Type, 0);
-    machine_ = make_safe(machine);
-    machine->cxx.reset(new bob::learn::linear::BICMachine());
-  }
-
   // train it
   self->cxx->train(*machine->cxx, *PyBlitzArrayCxx_AsBlitz<double,2>(intra), *PyBlitzArrayCxx_AsBlitz<double,2>(extra));
   return Py_BuildValue("O", machine);
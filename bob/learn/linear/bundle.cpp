@@ -0,0 +1,198 @@
+/**
+ * @date Sun Oct 18 10:12:41 CEST 2026
+ *
+ * @brief Python bindings to the bundles of machines
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#define BOB_LEARN_LINEAR_MODULE
+#include <bob.blitz/cppapi.h>
+#include <bob.blitz/cleanup.h>
+#include <bob.learn.linear/api.h>
+#include <bob.learn.linear/bundle.h>
+#include <bob.io.base/api.h>
+#include <bob.extension/documentation.h>
+
+static const char* filename_string(PyObject* filename) {
+#if PY_VERSION_HEX >= 0x03000000
+  return PyBytes_AS_STRING(filename);
+#else
+  return PyString_AS_STRING(filename);
+#endif
+}
+
+/******************************************************************/
+/************ Saving bundles **************************************/
+/******************************************************************/
+
+static auto save_bundle = bob::extension::FunctionDoc(
+  "save_bundle",
+  "Saves several machines into a single, memory-mappable bundle file",
+  "Bundles are an alternative to HDF5 that can hold any number of :py:class:`bob.learn.linear.Machine`, :py:class:`bob.learn.linear.BICMachine` and :py:class:`bob.learn.linear.GFKMachine` objects. "
+  "The file consists of a fixed, versioned header, the arrays of all machines as native doubles, each aligned to a page boundary, and an index with the names, types and shapes. "
+  "Loading the bundle with :py:func:`bob.learn.linear.load_bundle` hence requires a single ``mmap`` instead of one read per HDF5 dataset.\n\n"
+  "The bundle is written to a temporary file first, which replaces the given file only when all machines have been written. "
+  "Only the activation functions of :py:mod:`bob.learn.activation` can be stored."
+)
+.add_prototype("filename, machines")
+.add_parameter("filename", "str", "The name of the bundle file to write")
+.add_parameter("machines", "dict or [(str, machine)]", "The machines to store, either as a dictionary or as a sequence of ``(name, machine)`` pairs; the names must be unique")
+;
+static PyObject* PyBobLearnLinear_saveBundle(PyObject*, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  char** kwlist = save_bundle.kwlist();
+
+  PyObject* filename,* machines;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&O", kwlist,
+        &PyBobIo_FilenameConverter, &filename, &machines)) return 0;
+  auto filename_ = make_safe(filename);
+
+  // dictionaries are stored in the order of their items
+  PyObject* items = machines;
+  if (PyObject_HasAttrString(machines, "items")) items = PyObject_CallMethod(machines, const_cast<char*>("items"), 0);
+  else Py_INCREF(items);
+  if (!items) return 0;
+  auto items_ = make_safe(items);
+  auto iterator = make_xsafe(PyObject_GetIter(items));
+  if (!iterator) return 0;
+
+  bob::learn::linear::BundleWriter writer(filename_string(filename));
+  while (PyObject* item = PyIter_Next(iterator.get())) {
+    auto item_ = make_safe(item);
+    auto pair = make_xsafe(PySequence_Tuple(item));
+    if (!pair) return 0;
+    const char* name;
+    PyObject* machine;
+    if (!PyArg_ParseTuple(pair.get(), "sO", &name, &machine)) return 0;
+
+    if (PyBobLearnLinearMachine_Check(machine))
+      writer.add(name, *reinterpret_cast<PyBobLearnLinearMachineObject*>(machine)->cxx);
+    else if (PyBobLearnLinearBICMachine_Check(machine))
+      writer.add(name, *reinterpret_cast<PyBobLearnLinearBICMachineObject*>(machine)->cxx);
+    else if (PyBobLearnLinearGFKMachine_Check(machine))
+      writer.add(name, *reinterpret_cast<PyBobLearnLinearGFKMachineObject*>(machine)->cxx);
+    else {
+      PyErr_Format(PyExc_TypeError, "`%s' can only store objects of type `%s', `%s' or `%s', but `%s' was given for `%s'",
+          save_bundle.name(), PyBobLearnLinearMachine_Type.tp_name, PyBobLearnLinearBICMachine_Type.tp_name,
+          PyBobLearnLinearGFKMachine_Type.tp_name, Py_TYPE(machine)->tp_name, name);
+      return 0;
+    }
+  }
+  if (PyErr_Occurred()) return 0;
+
+  writer.close();
+  Py_RETURN_NONE;
+BOB_CATCH_FUNCTION("save_bundle", 0)
+}
+
+/******************************************************************/
+/************ Loading bundles *************************************/
+/******************************************************************/
+
+static auto load_bundle = bob::extension::FunctionDoc(
+  "load_bundle",
+  "Loads machines from a bundle file written with :py:func:`bob.learn.linear.save_bundle`",
+  "The whole file is mapped into memory at once, and the mapping is released when none of the loaded machines (nor their copies or :py:attr:`bob.learn.linear.Machine.weights` arrays) refer to it anymore. "
+  "Bundle files that are mapped must not be overwritten in place; :py:func:`bob.learn.linear.save_bundle` writes a new file and renames it over the old one, which keeps the loaded machines valid. "
+  "The weights of the linear machines (including the ``source_machine`` and ``target_machine`` of GFK machines) are used directly from the mapping (see :py:attr:`bob.learn.linear.Machine.is_mapped`) and copied only when modified; all other parameters are copied."
+)
+.add_prototype("filename, [names]", "machines")
+.add_parameter("filename", "str", "The name of the bundle file to read")
+.add_parameter("names", "[str]", "[Default: ``None``] The names of the machines to load; all machines are loaded if not given")
+.add_return("machines", "dict", "The loaded machines, indexed by their names")
+;
+
+template <typename T>
+static PyObject* load_machine(const bob::learn::linear::Bundle& bundle, const std::string& name, PyObject* module, const char* type) {
+  // creates an instance of the (possibly derived) Python class
+  PyObject* machine = PyObject_CallMethod(module, const_cast<char*>(type), 0);
+  if (!machine) return 0;
+  auto machine_ = make_safe(machine);
+  bundle.load(name, *reinterpret_cast<T*>(machine)->cxx);
+  Py_INCREF(machine);
+  return machine;
+}
+
+static PyObject* PyBobLearnLinear_loadBundle(PyObject*, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  char** kwlist = load_bundle.kwlist();
+
+  PyObject* filename,* names = 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|O", kwlist,
+        &PyBobIo_FilenameConverter, &filename, &names)) return 0;
+  auto filename_ = make_safe(filename);
+
+  bob::learn::linear::Bundle bundle(filename_string(filename));
+
+  std::vector<std::string> selected;
+  if (names && names != Py_None) {
+    auto iterator = make_xsafe(PyObject_GetIter(names));
+    if (!iterator) return 0;
+    while (PyObject* item = PyIter_Next(iterator.get())) {
+      auto item_ = make_safe(item);
+      const char* name;
+      if (!PyArg_Parse(item, "s", &name)) return 0;
+      selected.push_back(name);
+    }
+    if (PyErr_Occurred()) return 0;
+  }
+  else selected = bundle.names();
+
+  auto module = make_xsafe(PyImport_ImportModule(BOB_EXT_MODULE_PREFIX));
+  if (!module) return 0;
+
+  PyObject* retval = PyDict_New();
+  if (!retval) return 0;
+  auto retval_ = make_safe(retval);
+  for (auto it = selected.begin(); it != selected.end(); ++it) {
+    PyObject* machine = 0;
+    switch (bundle.type(*it)) {
+      case bob::learn::linear::BUNDLE_MACHINE:
+        machine = load_machine<PyBobLearnLinearMachineObject>(bundle, *it, module.get(), "Machine");
+        break;
+      case bob::learn::linear::BUNDLE_BIC_MACHINE:
+        machine = load_machine<PyBobLearnLinearBICMachineObject>(bundle, *it, module.get(), "BICMachine");
+        break;
+      case bob::learn::linear::BUNDLE_GFK_MACHINE:
+        machine = load_machine<PyBobLearnLinearGFKMachineObject>(bundle, *it, module.get(), "GFKMachine");
+        break;
+      default:
+        PyErr_Format(PyExc_RuntimeError, "`%s' cannot load the machine `%s' of unknown type %d", load_bundle.name(), it->c_str(), (int)bundle.type(*it));
+    }
+    if (!machine) return 0;
+    auto machine_ = make_safe(machine);
+    if (PyDict_SetItemString(retval, it->c_str(), machine) < 0) return 0;
+  }
+
+  Py_INCREF(retval);
+  return retval;
+BOB_CATCH_FUNCTION("load_bundle", 0)
+}
+
+static PyMethodDef PyBobLearnLinearBundle_methods[] = {
+  {
+    save_bundle.name(),
+    (PyCFunction)PyBobLearnLinear_saveBundle,
+    METH_VARARGS|METH_KEYWORDS,
+    save_bundle.doc()
+  },
+  {
+    load_bundle.name(),
+    (PyCFunction)PyBobLearnLinear_loadBundle,
+    METH_VARARGS|METH_KEYWORDS,
+    load_bundle.doc()
+  },
+  {0} /* Sentinel */
+};
+
+bool init_BobLearnLinearBundle(PyObject* module)
+{
+  // add the bundle functions to the module
+  for (PyMethodDef* def = PyBobLearnLinearBundle_methods; def->ml_name; ++def) {
+    PyObject* function = PyCFunction_NewEx(def, 0, 0);
+    if (!function) return false;
+    if (PyModule_AddObject(module, def->ml_name, function) < 0) return false;
+  }
+  return true;
+}
@@ -15,11 +15,17 @@
  */
 
 #include <bob.learn.linear/bic.h>
-#include <bob.learn.linear/pca.h>
 #include <bob.math/linear.h>
+#include <bob.math/stats.h>
+#include <bob.math/eig.h>
 #include <bob.core/assert.h>
 #include <bob.core/check.h>
 
+#include <boost/format.hpp>
+#include <thread>
+#include <utility>
+#include <exception>
+
 
 /*************************************************************
 ************************ BIC Machine *************************
@@ -253,6 +259,55 @@ void bob::learn::linear::BICMachine::setBIC(
   initialize(clazz, Phi.shape()[0], Phi.shape()[1]);
 }
 
+/**
+ * Sets the parameters of the given class that are required for computing the IEC scores (Guenther, Wuertz).
+ * The given arrays are taken over by the machine, unless they are referenced elsewhere, in which case they are copied.
+ *
+ * @param  clazz   false for the intrapersonal class, true for the extrapersonal one.
+ * @param  mean    The mean vector of the training data
+ * @param  variances  The variances of the training data
+ */
+void bob::learn::linear::BICMachine::setIEC(
+    bool clazz,
+    blitz::Array<double,1>&& mean,
+    blitz::Array<double,1>&& variances
+){
+  m_project_data = false;
+  take_or_copy(clazz ? m_mu_E : m_mu_I, mean);
+  take_or_copy(clazz ? m_lambda_E : m_lambda_I, variances);
+}
+
+/**
+ * Sets the parameters of the given class that are required for computing the BIC scores (Teixeira).
+ * The given arrays are taken over by the machine, unless they are referenced elsewhere, in which case they are copied.
+ *
+ * @param  clazz   false for the intrapersonal class, true for the extrapersonal one.
+ * @param  mean    The mean vector of the training data
+ * @param  variances  The eigenvalues of the training data
+ * @param  projection  The PCA projection matrix
+ * @param  rho     The residual eigenvalues, used for DFFS calculation
+ */
+void bob::learn::linear::BICMachine::setBIC(
+    bool clazz,
+    blitz::Array<double,1>&& mean,
+    blitz::Array<double,1>&& variances,
+    blitz::Array<double,2>&& projection,
+    const double rho
+){
+  m_project_data = true;
+  blitz::Array<double,2>& Phi = clazz ? m_Phi_E : m_Phi_I;
+  take_or_copy(clazz ? m_mu_E : m_mu_I, mean);
+  take_or_copy(clazz ? m_lambda_E : m_lambda_I, variances);
+  take_or_copy(Phi, projection);
+  (clazz ? m_rho_E : m_rho_I) = rho;
+
+  // check that rho has a reasonable value (if it is used)
+  if (m_use_DFFS && rho < 1e-12) throw std::runtime_error("The given average eigenvalue (rho) is too close to zero");
+
+  // initialize temporaries
+  initialize(clazz, Phi.shape()[0], Phi.shape()[1]);
+}
+
 /**
  * Set or unset the usage of the Distance From Feature Space
  *
@@ -377,14 +432,51 @@ static double sqr(const double& x){
 }
 
 /**
- * This function trains one of the classes of the given machine with the given data.
+ * Computes the leading eigenvalues and eigenvectors of the given covariance
+ * matrix, as many as the variances can hold.
+ *
+ * @param  covariance  The covariance matrix
+ * @param  variances  The leading eigenvalues (output)
+ * @param  projection  The leading eigenvectors (output)
+ * @return  The trace of the covariance matrix
+ */
+static double covariance_subspace(const blitz::Array<double,2>& covariance, blitz::Array<double,1>& variances, blitz::Array<double,2>& projection){
+  const int input_dim = covariance.extent(0), subspace_dim = variances.extent(0);
+  blitz::Range a = blitz::Range::all();
+  blitz::Array<double,2> V(input_dim, input_dim);
+  blitz::Array<double,1> e(input_dim);
+  double trace = 0.;
+  for (int i = input_dim; i--;) trace += covariance(i,i);
+  bob::math::eigSym_(covariance, V, e);
+
+  // eigenvalues are sorted in ascending order
+  for (int m = 0; m < subspace_dim; ++m){
+    const int index = input_dim - 1 - m;
+    variances(m) = e(index);
+    if (variances(m) < 1e-12)
+      throw std::runtime_error((boost::format("The chosen subspace dimension is %d, but the %dth eigenvalue is already to small")%subspace_dim%m).str());
+    projection(a, m) = V(a, index);
+  }
+  return trace;
+}
+
+/**
+ * This function estimates the parameters of one of the classes from the given data.
  * It computes either BIC projection matrices, or IEC mean and variance.
  *
+ * For BIC, only the leading subspace_dim eigenvectors are computed, using the
+ * smaller of the covariance matrix and the Gram matrix of the centered data.
+ * The average of the remaining eigenvalues (rho) is obtained from the trace of
+ * the covariance matrix, so that the full spectrum is never required.
+ *
+ * The differences are read element by element, without creating views of their rows,
+ * so that both classes can be estimated concurrently from arrays that share their memory.
+ *
  * @param  clazz    false for the intrapersonal class, true for the extrapersonal one.
- * @param  machine  The machine to be trained.
  * @param  differences  A set of (intra/extra)-personal difference vectors that should be trained.
+ * @param  model    The model, which will be filled with the estimated parameters.
  */
-void bob::learn::linear::BICTrainer::train_single(bool clazz, bob::learn::linear::BICMachine& machine, const blitz::Array<double,2>& differences) const {
+void bob::learn::linear::BICTrainer::estimate(bool clazz, const blitz::Array<double,2>& differences, ClassModel& model) const {
   int subspace_dim = clazz ? m_M_E : m_M_I;
   int input_dim = differences.extent(1);
   int data_count = differences.extent(0);
@@ -392,53 +484,73 @@ void bob::learn::linear::BICTrainer::train_single(bool clazz, bob::learn::linear
 
   if (subspace_dim){
     // train the class using BIC
-
-    // Compute PCA on the given dataset
-    bob::learn::linear::PCATrainer trainer;
-    const int n_eigs = trainer.output_size(differences);
-    bob::learn::linear::Machine pca(input_dim, n_eigs);
-    blitz::Array<double,1> variances(n_eigs);
-    trainer.train(pca, variances, differences);
-
-    // compute rho
-    double rho = 0.;
     int non_zero_eigenvalues = std::min(input_dim, data_count-1);
     // assert that the number of kept eigenvalues is not chosen to big
     if (subspace_dim >= non_zero_eigenvalues)
       throw std::runtime_error((boost::format("The chosen subspace dimension %d is larger than the theoretical number of nonzero eigenvalues %d")%subspace_dim%non_zero_eigenvalues).str());
-    // compute the average of the reminding eigenvalues
-    for (int i = subspace_dim; i < non_zero_eigenvalues; ++i){
-      rho += variances(i);
-    }
-    rho /= non_zero_eigenvalues - subspace_dim;
-
-    // limit dimensionalities
-    pca.resize(input_dim, subspace_dim);
-    variances.resizeAndPreserve(subspace_dim);
 
-    // check that all variances are meaningful
-    for (int i = 0; i < subspace_dim; ++i){
-      if (variances(i) < 1e-12)
-        throw std::runtime_error((boost::format("The chosen subspace dimension is %d, but the %dth eigenvalue is already to small")%subspace_dim%i).str());
+    model.mean.resize(input_dim);
+    model.variances.resize(subspace_dim);
+    model.projection.resize(input_dim, subspace_dim);
+
+    double trace = 0.;
+    if (data_count < input_dim){
+      // less data than dimensions: compute the eigenvectors of the (smaller) Gram matrix
+      // and map the leading ones back to the input space
+      model.mean = 0.;
+      for (int n = data_count; n--;)
+        for (int i = input_dim; i--;) model.mean(i) += differences(n,i);
+      model.mean /= data_count;
+      blitz::Array<double,2> centered(data_count, input_dim);
+      for (int n = data_count; n--;)
+        for (int i = input_dim; i--;) centered(n,i) = differences(n,i) - model.mean(i);
+      trace = blitz::sum(blitz::pow2(centered)) / (data_count - 1);
+
+      blitz::Array<double,2> gram(data_count, data_count), V(data_count, data_count);
+      blitz::Array<double,1> e(data_count);
+      bob::math::prod_(centered, centered.transpose(1,0), gram);
+      bob::math::eigSym_(gram, V, e);
+
+      // eigenvalues are sorted in ascending order
+      blitz::firstIndex i;
+      blitz::secondIndex j;
+      for (int m = 0; m < subspace_dim; ++m){
+        const int index = data_count - 1 - m;
+        model.variances(m) = e(index) / (data_count - 1);
+        if (model.variances(m) < 1e-12)
+          throw std::runtime_error((boost::format("The chosen subspace dimension is %d, but the %dth eigenvalue is already to small")%subspace_dim%m).str());
+        blitz::Array<double,1> v = V(a, index);
+        blitz::Array<double,1> column = model.projection(a, m);
+        column = blitz::sum(centered(j,i) * v(j), j) / std::sqrt(e(index));
+      }
+    } else {
+      // compute the eigenvectors of the covariance matrix directly
+      ScatterAccumulator statistics;
+      statistics.update(differences);
+      model.mean = statistics.getMean();
+      blitz::Array<double,2> covariance(input_dim, input_dim);
+      covariance = statistics.getScatter() / (data_count - 1);
+      trace = covariance_subspace(covariance, model.variances, model.projection);
     }
 
-    // initialize the machine
-    blitz::Array<double, 2> projection = pca.getWeights();
-    blitz::Array<double, 1> mean = pca.getInputSubtraction();
-    machine.setBIC(clazz, mean, variances, projection, rho);
+    // the average of the reminding eigenvalues is the remaining trace divided by their number
+    model.rho = (trace - blitz::sum(model.variances)) / (non_zero_eigenvalues - subspace_dim);
+
   } else {
     // train the class using IEC
     // => compute mean and variance only
-    blitz::Array<double,1> mean(input_dim), variance(input_dim);
+    model.mean.resize(input_dim);
+    model.variances.resize(input_dim);
+    blitz::Array<double,1>& mean = model.mean;
+    blitz::Array<double,1>& variance = model.variances;
 
     // compute mean and variance
     mean = 0.;
     variance = 0.;
     for (int n = data_count; n--;){
-      const blitz::Array<double,1>& diff = differences(n,a);
       for (int i = input_dim; i--;){
-        mean(i) += diff(i);
-        variance(i) += sqr(diff(i));
+        mean(i) += differences(n,i);
+        variance(i) += sqr(differences(n,i));
       }
     }
     // normalize mean and variances
@@ -449,8 +561,130 @@ void bob::learn::linear::BICTrainer::train_single(bool clazz, bob::learn::linear
       if (variance(i) < 1e-12)
         throw std::runtime_error((boost::format("The variance of the %dth dimension is too small. Check your data!")%i).str());
     }
+  }
+}
 
-    // set the results to the machine
-    machine.setIEC(clazz, mean, variance);
+/**
+ * This function estimates the parameters of one of the classes from the accumulated statistics of the data.
+ * It computes either BIC projection matrices, or IEC mean and variance.
+ * For BIC, the eigenvectors are always computed from the covariance matrix.
+ *
+ * @param  clazz    false for the intrapersonal class, true for the extrapersonal one.
+ * @param  statistics  The accumulated statistics of the (intra/extra)-personal difference vectors.
+ * @param  model    The model, which will be filled with the estimated parameters.
+ */
+void bob::learn::linear::BICTrainer::estimate(bool clazz, const bob::learn::linear::ScatterAccumulator& statistics, ClassModel& model) const {
+  int subspace_dim = clazz ? m_M_E : m_M_I;
+  int input_dim = statistics.numberOfFeatures();
+  int data_count = statistics.numberOfSamples();
+
+  blitz::Array<double,2> covariance(input_dim, input_dim);
+  statistics.covariance(covariance);
+  model.mean.resize(input_dim);
+  model.mean = statistics.getMean();
+
+  if (subspace_dim){
+    // train the class using BIC
+    int non_zero_eigenvalues = std::min(input_dim, data_count-1);
+    // assert that the number of kept eigenvalues is not chosen to big
+    if (subspace_dim >= non_zero_eigenvalues)
+      throw std::runtime_error((boost::format("The chosen subspace dimension %d is larger than the theoretical number of nonzero eigenvalues %d")%subspace_dim%non_zero_eigenvalues).str());
+
+    model.variances.resize(subspace_dim);
+    model.projection.resize(input_dim, subspace_dim);
+    double trace = covariance_subspace(covariance, model.variances, model.projection);
+
+    // the average of the reminding eigenvalues is the remaining trace divided by their number
+    model.rho = (trace - blitz::sum(model.variances)) / (non_zero_eigenvalues - subspace_dim);
+
+  } else {
+    // train the class using IEC
+    // => the variances are the diagonal of the covariance matrix
+    model.variances.resize(input_dim);
+    for (int i = 0; i < input_dim; ++i){
+      model.variances(i) = covariance(i,i);
+      if (model.variances(i) < 1e-12)
+        throw std::runtime_error((boost::format("The variance of the %dth dimension is too small. Check your data!")%i).str());
+    }
+  }
+}
+
+/**
+ * Hands the estimated parameters of one class over to the given machine, without copying them.
+ *
+ * @param  clazz    false for the intrapersonal class, true for the extrapersonal one.
+ * @param  machine  The machine to be trained.
+ * @param  model    The parameters that were estimated for the class.
+ */
+void bob::learn::linear::BICTrainer::apply(bool clazz, bob::learn::linear::BICMachine& machine, ClassModel&& model) const {
+  if (clazz ? m_M_E : m_M_I){
+    machine.setBIC(clazz, std::move(model.mean), std::move(model.variances), std::move(model.projection), model.rho);
+  } else {
+    machine.setIEC(clazz, std::move(model.mean), std::move(model.variances));
   }
 }
+
+/**
+ * This function trains one of the classes of the given machine with the given data.
+ * It computes either BIC projection matrices, or IEC mean and variance.
+ *
+ * @param  clazz    false for the intrapersonal class, true for the extrapersonal one.
+ * @param  machine  The machine to be trained.
+ * @param  differences  A set of (intra/extra)-personal difference vectors that should be trained.
+ */
+void bob::learn::linear::BICTrainer::train_single(bool clazz, bob::learn::linear::BICMachine& machine, const blitz::Array<double,2>& differences) const {
+  ClassModel model;
+  estimate(clazz, differences, model);
+  apply(clazz, machine, std::move(model));
+}
+
+/**
+ * This function trains both classes of the given machine with the given data.
+ * The two classes are estimated independently of each other, so the extrapersonal class is estimated in a separate thread.
+ * Neither estimation copies the differences or creates views of them, so that both may share their data.
+ * The machine itself is only modified after both estimations succeeded.
+ *
+ * @param  machine  The machine to be trained.
+ * @param  intra_differences  A set of intrapersonal difference vectors.
+ * @param  extra_differences  A set of extrapersonal difference vectors.
+ */
+void bob::learn::linear::BICTrainer::train(bob::learn::linear::BICMachine& machine, const blitz::Array<double,2>& intra_differences, const blitz::Array<double,2>& extra_differences) const {
+  ClassModel intra, extra;
+  std::exception_ptr extra_exception;
+  std::thread extra_thread([&](){
+    try {
+      estimate(true, extra_differences, extra);
+    } catch (...) {
+      extra_exception = std::current_exception();
+    }
+  });
+
+  try {
+    estimate(false, intra_differences, intra);
+  } catch (...) {
+    extra_thread.join();
+    throw;
+  }
+  extra_thread.join();
+  if (extra_exception) std::rethrow_exception(extra_exception);
+
+  apply(false, machine, std::move(intra));
+  apply(true, machine, std::move(extra));
+}
+
+/**
+ * This function trains both classes of the given machine with the accumulated statistics of the difference vectors.
+ * The machine itself is only modified after both estimations succeeded.
+ *
+ * @param  machine  The machine to be trained.
+ * @param  intra_statistics  The accumulated statistics of the intrapersonal difference vectors.
+ * @param  extra_statistics  The accumulated statistics of the extrapersonal difference vectors.
+ */
+void bob::learn::linear::BICTrainer::train(bob::learn::linear::BICMachine& machine, const bob::learn::linear::ScatterAccumulator& intra_statistics, const bob::learn::linear::ScatterAccumulator& extra_statistics) const {
+  ClassModel intra, extra;
+  estimate(false, intra_statistics, intra);
+  estimate(true, extra_statistics, extra);
+
+  apply(false, machine, std::move(intra));
+  apply(true, machine, std::move(extra));
+}
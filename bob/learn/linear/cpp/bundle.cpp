@@ -0,0 +1,541 @@
+/**
+ * @date Sun Oct 18 10:12:41 CEST 2026
+ *
+ * @brief A compact binary format that bundles several machines in a single,
+ * memory-mappable file
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <mutex>
+#include <tuple>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <boost/format.hpp>
+#include <boost/make_shared.hpp>
+
+#include <bob.learn.linear/bundle.h>
+
+namespace bob { namespace learn { namespace linear {
+
+  /**
+   * Unmaps the pages of a mapping when its last owner is released
+   */
+  struct Unmapper {
+    void* base;
+    size_t length;
+    void operator()(const char*) const { ::munmap(base, length); }
+  };
+
+  boost::shared_ptr<const char> map_file(const std::string& filename,
+      off_t offset, size_t bytes, const struct stat* expected) {
+
+    // the registry only refers to the mappings, which are owned by the
+    // machines and bundles that use them
+    static std::mutex mutex;
+    static std::map<std::tuple<dev_t, ino_t, time_t, off_t, off_t, size_t>, boost::weak_ptr<const char> > mappings;
+
+    boost::shared_ptr<const char> mapping;
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return mapping;
+    struct stat status;
+    if (::fstat(fd, &status) != 0 || offset + (off_t)bytes > status.st_size) {
+      ::close(fd);
+      return mapping;
+    }
+
+    // the file may have been replaced or modified since the caller read it
+    if (expected && (status.st_dev != expected->st_dev ||
+          status.st_ino != expected->st_ino ||
+          status.st_size != expected->st_size ||
+          status.st_mtime != expected->st_mtime)) {
+      ::close(fd);
+      return mapping;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = mappings.begin(); it != mappings.end();) {
+      if (it->second.expired()) it = mappings.erase(it);
+      else ++it;
+    }
+
+    // a file with a different size or modification time is a new version
+    auto key = std::make_tuple(status.st_dev, status.st_ino, status.st_mtime, status.st_size, offset, bytes);
+    auto it = mappings.find(key);
+    if (it != mappings.end()) mapping = it->second.lock();
+    if (mapping) {
+      ::close(fd);
+      return mapping;
+    }
+
+    // mappings need to start at page boundaries
+    const off_t page = ::sysconf(_SC_PAGESIZE);
+    const off_t start = offset - offset % page;
+    const size_t length = bytes + (offset - start);
+    void* base = ::mmap(0, length, PROT_READ, MAP_PRIVATE, fd, start);
+    ::close(fd);
+    if (base == MAP_FAILED) return mapping;
+
+    const Unmapper unmapper = {base, length};
+    mapping.reset(static_cast<const char*>(base) + (offset - start), unmapper);
+    mappings[key] = mapping;
+    return mapping;
+  }
+
+  /**
+   * The layout of the fixed header at the start of each bundle file
+   */
+  static const char BUNDLE_MAGIC[8] = {'B', 'O', 'B', 'L', 'I', 'N', 'B', '\0'};
+  static const uint32_t BUNDLE_BYTE_ORDER = 0x01020304;
+  static const size_t BUNDLE_HEADER_SIZE = 64;
+
+  enum {
+    HEADER_MAGIC = 0,
+    HEADER_VERSION = 8,
+    HEADER_BYTE_ORDER = 12,
+    HEADER_COUNT = 16,
+    HEADER_INDEX_OFFSET = 24,
+    HEADER_INDEX_SIZE = 32,
+    HEADER_FILE_SIZE = 40
+  };
+
+  /**
+   * The activation functions that can be stored in a bundle, together with
+   * their parameters
+   */
+  enum {
+    ACTIVATION_IDENTITY = 0,
+    ACTIVATION_LINEAR = 1,
+    ACTIVATION_LOGISTIC = 2,
+    ACTIVATION_TANH = 3,
+    ACTIVATION_MULTIPLIED_TANH = 4
+  };
+
+  static void activation_parameters(const boost::shared_ptr<bob::learn::activation::Activation>& activation, std::vector<double>& scalars) {
+    double code, C = 0., M = 0.;
+    if (boost::dynamic_pointer_cast<bob::learn::activation::IdentityActivation>(activation))
+      code = ACTIVATION_IDENTITY;
+    else if (auto linear = boost::dynamic_pointer_cast<bob::learn::activation::LinearActivation>(activation)) {
+      code = ACTIVATION_LINEAR;
+      C = linear->C();
+    }
+    else if (boost::dynamic_pointer_cast<bob::learn::activation::LogisticActivation>(activation))
+      code = ACTIVATION_LOGISTIC;
+    else if (boost::dynamic_pointer_cast<bob::learn::activation::HyperbolicTangentActivation>(activation))
+      code = ACTIVATION_TANH;
+    else if (auto multiplied = boost::dynamic_pointer_cast<bob::learn::activation::MultipliedHyperbolicTangentActivation>(activation)) {
+      code = ACTIVATION_MULTIPLIED_TANH;
+      C = multiplied->C();
+      M = multiplied->M();
+    }
+    else {
+      boost::format m("the activation function '%s' cannot be stored in a bundle");
+      m % activation->str();
+      throw std::runtime_error(m.str());
+    }
+    scalars.push_back(code);
+    scalars.push_back(C);
+    scalars.push_back(M);
+  }
+
+  static boost::shared_ptr<bob::learn::activation::Activation> make_activation(double code, double C, double M) {
+    switch ((int)code) {
+      case ACTIVATION_IDENTITY:
+        return boost::make_shared<bob::learn::activation::IdentityActivation>();
+      case ACTIVATION_LINEAR:
+        return boost::make_shared<bob::learn::activation::LinearActivation>(C);
+      case ACTIVATION_LOGISTIC:
+        return boost::make_shared<bob::learn::activation::LogisticActivation>();
+      case ACTIVATION_TANH:
+        return boost::make_shared<bob::learn::activation::HyperbolicTangentActivation>();
+      case ACTIVATION_MULTIPLIED_TANH:
+        return boost::make_shared<bob::learn::activation::MultipliedHyperbolicTangentActivation>(C, M);
+      default:
+        boost::format m("unknown activation function %g in bundle");
+        m % code;
+        throw std::runtime_error(m.str());
+    }
+  }
+
+  template <typename T>
+  static void append(std::vector<char>& buffer, const T& value) {
+    const char* data = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), data, data + sizeof(T));
+  }
+
+  static uint64_t align(uint64_t offset, uint64_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+  }
+
+  /************************ Bundle Writer ************************/
+
+  BundleWriter::BundleWriter(const std::string& filename):
+    m_filename(filename),
+    m_temporary((boost::format("%s.%d.tmp") % filename % ::getpid()).str()),
+    m_offset(BUNDLE_ALIGNMENT)
+  {
+    m_file.open(m_temporary.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+      boost::format m("cannot open file '%s' for writing");
+      m % m_temporary;
+      throw std::runtime_error(m.str());
+    }
+    // reserves the space of the header, which is written in close()
+    std::vector<char> zeros(BUNDLE_ALIGNMENT, 0);
+    m_file.write(&zeros[0], zeros.size());
+  }
+
+  BundleWriter::~BundleWriter()
+  {
+    if (m_file.is_open()) {
+      m_file.close();
+      std::remove(m_temporary.c_str());
+    }
+  }
+
+  void BundleWriter::begin(const std::string& name)
+  {
+    if (!m_file.is_open()) {
+      boost::format m("cannot add machine '%s' to the bundle '%s', which is already closed");
+      m % name % m_filename;
+      throw std::runtime_error(m.str());
+    }
+    if (std::find(m_names.begin(), m_names.end(), name) != m_names.end()) {
+      boost::format m("the bundle '%s' already contains a machine with name '%s'");
+      m % m_filename % name;
+      throw std::runtime_error(m.str());
+    }
+    m_scalars.clear();
+    m_arrays.clear();
+  }
+
+  void BundleWriter::end(const std::string& name, BundleType type)
+  {
+    if (!m_file) {
+      boost::format m("error writing machine '%s' to file '%s'");
+      m % name % m_temporary;
+      throw std::runtime_error(m.str());
+    }
+    append(m_index, (uint32_t)type);
+    append(m_index, (uint32_t)name.size());
+    append(m_index, (uint32_t)m_scalars.size());
+    append(m_index, (uint32_t)(m_arrays.size() / 4));
+    m_index.insert(m_index.end(), name.begin(), name.end());
+    m_index.resize(align(m_index.size(), sizeof(uint64_t)), 0);
+    for (size_t i = 0; i < m_scalars.size(); ++i) append(m_index, m_scalars[i]);
+    for (size_t i = 0; i < m_arrays.size(); ++i) append(m_index, m_arrays[i]);
+    m_names.push_back(name);
+  }
+
+  template <int N>
+  void BundleWriter::write(const blitz::Array<double,N>& array)
+  {
+    const blitz::Array<double,N> data = bob::core::array::isCZeroBaseContiguous(array) ? array : bob::core::array::ccopy(array);
+    uint64_t offset = 0;
+    if (data.size()) {
+      // aligns the array, so that it can be used directly from the mapping
+      offset = align(m_offset, BUNDLE_ALIGNMENT);
+      std::vector<char> zeros(offset - m_offset, 0);
+      if (zeros.size()) m_file.write(&zeros[0], zeros.size());
+      m_file.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(double));
+      m_offset = offset + data.size() * sizeof(double);
+    }
+    m_arrays.push_back(offset);
+    m_arrays.push_back(N);
+    m_arrays.push_back(data.extent(0));
+    m_arrays.push_back(N == 2 ? data.extent(N-1) : 1);
+  }
+
+  void BundleWriter::write(const Machine& machine)
+  {
+    activation_parameters(machine.getActivation(), m_scalars);
+    write(machine.getInputSubtraction());
+    write(machine.getInputDivision());
+    write(machine.getWeights());
+    write(machine.getBiases());
+  }
+
+  void BundleWriter::add(const std::string& name, const Machine& machine)
+  {
+    begin(name);
+    write(machine);
+    end(name, BUNDLE_MACHINE);
+  }
+
+  void BundleWriter::add(const std::string& name, const BICMachine& machine)
+  {
+    begin(name);
+    const bool project = machine.project_data();
+    m_scalars.push_back(machine.use_DFFS());
+    m_scalars.push_back(project);
+    m_scalars.push_back(project ? machine.rho(false) : 0.);
+    m_scalars.push_back(project ? machine.rho(true) : 0.);
+    for (int clazz = 0; clazz < 2; ++clazz) {
+      write(machine.mean(clazz));
+      write(machine.variances(clazz));
+      write(project ? machine.projection(clazz) : blitz::Array<double,2>());
+    }
+    end(name, BUNDLE_BIC_MACHINE);
+  }
+
+  void BundleWriter::add(const std::string& name, const GFKMachine& machine)
+  {
+    begin(name);
+    write(machine.getSourceMachine());
+    write(machine.getTargetMachine());
+    write(machine.getG());
+    write(machine.getBasis());
+    write(machine.getCore());
+    end(name, BUNDLE_GFK_MACHINE);
+  }
+
+  void BundleWriter::close()
+  {
+    if (!m_file.is_open()) return;
+
+    // the index follows the data
+    const uint64_t index_offset = align(m_offset, sizeof(uint64_t));
+    std::vector<char> zeros(index_offset - m_offset, 0);
+    if (zeros.size()) m_file.write(&zeros[0], zeros.size());
+    if (m_index.size()) m_file.write(&m_index[0], m_index.size());
+
+    std::vector<char> header(BUNDLE_HEADER_SIZE, 0);
+    const uint32_t version = BUNDLE_VERSION;
+    const uint64_t count = m_names.size(), index_size = m_index.size(),
+      file_size = index_offset + index_size;
+    std::memcpy(&header[HEADER_MAGIC], BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC));
+    std::memcpy(&header[HEADER_VERSION], &version, sizeof(version));
+    std::memcpy(&header[HEADER_BYTE_ORDER], &BUNDLE_BYTE_ORDER, sizeof(BUNDLE_BYTE_ORDER));
+    std::memcpy(&header[HEADER_COUNT], &count, sizeof(count));
+    std::memcpy(&header[HEADER_INDEX_OFFSET], &index_offset, sizeof(index_offset));
+    std::memcpy(&header[HEADER_INDEX_SIZE], &index_size, sizeof(index_size));
+    std::memcpy(&header[HEADER_FILE_SIZE], &file_size, sizeof(file_size));
+    m_file.seekp(0);
+    m_file.write(&header[0], header.size());
+    m_file.close();
+
+    if (m_file.fail() || std::rename(m_temporary.c_str(), m_filename.c_str()) != 0) {
+      std::remove(m_temporary.c_str());
+      boost::format m("error writing the bundle '%s'");
+      m % m_filename;
+      throw std::runtime_error(m.str());
+    }
+  }
+
+  /************************ Bundle Reader ************************/
+
+  /**
+   * Reads a value of the given type from the index, checking its bounds
+   */
+  template <typename T>
+  static T read_value(const char* data, uint64_t& position, uint64_t end, const std::string& filename) {
+    if (position + sizeof(T) > end) {
+      boost::format m("the index of the bundle '%s' is truncated");
+      m % filename;
+      throw std::runtime_error(m.str());
+    }
+    T value;
+    std::memcpy(&value, data + position, sizeof(T));
+    position += sizeof(T);
+    return value;
+  }
+
+  Bundle::Bundle(const std::string& filename):
+    m_filename(filename)
+  {
+    struct stat status;
+    if (::stat(filename.c_str(), &status) != 0) {
+      boost::format m("cannot open the bundle '%s'");
+      m % filename;
+      throw std::runtime_error(m.str());
+    }
+    const uint64_t size = status.st_size;
+
+    if (size >= BUNDLE_HEADER_SIZE) m_data = map_file(filename, 0, size);
+    const char* data = m_data.get();
+    if (!data || std::memcmp(data + HEADER_MAGIC, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC))) {
+      boost::format m("the file '%s' is not a bundle of machines");
+      m % filename;
+      throw std::runtime_error(m.str());
+    }
+
+    // checks the header
+    uint64_t position = HEADER_VERSION;
+    const uint32_t version = read_value<uint32_t>(data, position, size, filename);
+    const uint32_t byte_order = read_value<uint32_t>(data, position, size, filename);
+    const uint64_t count = read_value<uint64_t>(data, position, size, filename);
+    const uint64_t index_offset = read_value<uint64_t>(data, position, size, filename);
+    const uint64_t index_size = read_value<uint64_t>(data, position, size, filename);
+    const uint64_t file_size = read_value<uint64_t>(data, position, size, filename);
+    if (version > BUNDLE_VERSION) {
+      boost::format m("the bundle '%s' has version %u, but only versions up to %u are supported");
+      m % filename % version % BUNDLE_VERSION;
+      throw std::runtime_error(m.str());
+    }
+    if (byte_order != BUNDLE_BYTE_ORDER) {
+      boost::format m("the bundle '%s' was written on a machine with a different byte order");
+      m % filename;
+      throw std::runtime_error(m.str());
+    }
+    if (file_size != size || index_offset < BUNDLE_HEADER_SIZE || index_offset > size || index_size > size - index_offset) {
+      boost::format m("the bundle '%s' is truncated or corrupt");
+      m % filename;
+      throw std::runtime_error(m.str());
+    }
+
+    // reads the index
+    position = index_offset;
+    const uint64_t end = index_offset + index_size;
+    for (uint64_t k = 0; k < count; ++k) {
+      Entry entry;
+      entry.type = (BundleType)read_value<uint32_t>(data, position, end, filename);
+      const uint32_t name_size = read_value<uint32_t>(data, position, end, filename);
+      const uint32_t n_scalars = read_value<uint32_t>(data, position, end, filename);
+      const uint32_t n_arrays = read_value<uint32_t>(data, position, end, filename);
+      if (name_size > end - position) {
+        boost::format m("the index of the bundle '%s' is truncated");
+        m % filename;
+        throw std::runtime_error(m.str());
+      }
+      const std::string name(data + position, name_size);
+      position += align(name_size, sizeof(uint64_t));
+
+      for (uint32_t i = 0; i < n_scalars; ++i)
+        entry.scalars.push_back(read_value<double>(data, position, end, filename));
+
+      for (uint32_t i = 0; i < n_arrays; ++i) {
+        const uint64_t offset = read_value<uint64_t>(data, position, end, filename);
+        const uint64_t ndim = read_value<uint64_t>(data, position, end, filename);
+        const uint64_t rows = read_value<uint64_t>(data, position, end, filename);
+        const uint64_t cols = read_value<uint64_t>(data, position, end, filename);
+        const uint64_t limit = index_offset / sizeof(double);
+        if ((ndim != 1 && ndim != 2) || rows > limit || cols > limit ||
+            (rows && cols && rows * cols > limit) || offset % sizeof(double) ||
+            offset > index_offset || rows * cols * sizeof(double) > index_offset - offset) {
+          boost::format m("array %u of machine '%s' in the bundle '%s' is corrupt");
+          m % i % name % filename;
+          throw std::runtime_error(m.str());
+        }
+        ArrayEntry array;
+        array.data = rows * cols ? reinterpret_cast<const double*>(data + offset) : 0;
+        array.ndim = ndim;
+        array.shape[0] = rows;
+        array.shape[1] = cols;
+        entry.arrays.push_back(array);
+      }
+
+      if (!m_entries.insert(std::make_pair(name, entry)).second) {
+        boost::format m("the bundle '%s' contains several machines with name '%s'");
+        m % filename % name;
+        throw std::runtime_error(m.str());
+      }
+      m_names.push_back(name);
+    }
+  }
+
+  Bundle::~Bundle() {}
+
+  bool Bundle::contains(const std::string& name) const
+  {
+    return m_entries.find(name) != m_entries.end();
+  }
+
+  BundleType Bundle::type(const std::string& name) const
+  {
+    auto it = m_entries.find(name);
+    if (it == m_entries.end()) {
+      boost::format m("the bundle '%s' does not contain a machine with name '%s'");
+      m % m_filename % name;
+      throw std::runtime_error(m.str());
+    }
+    return it->second.type;
+  }
+
+  const Bundle::Entry& Bundle::entry(const std::string& name, BundleType type,
+    size_t n_scalars, size_t n_arrays) const
+  {
+    const BundleType stored = this->type(name);
+    const Entry& entry = m_entries.find(name)->second;
+    if (stored != type) {
+      boost::format m("the machine '%s' in the bundle '%s' has type %d, but type %d was requested");
+      m % name % m_filename % stored % type;
+      throw std::runtime_error(m.str());
+    }
+    if (entry.scalars.size() != n_scalars || entry.arrays.size() != n_arrays) {
+      boost::format m("the machine '%s' in the bundle '%s' has %u scalars and %u arrays, but %u and %u are required");
+      m % name % m_filename % entry.scalars.size() % entry.arrays.size() % n_scalars % n_arrays;
+      throw std::runtime_error(m.str());
+    }
+    return entry;
+  }
+
+  blitz::Array<double,1> Bundle::array1(const ArrayEntry& array)
+  {
+    if (array.ndim != 1)
+      throw std::runtime_error("a 1D array was expected in the bundle");
+    if (!array.data) return blitz::Array<double,1>(array.shape[0]);
+    return blitz::Array<double,1>(const_cast<double*>(array.data),
+      blitz::shape(array.shape[0]), blitz::neverDeleteData);
+  }
+
+  blitz::Array<double,2> Bundle::array2(const ArrayEntry& array)
+  {
+    if (array.ndim != 2)
+      throw std::runtime_error("a 2D array was expected in the bundle");
+    if (!array.data) return blitz::Array<double,2>(array.shape[0], array.shape[1]);
+    return blitz::Array<double,2>(const_cast<double*>(array.data),
+      blitz::shape(array.shape[0], array.shape[1]), blitz::neverDeleteData);
+  }
+
+  void Bundle::load(const Entry& entry, size_t scalar, size_t array,
+    Machine& machine) const
+  {
+    // the weights refer to the mapping, which the machine keeps alive; all
+    // other arrays are copied
+    const blitz::Array<double,2> weights = array2(entry.arrays[array+2]);
+    if (entry.arrays[array+2].data) machine.mapWeights(weights, m_data);
+    else machine = Machine(weights.extent(0), weights.extent(1));
+    machine.setInputSubtraction(bob::core::array::ccopy(array1(entry.arrays[array])));
+    machine.setInputDivision(bob::core::array::ccopy(array1(entry.arrays[array+1])));
+    machine.setBiases(bob::core::array::ccopy(array1(entry.arrays[array+3])));
+    machine.setActivation(make_activation(entry.scalars[scalar],
+      entry.scalars[scalar+1], entry.scalars[scalar+2]));
+  }
+
+  void Bundle::load(const std::string& name, Machine& machine) const
+  {
+    load(entry(name, BUNDLE_MACHINE, 3, 4), 0, 0, machine);
+  }
+
+  void Bundle::load(const std::string& name, BICMachine& machine) const
+  {
+    const Entry& e = entry(name, BUNDLE_BIC_MACHINE, 4, 6);
+    machine.use_DFFS(e.scalars[0] != 0.);
+    for (int clazz = 0; clazz < 2; ++clazz) {
+      const size_t a = 3 * clazz;
+      if (e.scalars[1] != 0.)
+        machine.setBIC(clazz, array1(e.arrays[a]), array1(e.arrays[a+1]),
+          array2(e.arrays[a+2]), e.scalars[2+clazz], true);
+      else
+        machine.setIEC(clazz, array1(e.arrays[a]), array1(e.arrays[a+1]), true);
+    }
+  }
+
+  void Bundle::load(const std::string& name, GFKMachine& machine) const
+  {
+    const Entry& e = entry(name, BUNDLE_GFK_MACHINE, 6, 11);
+    Machine source, target;
+    load(e, 0, 0, source);
+    load(e, 3, 4, target);
+    machine.setSourceMachine(source);
+    machine.setTargetMachine(target);
+    machine.setG(array2(e.arrays[8]));
+    machine.setFactors(array2(e.arrays[9]), array2(e.arrays[10]));
+  }
+
+}}}
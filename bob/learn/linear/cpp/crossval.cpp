@@ -0,0 +1,267 @@
+/**
+ * @date Sun Oct 18 17:40:27 CEST 2026
+ *
+ * @brief k-fold cross-validation of the trainers, running the folds in
+ * parallel threads
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.linear/crossval.h>
+#include <bob.core/logging.h>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace bob { namespace learn { namespace linear {
+
+  /**
+   * Calls function(k) for k = 0, ..., n-1 in the given number of threads (0
+   * for one per processor). After an exception, no further calls are
+   * started, and the first exception is rethrown once all threads finished.
+   *
+   * The reference counts of blitz arrays are not atomic (see Machine), so
+   * the function must not create references or slices of arrays that are
+   * shared between the threads, but access their elements only.
+   */
+  static void parallel_for(const size_t n, size_t n_threads,
+      const std::function<void (size_t)>& function) {
+    if (!n_threads) n_threads = std::max(1u, std::thread::hardware_concurrency());
+    n_threads = std::min(n_threads, n);
+
+    std::atomic<size_t> next(0);
+    std::exception_ptr error;
+    std::mutex mutex;
+    auto worker = [&]() {
+      for (size_t k = next++; k < n; k = next++) {
+        try {
+          function(k);
+        }
+        catch (...) {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!error) error = std::current_exception();
+          next = n;
+        }
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < n_threads; ++t) threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads) thread.join();
+    if (error) std::rethrow_exception(error);
+  }
+
+  /**
+   * Checks the data and the fold indices of the samples of each class, and
+   * returns the number of folds
+   */
+  static size_t number_of_folds(const std::vector<blitz::Array<double,2> >& data,
+      const std::vector<blitz::Array<int64_t,1> >& folds) {
+    if (data.empty() || data.size() != folds.size()) {
+      boost::format m("cross-validation requires the fold indices of the samples of each of the %d classes, but %d arrays of fold indices were given");
+      m % data.size() % folds.size();
+      throw std::runtime_error(m.str());
+    }
+    int64_t last = -1;
+    for (size_t c = 0; c < data.size(); ++c) {
+      if (data[c].extent(1) != data[0].extent(1)) {
+        boost::format m("the samples of class %d have %d features, but the samples of class 0 have %d features");
+        m % c % data[c].extent(1) % data[0].extent(1);
+        throw std::runtime_error(m.str());
+      }
+      if (folds[c].extent(0) != data[c].extent(0)) {
+        boost::format m("class %d has %d samples, but %d fold indices");
+        m % c % data[c].extent(0) % folds[c].extent(0);
+        throw std::runtime_error(m.str());
+      }
+      for (int i = 0; i < folds[c].extent(0); ++i) {
+        if (folds[c](i) < 0) {
+          boost::format m("the fold index of sample %d of class %d is negative (%d)");
+          m % i % c % folds[c](i);
+          throw std::runtime_error(m.str());
+        }
+        last = std::max(last, folds[c](i));
+      }
+    }
+    if (last < 1) {
+      throw std::runtime_error("cross-validation requires at least two folds");
+    }
+    return last + 1;
+  }
+
+  /**
+   * Copies the samples of fold k (or, if held_out is false, of all other
+   * folds) into a new array, element by element
+   */
+  static blitz::Array<double,2> gather(const blitz::Array<double,2>& data,
+      const blitz::Array<int64_t,1>& folds, const int64_t k, const bool held_out) {
+    int n_samples = 0;
+    for (int i = 0; i < folds.extent(0); ++i)
+      if ((folds(i) == k) == held_out) ++n_samples;
+    blitz::Array<double,2> result(n_samples, data.extent(1));
+    int row = 0;
+    for (int i = 0; i < folds.extent(0); ++i) {
+      if ((folds(i) == k) != held_out) continue;
+      for (int j = 0; j < data.extent(1); ++j) result(row,j) = data(i,j);
+      ++row;
+    }
+    return result;
+  }
+
+  /**
+   * Returns the statistics of the training samples of each class for each
+   * fold. The data is scanned once to accumulate the statistics of each fold;
+   * the statistics of the training samples are those of all data minus those
+   * of the fold.
+   */
+  static std::vector<std::vector<ScatterAccumulator> > training_statistics(
+      const std::vector<blitz::Array<double,2> >& data,
+      const std::vector<blitz::Array<int64_t,1> >& folds,
+      const size_t n_folds, const size_t n_threads) {
+    const size_t n_classes = data.size();
+    const ScatterAccumulator empty(data[0].extent(1));
+    std::vector<std::vector<ScatterAccumulator> > statistics(n_folds, std::vector<ScatterAccumulator>(n_classes, empty));
+    parallel_for(n_folds, n_threads, [&](size_t k) {
+      for (size_t c = 0; c < n_classes; ++c)
+        statistics[k][c].update(gather(data[c], folds[c], k, true));
+    });
+
+    std::vector<ScatterAccumulator> total(n_classes, empty);
+    for (size_t k = 0; k < n_folds; ++k)
+      for (size_t c = 0; c < n_classes; ++c)
+        total[c].merge(statistics[k][c]);
+
+    for (size_t k = 0; k < n_folds; ++k) {
+      for (size_t c = 0; c < n_classes; ++c) {
+        const ScatterAccumulator fold(statistics[k][c]);
+        statistics[k][c] = total[c];
+        statistics[k][c].subtract(fold);
+      }
+    }
+    return statistics;
+  }
+
+  /**
+   * Truncates the machines to the same number of outputs, and sets the
+   * scores of the samples of each class to the outputs of the machine of
+   * their fold
+   */
+  static void score(std::vector<Machine>& machines,
+      const std::vector<blitz::Array<double,2> >& data,
+      const std::vector<blitz::Array<int64_t,1> >& folds,
+      std::vector<blitz::Array<double,2> >& scores, const size_t n_threads) {
+    size_t n_outputs = machines[0].outputSize();
+    for (size_t k = 1; k < machines.size(); ++k)
+      n_outputs = std::min(n_outputs, machines[k].outputSize());
+    for (size_t k = 0; k < machines.size(); ++k)
+      if (machines[k].outputSize() != n_outputs) machines[k].resize(machines[k].inputSize(), n_outputs);
+
+    const int n_features = data[0].extent(1);
+    scores.resize(data.size());
+    for (size_t c = 0; c < data.size(); ++c)
+      scores[c].resize(data[c].extent(0), n_outputs);
+
+    parallel_for(machines.size(), n_threads, [&](size_t k) {
+      blitz::Array<double,1> input(n_features), output(n_outputs);
+      for (size_t c = 0; c < data.size(); ++c) {
+        for (int i = 0; i < folds[c].extent(0); ++i) {
+          if (folds[c](i) != (int64_t)k) continue;
+          for (int j = 0; j < n_features; ++j) input(j) = data[c](i,j);
+          machines[k].forward_(input, output);
+          for (size_t o = 0; o < n_outputs; ++o) scores[c](i,o) = output(o);
+        }
+      }
+    });
+  }
+
+  void cross_validate(const PCATrainer& trainer,
+      const blitz::Array<double,2>& data,
+      const blitz::Array<int64_t,1>& folds,
+      std::vector<Machine>& machines, blitz::Array<double,2>& scores,
+      size_t n_threads) {
+    // a single class of samples
+    const std::vector<blitz::Array<double,2> > classes(1, data);
+    const std::vector<blitz::Array<int64_t,1> > class_folds(1, folds);
+    const size_t n_folds = number_of_folds(classes, class_folds);
+    const std::vector<std::vector<ScatterAccumulator> > statistics = training_statistics(classes, class_folds, n_folds, n_threads);
+
+    machines.resize(n_folds);
+    parallel_for(n_folds, n_threads, [&](size_t k) {
+      // copies of the trainer do not share its TrainingStats
+      const PCATrainer local(trainer);
+      Machine machine(data.extent(1), local.output_size(statistics[k][0]));
+      local.train(machine, statistics[k][0]);
+      machines[k] = machine;
+    });
+
+    std::vector<blitz::Array<double,2> > class_scores;
+    score(machines, classes, class_folds, class_scores, n_threads);
+    scores.reference(class_scores[0]);
+  }
+
+  void cross_validate(const FisherLDATrainer& trainer,
+      const std::vector<blitz::Array<double,2> >& data,
+      const std::vector<blitz::Array<int64_t,1> >& folds,
+      std::vector<Machine>& machines,
+      std::vector<blitz::Array<double,2> >& scores, size_t n_threads) {
+    const size_t n_folds = number_of_folds(data, folds);
+    const std::vector<std::vector<ScatterAccumulator> > statistics = training_statistics(data, folds, n_folds, n_threads);
+
+    machines.resize(n_folds);
+    parallel_for(n_folds, n_threads, [&](size_t k) {
+      // copies of the trainer do not share its TrainingStats
+      const FisherLDATrainer local(trainer);
+      Machine machine(data[0].extent(1), local.output_size(statistics[k]));
+      local.train(machine, statistics[k]);
+      machines[k] = machine;
+    });
+
+    score(machines, data, folds, scores, n_threads);
+  }
+
+  void cross_validate(const CGLogRegTrainer& trainer,
+      const std::vector<blitz::Array<double,2> >& data,
+      const std::vector<blitz::Array<int64_t,1> >& folds,
+      std::vector<Machine>& machines,
+      std::vector<blitz::Array<double,2> >& scores, size_t n_threads) {
+    cross_validate(trainer, data, folds, machines, scores, bob::core::info, n_threads);
+  }
+
+  void cross_validate(const CGLogRegTrainer& trainer,
+      const std::vector<blitz::Array<double,2> >& data,
+      const std::vector<blitz::Array<int64_t,1> >& folds,
+      std::vector<Machine>& machines,
+      std::vector<blitz::Array<double,2> >& scores, std::ostream& log,
+      size_t n_threads) {
+    if (data.size() != 2) {
+      boost::format m("the cross-validation of the logistic regression requires negative and positive samples, but %d classes were given");
+      m % data.size();
+      throw std::runtime_error(m.str());
+    }
+    const size_t n_folds = number_of_folds(data, folds);
+
+    machines.resize(n_folds);
+    // the log is not thread-safe, so that the messages of the solver are
+    // collected for each fold and written once all threads finished
+    std::vector<std::ostringstream> logs(n_folds);
+    parallel_for(n_folds, n_threads, [&](size_t k) {
+      const blitz::Array<double,2> negatives(gather(data[0], folds[0], k, false));
+      const blitz::Array<double,2> positives(gather(data[1], folds[1], k, false));
+      const CGLogRegTrainer local(trainer);
+      Machine machine;
+      local.train(machine, negatives, positives, CGLogRegCallback(), logs[k]);
+      machines[k] = machine;
+    });
+    for (size_t k = 0; k < n_folds; ++k) log << logs[k].str();
+
+    score(machines, data, folds, scores, n_threads);
+  }
+
+}}}
@@ -0,0 +1,695 @@
+/**
+ * @date Sun Oct 18 10:12:41 CEST 2026
+ *
+ * @brief Training and evaluation of the Geodesic Flow Kernel (GFK)
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <cmath>
+#include <utility>
+#include <thread>
+#include <exception>
+#include <boost/format.hpp>
+#include <bob.core/array_copy.h>
+#include <bob.core/logging.h>
+#include <bob.math/linear.h>
+#include <bob.math/stats.h>
+#include <bob.math/eig.h>
+
+#include <bob.learn.linear/gfk.h>
+#include <bob.learn.linear/pca.h>
+#include <bob.learn.linear/scatter.h>
+
+namespace bob { namespace learn { namespace linear {
+
+  /**
+   * Computes result = ((data - subtraction) / division) * matrix for all rows
+   * of data at once. The input normalization of the machine is folded into
+   * the (small) matrix, so that the data itself is never copied.
+   */
+  static void normalized_product(const Machine& machine,
+    const blitz::Array<double,2>& data, const blitz::Array<double,2>& matrix,
+    blitz::Array<double,2>& result)
+  {
+    const blitz::Array<double,1>& sub = machine.getInputSubtraction();
+    const blitz::Array<double,1>& div = machine.getInputDivision();
+    blitz::firstIndex i;
+    blitz::secondIndex j;
+
+    blitz::Array<double,2> scaled(matrix.shape());
+    scaled = matrix(i,j) / div(i);
+    blitz::Array<double,1> offset(matrix.extent(1));
+    offset = blitz::sum(sub(j) * scaled(j,i), j);
+
+    bob::math::prod_(data, scaled, result);
+    for (int n = result.extent(0); n--;)
+      result(n, blitz::Range::all()) -= offset;
+  }
+
+  static void check_input(const Machine& machine, const blitz::Array<double,2>& data, int dimension, const char* domain)
+  {
+    if ((int)machine.inputSize() != dimension) {
+      boost::format m("%s machine input size (%u) does not match the kernel dimension (%d)");
+      m % domain % machine.inputSize() % dimension;
+      throw std::runtime_error(m.str());
+    }
+    if (data.extent(1) != dimension) {
+      boost::format m("number of columns in %s data (%d) does not match the kernel dimension (%d)");
+      m % domain % data.extent(1) % dimension;
+      throw std::runtime_error(m.str());
+    }
+  }
+
+  static void check_output(const blitz::Array<double,2>& source, const blitz::Array<double,2>& target, const blitz::Array<double,2>& kernel)
+  {
+    if (kernel.extent(0) != source.extent(0) || kernel.extent(1) != target.extent(0)) {
+      boost::format m("kernel matrix shape (%d, %d) does not match the number of source and target samples (%d, %d)");
+      m % kernel.extent(0) % kernel.extent(1) % source.extent(0) % target.extent(0);
+      throw std::runtime_error(m.str());
+    }
+  }
+
+  void gfk_kernel(const Machine& source_machine, const Machine& target_machine,
+    const blitz::Array<double,2>& G,
+    const blitz::Array<double,2>& source, const blitz::Array<double,2>& target,
+    blitz::Array<double,2>& kernel)
+  {
+    const int dimension = G.extent(0);
+    if (G.extent(1) != dimension) {
+      boost::format m("kernel matrix G should be square, but has shape (%d, %d)");
+      m % G.extent(0) % G.extent(1);
+      throw std::runtime_error(m.str());
+    }
+    check_input(source_machine, source, dimension, "source");
+    check_input(target_machine, target, dimension, "target");
+    check_output(source, target, kernel);
+
+    // 1. Projects the normalized source data with G
+    blitz::Array<double,2> source_G(source.extent(0), dimension);
+    normalized_product(source_machine, source, G, source_G);
+
+    // 2. kernel^T = normalized target * (source * G)^T
+    blitz::Array<double,2> kernel_t = kernel.transpose(1,0);
+    normalized_product(target_machine, target, source_G.transpose(1,0), kernel_t);
+  }
+
+  void gfk_kernel(const Machine& source_machine, const Machine& target_machine,
+    const blitz::Array<double,2>& basis, const blitz::Array<double,2>& core,
+    const blitz::Array<double,2>& source, const blitz::Array<double,2>& target,
+    blitz::Array<double,2>& kernel)
+  {
+    const int dimension = basis.extent(0);
+    const int rank = basis.extent(1);
+    if (core.extent(0) != rank || core.extent(1) != rank) {
+      boost::format m("core matrix shape (%d, %d) does not match the rank of the basis (%d)");
+      m % core.extent(0) % core.extent(1) % rank;
+      throw std::runtime_error(m.str());
+    }
+    check_input(source_machine, source, dimension, "source");
+    check_input(target_machine, target, dimension, "target");
+    check_output(source, target, kernel);
+
+    // 1. Projects both normalized data sets into the space spanned by the basis
+    blitz::Array<double,2> source_projected(source.extent(0), rank);
+    blitz::Array<double,2> target_projected(target.extent(0), rank);
+    normalized_product(source_machine, source, basis, source_projected);
+    normalized_product(target_machine, target, basis, target_projected);
+
+    // 2. kernel = source_projected * core * target_projected^T
+    blitz::Array<double,2> source_core(source.extent(0), rank);
+    bob::math::prod_(source_projected, core, source_core);
+    bob::math::prod_(source_core, target_projected.transpose(1,0), kernel);
+  }
+
+  /************************ GFK Machine ************************/
+
+  GFKMachine::GFKMachine()
+  {
+  }
+
+  GFKMachine::GFKMachine(const GFKMachine& other):
+    m_source_machine(other.m_source_machine),
+    m_target_machine(other.m_target_machine),
+    m_G(bob::core::array::ccopy(other.m_G)),
+    m_basis(bob::core::array::ccopy(other.m_basis)),
+    m_core(bob::core::array::ccopy(other.m_core))
+  {
+  }
+
+  GFKMachine::GFKMachine(bob::io::base::HDF5File& config)
+  {
+    load(config);
+  }
+
+  GFKMachine::~GFKMachine() {}
+
+  GFKMachine& GFKMachine::operator=(const GFKMachine& other)
+  {
+    if (this != &other) {
+      m_source_machine = other.m_source_machine;
+      m_target_machine = other.m_target_machine;
+      m_G.reference(bob::core::array::ccopy(other.m_G));
+      m_basis.reference(bob::core::array::ccopy(other.m_basis));
+      m_core.reference(bob::core::array::ccopy(other.m_core));
+    }
+    return *this;
+  }
+
+  bool GFKMachine::operator==(const GFKMachine& other) const
+  {
+    return m_source_machine == other.m_source_machine &&
+      m_target_machine == other.m_target_machine &&
+      bob::core::array::isEqual(m_G, other.m_G) &&
+      bob::core::array::isEqual(m_basis, other.m_basis) &&
+      bob::core::array::isEqual(m_core, other.m_core);
+  }
+
+  bool GFKMachine::operator!=(const GFKMachine& other) const
+  {
+    return !(this->operator==(other));
+  }
+
+  bool GFKMachine::is_similar_to(const GFKMachine& other, const double r_epsilon, const double a_epsilon) const
+  {
+    return m_source_machine.is_similar_to(other.m_source_machine, r_epsilon, a_epsilon) &&
+      m_target_machine.is_similar_to(other.m_target_machine, r_epsilon, a_epsilon) &&
+      bob::core::array::isClose(m_G, other.m_G, r_epsilon, a_epsilon) &&
+      bob::core::array::isClose(m_basis, other.m_basis, r_epsilon, a_epsilon) &&
+      bob::core::array::isClose(m_core, other.m_core, r_epsilon, a_epsilon);
+  }
+
+  static const char* const core_blocks[] = {"B1", "B2", "B3", "B4"};
+
+  void GFKMachine::load(bob::io::base::HDF5File& config)
+  {
+    config.cd("source_machine");
+    m_source_machine.load(config);
+    config.cd("..");
+    config.cd("target_machine");
+    m_target_machine.load(config);
+    config.cd("..");
+
+    if (config.contains("G")) m_G.reference(config.readArray<double,2>("G"));
+    else m_G.resize(0,0);
+
+    if (config.hasGroup("G_factors")) {
+      config.cd("G_factors");
+      m_basis.reference(config.readArray<double,2>("basis"));
+      // the core matrix consists of four diagonal blocks
+      const int dim = m_basis.extent(1) / 2;
+      m_core.resize(2*dim, 2*dim);
+      m_core = 0.;
+      for (int b = 0; b < 4; ++b) {
+        blitz::Array<double,1> diagonal = config.readArray<double,1>(core_blocks[b]);
+        if (diagonal.extent(0) != dim) {
+          boost::format m("length of the core block '%s' (%d) does not match the basis (%d)");
+          m % core_blocks[b] % diagonal.extent(0) % dim;
+          throw std::runtime_error(m.str());
+        }
+        const int row = (b / 2) * dim, col = (b % 2) * dim;
+        for (int k = 0; k < dim; ++k) m_core(row + k, col + k) = diagonal(k);
+      }
+      config.cd("..");
+    } else {
+      m_basis.resize(0,0);
+      m_core.resize(0,0);
+    }
+  }
+
+  void GFKMachine::save(bob::io::base::HDF5File& config) const
+  {
+    config.createGroup("source_machine");
+    config.cd("source_machine");
+    m_source_machine.save(config);
+    config.cd("..");
+    config.createGroup("target_machine");
+    config.cd("target_machine");
+    m_target_machine.save(config);
+    config.cd("..");
+
+    if (m_G.size()) config.setArray("G", m_G);
+
+    if (m_basis.size()) {
+      const int dim = m_basis.extent(1) / 2;
+      config.createGroup("G_factors");
+      config.cd("G_factors");
+      config.setArray("basis", m_basis);
+      blitz::Array<double,1> diagonal(dim);
+      for (int b = 0; b < 4; ++b) {
+        const int row = (b / 2) * dim, col = (b % 2) * dim;
+        for (int k = 0; k < dim; ++k) diagonal(k) = m_core(row + k, col + k);
+        config.setArray(core_blocks[b], diagonal);
+      }
+      config.cd("..");
+    }
+  }
+
+  size_t GFKMachine::inputSize() const
+  {
+    if (m_basis.size()) return m_basis.extent(0);
+    if (m_G.size()) return m_G.extent(0);
+    return m_source_machine.inputSize();
+  }
+
+  void GFKMachine::setG(const blitz::Array<double,2>& G)
+  {
+    if (G.extent(0) != G.extent(1)) {
+      boost::format m("kernel matrix G should be square, but has shape (%d, %d)");
+      m % G.extent(0) % G.extent(1);
+      throw std::runtime_error(m.str());
+    }
+    m_G.reference(bob::core::array::ccopy(G));
+  }
+
+  void GFKMachine::setFactors(const blitz::Array<double,2>& basis, const blitz::Array<double,2>& core)
+  {
+    if (core.extent(0) != basis.extent(1) || core.extent(1) != basis.extent(1)) {
+      boost::format m("core matrix shape (%d, %d) does not match the rank of the basis (%d)");
+      m % core.extent(0) % core.extent(1) % basis.extent(1);
+      throw std::runtime_error(m.str());
+    }
+    m_basis.reference(bob::core::array::ccopy(basis));
+    m_core.reference(bob::core::array::ccopy(core));
+  }
+
+  void GFKMachine::computeG(blitz::Array<double,2>& G) const
+  {
+    if (m_G.size()) {
+      G.resize(m_G.shape());
+      G = m_G;
+    } else if (m_basis.size()) {
+      blitz::Array<double,2> basis_core(m_basis.extent(0), m_basis.extent(1));
+      bob::math::prod_(m_basis, m_core, basis_core);
+      G.resize(m_basis.extent(0), m_basis.extent(0));
+      bob::math::prod_(basis_core, m_basis.transpose(1,0), G);
+    } else {
+      throw std::runtime_error("the GFK machine does not contain a kernel matrix");
+    }
+  }
+
+  void GFKMachine::forward(const blitz::Array<double,2>& source,
+    const blitz::Array<double,2>& target,
+    blitz::Array<double,2>& kernel) const
+  {
+    if (m_basis.size())
+      gfk_kernel(m_source_machine, m_target_machine, m_basis, m_core, source, target, kernel);
+    else if (m_G.size())
+      gfk_kernel(m_source_machine, m_target_machine, m_G, source, target, kernel);
+    else
+      throw std::runtime_error("the GFK machine does not contain a kernel matrix");
+  }
+
+
+  /************************ GFK Trainer ************************/
+
+  GFKTrainer::GFKTrainer(int number_of_subspaces,
+    double subspace_dim_source, bool source_energy,
+    double subspace_dim_target, bool target_energy,
+    double eps, bool factored):
+    m_number_of_subspaces(number_of_subspaces),
+    m_subspace_dim_source(subspace_dim_source),
+    m_source_energy(source_energy),
+    m_subspace_dim_target(subspace_dim_target),
+    m_target_energy(target_energy),
+    m_eps(eps),
+    m_factored(factored)
+  {
+  }
+
+  GFKTrainer::GFKTrainer(const GFKTrainer& other):
+    m_number_of_subspaces(other.m_number_of_subspaces),
+    m_subspace_dim_source(other.m_subspace_dim_source),
+    m_source_energy(other.m_source_energy),
+    m_subspace_dim_target(other.m_subspace_dim_target),
+    m_target_energy(other.m_target_energy),
+    m_eps(other.m_eps),
+    m_factored(other.m_factored)
+  {
+  }
+
+  GFKTrainer::~GFKTrainer() {}
+
+  GFKTrainer& GFKTrainer::operator=(const GFKTrainer& other)
+  {
+    if (this != &other) {
+      m_number_of_subspaces = other.m_number_of_subspaces;
+      m_subspace_dim_source = other.m_subspace_dim_source;
+      m_source_energy = other.m_source_energy;
+      m_subspace_dim_target = other.m_subspace_dim_target;
+      m_target_energy = other.m_target_energy;
+      m_eps = other.m_eps;
+      m_factored = other.m_factored;
+    }
+    return *this;
+  }
+
+  bool GFKTrainer::operator==(const GFKTrainer& other) const
+  {
+    return m_number_of_subspaces == other.m_number_of_subspaces &&
+      m_subspace_dim_source == other.m_subspace_dim_source &&
+      m_source_energy == other.m_source_energy &&
+      m_subspace_dim_target == other.m_subspace_dim_target &&
+      m_target_energy == other.m_target_energy &&
+      m_eps == other.m_eps &&
+      m_factored == other.m_factored;
+  }
+
+  bool GFKTrainer::operator!=(const GFKTrainer& other) const
+  {
+    return !(this->operator==(other));
+  }
+
+  /**
+   * Runs the two given functions concurrently, and re-throws the first
+   * exception that occurred in any of them.
+   */
+  template <typename F1, typename F2>
+  static void run_concurrently(F1 first, F2 second)
+  {
+    std::exception_ptr second_exception;
+    std::thread second_thread([&](){
+      try {
+        second();
+      } catch (...) {
+        second_exception = std::current_exception();
+      }
+    });
+
+    try {
+      first();
+    } catch (...) {
+      second_thread.join();
+      throw;
+    }
+    second_thread.join();
+    if (second_exception) std::rethrow_exception(second_exception);
+  }
+
+  /**
+   * Accumulates mean and scatter of the given data, without copying it or
+   * creating views of its rows
+   */
+  static void domain_statistics(const blitz::Array<double,2>& data, const char* domain, ScatterAccumulator& stats)
+  {
+    if (data.extent(0) < 2) {
+      boost::format m("the %s data needs at least two samples, but has %d");
+      m % domain % data.extent(0);
+      throw std::runtime_error(m.str());
+    }
+    stats.update(data);
+  }
+
+  /**
+   * Computes the PCA projection of one domain from its statistics with the
+   * PCATrainer.
+   *
+   * The z-normalization of the data is folded into the statistics, i.e., the
+   * PCA is computed on diag(1/std) * C * diag(1/std). Either the given number
+   * of dimensions or the given fraction of the energy is kept.
+   */
+  static void domain_pca(const ScatterAccumulator& stats, bool norm_inputs,
+    double subspace_dim, bool energy, const char* domain, Machine& machine)
+  {
+    const int dim = stats.numberOfFeatures();
+    const double n = stats.numberOfSamples();
+    const blitz::Array<double,2>& scatter = stats.getScatter();
+
+    blitz::Array<double,1> deviation(dim);
+    if (norm_inputs) {
+      for (int k = 0; k < dim; ++k) {
+        deviation(k) = std::sqrt(scatter(k,k) / n);
+        // constant features are only centered
+        if (deviation(k) == 0.) deviation(k) = 1.;
+      }
+    } else {
+      deviation = 1.;
+    }
+
+    ScatterAccumulator normalized;
+    if (norm_inputs) {
+      normalized = stats;
+      normalized.scale(deviation);
+    }
+
+    // the eigen values are returned in descending order
+    const PCATrainer pca(false);
+    const ScatterAccumulator& statistics = norm_inputs ? normalized : stats;
+    const int rank = pca.output_size(statistics);
+    blitz::Array<double,1> e(rank);
+    machine.resize(dim, rank);
+    pca.train(machine, e, statistics);
+
+    int kept;
+    if (energy) {
+      const double total = blitz::sum(e);
+      double cumulated = 0.;
+      kept = rank - 1;
+      for (int k = 0; k < rank; ++k) {
+        cumulated += e(k);
+        if (cumulated / total > subspace_dim) {
+          kept = k;
+          break;
+        }
+      }
+    } else {
+      kept = (int)subspace_dim;
+      if (kept < 0 || kept > rank) {
+        boost::format m("cannot keep %d %s PCA dimensions, since the %s data has rank %d");
+        m % kept % domain % domain % rank;
+        throw std::runtime_error(m.str());
+      }
+    }
+
+    machine.resize(dim, kept);
+    if (norm_inputs) machine.setInputSubtraction(stats.getMean());
+    else machine.setInputSubtraction(0.);
+    machine.setInputDivision(std::move(deviation));
+    machine.setBiases(0.);
+  }
+
+  /**
+   * Computes the sines of the principal angles between the subspaces spanned
+   * by the orthonormal columns of A and B, starting with the smallest angle
+   */
+  static blitz::Array<double,1> principal_angle_sines(const blitz::Array<double,2>& A, const blitz::Array<double,2>& B)
+  {
+    const int k = std::min(A.extent(1), B.extent(1));
+    blitz::Array<double,1> sines(k);
+    if (!k) return sines;
+
+    // the squared singular values of A^T B are the eigenvalues of the smaller Gram matrix
+    blitz::Array<double,2> AtB(A.extent(1), B.extent(1)), gram(k, k), V(k, k);
+    bob::math::prod_(A.transpose(1,0), B, AtB);
+    if (A.extent(1) <= B.extent(1)) bob::math::prod_(AtB, AtB.transpose(1,0), gram);
+    else bob::math::prod_(AtB.transpose(1,0), AtB, gram);
+    blitz::Array<double,1> e(k);
+    bob::math::eigSym_(gram, V, e);
+    e.reverseSelf(0);
+
+    for (int n = 0; n < k; ++n) {
+      const double cosine = std::min(std::sqrt(std::max(e(n), 0.)), 1.);
+      sines(n) = std::sqrt(1. - cosine * cosine);
+    }
+    return sines;
+  }
+
+  /**
+   * Orthonormalizes the columns of Q in place (modified Gram-Schmidt).
+   * Columns that are (numerically) linearly dependent on the previous ones are
+   * replaced by the unit vector with the largest component orthogonal to the
+   * previous columns.
+   */
+  static void orthonormalize(blitz::Array<double,2>& Q, double tolerance)
+  {
+    const int rows = Q.extent(0);
+    blitz::Range all = blitz::Range::all();
+    blitz::Array<double,1> candidate(rows);
+    for (int c = 0; c < Q.extent(1); ++c) {
+      blitz::Array<double,1> q = Q(all, c);
+      for (int o = 0; o < c; ++o) {
+        blitz::Array<double,1> p = Q(all, o);
+        q -= blitz::sum(p * q) * p;
+      }
+      double norm = std::sqrt(blitz::sum(q * q));
+      if (norm <= tolerance) {
+        norm = 0.;
+        for (int k = 0; k < rows; ++k) {
+          candidate = 0.;
+          candidate(k) = 1.;
+          for (int o = 0; o < c; ++o) {
+            blitz::Array<double,1> p = Q(all, o);
+            candidate -= p(k) * p;
+          }
+          const double n = std::sqrt(blitz::sum(candidate * candidate));
+          if (n > norm) {
+            norm = n;
+            q = candidate;
+          }
+        }
+      }
+      q /= norm;
+    }
+  }
+
+  /**
+   * Computes the kernel matrix in the factored form G = basis * core * basis^T
+   * (Equation (9) of the supplementary material).
+   *
+   * The generalized SVD of [Ps^T Pt ; Rs^T Pt] shares V1, cos(theta) and V with
+   * the small SVD of Ps^T Pt, which is obtained from the eigendecomposition of
+   * (Ps^T Pt)^T (Ps^T Pt). The product with the orthogonal complement Rs of
+   * the source subspace is computed implicitly as -(Pt - Ps Ps^T Pt) V, so
+   * that no D x D matrix is formed.
+   */
+  static void kernel_factors(const blitz::Array<double,2>& source_weights,
+    const blitz::Array<double,2>& target_weights, double eps,
+    blitz::Array<double,2>& basis, blitz::Array<double,2>& core)
+  {
+    const int D = target_weights.extent(0), dim = target_weights.extent(1);
+    const double tolerance = 1e-12;
+    blitz::Range all = blitz::Range::all(), left(0, dim-1), right(dim, 2*dim-1);
+
+    // the first dim columns of [Ps, Rs]
+    blitz::Array<double,2> Ps(D, dim);
+    Ps = 0.;
+    const int available = std::min(dim, source_weights.extent(1));
+    if (available) Ps(all, blitz::Range(0, available-1)) = source_weights(all, blitz::Range(0, available-1));
+    if (available < dim) orthonormalize(Ps, tolerance);
+
+    // Ps^T Pt = V1 diag(cos(theta)) V^T
+    blitz::Array<double,2> QPt(dim, dim), gram(dim, dim), V(dim, dim);
+    blitz::Array<double,1> e(dim);
+    bob::math::prod_(Ps.transpose(1,0), target_weights, QPt);
+    bob::math::prod_(QPt.transpose(1,0), QPt, gram);
+    bob::math::eigSym_(gram, V, e);
+    V.reverseSelf(1);
+
+    // V1 diag(cos(theta)) = Ps^T Pt V and Rs V2 diag(sin(theta)) = -(Pt - Ps Ps^T Pt) V
+    blitz::Array<double,2> V1(dim, dim), residual(D, dim), RsV2(D, dim);
+    bob::math::prod_(QPt, V, V1);
+    bob::math::prod_(Ps, QPt, residual);
+    residual = target_weights - residual;
+    bob::math::prod_(residual, V, RsV2);
+    RsV2 *= -1.;
+
+    blitz::Array<double,1> theta(dim);
+    for (int k = 0; k < dim; ++k) {
+      blitz::Array<double,1> cosine = V1(all, k), sine = RsV2(all, k);
+      const double cos_theta = std::sqrt(blitz::sum(cosine * cosine));
+      const double sin_theta = std::sqrt(blitz::sum(sine * sine));
+      theta(k) = std::atan2(sin_theta, cos_theta);
+      // for identical directions (theta = 0), the corresponding blocks of B2 and B4 vanish
+      if (sin_theta > eps) sine /= sin_theta;
+      else sine = 0.;
+    }
+    // normalizes the columns of V1; for orthogonal directions (theta = pi/2), any completion is valid
+    orthonormalize(V1, tolerance);
+
+    basis.resize(D, 2*dim);
+    blitz::Array<double,2> basis_left = basis(all, left);
+    bob::math::prod_(Ps, V1, basis_left);
+    basis(all, right) = RsV2;
+
+    // Equation (6)
+    core.resize(2*dim, 2*dim);
+    core = 0.;
+    for (int k = 0; k < dim; ++k) {
+      const double t = std::max(theta(k), eps);
+      const double B1 = 0.5 * (1. + std::sin(2. * theta(k)) / (2. * t));
+      const double B2 = 0.5 * (std::cos(2. * theta(k)) - 1.) / (2. * t);
+      const double B4 = 0.5 * (1. - std::sin(2. * theta(k)) / (2. * t));
+      core(k, k) = B1;
+      core(k, dim + k) = B2;
+      core(dim + k, k) = B2;
+      core(dim + k, dim + k) = B4;
+    }
+  }
+
+  void GFKTrainer::train(GFKMachine& machine, const blitz::Array<double,2>& source,
+    const blitz::Array<double,2>& target, bool norm_inputs) const
+  {
+    if (source.extent(1) != target.extent(1)) {
+      boost::format m("number of columns in source data (%d) does not match the number of columns in target data (%d)");
+      m % source.extent(1) % target.extent(1);
+      throw std::runtime_error(m.str());
+    }
+
+    const bool automatic = m_number_of_subspaces == -1;
+    if (automatic) {
+      norm_inputs = true;
+      bob::core::info << "  -> Automatic search for d. We set norm_inputs=True" << std::endl;
+    }
+
+    // 1. mean and scatter of both domains, which are read element by element,
+    // so that source and target may share their memory
+    ScatterAccumulator source_stats, target_stats;
+    run_concurrently(
+      [&](){ domain_statistics(source, "source", source_stats); },
+      [&](){ domain_statistics(target, "target", target_stats); }
+    );
+
+    // 2. PCA of both domains
+    Machine source_machine, target_machine;
+    run_concurrently(
+      [&](){ domain_pca(source_stats, norm_inputs, m_subspace_dim_source, m_source_energy, "source", source_machine); },
+      [&](){ domain_pca(target_stats, norm_inputs, m_subspace_dim_target, m_target_energy, "target", target_machine); }
+    );
+    bob::core::info << "    ... Keeping " << source_machine.outputSize() << " source and " << target_machine.outputSize() << " target PCA dimensions" << std::endl;
+
+    // 3. the number of subspaces (section 3.4 of the paper)
+    int subspaces = m_number_of_subspaces;
+    if (automatic) {
+      bob::core::info << "  -> Computing the best value for the number of subspaces" << std::endl;
+      // the PCA of the joint data is computed from the merged statistics of both domains
+      ScatterAccumulator joint_stats(source_stats);
+      joint_stats.merge(target_stats);
+      Machine joint_machine;
+      const bool source_smaller = m_subspace_dim_source <= m_subspace_dim_target;
+      domain_pca(joint_stats, true,
+        source_smaller ? m_subspace_dim_source : m_subspace_dim_target,
+        source_smaller ? m_source_energy : m_target_energy,
+        "joint", joint_machine);
+
+      blitz::Array<double,1> alpha = principal_angle_sines(source_machine.getWeights(), joint_machine.getWeights());
+      blitz::Array<double,1> beta = principal_angle_sines(target_machine.getWeights(), joint_machine.getWeights());
+      const int candidates = std::min(alpha.extent(0), beta.extent(0));
+      double best = -1.;
+      subspaces = 0;
+      for (int k = 0; k < candidates; ++k) {
+        const double d = 0.5 * (alpha(k) + beta(k));
+        if (d > best) {
+          best = d;
+          subspaces = k;
+        }
+      }
+      // at least one subspace is required to define a kernel
+      subspaces = std::max(subspaces, 1);
+      bob::core::info << "  -> Best number of subspaces is " << subspaces << std::endl;
+    }
+
+    const int dim = std::min(subspaces, (int)target_machine.outputSize());
+    if (dim <= 0) {
+      boost::format m("cannot compute the GFK with %d subspaces, as the target PCA has %d dimensions");
+      m % subspaces % target_machine.outputSize();
+      throw std::runtime_error(m.str());
+    }
+
+    // 4. the kernel matrix
+    blitz::Array<double,2> basis, core;
+    kernel_factors(source_machine.getWeights(),
+      target_machine.getWeights()(blitz::Range::all(), blitz::Range(0, dim-1)),
+      m_eps, basis, core);
+
+    machine.setSourceMachine(source_machine);
+    machine.setTargetMachine(target_machine);
+    machine.setFactors(basis, core);
+    machine.setG(blitz::Array<double,2>());
+    if (!m_factored) {
+      blitz::Array<double,2> G;
+      machine.computeG(G);
+      machine.setG(G);
+    }
+  }
+
+}}}
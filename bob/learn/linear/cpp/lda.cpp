@@ -10,6 +10,7 @@
  * Copyright (C) Idiap Research Institute, Martigny, Switzerland
  */
 
+#include <utility>
 #include <boost/format.hpp>
 #include <bob.math/pinv.h>
 #include <bob.math/eig.h>
@@ -83,34 +84,16 @@ namespace bob { namespace learn { namespace linear {
     return idx;
   }
 
-  void FisherLDATrainer::train
-    (Machine& machine, blitz::Array<double,1>& eigen_values,
-     const std::vector<blitz::Array<double, 2> >& data) const
+  /**
+   * Checks that machine and eigen values match the given number of features
+   * and outputs
+   */
+  static void check_dimensions(const Machine& machine,
+      const blitz::Array<double,1>& eigen_values, int n_features, int osize)
     {
-      // if #classes < 2, then throw
-      if (data.size() < 2) {
-        boost::format m("The number of arrays in the input data == %d whereas for LDA you should provide at least 2");
-        m % data.size();
-        throw std::runtime_error(m.str());
-      }
-
-      // checks for arrayset data type and shape once
-      int n_features = data[0].extent(1);
-
-      for (size_t cl=0; cl<data.size(); ++cl) {
-        if (data[cl].extent(1) != n_features) {
-          boost::format m("The number of features/columns (%d) in array at position %d of your input differs from that of array at position 0 (%d)");
-          m % data[cl].extent(1) % n_features;
-          throw std::runtime_error(m.str());
-        }
-      }
-
-      int osize = output_size(data);
-
-      // Checks that the dimensions are matching
-      if (machine.inputSize() != (size_t)data[0].extent(1)) {
+      if (machine.inputSize() != (size_t)n_features) {
         boost::format m("Number of features at input data set (%d columns) does not match machine input size (%d)");
-        m % data[0].extent(1) % machine.inputSize();
+        m % n_features % machine.inputSize();
         throw std::runtime_error(m.str());
       }
       if (machine.outputSize() != (size_t)osize) {
@@ -123,24 +106,34 @@ namespace bob { namespace learn { namespace linear {
         m % eigen_values.extent(0) % osize;
         throw std::runtime_error(m.str());
       }
+    }
 
-      blitz::Array<double,1> preMean(n_features);
-      blitz::Array<double,2> Sw(n_features, n_features);
-      blitz::Array<double,2> Sb(n_features, n_features);
-      bob::math::scatters_(data, Sw, Sb, preMean);
+  /**
+   * Sets up the machine from the within-class and between-class scatter
+   * matrices; Sw and Sb are overwritten
+   */
+  static void lda_from_scatters(Machine& machine,
+      blitz::Array<double,1>& eigen_values, const blitz::Array<double,1>& preMean,
+      blitz::Array<double,2>& Sw, blitz::Array<double,2>& Sb, int osize,
+      bool use_pinv, TrainingStats::Scope& scope)
+    {
+      const int n_features = Sw.extent(0);
+      const size_t D = n_features;
 
       // computes the generalized eigenvalue decomposition
       // so to find the eigen vectors/values of Sw^(-1) * Sb
+      scope.phase("decomposition", sizeof(double) * (D*D + D));
       blitz::Array<double,2> V(Sw.shape());
       blitz::Array<double,1> eigen_values_(n_features);
 
-      if (m_use_pinv) {
+      if (use_pinv) {
 
         //note: misuse V and Sw as temporary place holders for data
         bob::math::pinv_(Sw, V); //V now contains Sw^-1
         bob::math::prod_(V, Sb, Sw); //Sw now contains Sw^-1*Sb
         blitz::Array<std::complex<double>,1> Dtemp(eigen_values_.shape());
         blitz::Array<std::complex<double>,2> Vtemp(V.shape());
+        scope.phase("decomposition", sizeof(std::complex<double>) * (D + D*D));
         bob::math::eig_(Sw, Vtemp, Dtemp); //V now contains eigen-vectors
 
         //sorting: we know this problem on has real eigen-values
@@ -156,22 +149,21 @@ namespace bob { namespace learn { namespace linear {
         bob::math::eigSym_(Sb, Sw, V, eigen_values_);
       }
 
-      // Convert ascending order to descending order
-      eigen_values_.reverseSelf(0);
-      V.reverseSelf(1);
-
-      // limit the dimensions of the resulting projection matrix and eigen values
-      eigen_values = eigen_values_(blitz::Range(0,osize-1));
-      V.resizeAndPreserve(V.extent(0), osize);
-
-      // normalizes the eigen vectors so they have unit length
+      // convert ascending order to descending order, limiting the
+      // dimensions of the resulting projection matrix and eigen values, and
+      // normalize the eigen vectors so they have unit length
+      scope.phase("truncation", sizeof(double) * D * osize);
       blitz::Range a = blitz::Range::all();
-      for (int column=0; column<V.extent(1); ++column) {
-        math::normalizeSelf(V(a,column));
+      blitz::Array<double,2> W(n_features, osize);
+      for (int column=0; column<osize; ++column) {
+        eigen_values(column) = eigen_values_(n_features-1-column);
+        W(a,column) = V(a,n_features-1-column);
+        math::normalizeSelf(W(a,column));
       }
 
-      // updates the machine
-      machine.setWeights(V);
+      // updates the machine, handing over the projection matrix
+      scope.phase("machine update");
+      machine.setWeights(std::move(W));
       machine.setInputSubtraction(preMean);
 
       // also set input_div and biases to neutral values...
@@ -179,14 +171,105 @@ namespace bob { namespace learn { namespace linear {
       machine.setBiases(0.0);
     }
 
+  void FisherLDATrainer::train
+    (Machine& machine, blitz::Array<double,1>& eigen_values,
+     const std::vector<blitz::Array<double, 2> >& data) const
+    {
+      // if #classes < 2, then throw
+      if (data.size() < 2) {
+        boost::format m("The number of arrays in the input data == %d whereas for LDA you should provide at least 2");
+        m % data.size();
+        throw std::runtime_error(m.str());
+      }
+
+      // checks for arrayset data type and shape once
+      int n_features = data[0].extent(1);
+
+      for (size_t cl=0; cl<data.size(); ++cl) {
+        if (data[cl].extent(1) != n_features) {
+          boost::format m("The number of features/columns (%d) in array at position %d of your input differs from that of array at position 0 (%d)");
+          m % data[cl].extent(1) % n_features;
+          throw std::runtime_error(m.str());
+        }
+      }
+
+      int osize = output_size(data);
+
+      // Checks that the dimensions are matching
+      check_dimensions(machine, eigen_values, n_features, osize);
+
+      TrainingStats::Scope scope(m_stats.get());
+      scope.phase("scatter", sizeof(double) * n_features * (2*n_features + 1));
+      blitz::Array<double,1> preMean(n_features);
+      blitz::Array<double,2> Sw(n_features, n_features);
+      blitz::Array<double,2> Sb(n_features, n_features);
+      bob::math::scatters_(data, Sw, Sb, preMean);
+
+      lda_from_scatters(machine, eigen_values, preMean, Sw, Sb, osize, m_use_pinv, scope);
+    }
+
+  void FisherLDATrainer::train
+    (Machine& machine, blitz::Array<double,1>& eigen_values,
+     const std::vector<ScatterAccumulator>& statistics) const
+    {
+      // if #classes < 2, then throw
+      if (statistics.size() < 2) {
+        boost::format m("The number of accumulators in the input == %d whereas for LDA you should provide at least 2");
+        m % statistics.size();
+        throw std::runtime_error(m.str());
+      }
+
+      const int n_features = statistics[0].numberOfFeatures();
+      const int osize = output_size(statistics);
+      check_dimensions(machine, eigen_values, n_features, osize);
+
+      TrainingStats::Scope scope(m_stats.get());
+      scope.phase("scatter", sizeof(double) * n_features * (2*n_features + 1));
+      blitz::Array<double,1> preMean(n_features);
+      blitz::Array<double,2> Sw(n_features, n_features);
+      blitz::Array<double,2> Sb(n_features, n_features);
+      scatters(statistics, Sw, Sb, preMean);
+
+      lda_from_scatters(machine, eigen_values, preMean, Sw, Sb, osize, m_use_pinv, scope);
+    }
+
   void FisherLDATrainer::train(Machine& machine,
       const std::vector<blitz::Array<double,2> >& data) const {
     blitz::Array<double,1> throw_away(output_size(data));
     train(machine, throw_away, data);
   }
 
+  void FisherLDATrainer::train(Machine& machine,
+      const std::vector<ScatterAccumulator>& statistics) const {
+    blitz::Array<double,1> throw_away(output_size(statistics));
+    train(machine, throw_away, statistics);
+  }
+
+  void FisherLDATrainer::train(Machine& machine,
+      blitz::Array<double,1>& eigen_values,
+      const std::vector<blitz::Array<double,2> >& data,
+      const std::vector<blitz::Array<double,1> >& weights) const {
+    // the accumulation of the weighted statistics is part of the scatter phase
+    TrainingStats::Scope scope(m_stats.get());
+    const size_t n_features = data.empty() ? 0 : data[0].extent(1);
+    scope.phase("scatter", sizeof(double) * data.size() * (n_features + n_features*n_features));
+    train(machine, eigen_values, class_statistics(data, weights));
+  }
+
+  void FisherLDATrainer::train(Machine& machine,
+      const std::vector<blitz::Array<double,2> >& data,
+      const std::vector<blitz::Array<double,1> >& weights) const {
+    blitz::Array<double,1> throw_away(output_size(data));
+    train(machine, throw_away, data, weights);
+  }
+
   size_t FisherLDATrainer::output_size(const std::vector<blitz::Array<double,2> >& data) const {
     return m_strip_to_rank ? std::min(data.size()-1, (size_t)data[0].extent(1)) : data[0].extent(1);
   }
 
+  size_t FisherLDATrainer::output_size(const std::vector<ScatterAccumulator>& statistics) const {
+    if (statistics.empty()) return 0;
+    return m_strip_to_rank ? std::min(statistics.size()-1, statistics[0].numberOfFeatures()) : statistics[0].numberOfFeatures();
+  }
+
 }}}
@@ -7,7 +7,13 @@
 
 #include <bob.core/logging.h>
 #include <bob.math/linear.h>
+#include <boost/make_shared.hpp>
+#include <algorithm>
 #include <limits>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <vector>
 
 #include <bob.learn.linear/logreg.h>
 
@@ -15,12 +21,15 @@ namespace bob { namespace learn { namespace linear {
 
   CGLogRegTrainer::CGLogRegTrainer(const double prior,
       const double convergence_threshold, const size_t max_iterations,
-      const double lambda, const bool mean_std_norm):
+      const double lambda, const bool mean_std_norm, const Solver solver,
+      const bool warm_start):
     m_prior(prior),
     m_convergence_threshold(convergence_threshold),
     m_max_iterations(max_iterations),
     m_lambda(lambda),
-    m_mean_std_norm(mean_std_norm)
+    m_mean_std_norm(mean_std_norm),
+    m_solver(solver),
+    m_warm_start(warm_start)
   {
     if(prior<=0. || prior>=1.)
     {
@@ -35,7 +44,9 @@ namespace bob { namespace learn { namespace linear {
     m_convergence_threshold(other.m_convergence_threshold),
     m_max_iterations(other.m_max_iterations),
     m_lambda(other.m_lambda),
-    m_mean_std_norm(other.m_mean_std_norm)
+    m_mean_std_norm(other.m_mean_std_norm),
+    m_solver(other.m_solver),
+    m_warm_start(other.m_warm_start)
   {
   }
 
@@ -51,6 +62,8 @@ namespace bob { namespace learn { namespace linear {
         m_max_iterations = other.m_max_iterations;
         m_lambda = other.m_lambda;
         m_mean_std_norm = other.m_mean_std_norm;
+        m_solver = other.m_solver;
+        m_warm_start = other.m_warm_start;
       }
       return *this;
     }
@@ -60,109 +73,278 @@ namespace bob { namespace learn { namespace linear {
         this->m_convergence_threshold == b.m_convergence_threshold &&
         this->m_max_iterations == b.m_max_iterations &&
         this->m_lambda == b.m_lambda &&
-        this->m_mean_std_norm == b.m_mean_std_norm);
+        this->m_mean_std_norm == b.m_mean_std_norm &&
+        this->m_solver == b.m_solver &&
+        this->m_warm_start == b.m_warm_start);
   }
 
   bool CGLogRegTrainer::operator!=(const CGLogRegTrainer& b) const {
     return !(this->operator==(b));
   }
 
-  void CGLogRegTrainer::train(Machine& machine, const blitz::Array<double,2>& negatives, const blitz::Array<double,2>& positives) const {
+  /**
+   * The design matrix of the logistic regression: one column per sample,
+   * holding the normalized sample and a trailing 1 for the bias, multiplied
+   * with the label y_i (+1 for positives, -1 for negatives)
+   */
+  class DenseLogRegDesign {
 
-    // Checks for arraysets data type and shape once
-    bob::core::array::assertSameDimensionLength(negatives.extent(1), positives.extent(1));
+    public:
 
-    // Data is checked now and conforms, just proceed w/o any further checks.
-    size_t n_samples1 = positives.extent(0);
-    size_t n_samples2 = negatives.extent(0);
-    size_t n_samples = n_samples1 + n_samples2;
-    size_t n_features = positives.extent(1);
+      DenseLogRegDesign(const blitz::Array<double,2>& x): m_x(x) {}
 
-    // Defines useful ranges
-    blitz::Range rall = blitz::Range::all();
-    blitz::Range rd = blitz::Range(0,n_features-1);
-    blitz::Range r1 = blitz::Range(0,n_samples1-1);
-    blitz::Range r2 = blitz::Range(n_samples1,n_samples-1);
+      /**
+       * z = x^T v, i.e., z(i) = y_i v^T x_i
+       */
+      void project(const blitz::Array<double,1>& v, blitz::Array<double,1>& z) const {
+        bob::math::prod(v, m_x, z);
+      }
 
-    // indices for blitz iterations
-    blitz::firstIndex i;
-    blitz::secondIndex j;
+      /**
+       * g = x r, i.e., the sum of the columns weighted with r
+       */
+      void combine(const blitz::Array<double,1>& r, blitz::Array<double,1>& g) const {
+        bob::math::prod(m_x, r, g);
+      }
 
-    blitz::Array<double,1> mean(n_features);
-    blitz::Array<double,1> std_dev(n_features);
-    // mean and variance of the training data
-    if (m_mean_std_norm){
-      // collect all samples in one matrix
-      blitz::Array<double,2> all_data(n_samples,n_features);
-      for(size_t i=0; i<n_samples1; ++i)
-        all_data(i,rall) = positives(i,rall);
-      for(size_t i=0; i<n_samples2; ++i)
-        all_data(i+n_samples1, rall) = negatives(i,rall);
+    private:
 
-      // compute mean and std-dev from samples
-      mean = blitz::mean(all_data(j,i), j);
-      blitz::Array<double,2> squared(blitz::pow2(all_data));
-      std_dev = blitz::sqrt((blitz::sum(squared(j,i), j) - n_samples*blitz::pow2(mean)) / n_samples);
-    } else {
-      mean = 0.;
-      std_dev = 1.;
+      const blitz::Array<double,2>& m_x;
+  };
+
+  /**
+   * The design matrix of the logistic regression for sparse data, see
+   * DenseLogRegDesign; the columns (x_i - mean) / std_dev are never formed,
+   * but the centering is folded into the bias, so that only the non-zero
+   * values of the samples are visited
+   */
+  class SparseLogRegDesign {
+
+    public:
+
+      SparseLogRegDesign(const CSRMatrix& negatives, const CSRMatrix& positives,
+          const blitz::Array<double,1>& mean, const blitz::Array<double,1>& std_dev):
+        m_negatives(negatives), m_positives(positives), m_mean(mean),
+        m_std_dev(std_dev), m_u(mean.extent(0))
+      {
+      }
+
+      /**
+       * z(i) = y_i (u^T x_i + c), with u = v / std_dev and c = v_D - u^T mean
+       */
+      void project(const blitz::Array<double,1>& v, blitz::Array<double,1>& z) const {
+        const int n_features = m_mean.extent(0);
+        m_u = v(blitz::Range(0,n_features-1)) / m_std_dev;
+        const double c = v(n_features) - blitz::sum(m_u * m_mean);
+        const int n_positives = m_positives.rows();
+        for (int i = 0; i < n_positives; ++i)
+          z(i) = dot(m_positives, i, m_u) + c;
+        for (int i = 0; i < (int)m_negatives.rows(); ++i)
+          z(n_positives+i) = -(dot(m_negatives, i, m_u) + c);
+      }
+
+      /**
+       * g = (sum_i r_i y_i (x_i - mean) / std_dev, sum_i r_i y_i)
+       */
+      void combine(const blitz::Array<double,1>& r, blitz::Array<double,1>& g) const {
+        const int n_features = m_mean.extent(0);
+        const blitz::Range rd(0,n_features-1);
+        g = 0.;
+        double sum = 0.;
+        const int n_positives = m_positives.rows();
+        for (int i = 0; i < n_positives; ++i) {
+          add(m_positives, i, r(i), g);
+          sum += r(i);
+        }
+        for (int i = 0; i < (int)m_negatives.rows(); ++i) {
+          add(m_negatives, i, -r(n_positives+i), g);
+          sum -= r(n_positives+i);
+        }
+        g(rd) = (g(rd) - sum * m_mean) / m_std_dev;
+        g(n_features) = sum;
+      }
+
+    private:
+
+      /**
+       * The inner product of the given row of x and u
+       */
+      static double dot(const CSRMatrix& x, int row, const blitz::Array<double,1>& u) {
+        const blitz::Array<double,1>& data = x.data();
+        const blitz::Array<int64_t,1>& indices = x.indices();
+        double result = 0.;
+        for (int64_t n = x.indptr()(row); n < x.indptr()(row+1); ++n)
+          result += data(n) * u(indices(n));
+        return result;
+      }
+
+      /**
+       * g += factor x_row
+       */
+      static void add(const CSRMatrix& x, int row, double factor, blitz::Array<double,1>& g) {
+        const blitz::Array<double,1>& data = x.data();
+        const blitz::Array<int64_t,1>& indices = x.indices();
+        for (int64_t n = x.indptr()(row); n < x.indptr()(row+1); ++n)
+          g(indices(n)) += factor * data(n);
+      }
+
+      const CSRMatrix& m_negatives;
+      const CSRMatrix& m_positives;
+      const blitz::Array<double,1>& m_mean;
+      const blitz::Array<double,1>& m_std_dev;
+      mutable blitz::Array<double,1> m_u; ///< the weights scaled by the standard deviation
+  };
+
+  /**
+   * The objective function that all solvers minimize, i.e., the
+   * prior-weighted and regularized negative log-likelihood
+   *   f(w) = sum_i weights(i) log(1 + exp(-z_i)) + lambda/2 w^T w
+   * with the margins z = x^T w + offset, where the offset contains the
+   * y_i logit(prior) values
+   */
+  template <typename Design>
+  class LogRegObjective {
+
+    public:
+
+      LogRegObjective(const Design& x, const blitz::Array<double,1>& weights,
+          const blitz::Array<double,1>& offset, double lambda):
+        m_x(x), m_weights(weights), m_offset(offset), m_lambda(lambda),
+        m_z(weights.extent(0)), m_s(weights.extent(0)), m_r(weights.extent(0))
+      {
+      }
+
+      /**
+       * Computes the gradient of f at w and, if requested, the value f(w),
+       * which is 0 otherwise. The probabilities s_i = 1 / (1 + exp(z_i)) of
+       * misclassification are kept for the products with the Hessian.
+       */
+      double evaluate(const blitz::Array<double,1>& w, blitz::Array<double,1>& gradient, bool value=true) {
+        m_x.project(w, m_z);
+        m_z += m_offset;
+        double f = 0.;
+        if (value) {
+          for (int n = 0; n < m_z.extent(0); ++n) {
+            const double z = m_z(n);
+            f += m_weights(n) * (z < 0. ? -z + log1p(exp(z)) : log1p(exp(-z)));
+          }
+          f += 0.5 * m_lambda * blitz::sum(blitz::pow2(w));
+        }
+        m_s = 1. / (1. + blitz::exp(m_z));
+        m_r = -m_s * m_weights;
+        m_x.combine(m_r, gradient);
+        gradient += m_lambda * w;
+        return f;
+      }
+
+      /**
+       * Computes v^T H v, where H is the Hessian of f at the w of the last
+       * call to evaluate()
+       */
+      double curvature(const blitz::Array<double,1>& v) {
+        m_x.project(v, m_z);
+        return blitz::sum(blitz::pow2(m_z) * m_weights * m_s * (1.-m_s)) + m_lambda * blitz::sum(blitz::pow2(v));
+      }
+
+      /**
+       * Computes Hv = x diag(weights s (1-s)) x^T v + lambda v, where H is the
+       * Hessian of f at the w of the last call to evaluate()
+       */
+      void hessian(const blitz::Array<double,1>& v, blitz::Array<double,1>& Hv) {
+        m_x.project(v, m_z);
+        m_r = m_z * m_weights * m_s * (1.-m_s);
+        m_x.combine(m_r, Hv);
+        Hv += m_lambda * v;
+      }
+
+    private:
+
+      const Design& m_x;
+      const blitz::Array<double,1>& m_weights;
+      const blitz::Array<double,1>& m_offset;
+      const double m_lambda;
+      blitz::Array<double,1> m_z; ///< the margins, or the projections in curvature() and hessian()
+      blitz::Array<double,1> m_s; ///< the probabilities of misclassification
+      blitz::Array<double,1> m_r; ///< the weights of the columns in the gradient or Hessian-vector product
+  };
+
+  /**
+   * The stopping criteria that are shared by all solvers
+   */
+  struct LogRegStopping {
+    const char* name; ///< the name of the trainer, which prefixes the messages
+    double threshold; ///< the convergence threshold on the maximum weight change
+    size_t max_iterations; ///< the maximum number of iterations; 0 for infinity
+    const CGLogRegCallback& callback; ///< the callback, which may be empty
+    std::chrono::steady_clock::time_point start; ///< the start of the training
+    std::ostream& log; ///< the stream that receives the messages
+
+    /**
+     * Calls the callback with the state after the given iteration and checks
+     * for convergence; returns true if the solver should stop
+     */
+    bool stop(size_t iteration, double objective, double gradient_norm, double change, double step) const {
+      if (callback) {
+        CGLogRegIteration state;
+        state.iteration = iteration;
+        state.objective = objective;
+        state.gradient_norm = gradient_norm;
+        state.weight_change = change;
+        state.step_size = step;
+        state.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (callback(state))
+        {
+          log << "# " << name << " Training terminated: stopped by the callback after " << iteration << " iterations." << std::endl;
+          return true;
+        }
+      }
+      // Terminates if convergence has been reached
+      if(change <= threshold)
+      {
+        log << "# " << name << " Training terminated: convergence after " << iteration << " iterations." << std::endl;
+        return true;
+      }
+      // Terminates if maximum number of iterations has been reached
+      if(max_iterations > 0 && iteration+1 >= max_iterations)
+      {
+        log << "# " << name << " terminated: maximum number of iterations (" << max_iterations << ") reached." << std::endl;
+        return true;
+      }
+      return false;
     }
+  };
 
-    // Creates a large blitz::Array containing the samples
-    // x = |positives - negatives|, of size (n_features+1,n_samples1+n_samples2)
-    //     |1.  -1. |
-    blitz::Array<double,2> x(n_features+1, n_samples);
-    x(n_features,r1) = 1.;
-    x(n_features,r2) = -1.;
-    for(size_t i=0; i<n_samples1; ++i)
-      x(rd,i) = (positives(i,rall) - mean(rall)) / std_dev(rall);
-    for(size_t i=0; i<n_samples2; ++i)
-      x(rd,i+n_samples1) = -(negatives(i,rall) - mean(rall)) / std_dev(rall);
-
-    // Ratio between the two classes and weights vector
-    double prop = (double)n_samples1 / (double)n_samples;
-    blitz::Array<double,1> weights(n_samples);
-    weights(r1) = m_prior / prop;
-    weights(r2) = (1.-m_prior) / (1.-prop);
-
-    // Initializes offset vector
-    blitz::Array<double,1> offset(n_samples);
-    const double logit = log(m_prior/(1.-m_prior));
-    offset(r1) = logit;
-    offset(r2) = -logit;
+  /**
+   * Minimizes f using nonlinear conjugate gradients with the
+   * Hestenes-Stiefel formula and a single Newton step as line search
+   */
+  template <typename Objective>
+  static void minimize_cg(Objective& f, blitz::Array<double,1>& w, const LogRegStopping& stopping) {
 
     // Initializes gradient and w vectors
-    blitz::Array<double,1> g_old(n_features+1);
-    blitz::Array<double,1> w_old(n_features+1);
-    blitz::Array<double,1> g(n_features+1);
-    blitz::Array<double,1> w(n_features+1);
+    const int d = w.extent(0);
+    blitz::Array<double,1> g_old(d);
+    blitz::Array<double,1> w_old(d);
+    blitz::Array<double,1> g(d);
     g_old = 0.;
-    w_old = 0.;
+    w_old = w;
     g = 0.;
-    w = 0.;
 
     // Initialize working arrays
-    blitz::Array<double,1> s1(n_samples);
-    blitz::Array<double,1> u(n_features+1);
-    blitz::Array<double,1> tmp_n(n_samples);
-    blitz::Array<double,1> tmp_d(n_features+1);
+    blitz::Array<double,1> u(d);
+    blitz::Array<double,1> tmp_d(d);
 
     // Iterates...
     static const double ten_epsilon = 10*std::numeric_limits<double>::epsilon();
     for(size_t iter=0; ; ++iter)
     {
-      // 1. Computes the non-weighted version of the likelihood
-      // s1 = sum_{i=1}^{n}(1./(1.+exp(-y_i (w^T x_i + logit))
-      //   where - the x blitz::Array contains -y_i x_i values
-      //         - the offset blitz::Array contains -y_i logit values
-      s1 = 1. / (1. + blitz::exp(blitz::sum(w(j)*x(j,i), j) + offset));
-      // 2. Likelihood weighted by the prior/proportion
-      tmp_n = s1 * weights;
-      // 3. Gradient g of this weighted likelihood wrt. the weight vector w
-      bob::math::prod(x, tmp_n, g);
-      g -= m_lambda * w; // Regularization
-
-      // 4. Conjugate gradient step
+      // 1. Gradient g of the weighted log-likelihood wrt. the weight vector
+      // w, i.e., the negative gradient of f; the value is only needed for
+      // the callback
+      const double objective = f.evaluate(w, g, !stopping.callback.empty());
+      g = -g;
+
+      // 2. Conjugate gradient step
       if(iter == 0)
         u = g;
       else
@@ -181,47 +363,869 @@ namespace bob { namespace learn { namespace linear {
         }
       }
 
-      // 5. Line search along the direction u
-      // a. Compute ux
-      bob::math::prod(u,x,tmp_n);
-      // b. Compute u^T H u
-      //      = sum_{i} weights(i) sigmoid(w^T x_i) [1-sigmoid(w^T x_i)] (u^T x_i) + lambda u^T u
-      double uhu = blitz::sum(blitz::pow2(tmp_n) * weights * s1 * (1.-s1)) + m_lambda*blitz::sum(blitz::pow2(u));
+      // 3. Line search along the direction u
+      // a. Compute u^T H u
+      //      = sum_{i} weights(i) sigmoid(w^T x_i) [1-sigmoid(w^T x_i)] (u^T x_i)^2 + lambda u^T u
+      double uhu = f.curvature(u);
       // Terminates if uhu is close to zero
       if(fabs(uhu) < ten_epsilon)
       {
-        bob::core::info << "# CGLogReg Training terminated: convergence after " << iter << " iterations (u^T H u == 0)." << std::endl;
+        stopping.log << "# " << stopping.name << " Training terminated: convergence after " << iter << " iterations (u^T H u == 0)." << std::endl;
         break;
       }
-      // c. Compute w = w_old - (g^T u)/(u^T H u) u
-      w = w + blitz::sum(u*g) / uhu * u;
+      // b. Compute w = w_old - (g^T u)/(u^T H u) u
+      const double step = blitz::sum(u*g) / uhu;
+      w = w + step * u;
+      const double change = blitz::max(blitz::fabs(w-w_old));
 
-      // Terminates if convergence has been reached
-      if(blitz::max(blitz::fabs(w-w_old)) <= m_convergence_threshold)
+      if (stopping.stop(iter, objective, sqrt(blitz::sum(blitz::pow2(g))), change, step)) break;
+
+      // Backup previous values
+      g_old = g;
+      w_old = w;
+    }
+  }
+
+  /**
+   * Finds a step along the descent direction p that satisfies the weak Wolfe
+   * conditions, by bisection of the bracketing interval. On success, w_new,
+   * value_new and g_new contain the new point, and the last evaluation of f
+   * is at w_new.
+   */
+  template <typename Objective>
+  static bool wolfe_search(Objective& f, const blitz::Array<double,1>& w,
+      double value, double slope, const blitz::Array<double,1>& p,
+      blitz::Array<double,1>& w_new, double& value_new,
+      blitz::Array<double,1>& g_new, double& step) {
+    static const double c1 = 1e-4, c2 = 0.9;
+    static const int max_evaluations = 40;
+    double lo = 0., hi = std::numeric_limits<double>::infinity();
+    step = 1.;
+    for (int k = 0; k < max_evaluations; ++k) {
+      w_new = w + step * p;
+      value_new = f.evaluate(w_new, g_new);
+      if (value_new > value + c1 * step * slope) hi = step; // not sufficiently decreasing
+      else if (blitz::sum(g_new * p) < c2 * slope) lo = step; // still steep
+      else return true;
+      step = std::isinf(hi) ? 2. * lo : 0.5 * (lo + hi);
+    }
+    if (lo == 0.) return false;
+    // falls back to the last step with a sufficient decrease
+    step = lo;
+    w_new = w + step * p;
+    value_new = f.evaluate(w_new, g_new);
+    return true;
+  }
+
+  /**
+   * Minimizes f using the limited-memory BFGS algorithm with a line search
+   * satisfying the weak Wolfe conditions
+   */
+  template <typename Objective>
+  static void minimize_lbfgs(Objective& f, blitz::Array<double,1>& w, const LogRegStopping& stopping) {
+
+    static const size_t memory = 10; ///< the number of kept corrections
+    const int d = w.extent(0);
+    std::deque<blitz::Array<double,1> > S, Y; ///< the last steps and gradient changes
+    std::deque<double> rho; ///< 1 / (s^T y) for each correction
+    std::vector<double> alpha(memory);
+
+    blitz::Array<double,1> g(d), p(d), w_new(d), g_new(d);
+    double value = f.evaluate(w, g);
+
+    for(size_t iter=0; ; ++iter)
+    {
+      const double gradient_norm = sqrt(blitz::sum(blitz::pow2(g)));
+      if (gradient_norm == 0.)
       {
-        bob::core::info << "# CGLogReg Training terminated: convergence after " << iter << " iterations." << std::endl;
+        stopping.log << "# " << stopping.name << " Training terminated: convergence after " << iter << " iterations (zero gradient)." << std::endl;
         break;
       }
-      // Terminates if maximum number of iterations has been reached
-      if(m_max_iterations > 0 && iter+1 >= m_max_iterations)
+
+      // 1. The search direction p = -H g, where H approximates the inverse
+      // Hessian, using the two-loop recursion; without corrections, the
+      // first step is the negative gradient, shortened to unit length
+      p = g;
+      for (size_t k = S.size(); k-- > 0;) {
+        alpha[k] = rho[k] * blitz::sum(S[k] * p);
+        p -= alpha[k] * Y[k];
+      }
+      if (S.empty()) p /= std::max(1., gradient_norm);
+      else p *= 1. / (rho.back() * blitz::sum(blitz::pow2(Y.back())));
+      for (size_t k = 0; k < S.size(); ++k) {
+        const double beta = rho[k] * blitz::sum(Y[k] * p);
+        p += (alpha[k] - beta) * S[k];
+      }
+      p = -p;
+
+      double slope = blitz::sum(g * p);
+      if (!(slope < 0.)) {
+        // restarts with the steepest descent direction
+        S.clear(); Y.clear(); rho.clear();
+        p = -g / gradient_norm;
+        slope = -gradient_norm;
+      }
+
+      // 2. Line search along p
+      double value_new, step;
+      if (!wolfe_search(f, w, value, slope, p, w_new, value_new, g_new, step))
       {
-        bob::core::info << "# CGLogReg terminated: maximum number of iterations (" << m_max_iterations << ") reached." << std::endl;
+        stopping.log << "# " << stopping.name << " Training terminated: no further decrease after " << iter << " iterations." << std::endl;
         break;
       }
 
-      // Backup previous values
-      g_old = g;
-      w_old = w;
+      // 3. Keeps the correction pair, if the curvature is positive
+      blitz::Array<double,1> s(d), y(d);
+      s = w_new - w;
+      y = g_new - g;
+      const double sy = blitz::sum(s * y);
+      if (sy > std::numeric_limits<double>::epsilon() * blitz::sum(blitz::pow2(y))) {
+        if (S.size() == memory) { S.pop_front(); Y.pop_front(); rho.pop_front(); }
+        S.push_back(s); Y.push_back(y); rho.push_back(1. / sy);
+      }
+
+      const double objective = value;
+      const double change = blitz::max(blitz::fabs(s));
+      w = w_new;
+      g = g_new;
+      value = value_new;
+
+      if (stopping.stop(iter, objective, gradient_norm, change, step)) break;
+    }
+  }
+
+  /**
+   * Minimizes f using a truncated Newton method: the Newton direction is
+   * approximated with linear conjugate gradients on Hessian-vector products,
+   * followed by a backtracking line search
+   */
+  template <typename Objective>
+  static void minimize_newton_cg(Objective& f, blitz::Array<double,1>& w, const LogRegStopping& stopping) {
+
+    static const int max_evaluations = 40;
+    const int d = w.extent(0);
+    blitz::Array<double,1> g(d), p(d), r(d), q(d), Hq(d), w_new(d), g_new(d);
+    double value = f.evaluate(w, g);
+
+    for(size_t iter=0; ; ++iter)
+    {
+      const double gradient_norm = sqrt(blitz::sum(blitz::pow2(g)));
+      if (gradient_norm == 0.)
+      {
+        stopping.log << "# " << stopping.name << " Training terminated: convergence after " << iter << " iterations (zero gradient)." << std::endl;
+        break;
+      }
+
+      // 1. Solves H p = -g up to a relative residual of min(0.5, sqrt(|g|))
+      const double tolerance = std::min(0.5, sqrt(gradient_norm)) * gradient_norm;
+      p = 0.;
+      r = -g;
+      q = r;
+      double rr = blitz::sum(blitz::pow2(r));
+      for (int k = 0; k < d; ++k) {
+        f.hessian(q, Hq);
+        const double qHq = blitz::sum(q * Hq);
+        if (qHq <= 0.) {
+          // no positive curvature along q (e.g. due to rounding errors)
+          if (k == 0) p = -g;
+          break;
+        }
+        const double a = rr / qHq;
+        p += a * q;
+        r -= a * Hq;
+        const double rr_new = blitz::sum(blitz::pow2(r));
+        if (sqrt(rr_new) <= tolerance) break;
+        q = r + (rr_new / rr) * q;
+        rr = rr_new;
+      }
+
+      // 2. Backtracking line search, starting with the Newton step
+      const double slope = blitz::sum(g * p);
+      double value_new = value, step = 1.;
+      bool decreased = false;
+      for (int k = 0; k < max_evaluations; ++k, step *= 0.5) {
+        w_new = w + step * p;
+        value_new = f.evaluate(w_new, g_new);
+        decreased = value_new <= value + 1e-4 * step * slope;
+        if (decreased) break;
+      }
+      if (!decreased)
+      {
+        stopping.log << "# " << stopping.name << " Training terminated: no further decrease after " << iter << " iterations." << std::endl;
+        break;
+      }
+
+      const double objective = value;
+      const double change = blitz::max(blitz::fabs(w_new - w));
+      w = w_new;
+      g = g_new;
+      value = value_new;
+
+      if (stopping.stop(iter, objective, gradient_norm, change, step)) break;
+    }
+  }
+
+  /**
+   * The normalized data of a two-class logistic regression, which can be
+   * shared by several trainings on the same data
+   */
+  struct LogRegProblem {
+    blitz::Array<double,2> x; ///< the design matrix of dense data, see DenseLogRegDesign
+    blitz::Array<double,1> weights; ///< the prior weights of the samples
+    blitz::Array<double,1> offset; ///< the y_i logit(prior) offsets of the samples
+    blitz::Array<double,1> mean; ///< the mean of the samples, or 0
+    blitz::Array<double,1> std_dev; ///< the standard deviation of the samples, or 1
+
+    LogRegProblem(const blitz::Array<double,2>& negatives,
+        const blitz::Array<double,2>& positives, const double prior,
+        const bool mean_std_norm) {
+
+      // Checks for arraysets data type and shape once
+      bob::core::array::assertSameDimensionLength(negatives.extent(1), positives.extent(1));
+
+      // Data is checked now and conforms, just proceed w/o any further checks.
+      size_t n_samples1 = positives.extent(0);
+      size_t n_samples2 = negatives.extent(0);
+      size_t n_samples = n_samples1 + n_samples2;
+      size_t n_features = positives.extent(1);
+
+      // Defines useful ranges
+      blitz::Range rall = blitz::Range::all();
+      blitz::Range rd = blitz::Range(0,n_features-1);
+      blitz::Range r1 = blitz::Range(0,n_samples1-1);
+      blitz::Range r2 = blitz::Range(n_samples1,n_samples-1);
+
+      // indices for blitz iterations
+      blitz::firstIndex i;
+      blitz::secondIndex j;
+
+      mean.resize(n_features);
+      std_dev.resize(n_features);
+      // mean and variance of the training data
+      if (mean_std_norm){
+        // collect all samples in one matrix
+        blitz::Array<double,2> all_data(n_samples,n_features);
+        for(size_t i=0; i<n_samples1; ++i)
+          all_data(i,rall) = positives(i,rall);
+        for(size_t i=0; i<n_samples2; ++i)
+          all_data(i+n_samples1, rall) = negatives(i,rall);
+
+        // compute mean and std-dev from samples
+        mean = blitz::mean(all_data(j,i), j);
+        blitz::Array<double,2> squared(blitz::pow2(all_data));
+        std_dev = blitz::sqrt((blitz::sum(squared(j,i), j) - n_samples*blitz::pow2(mean)) / n_samples);
+      } else {
+        mean = 0.;
+        std_dev = 1.;
+      }
+
+      // Creates a large blitz::Array containing the samples
+      // x = |positives - negatives|, of size (n_features+1,n_samples1+n_samples2)
+      //     |1.  -1. |
+      x.resize(n_features+1, n_samples);
+      x(n_features,r1) = 1.;
+      x(n_features,r2) = -1.;
+      for(size_t i=0; i<n_samples1; ++i)
+        x(rd,i) = (positives(i,rall) - mean(rall)) / std_dev(rall);
+      for(size_t i=0; i<n_samples2; ++i)
+        x(rd,i+n_samples1) = -(negatives(i,rall) - mean(rall)) / std_dev(rall);
+
+      initialize(n_samples1, n_samples2, prior);
+    }
+
+    /**
+     * Prepares sparse data, which is used through a SparseLogRegDesign
+     * instead of x
+     */
+    LogRegProblem(const CSRMatrix& negatives, const CSRMatrix& positives,
+        const double prior, const bool mean_std_norm) {
+
+      bob::core::array::assertSameDimensionLength(negatives.columns(), positives.columns());
+      const size_t n_samples = positives.rows() + negatives.rows();
+      const int n_features = positives.columns();
+
+      mean.resize(n_features);
+      std_dev.resize(n_features);
+      if (mean_std_norm) {
+        // mean and variance from the sums of the non-zero values
+        blitz::Array<double,1> squared(n_features);
+        mean = 0.;
+        squared = 0.;
+        for (const CSRMatrix* samples : {&positives, &negatives}) {
+          const blitz::Array<double,1>& data = samples->data();
+          const blitz::Array<int64_t,1>& indices = samples->indices();
+          for (int64_t n = 0; n < (int64_t)samples->nonZeros(); ++n) {
+            mean(indices(n)) += data(n);
+            squared(indices(n)) += data(n) * data(n);
+          }
+        }
+        mean /= (double)n_samples;
+        std_dev = blitz::sqrt((squared - n_samples*blitz::pow2(mean)) / n_samples);
+        // features that are zero throughout, which are common in sparse data,
+        // are not scaled
+        std_dev = blitz::where(std_dev > 0., std_dev, 1.);
+      } else {
+        mean = 0.;
+        std_dev = 1.;
+      }
+
+      initialize(positives.rows(), negatives.rows(), prior);
+    }
+
+    /**
+     * Minimizes the objective for the given design matrix with the given
+     * solver and regularization, starting from w
+     */
+    template <typename Design>
+    void minimize(const Design& design, const CGLogRegTrainer::Solver solver,
+        const double lambda, blitz::Array<double,1>& w,
+        const LogRegStopping& stopping) const {
+      LogRegObjective<Design> objective(design, weights, offset, lambda);
+      switch (solver) {
+        case CGLogRegTrainer::LBFGS: minimize_lbfgs(objective, w, stopping); break;
+        case CGLogRegTrainer::NEWTON_CG: minimize_newton_cg(objective, w, stopping); break;
+        default: minimize_cg(objective, w, stopping);
+      }
+    }
+
+    /**
+     * Sets w to the weights and bias of the given machine, expressed for the
+     * normalization of this data; w is set to 0 if the machine has another
+     * shape
+     */
+    void start(const Machine& machine, blitz::Array<double,1>& w) const {
+      const int n_features = mean.extent(0);
+      if (machine.inputSize() != (size_t)n_features || machine.outputSize() != 1) {
+        w = 0.;
+        return;
+      }
+      // w^T (x - m0) / s0 + b = (w s1 / s0)^T (x - m1) / s1 + w^T (m1 - m0) / s0 + b
+      const blitz::Array<double,1> w0 = machine.getWeights()(blitz::Range::all(), 0);
+      const blitz::Array<double,1>& m0 = machine.getInputSubtraction();
+      const blitz::Array<double,1>& s0 = machine.getInputDivision();
+      w(blitz::Range(0,n_features-1)) = w0 * std_dev / s0;
+      w(n_features) = machine.getBiases()(0) + blitz::sum(w0 * (mean - m0) / s0);
+    }
+
+    /**
+     * Updates the LinearMachine with the normalization and the weights w
+     */
+    void finalize(Machine& machine, const blitz::Array<double,1>& w) const {
+      const int n_features = mean.extent(0);
+      machine.resize(n_features, 1);
+      machine.setInputSubtraction(mean);
+      machine.setInputDivision(std_dev);
+
+      blitz::Array<double,2>& w_ = machine.updateWeights();
+      w_(blitz::Range::all(),0) = w(blitz::Range(0,n_features-1)); // Weights: first D values
+      machine.setBiases(w(n_features)); // Bias: D+1 value
     }
 
+    private:
+
+    /**
+     * Sets the prior weights and the offsets of the positive samples, which
+     * come first, and of the negative samples
+     */
+    void initialize(const size_t n_samples1, const size_t n_samples2, const double prior) {
+      const size_t n_samples = n_samples1 + n_samples2;
+      blitz::Range r1 = blitz::Range(0,n_samples1-1);
+      blitz::Range r2 = blitz::Range(n_samples1,n_samples-1);
+
+      // Ratio between the two classes and weights vector
+      double prop = (double)n_samples1 / (double)n_samples;
+      weights.resize(n_samples);
+      weights(r1) = prior / prop;
+      weights(r2) = (1.-prior) / (1.-prop);
+
+      // Initializes offset vector
+      offset.resize(n_samples);
+      const double logit = log(prior/(1.-prior));
+      offset(r1) = logit;
+      offset(r2) = -logit;
+    }
+  };
+
+  void CGLogRegTrainer::train(Machine& machine, const blitz::Array<double,2>& negatives, const blitz::Array<double,2>& positives) const {
+    train(machine, negatives, positives, CGLogRegCallback());
+  }
+
+  void CGLogRegTrainer::train(Machine& machine, const blitz::Array<double,2>& negatives, const blitz::Array<double,2>& positives, const CGLogRegCallback& callback) const {
+    train(machine, negatives, positives, callback, bob::core::info);
+  }
+
+  void CGLogRegTrainer::train(Machine& machine, const blitz::Array<double,2>& negatives, const blitz::Array<double,2>& positives, const CGLogRegCallback& callback, std::ostream& log) const {
+
+    const LogRegStopping stopping = {"CGLogReg", m_convergence_threshold, m_max_iterations, callback, std::chrono::steady_clock::now(), log};
+
+    const LogRegProblem problem(negatives, positives, m_prior, m_mean_std_norm);
+
+    // Minimizes the objective, starting from w = 0 or from the machine
+    blitz::Array<double,1> w(positives.extent(1)+1);
+    if (m_warm_start) problem.start(machine, w);
+    else w = 0.;
+    problem.minimize(DenseLogRegDesign(problem.x), m_solver, m_lambda, w, stopping);
+
+    problem.finalize(machine, w);
+  }
+
+  void CGLogRegTrainer::train(Machine& machine, const CSRMatrix& negatives, const CSRMatrix& positives) const {
+    train(machine, negatives, positives, CGLogRegCallback());
+  }
+
+  void CGLogRegTrainer::train(Machine& machine, const CSRMatrix& negatives, const CSRMatrix& positives, const CGLogRegCallback& callback) const {
+
+    const LogRegStopping stopping = {"CGLogReg", m_convergence_threshold, m_max_iterations, callback, std::chrono::steady_clock::now(), bob::core::info};
+
+    const LogRegProblem problem(negatives, positives, m_prior, m_mean_std_norm);
+
+    // Minimizes the objective, starting from w = 0 or from the machine
+    blitz::Array<double,1> w(positives.columns()+1);
+    if (m_warm_start) problem.start(machine, w);
+    else w = 0.;
+    problem.minimize(SparseLogRegDesign(negatives, positives, problem.mean, problem.std_dev), m_solver, m_lambda, w, stopping);
+
+    problem.finalize(machine, w);
+  }
+
+  void CGLogRegTrainer::trainPath(std::vector<Machine>& machines, const blitz::Array<double,2>& negatives, const blitz::Array<double,2>& positives, const std::vector<double>& lambdas) const {
+
+    const LogRegStopping stopping = {"CGLogReg", m_convergence_threshold, m_max_iterations, CGLogRegCallback(), std::chrono::steady_clock::now(), bob::core::info};
+
+    // the data is normalized only once for all regularization factors
+    const LogRegProblem problem(negatives, positives, m_prior, m_mean_std_norm);
+
+    // each solution starts from the previous one
+    blitz::Array<double,1> w(positives.extent(1)+1);
+    w = 0.;
+    machines.resize(lambdas.size());
+    for (size_t l = 0; l < lambdas.size(); ++l) {
+      problem.minimize(DenseLogRegDesign(problem.x), m_solver, lambdas[l], w, stopping);
+      problem.finalize(machines[l], w);
+    }
+  }
+
+  MiniBatchLogRegTrainer::MiniBatchLogRegTrainer(const double prior,
+      const double lambda, const bool mean_std_norm, const size_t batch_size,
+      const double learning_rate, const size_t epochs):
+    m_prior(0.5),
+    m_lambda(lambda),
+    m_mean_std_norm(mean_std_norm),
+    m_batch_size(1),
+    m_learning_rate(learning_rate),
+    m_epochs(epochs)
+  {
+    setPrior(prior);
+    setBatchSize(batch_size);
+    initialize();
+  }
+
+  MiniBatchLogRegTrainer::MiniBatchLogRegTrainer(const MiniBatchLogRegTrainer& other):
+    m_prior(other.m_prior),
+    m_lambda(other.m_lambda),
+    m_mean_std_norm(other.m_mean_std_norm),
+    m_batch_size(other.m_batch_size),
+    m_learning_rate(other.m_learning_rate),
+    m_epochs(other.m_epochs),
+    m_n_negatives(other.m_n_negatives),
+    m_n_positives(other.m_n_positives),
+    m_mean(other.m_mean.copy()),
+    m_scatter(other.m_scatter.copy()),
+    m_w(other.m_w.copy()),
+    m_moment1(other.m_moment1.copy()),
+    m_moment2(other.m_moment2.copy()),
+    m_steps(other.m_steps),
+    m_seen(other.m_seen)
+  {
+  }
+
+  MiniBatchLogRegTrainer::~MiniBatchLogRegTrainer() {}
+
+  MiniBatchLogRegTrainer& MiniBatchLogRegTrainer::operator=
+    (const MiniBatchLogRegTrainer& other)
+    {
+      if(this != &other)
+      {
+        m_prior = other.m_prior;
+        m_lambda = other.m_lambda;
+        m_mean_std_norm = other.m_mean_std_norm;
+        m_batch_size = other.m_batch_size;
+        m_learning_rate = other.m_learning_rate;
+        m_epochs = other.m_epochs;
+        m_n_negatives = other.m_n_negatives;
+        m_n_positives = other.m_n_positives;
+        m_mean.reference(other.m_mean.copy());
+        m_scatter.reference(other.m_scatter.copy());
+        m_w.reference(other.m_w.copy());
+        m_moment1.reference(other.m_moment1.copy());
+        m_moment2.reference(other.m_moment2.copy());
+        m_steps = other.m_steps;
+        m_seen = other.m_seen;
+      }
+      return *this;
+    }
+
+  bool MiniBatchLogRegTrainer::operator==(const MiniBatchLogRegTrainer& b) const {
+    return (this->m_prior == b.m_prior &&
+        this->m_lambda == b.m_lambda &&
+        this->m_mean_std_norm == b.m_mean_std_norm &&
+        this->m_batch_size == b.m_batch_size &&
+        this->m_learning_rate == b.m_learning_rate &&
+        this->m_epochs == b.m_epochs);
+  }
+
+  bool MiniBatchLogRegTrainer::operator!=(const MiniBatchLogRegTrainer& b) const {
+    return !(this->operator==(b));
+  }
+
+  void MiniBatchLogRegTrainer::setPrior(const double prior) {
+    if(prior<=0. || prior>=1.)
+    {
+      boost::format m("Prior (%f) not in the range ]0,1[.");
+      m % prior;
+      throw std::runtime_error(m.str());
+    }
+    m_prior = prior;
+  }
+
+  void MiniBatchLogRegTrainer::setBatchSize(const size_t batch_size) {
+    if (!batch_size) throw std::runtime_error("the batch size must be positive");
+    m_batch_size = batch_size;
+  }
+
+  void MiniBatchLogRegTrainer::initialize(const size_t n_features) {
+    m_n_negatives = 0;
+    m_n_positives = 0;
+    m_mean.resize(n_features);
+    m_mean = 0.;
+    m_scatter.resize(n_features);
+    m_scatter = 0.;
+    m_w.resize(n_features+1);
+    m_w = 0.;
+    m_moment1.resize(n_features+1);
+    m_moment1 = 0.;
+    m_moment2.resize(n_features+1);
+    m_moment2 = 0.;
+    m_steps = 0;
+    m_seen = 0.;
+  }
+
+  /**
+   * Adds the per-feature mean and sum of squared deviations of the given
+   * block to the ones of n samples, with the pairwise update of Chan et al.
+   */
+  static void add_moments(const blitz::Array<double,2>& block, const size_t n,
+      blitz::Array<double,1>& mean, blitz::Array<double,1>& scatter) {
+    const int m = block.extent(0);
+    if (!m) return;
+    blitz::firstIndex i;
+    blitz::secondIndex j;
+    blitz::Array<double,1> block_mean(block.extent(1));
+    block_mean = blitz::mean(block(j,i), j);
+    for (int k = 0; k < m; ++k)
+      scatter += blitz::pow2(block(k, blitz::Range::all()) - block_mean);
+    const double total = n + m;
+    blitz::Array<double,1> delta(block_mean - mean);
+    scatter += blitz::pow2(delta) * ((double)n * m / total);
+    mean += delta * (m / total);
+  }
+
+  void MiniBatchLogRegTrainer::accumulate(const blitz::Array<double,2>& negatives, const blitz::Array<double,2>& positives) {
+    bob::core::array::assertSameDimensionLength(negatives.extent(1), positives.extent(1));
+    if (m_steps)
+      throw std::runtime_error("all chunks must be accumulated before the first update");
+
+    const int n_features = positives.extent(1);
+    if (!m_mean.extent(0) && !m_n_negatives && !m_n_positives)
+      // the first chunk defines the dimensionality
+      initialize(n_features);
+    else if (n_features != m_mean.extent(0)) {
+      boost::format m("the dimensionality of the samples (%d) does not match the dimensionality of the trainer (%d)");
+      m % n_features % m_mean.extent(0);
+      throw std::runtime_error(m.str());
+    }
+
+    add_moments(negatives, m_n_negatives + m_n_positives, m_mean, m_scatter);
+    m_n_negatives += negatives.extent(0);
+    add_moments(positives, m_n_negatives + m_n_positives, m_mean, m_scatter);
+    m_n_positives += positives.extent(0);
+  }
+
+  void MiniBatchLogRegTrainer::normalization(blitz::Array<double,1>& mean, blitz::Array<double,1>& std_dev) const {
+    if (m_mean_std_norm) {
+      mean = m_mean;
+      std_dev = blitz::sqrt(m_scatter / (double)(m_n_negatives + m_n_positives));
+    } else {
+      mean = 0.;
+      std_dev = 1.;
+    }
+  }
+
+  double MiniBatchLogRegTrainer::update(const blitz::Array<double,2>& negatives, const blitz::Array<double,2>& positives) {
+    if (!m_n_negatives || !m_n_positives)
+      throw std::runtime_error("the statistics of samples of both classes must be accumulated before the first update");
+    const int n_features = m_mean.extent(0);
+    bob::core::array::assertSameDimensionLength(negatives.extent(1), n_features);
+    bob::core::array::assertSameDimensionLength(positives.extent(1), n_features);
+
+    const double n_samples = m_n_negatives + m_n_positives;
+    blitz::Array<double,1> mean(n_features);
+    blitz::Array<double,1> std_dev(n_features);
+    normalization(mean, std_dev);
+
+    // Ratio between the two classes and weights, as in the CGLogRegTrainer
+    const double prop = m_n_positives / n_samples;
+    const double weight_p = m_prior / prop;
+    const double weight_n = (1.-m_prior) / (1.-prop);
+    const double logit = log(m_prior/(1.-m_prior));
+
+    static const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+    blitz::Range rd = blitz::Range(0,n_features-1);
+    blitz::Range rall = blitz::Range::all();
+    blitz::Array<double,1> x(n_features+1);
+    blitz::Array<double,1> g(n_features+1);
+    double loss = 0.;
+
+    // Adds the gradient of the sample, with x = y [(sample-mean)/std_dev, 1],
+    // to g and returns its weighted negative log-likelihood
+    auto add_sample = [&](const blitz::Array<double,1>& sample, double y, double weight) -> double {
+      x(rd) = y * (sample - mean) / std_dev;
+      x(n_features) = y;
+      const double z = blitz::sum(x * m_w) + y * logit;
+      g -= (weight / (1. + exp(z))) * x;
+      return weight * (z < 0. ? -z + log1p(exp(z)) : log1p(exp(-z)));
+    };
+
+    // Each mini-batch takes the same share of the positives and negatives
+    const long n_p = positives.extent(0), n_n = negatives.extent(0);
+    const long n_batches = std::max<long>(1, (n_p + n_n + m_batch_size - 1) / m_batch_size);
+    for (long b = 0; b < n_batches; ++b) {
+      const long p_begin = b * n_p / n_batches, p_end = (b+1) * n_p / n_batches;
+      const long n_begin = b * n_n / n_batches, n_end = (b+1) * n_n / n_batches;
+      const double size = (p_end - p_begin) + (n_end - n_begin);
+      if (!size) continue;
+
+      // Gradient of the objective divided by the number of samples
+      g = 0.;
+      for (long k = p_begin; k < p_end; ++k)
+        loss += add_sample(positives(k,rall), 1., weight_p);
+      for (long k = n_begin; k < n_end; ++k)
+        loss += add_sample(negatives(k,rall), -1., weight_n);
+      g /= size;
+      g += (m_lambda / n_samples) * m_w;
+
+      // Adam step, with a learning rate decaying with the number of epochs
+      ++m_steps;
+      m_moment1 = beta1 * m_moment1 + (1.-beta1) * g;
+      m_moment2 = beta2 * m_moment2 + (1.-beta2) * blitz::pow2(g);
+      const double rate = m_learning_rate / sqrt(1. + m_seen / n_samples);
+      const double correction1 = 1. - pow(beta1, (double)m_steps);
+      const double correction2 = 1. - pow(beta2, (double)m_steps);
+      m_w -= rate * (m_moment1 / correction1) / (blitz::sqrt(m_moment2 / correction2) + epsilon);
+      m_seen += size;
+    }
+
+    return (n_p + n_n) ? loss / (n_p + n_n) : 0.;
+  }
+
+  void MiniBatchLogRegTrainer::finalize(Machine& machine) const {
+    const int n_features = m_mean.extent(0);
+    if (!n_features)
+      throw std::runtime_error("the trainer has not seen any samples");
+
+    blitz::Array<double,1> mean(n_features);
+    blitz::Array<double,1> std_dev(n_features);
+    normalization(mean, std_dev);
+
     // Updates the LinearMachine
     machine.resize(n_features, 1);
     machine.setInputSubtraction(mean);
     machine.setInputDivision(std_dev);
 
+    blitz::Range rall = blitz::Range::all();
     blitz::Array<double,2>& w_ = machine.updateWeights();
-    w_(rall,0) = w(rd); // Weights: first D values
-    machine.setBiases(w(n_features)); // Bias: D+1 value
+    w_(rall,0) = m_w(blitz::Range(0,n_features-1)); // Weights: first D values
+    machine.setBiases(m_w(n_features)); // Bias: D+1 value
+  }
+
+  void MiniBatchLogRegTrainer::train(Machine& machine, const blitz::Array<double,2>& negatives, const blitz::Array<double,2>& positives) {
+    initialize(positives.extent(1));
+    accumulate(negatives, positives);
+    for (size_t epoch = 0; epoch < m_epochs; ++epoch)
+      update(negatives, positives);
+    bob::core::info << "# MiniBatchLogReg Training terminated after " << m_epochs << " epochs (" << m_steps << " steps)." << std::endl;
+    finalize(machine);
+  }
+
+
+  MultinomialLogRegTrainer::MultinomialLogRegTrainer(
+      const double convergence_threshold, const size_t max_iterations,
+      const double lambda, const bool mean_std_norm):
+    m_convergence_threshold(convergence_threshold),
+    m_max_iterations(max_iterations),
+    m_lambda(lambda),
+    m_mean_std_norm(mean_std_norm)
+  {
+  }
+
+  MultinomialLogRegTrainer::MultinomialLogRegTrainer(const MultinomialLogRegTrainer& other):
+    m_convergence_threshold(other.m_convergence_threshold),
+    m_max_iterations(other.m_max_iterations),
+    m_lambda(other.m_lambda),
+    m_mean_std_norm(other.m_mean_std_norm)
+  {
+  }
+
+  MultinomialLogRegTrainer::~MultinomialLogRegTrainer() {}
+
+  MultinomialLogRegTrainer& MultinomialLogRegTrainer::operator=
+    (const MultinomialLogRegTrainer& other)
+    {
+      if(this != &other)
+      {
+        m_convergence_threshold = other.m_convergence_threshold;
+        m_max_iterations = other.m_max_iterations;
+        m_lambda = other.m_lambda;
+        m_mean_std_norm = other.m_mean_std_norm;
+      }
+      return *this;
+    }
+
+  bool MultinomialLogRegTrainer::operator==(const MultinomialLogRegTrainer& b) const {
+    return (this->m_convergence_threshold == b.m_convergence_threshold &&
+        this->m_max_iterations == b.m_max_iterations &&
+        this->m_lambda == b.m_lambda &&
+        this->m_mean_std_norm == b.m_mean_std_norm);
+  }
+
+  bool MultinomialLogRegTrainer::operator!=(const MultinomialLogRegTrainer& b) const {
+    return !(this->operator==(b));
+  }
+
+  /**
+   * The regularized negative log-likelihood of the multinomial logistic
+   * regression
+   *   f(W) = sum_i [log(sum_k exp(z_ik)) - z_iy_i] + lambda/2 |W|^2
+   * with the margins Z = x W of all classes, where the rows of x are the
+   * normalized samples with a trailing 1 for the biases. The weights W of
+   * size (n_features+1, n_classes) are stored row by row in a vector, so that
+   * the vector solvers can be used.
+   */
+  class MultinomialLogRegObjective {
+
+    public:
+
+      MultinomialLogRegObjective(const blitz::Array<double,2>& x,
+          const blitz::Array<int,1>& labels, int n_classes, double lambda):
+        m_x(x), m_labels(labels), m_lambda(lambda),
+        m_z(x.extent(0), n_classes)
+      {
+      }
+
+      /**
+       * Computes the value and the gradient of f at w; both are always
+       * computed, as they share the probabilities
+       */
+      double evaluate(const blitz::Array<double,1>& w, blitz::Array<double,1>& gradient, bool /*value*/=true) {
+        const blitz::TinyVector<int,2> shape(m_x.extent(1), m_z.extent(1));
+        const blitz::Array<double,2> W(const_cast<double*>(w.data()), shape, blitz::neverDeleteData);
+        blitz::Array<double,2> G(gradient.data(), shape, blitz::neverDeleteData);
+
+        // the margins of all classes in a single product
+        bob::math::prod_(m_x, W, m_z);
+
+        // replaces the margins with the probabilities minus the targets
+        double f = 0.;
+        blitz::Range rall = blitz::Range::all();
+        for (int n = 0; n < m_z.extent(0); ++n) {
+          blitz::Array<double,1> z = m_z(n, rall);
+          const double top = blitz::max(z);
+          f -= z(m_labels(n)) - top;
+          z = blitz::exp(z - top);
+          const double sum = blitz::sum(z);
+          f += log(sum);
+          z /= sum;
+          z(m_labels(n)) -= 1.;
+        }
+
+        bob::math::prod_(m_x.transpose(1,0), m_z, G);
+        G += m_lambda * W;
+        return f + 0.5 * m_lambda * blitz::sum(blitz::pow2(W));
+      }
+
+    private:
+
+      const blitz::Array<double,2>& m_x;
+      const blitz::Array<int,1>& m_labels;
+      const double m_lambda;
+      blitz::Array<double,2> m_z; ///< the margins, and then the residuals of the probabilities
+  };
+
+  void MultinomialLogRegTrainer::train(Machine& machine, const std::vector<blitz::Array<double,2> >& data) const {
+    train(machine, data, CGLogRegCallback());
+  }
+
+  void MultinomialLogRegTrainer::train(Machine& machine, const std::vector<blitz::Array<double,2> >& data, const CGLogRegCallback& callback) const {
+
+    const LogRegStopping stopping = {"MultinomialLogReg", m_convergence_threshold, m_max_iterations, callback, std::chrono::steady_clock::now(), bob::core::info};
+
+    if (data.size() < 2)
+      throw std::runtime_error("multinomial logistic regression requires the data of at least two classes");
+
+    const int n_classes = data.size();
+    const int n_features = data[0].extent(1);
+    int n_samples = 0;
+    for (size_t k = 0; k < data.size(); ++k) {
+      bob::core::array::assertSameDimensionLength(data[k].extent(1), n_features);
+      n_samples += data[k].extent(0);
+    }
+
+    blitz::Range rall = blitz::Range::all();
+    blitz::Range rd = blitz::Range(0,n_features-1);
+
+    // mean and standard deviation of the training data
+    blitz::Array<double,1> mean(n_features);
+    blitz::Array<double,1> std_dev(n_features);
+    mean = 0.;
+    std_dev = 1.;
+    if (m_mean_std_norm) {
+      blitz::firstIndex i;
+      blitz::secondIndex j;
+      for (size_t k = 0; k < data.size(); ++k)
+        mean += blitz::sum(data[k](j,i), j);
+      mean /= n_samples;
+      std_dev = 0.;
+      for (size_t k = 0; k < data.size(); ++k)
+        for (int n = 0; n < data[k].extent(0); ++n)
+          std_dev += blitz::pow2(data[k](n,rall) - mean);
+      std_dev = blitz::sqrt(std_dev / n_samples);
+    }
+
+    // Creates a large blitz::Array containing the normalized samples in its
+    // rows, followed by a 1 for the biases, and the labels
+    blitz::Array<double,2> x(n_samples, n_features+1);
+    blitz::Array<int,1> labels(n_samples);
+    x(rall,n_features) = 1.;
+    for (int k = 0, n = 0; k < n_classes; ++k)
+      for (int s = 0; s < data[k].extent(0); ++s, ++n) {
+        x(n,rd) = (data[k](s,rall) - mean) / std_dev;
+        labels(n) = k;
+      }
+
+    // Minimizes the objective, starting from W = 0
+    MultinomialLogRegObjective objective(x, labels, n_classes, m_lambda);
+    blitz::Array<double,1> w((n_features+1) * n_classes);
+    w = 0.;
+    minimize_lbfgs(objective, w, stopping);
+    const blitz::Array<double,2> W(w.data(), blitz::shape(n_features+1, n_classes), blitz::neverDeleteData);
+
+    // Updates the LinearMachine
+    machine.resize(n_features, n_classes);
+    machine.setInputSubtraction(mean);
+    machine.setInputDivision(std_dev);
+    machine.updateWeights() = W(rd,rall); // Weights: first D rows
+    machine.setBiases(W(n_features,rall).copy()); // Biases: D+1 row
+    machine.setActivation(boost::make_shared<bob::learn::activation::IdentityActivation>());
   }
 
 }}}
@@ -8,16 +8,93 @@
  */
 
 #include <cmath>
+#include <algorithm>
+#include <vector>
+#include <sys/stat.h>
+#include <hdf5.h>
 #include <boost/make_shared.hpp>
 #include <boost/format.hpp>
 
 #include <bob.core/array_copy.h>
+#include <bob.core/logging.h>
 #include <bob.math/linear.h>
 
 #include <bob.learn.linear/machine.h>
+#include <bob.learn.linear/bundle.h>
 
 namespace bob { namespace learn { namespace linear {
 
+  /**
+   * Returns the identifier of the given file as it is currently opened in
+   * this process (e.g., by a bob::io::base::HDF5File), or a negative value.
+   * The identifier is not owned by the caller.
+   */
+  static hid_t open_file(const std::string& filename) {
+
+    hid_t file = -1;
+    ssize_t count = H5Fget_obj_count(H5F_OBJ_ALL, H5F_OBJ_FILE);
+    if (count <= 0) return file;
+    std::vector<hid_t> ids(count);
+    count = H5Fget_obj_ids(H5F_OBJ_ALL, H5F_OBJ_FILE, ids.size(), &ids[0]);
+    for (ssize_t i = 0; i < count && file < 0; ++i) {
+      const ssize_t length = H5Fget_name(ids[i], 0, 0);
+      if (length <= 0) continue;
+      std::vector<char> name(length + 1);
+      if (H5Fget_name(ids[i], &name[0], name.size()) == length && filename == &name[0])
+        file = ids[i];
+    }
+    return file;
+  }
+
+  /**
+   * Checks that the 2D dataset at the given path of the given open file
+   * holds native doubles, stored contiguously and without filters, so that
+   * its raw data can be mapped into memory. Returns the shape and the byte
+   * offset of the data in the file, together with the status of the file
+   * that HDF5 reads, or false if the dataset cannot be mapped.
+   */
+  static bool mappable_dataset(const std::string& filename,
+      const std::string& path, hsize_t* shape, haddr_t& offset,
+      struct stat& status) {
+
+    // disables the HDF5 error stack while probing
+    H5E_auto2_t error_function;
+    void* error_data;
+    H5Eget_auto2(H5E_DEFAULT, &error_function, &error_data);
+    H5Eset_auto2(H5E_DEFAULT, 0, 0);
+
+    // uses the handle of the HDF5File instead of opening the file again
+    bool mappable = false;
+    hid_t file = open_file(filename);
+    void* handle = 0;
+    if (file >= 0 && H5Fget_vfd_handle(file, H5P_DEFAULT, &handle) >= 0 &&
+        handle && ::fstat(*static_cast<int*>(handle), &status) == 0) {
+      // makes sure that the data has been written to disk
+      H5Fflush(file, H5F_SCOPE_GLOBAL);
+      hid_t dataset = H5Dopen2(file, path.c_str(), H5P_DEFAULT);
+      if (dataset >= 0) {
+        hid_t type = H5Dget_type(dataset);
+        hid_t space = H5Dget_space(dataset);
+        hid_t plist = H5Dget_create_plist(dataset);
+        offset = H5Dget_offset(dataset);
+        mappable = type >= 0 && space >= 0 && plist >= 0 &&
+          H5Tequal(type, H5T_NATIVE_DOUBLE) > 0 &&
+          H5Sget_simple_extent_ndims(space) == 2 &&
+          H5Sget_simple_extent_dims(space, shape, 0) == 2 &&
+          H5Pget_layout(plist) == H5D_CONTIGUOUS &&
+          H5Pget_nfilters(plist) == 0 &&
+          offset != HADDR_UNDEF && offset % sizeof(double) == 0;
+        if (plist >= 0) H5Pclose(plist);
+        if (space >= 0) H5Sclose(space);
+        if (type >= 0) H5Tclose(type);
+        H5Dclose(dataset);
+      }
+    }
+
+    H5Eset_auto2(H5E_DEFAULT, error_function, error_data);
+    return mappable;
+  }
+
   Machine::Machine(const blitz::Array<double,2>& weight)
     : m_input_sub(weight.extent(0)),
     m_input_div(weight.extent(0)),
@@ -28,44 +105,64 @@ namespace bob { namespace learn { namespace linear {
     m_input_sub = 0.0;
     m_input_div = 1.0;
     m_bias = 0.0;
-    m_weight.reference(bob::core::array::ccopy(weight));
+    blitz::Array<double,2> copy(bob::core::array::ccopy(weight));
+    own(copy);
+  }
+
+  Machine::Machine(blitz::Array<double,2>&& weight)
+    : m_input_sub(weight.extent(0)),
+    m_input_div(weight.extent(0)),
+    m_bias(weight.extent(1)),
+    m_activation(boost::make_shared<bob::learn::activation::IdentityActivation>()),
+    m_buffer(weight.extent(0))
+  {
+    m_input_sub = 0.0;
+    m_input_div = 1.0;
+    m_bias = 0.0;
+    own(weight);
   }
 
   Machine::Machine():
     m_input_sub(0),
     m_input_div(0),
-    m_weight(0, 0),
     m_bias(0),
     m_activation(boost::make_shared<bob::learn::activation::IdentityActivation>()),
     m_buffer(0)
   {
+    blitz::Array<double,2> weight(0, 0);
+    own(weight);
   }
 
   Machine::Machine(size_t n_input, size_t n_output):
     m_input_sub(n_input),
     m_input_div(n_input),
-    m_weight(n_input, n_output),
     m_bias(n_output),
     m_activation(boost::make_shared<bob::learn::activation::IdentityActivation>()),
     m_buffer(n_input)
   {
     m_input_sub = 0.0;
     m_input_div = 1.0;
-    m_weight = 0.0;
     m_bias = 0.0;
+    blitz::Array<double,2> weight(n_input, n_output);
+    weight = 0.0;
+    own(weight);
   }
 
   Machine::Machine(const Machine& other):
     m_input_sub(bob::core::array::ccopy(other.m_input_sub)),
     m_input_div(bob::core::array::ccopy(other.m_input_div)),
-    m_weight(bob::core::array::ccopy(other.m_weight)),
+    m_weight(other.m_weight), //shares the data, see detach()
+    m_storage(other.m_storage),
+    m_mapped(other.m_mapped),
     m_bias(bob::core::array::ccopy(other.m_bias)),
     m_activation(other.m_activation),
     m_buffer(m_input_sub.shape())
   {
   }
 
-  Machine::Machine (bob::io::base::HDF5File& config) {
+  Machine::Machine (bob::io::base::HDF5File& config):
+    m_mapped(false)
+  {
     load(config);
   }
 
@@ -77,7 +174,9 @@ namespace bob { namespace learn { namespace linear {
       {
         m_input_sub.reference(bob::core::array::ccopy(other.m_input_sub));
         m_input_div.reference(bob::core::array::ccopy(other.m_input_div));
-        m_weight.reference(bob::core::array::ccopy(other.m_weight));
+        m_weight.reference(other.m_weight);
+        m_storage = other.m_storage;
+        m_mapped = other.m_mapped;
         m_bias.reference(bob::core::array::ccopy(other.m_bias));
         m_activation = other.m_activation;
         m_buffer.resize(m_input_sub.shape());
@@ -106,13 +205,35 @@ namespace bob { namespace learn { namespace linear {
         m_activation->str() == b.m_activation->str());
   }
 
-  void Machine::load (bob::io::base::HDF5File& config) {
+  void Machine::load (bob::io::base::HDF5File& config, bool map_weights) {
 
     //reads all data directly into the member variables
     m_input_sub.reference(config.readArray<double,1>("input_sub"));
     m_input_div.reference(config.readArray<double,1>("input_div"));
-    m_weight.reference(config.readArray<double,2>("weights"));
     m_bias.reference(config.readArray<double,1>("biases"));
+
+    //maps the weights from the file, if possible; the previous weights are
+    //released once no other machine refers to them
+    boost::shared_ptr<const char> mapping;
+    if (map_weights) {
+      const std::string path = config.cwd() == "/" ? "/weights" : config.cwd() + "/weights";
+      hsize_t shape[2];
+      haddr_t offset;
+      struct stat status;
+      if (mappable_dataset(config.filename(), path, shape, offset, status) && shape[0] && shape[1])
+        mapping = map_file(config.filename(), offset, shape[0] * shape[1] * sizeof(double), &status);
+      if (mapping) {
+        mapWeights(blitz::Array<double,2>(const_cast<double*>(reinterpret_cast<const double*>(mapping.get())),
+              blitz::shape(shape[0], shape[1]), blitz::neverDeleteData), mapping);
+      }
+      else {
+        bob::core::warn << "The weights of the machine in '" << config.filename() << ":" << path << "' cannot be memory-mapped; reading them instead" << std::endl;
+      }
+    }
+    if (!mapping) {
+      blitz::Array<double,2> weight(config.readArray<double,2>("weights"));
+      own(weight);
+    }
     m_buffer.resize(m_input_sub.extent(0));
 
     //switch between different versions - support for version 1
@@ -128,14 +249,64 @@ namespace bob { namespace learn { namespace linear {
 
   }
 
+  void Machine::own (blitz::Array<double,2>& weight) {
+
+    // the owner holds the only blitz reference to the memory block, so that
+    // copies of this machine never modify its (non-atomic) reference count
+    boost::shared_ptr<blitz::Array<double,2> > storage = boost::make_shared<blitz::Array<double,2> >();
+    take_or_copy(*storage, weight);
+    weight.free();
+    m_weight.reference(blitz::Array<double,2>(storage->data(), storage->shape(), blitz::neverDeleteData));
+    m_storage = storage;
+    m_mapped = false;
+
+  }
+
+  void Machine::detach () {
+
+    // weights with more than one owner (other machines, or views handed out
+    // to Python) are copied on write; copying mapped weights releases this
+    // machine's reference to the mapping
+    if (m_mapped || m_storage.use_count() > 1) {
+      blitz::Array<double,2> copy(bob::core::array::ccopy(m_weight));
+      own(copy);
+    }
+
+  }
+
+  void Machine::mapWeights (const blitz::Array<double,2>& weight,
+      const boost::shared_ptr<const void>& mapping) {
+
+    m_weight.reference(weight);
+    m_storage = mapping;
+    m_mapped = true;
+    m_input_sub.resizeAndPreserve(weight.extent(0));
+    m_input_div.resizeAndPreserve(weight.extent(0));
+    m_buffer.resizeAndPreserve(weight.extent(0));
+    m_bias.resizeAndPreserve(weight.extent(1));
+
+  }
+
   void Machine::resize (size_t input, size_t output) {
 
+    if (input == inputSize() && output == outputSize()) {
+      detach();
+      return;
+    }
+    const int rows = std::min(input, inputSize()), columns = std::min(output, outputSize());
     m_input_sub.resizeAndPreserve(input);
     m_input_div.resizeAndPreserve(input);
     m_buffer.resizeAndPreserve(input);
-    m_weight.resizeAndPreserve(input, output);
     m_bias.resizeAndPreserve(output);
 
+    // the preserved weights are copied into memory owned by this machine
+    blitz::Array<double,2> weight(input, output);
+    if (rows && columns) {
+      const blitz::Range r(0, rows-1), c(0, columns-1);
+      weight(r,c) = m_weight(r,c);
+    }
+    own(weight);
+
   }
 
   void Machine::save (bob::io::base::HDF5File& config) const {
@@ -177,8 +348,55 @@ namespace bob { namespace learn { namespace linear {
 
   }
 
+  void Machine::forward_ (const CSRMatrix& input, blitz::Array<double,2>& output) const {
+
+    // ((x - sub) / div) W + b = x (W / div) + (b - (sub / div) W), where only
+    // the non-zero values of x contribute to the first term
+    const int n_outputs = m_weight.extent(1);
+    blitz::firstIndex i;
+    blitz::secondIndex j;
+    blitz::Array<double,1> offset(n_outputs);
+    offset = m_bias - blitz::sum(m_input_sub(j) / m_input_div(j) * m_weight(j,i), j);
+
+    const blitz::Array<double,1>& data = input.data();
+    const blitz::Array<int64_t,1>& indices = input.indices();
+    const blitz::Array<int64_t,1>& indptr = input.indptr();
+    for (int row = 0; row < output.extent(0); ++row) {
+      for (int o = 0; o < n_outputs; ++o) output(row,o) = offset(o);
+      for (int64_t n = indptr(row); n < indptr(row+1); ++n) {
+        const int column = indices(n);
+        const double value = data(n) / m_input_div(column);
+        for (int o = 0; o < n_outputs; ++o) output(row,o) += value * m_weight(column,o);
+      }
+      for (int o = 0; o < n_outputs; ++o) output(row,o) = m_activation->f(output(row,o));
+    }
+
+  }
+
+  void Machine::forward (const CSRMatrix& input, blitz::Array<double,2>& output) const {
+
+    if ((size_t)m_weight.extent(0) != input.columns()) { //checks input dimension
+      boost::format m("mismatch on the input dimension: expected a sparse matrix with %d columns, but you input one with %d columns instead");
+      m % m_weight.extent(0) % input.columns();
+      throw std::runtime_error(m.str());
+    }
+    if (m_weight.extent(1) != output.extent(1) || (size_t)output.extent(0) != input.rows()) { //checks output dimension
+      boost::format m("mismatch on the output dimension: expected an array of shape (%d,%d), but you input one with shape (%d,%d) instead");
+      m % input.rows() % m_weight.extent(1) % output.extent(0) % output.extent(1);
+      throw std::runtime_error(m.str());
+    }
+    forward_(input, output);
+
+  }
+
   void Machine::setWeights (const blitz::Array<double,2>& weight) {
 
+    setWeights(bob::core::array::ccopy(weight));
+
+  }
+
+  void Machine::setWeights (blitz::Array<double,2>&& weight) {
+
     if (weight.extent(0) != m_input_sub.extent(0)) { //checks 1st dimension
       boost::format m("mismatch on the weight shape (number of rows): expected a weight matrix with %d row(s), but you input one with %d row(s) instead");
       m % m_input_sub.extent(0) % weight.extent(0);
@@ -189,40 +407,58 @@ namespace bob { namespace learn { namespace linear {
       m % m_bias.extent(0) % weight.extent(1);
       throw std::runtime_error(m.str());
     }
-    m_weight.reference(bob::core::array::ccopy(weight));
+    own(weight);
 
   }
 
   void Machine::setBiases (const blitz::Array<double,1>& bias) {
 
+    setBiases(bob::core::array::ccopy(bias));
+
+  }
+
+  void Machine::setBiases (blitz::Array<double,1>&& bias) {
+
     if (m_weight.extent(1) != bias.extent(0)) {
       boost::format m("mismatch on the bias shape: expected a vector of size %d, but you input one with size = %d instead");
       m % m_weight.extent(1) % bias.extent(0);
       throw std::runtime_error(m.str());
     }
-    m_bias.reference(bob::core::array::ccopy(bias));
+    take_or_copy(m_bias, bias);
 
   }
 
   void Machine::setInputSubtraction (const blitz::Array<double,1>& v) {
 
+    setInputSubtraction(bob::core::array::ccopy(v));
+
+  }
+
+  void Machine::setInputSubtraction (blitz::Array<double,1>&& v) {
+
     if (m_weight.extent(0) != v.extent(0)) {
       boost::format m("mismatch on the input subtraction shape: expected a vector of size %d, but you input one with size = %d instead");
       m % m_weight.extent(0) % v.extent(0);
       throw std::runtime_error(m.str());
     }
-    m_input_sub.reference(bob::core::array::ccopy(v));
+    take_or_copy(m_input_sub, v);
 
   }
 
   void Machine::setInputDivision (const blitz::Array<double,1>& v) {
 
+    setInputDivision(bob::core::array::ccopy(v));
+
+  }
+
+  void Machine::setInputDivision (blitz::Array<double,1>&& v) {
+
     if (m_weight.extent(0) != v.extent(0)) {
       boost::format m("mismatch on the input division shape: expected a vector of size %d, but you input one with size = %d instead");
       m % m_weight.extent(0) % v.extent(0);
       throw std::runtime_error(m.str());
     }
-    m_input_div.reference(bob::core::array::ccopy(v));
+    take_or_copy(m_input_div, v);
 
   }
 
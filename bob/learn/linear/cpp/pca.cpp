@@ -11,6 +11,8 @@
  */
 
 #include <algorithm>
+#include <cmath>
+#include <utility>
 #include <blitz/array.h>
 #include <boost/format.hpp>
 #include <bob.math/stats.h>
@@ -55,63 +57,99 @@ namespace bob { namespace learn { namespace linear {
   }
 
   /**
-   * Sets up the machine calculating the PC's via the Covariance Matrix
+   * Sets up the machine from the eigen-decomposition of the given covariance
+   * matrix
    */
-  static void pca_via_covmat(Machine& machine,
-      blitz::Array<double,1>& eigen_values, const blitz::Array<double,2>& X,
-      int rank) {
+  static void pca_from_covariance(Machine& machine,
+      blitz::Array<double,1>& eigen_values, const blitz::Array<double,1>& mean,
+      const blitz::Array<double,2>& Sigma, int rank, TrainingStats::Scope& scope) {
+
+    const size_t D = Sigma.extent(0);
 
     /**
-     * computes the covariance matrix (X-mu)(X-mu)^T / (len(X)-1) and then solves
-     * the generalized eigen-value problem taking into consideration the
+     * solves the eigen-value problem taking into consideration the
      * covariance matrix is symmetric (and, by extension, hermitian).
      */
-    blitz::Array<double,1> mean(X.extent(1));
-    blitz::Array<double,2> Sigma(X.extent(1), X.extent(1));
-    bob::math::scatter_(X, Sigma, mean);
-    Sigma /= (X.extent(0)-1); //unbiased variance estimator
-
-    blitz::Array<double,2> U(X.extent(1), X.extent(1));
-    blitz::Array<double,1> e(X.extent(1));
+    scope.phase("decomposition", sizeof(double) * (D*D + D));
+    blitz::Array<double,2> U(Sigma.extent(0), Sigma.extent(0));
+    blitz::Array<double,1> e(Sigma.extent(0));
     bob::math::eigSym_(Sigma, U, e);
-    e.reverseSelf(0);
-    U.reverseSelf(1);
+
+    /**
+     * eigen values are sorted in ascending order: the eigen vectors of the
+     * rank largest ones are copied in descending order, directly into the
+     * weights that are handed over to the machine
+     */
+    scope.phase("truncation", sizeof(double) * D * rank);
+    blitz::Range a = blitz::Range::all();
+    const int last = e.extent(0) - 1;
+    blitz::Array<double,2> W(Sigma.extent(0), rank);
+    for (int k=0; k<rank; ++k) {
+      eigen_values(k) = e(last-k);
+      W(a,k) = U(a,last-k);
+    }
 
     /**
      * sets the linear machine with the results:
      */
+    scope.phase("machine update");
     machine.setInputSubtraction(mean);
     machine.setInputDivision(1.0);
     machine.setBiases(0.0);
-    if (e.size() == eigen_values.size()) {
-      eigen_values = e;
-      machine.setWeights(U);
-    }
-    else {
-      eigen_values = e(blitz::Range(0,rank-1));
-      machine.setWeights(U(blitz::Range::all(), blitz::Range(0,rank-1)));
-    }
+    machine.setWeights(std::move(W));
+
+  }
+
+  /**
+   * Sets up the machine calculating the PC's via the Covariance Matrix
+   */
+  static void pca_via_covmat(Machine& machine,
+      blitz::Array<double,1>& eigen_values, const blitz::Array<double,2>& X,
+      int rank, TrainingStats::Scope& scope) {
+
+    /**
+     * computes the covariance matrix (X-mu)(X-mu)^T / (len(X)-1)
+     */
+    const size_t D = X.extent(1);
+    scope.phase("scatter", sizeof(double) * (D + D*D));
+    blitz::Array<double,1> mean(X.extent(1));
+    blitz::Array<double,2> Sigma(X.extent(1), X.extent(1));
+    bob::math::scatter_(X, Sigma, mean);
+    Sigma /= (X.extent(0)-1); //unbiased variance estimator
 
+    pca_from_covariance(machine, eigen_values, mean, Sigma, rank, scope);
   }
 
   /**
-   * Sets up the machine calculating the PC's via SVD
+   * Sets up the machine calculating the PC's via SVD. If weights are given
+   * (i.e., the array is not empty), each sample is weighted with its
+   * frequency weight.
    */
   static void pca_via_svd(Machine& machine, blitz::Array<double,1>& eigen_values,
-      const blitz::Array<double,2>& X, int rank, bool safe_svd) {
+      const blitz::Array<double,2>& X, const blitz::Array<double,1>& weights,
+      int rank, bool safe_svd, TrainingStats::Scope& scope) {
 
     // removes the empirical mean from the training data
+    const size_t N = X.extent(0), D = X.extent(1);
+    scope.phase("scatter", sizeof(double) * (D*N + D));
     blitz::Array<double,2> data(X.extent(1), X.extent(0));
     blitz::Range a = blitz::Range::all();
     for (int i=0; i<X.extent(0); ++i) data(a,i) = X(i,a);
 
-    // computes the mean of the training data
+    // computes the (weighted) mean of the training data
     blitz::secondIndex j;
     blitz::Array<double,1> mean(X.extent(1));
-    mean = blitz::mean(data, j);
-
-    // applies the training data mean
-    for (int i=0; i<X.extent(0); ++i) data(a,i) -= mean;
+    double total = X.extent(0);
+    if (weights.size()) total = weighted_mean(X, weights, mean);
+    else mean = blitz::mean(data, j);
+
+    // applies the training data mean; weighted samples are scaled with the
+    // square root of their weight, so that data * data^T is the weighted
+    // scatter matrix
+    for (int i=0; i<X.extent(0); ++i) {
+      data(a,i) -= mean;
+      if (weights.size()) data(a,i) *= std::sqrt(weights(i));
+    }
 
     /**
      * computes the singular value decomposition using lapack
@@ -121,54 +159,101 @@ namespace bob { namespace learn { namespace linear {
      * You **don't** need sorting after this.
      */
     const int rank_1 = (rank == (int)X.extent(1))? X.extent(1) : X.extent(0);
+    scope.phase("decomposition", sizeof(double) * (D*rank_1 + rank_1));
     blitz::Array<double,2> U(X.extent(1), rank_1);
     blitz::Array<double,1> sigma(rank_1);
     bob::math::svd_(data, U, sigma, safe_svd);
 
     /**
-     * sets the linear machine with the results:
-     *
      * note: eigen values are sigma^2/X.extent(0) diagonal
      *       eigen vectors are the rows of U
      */
-    machine.setInputSubtraction(mean);
-    machine.setInputDivision(1.0);
-    machine.setBiases(0.0);
+    scope.phase("truncation", rank == rank_1 ? 0 : sizeof(double) * D * rank);
     blitz::Range up_to_rank(0, rank-1);
-    machine.setWeights(U(a,up_to_rank));
+    eigen_values = (blitz::pow2(sigma)/(total-1))(up_to_rank);
+    if (rank != rank_1) U.reference(U(a,up_to_rank).copy());
 
     //weight normalization (if necessary):
     //norm_factor = blitz::sum(blitz::pow2(V(all,i)))
 
-    // finally, we set also the eigen values in this version
-    eigen_values = (blitz::pow2(sigma)/(X.extent(0)-1))(up_to_rank);
+    /**
+     * sets the linear machine with the results:
+     */
+    scope.phase("machine update");
+    machine.setInputSubtraction(mean);
+    machine.setInputDivision(1.0);
+    machine.setBiases(0.0);
+    machine.setWeights(std::move(U));
   }
 
-  void PCATrainer::train(Machine& machine, blitz::Array<double,1>& eigen_values,
-      const blitz::Array<double,2>& X) const {
-
-    // data is checked now and conforms, just proceed w/o any further checks.
-    const int rank = output_size(X);
-
-    // Checks that the dimensions are matching
-    if (machine.inputSize() != (size_t)X.extent(1)) {
+  /**
+   * Checks that machine and eigen values match the given number of samples
+   * and features
+   */
+  static void check_dimensions(const Machine& machine,
+      const blitz::Array<double,1>& eigen_values, int n_samples, int n_features,
+      int rank) {
+    if (machine.inputSize() != (size_t)n_features) {
       boost::format m("Number of features at input data set (%d columns) does not match machine input size (%d)");
-      m % X.extent(1) % machine.inputSize();
+      m % n_features % machine.inputSize();
       throw std::runtime_error(m.str());
     }
     if (machine.outputSize() != (size_t)rank) {
       boost::format m("Number of outputs of the given machine (%d) does not match the maximum covariance rank, i.e., min(#samples-1,#features) = min(%d, %d) = %d");
-      m % machine.outputSize() % (X.extent(0)-1) % X.extent(1) % rank;
+      m % machine.outputSize() % (n_samples-1) % n_features % rank;
       throw std::runtime_error(m.str());
     }
     if (eigen_values.extent(0) != rank) {
       boost::format m("Number of eigenvalues on the given 1D array (%d) does not match the maximum covariance rank, i.e., min(#samples-1,#features) = min(%d,%d) = %d");
-      m % eigen_values.extent(0) % (X.extent(0)-1) % X.extent(1) % rank;
+      m % eigen_values.extent(0) % (n_samples-1) % n_features % rank;
       throw std::runtime_error(m.str());
     }
+  }
+
+  void PCATrainer::train(Machine& machine, blitz::Array<double,1>& eigen_values,
+      const blitz::Array<double,2>& X) const {
 
-    if (m_use_svd) pca_via_svd(machine, eigen_values, X, rank, m_safe_svd);
-    else pca_via_covmat(machine, eigen_values, X, rank);
+    // data is checked now and conforms, just proceed w/o any further checks.
+    const int rank = output_size(X);
+
+    // Checks that the dimensions are matching
+    check_dimensions(machine, eigen_values, X.extent(0), X.extent(1), rank);
+
+    TrainingStats::Scope scope(m_stats.get());
+    if (m_use_svd) pca_via_svd(machine, eigen_values, X, blitz::Array<double,1>(), rank, m_safe_svd, scope);
+    else pca_via_covmat(machine, eigen_values, X, rank, scope);
+  }
+
+  void PCATrainer::train(Machine& machine, blitz::Array<double,1>& eigen_values,
+      const blitz::Array<double,2>& X, const blitz::Array<double,1>& weights) const {
+
+    const int rank = output_size(X);
+    check_dimensions(machine, eigen_values, X.extent(0), X.extent(1), rank);
+
+    TrainingStats::Scope scope(m_stats.get());
+    if (!m_use_svd) {
+      // the covariance method uses the weighted statistics of the data
+      const size_t D = X.extent(1);
+      scope.phase("scatter", sizeof(double) * (D + D*D));
+      ScatterAccumulator statistics(X.extent(1));
+      statistics.update(X, weights);
+      train(machine, eigen_values, statistics);
+      return;
+    }
+
+    const double total = blitz::sum(weights);
+    if (total <= 1.) {
+      boost::format m("the sum of the sample weights (%g) must be above 1");
+      m % total;
+      throw std::runtime_error(m.str());
+    }
+    pca_via_svd(machine, eigen_values, X, weights, rank, m_safe_svd, scope);
+  }
+
+  void PCATrainer::train(Machine& machine, const blitz::Array<double,2>& X,
+      const blitz::Array<double,1>& weights) const {
+    blitz::Array<double,1> throw_away_eigen_values(output_size(X));
+    train(machine, throw_away_eigen_values, X, weights);
   }
 
   void PCATrainer::train(Machine& machine, const blitz::Array<double,2>& X) const {
@@ -176,8 +261,34 @@ namespace bob { namespace learn { namespace linear {
     train(machine, throw_away_eigen_values, X);
   }
 
+  void PCATrainer::train(Machine& machine, blitz::Array<double,1>& eigen_values,
+      const ScatterAccumulator& statistics) const {
+
+    const int rank = output_size(statistics);
+    check_dimensions(machine, eigen_values, statistics.numberOfSamples(),
+        statistics.numberOfFeatures(), rank);
+
+    // the data is not available, so the covariance method is always used
+    const size_t D = statistics.numberOfFeatures();
+    TrainingStats::Scope scope(m_stats.get());
+    scope.phase("scatter", sizeof(double) * D * D);
+    blitz::Array<double,2> Sigma(D, D);
+    statistics.covariance(Sigma);
+    pca_from_covariance(machine, eigen_values, statistics.getMean(), Sigma, rank, scope);
+  }
+
+  void PCATrainer::train(Machine& machine, const ScatterAccumulator& statistics) const {
+    blitz::Array<double,1> throw_away_eigen_values(output_size(statistics));
+    train(machine, throw_away_eigen_values, statistics);
+  }
+
   size_t PCATrainer::output_size (const blitz::Array<double,2>& X) const {
     return (size_t)std::min(X.extent(0)-1,X.extent(1));
   }
 
+  size_t PCATrainer::output_size (const ScatterAccumulator& statistics) const {
+    if (!statistics.numberOfSamples()) return 0;
+    return std::min(statistics.numberOfSamples()-1, statistics.numberOfFeatures());
+  }
+
 }}}
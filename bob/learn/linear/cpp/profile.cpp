@@ -0,0 +1,80 @@
+/**
+ * @date Sun Oct 18 10:12:41 CEST 2026
+ *
+ * @brief Opt-in timing statistics of the phases of a training
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.linear/profile.h>
+
+namespace bob { namespace learn { namespace linear {
+
+  TrainingStats::Scope::Scope(TrainingStats* stats):
+    m_stats(stats)
+  {
+    if (m_stats && !m_stats->m_depth++) m_stats->reset();
+  }
+
+  TrainingStats::Scope::~Scope()
+  {
+    if (m_stats && !--m_stats->m_depth) m_stats->stop();
+  }
+
+  void TrainingStats::Scope::phase(const std::string& name, size_t bytes)
+  {
+    if (m_stats) m_stats->start(name, bytes);
+  }
+
+  TrainingStats::TrainingStats():
+    m_running(false),
+    m_depth(0)
+  {
+  }
+
+  void TrainingStats::reset()
+  {
+    m_phases.clear();
+    m_running = false;
+  }
+
+  void TrainingStats::start(const std::string& name, size_t bytes)
+  {
+    if (m_running && m_phases.back().name == name) {
+      m_phases.back().estimated_bytes += bytes;
+      return;
+    }
+    stop();
+    Phase phase = {name, 0., bytes};
+    m_phases.push_back(phase);
+    m_start = std::chrono::steady_clock::now();
+    m_running = true;
+  }
+
+  void TrainingStats::allocated(size_t bytes)
+  {
+    if (m_running) m_phases.back().estimated_bytes += bytes;
+  }
+
+  void TrainingStats::stop()
+  {
+    if (!m_running) return;
+    m_phases.back().seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    m_running = false;
+  }
+
+  double TrainingStats::totalSeconds() const
+  {
+    double total = 0.;
+    for (size_t i = 0; i < m_phases.size(); ++i) total += m_phases[i].seconds;
+    return total;
+  }
+
+  size_t TrainingStats::totalEstimatedBytes() const
+  {
+    size_t total = 0;
+    for (size_t i = 0; i < m_phases.size(); ++i) total += m_phases[i].estimated_bytes;
+    return total;
+  }
+
+}}}
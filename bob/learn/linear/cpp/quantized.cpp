@@ -0,0 +1,292 @@
+/**
+ * @date Sun Oct 18 19:05:12 CEST 2026
+ *
+ * @brief A linear machine with 8-bit integer weights, for fast and compact
+ * inference
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <boost/format.hpp>
+#include <boost/make_shared.hpp>
+#include <bob.core/array_compare.h>
+
+#include <bob.learn.linear/quantized.h>
+
+namespace bob { namespace learn { namespace linear {
+
+  /**
+   * The number of 8-bit products that are summed in a 32-bit integer before
+   * it is added to the 64-bit result; 65536 * 128 * 128 fits into 32 bits
+   */
+  static const int s_block = 65536;
+
+  /**
+   * The number of inputs that are projected together in the batch
+   * projection, so that each row of weights is reused while it is cached
+   */
+  static const int s_rows = 64;
+
+  /**
+   * Computes the dot product of two contiguous int8 vectors of length n. The
+   * inner loop only uses 32-bit integers, so that it can be vectorized.
+   */
+  static int64_t dot(const int8_t* a, const int8_t* b, const int n) {
+    int64_t result = 0;
+    for (int start = 0; start < n; start += s_block) {
+      const int end = std::min(n, start + s_block);
+      int32_t sum = 0;
+      for (int k = start; k < end; ++k) sum += int32_t(a[k]) * int32_t(b[k]);
+      result += sum;
+    }
+    return result;
+  }
+
+  QuantizedMachine::QuantizedMachine():
+    m_input_sub(0),
+    m_input_div(0),
+    m_weight(0, 0),
+    m_scale(0),
+    m_bias(0),
+    m_activation(boost::make_shared<bob::learn::activation::IdentityActivation>()),
+    m_buffer(0)
+  {
+  }
+
+  QuantizedMachine::QuantizedMachine(const Machine& machine)
+  {
+    quantize(machine);
+  }
+
+  QuantizedMachine::QuantizedMachine(bob::io::base::HDF5File& config)
+  {
+    load(config);
+  }
+
+  QuantizedMachine::QuantizedMachine(const QuantizedMachine& other):
+    m_input_sub(bob::core::array::ccopy(other.m_input_sub)),
+    m_input_div(bob::core::array::ccopy(other.m_input_div)),
+    m_weight(bob::core::array::ccopy(other.m_weight)),
+    m_scale(bob::core::array::ccopy(other.m_scale)),
+    m_bias(bob::core::array::ccopy(other.m_bias)),
+    m_activation(other.m_activation),
+    m_buffer(other.m_buffer.shape())
+  {
+  }
+
+  QuantizedMachine::~QuantizedMachine() {}
+
+  QuantizedMachine& QuantizedMachine::operator=(const QuantizedMachine& other)
+  {
+    if (this != &other) {
+      m_input_sub.reference(bob::core::array::ccopy(other.m_input_sub));
+      m_input_div.reference(bob::core::array::ccopy(other.m_input_div));
+      m_weight.reference(bob::core::array::ccopy(other.m_weight));
+      m_scale.reference(bob::core::array::ccopy(other.m_scale));
+      m_bias.reference(bob::core::array::ccopy(other.m_bias));
+      m_activation = other.m_activation;
+      m_buffer.resize(other.m_buffer.shape());
+    }
+    return *this;
+  }
+
+  bool QuantizedMachine::operator==(const QuantizedMachine& other) const
+  {
+    return bob::core::array::isEqual(m_input_sub, other.m_input_sub) &&
+      bob::core::array::isEqual(m_input_div, other.m_input_div) &&
+      bob::core::array::isEqual(m_weight, other.m_weight) &&
+      bob::core::array::isEqual(m_scale, other.m_scale) &&
+      bob::core::array::isEqual(m_bias, other.m_bias) &&
+      m_activation->str() == other.m_activation->str();
+  }
+
+  bool QuantizedMachine::operator!=(const QuantizedMachine& other) const
+  {
+    return !(this->operator==(other));
+  }
+
+  void QuantizedMachine::quantize(const Machine& machine)
+  {
+    const blitz::Array<double,2>& weight = machine.getWeights();
+    const int n_inputs = weight.extent(0), n_outputs = weight.extent(1);
+
+    // each output (column of the weights) gets its own scale, and its
+    // weights are stored contiguously in a row
+    m_weight.resize(n_outputs, n_inputs);
+    m_scale.resize(n_outputs);
+    for (int j = 0; j < n_outputs; ++j) {
+      double max = 0.;
+      for (int k = 0; k < n_inputs; ++k) max = std::max(max, std::fabs(weight(k,j)));
+      m_scale(j) = max / 127.;
+      const double inverse = max > 0. ? 127. / max : 0.;
+      for (int k = 0; k < n_inputs; ++k) m_weight(j,k) = static_cast<int8_t>(std::lround(weight(k,j) * inverse));
+    }
+
+    m_input_sub.reference(bob::core::array::ccopy(machine.getInputSubtraction()));
+    m_input_div.reference(bob::core::array::ccopy(machine.getInputDivision()));
+    m_bias.reference(bob::core::array::ccopy(machine.getBiases()));
+    m_activation = machine.getActivation();
+    m_buffer.resize(n_inputs);
+  }
+
+  void QuantizedMachine::load(bob::io::base::HDF5File& config)
+  {
+    m_input_sub.reference(config.readArray<double,1>("input_sub"));
+    m_input_div.reference(config.readArray<double,1>("input_div"));
+    m_weight.reference(config.readArray<int8_t,2>("weights"));
+    m_scale.reference(config.readArray<double,1>("scales"));
+    m_bias.reference(config.readArray<double,1>("biases"));
+    config.cd("activation");
+    m_activation = bob::learn::activation::load_activation(config);
+    config.cd("..");
+
+    if (m_input_sub.extent(0) != m_weight.extent(1) || m_input_div.extent(0) != m_weight.extent(1) ||
+        m_scale.extent(0) != m_weight.extent(0) || m_bias.extent(0) != m_weight.extent(0)) {
+      boost::format m("the quantized machine in '%s' has weights of shape (%d,%d) (one row per output), but %d input subtractions, %d input divisions, %d scales and %d biases");
+      m % config.filename() % m_weight.extent(0) % m_weight.extent(1) % m_input_sub.extent(0) % m_input_div.extent(0) % m_scale.extent(0) % m_bias.extent(0);
+      throw std::runtime_error(m.str());
+    }
+    m_buffer.resize(m_weight.extent(1));
+  }
+
+  void QuantizedMachine::save(bob::io::base::HDF5File& config) const
+  {
+    config.setAttribute(".", "version", 1);
+    config.setArray("input_sub", m_input_sub);
+    config.setArray("input_div", m_input_div);
+    config.setArray("weights", m_weight);
+    config.setArray("scales", m_scale);
+    config.setArray("biases", m_bias);
+    config.createGroup("activation");
+    config.cd("activation");
+    m_activation->save(config);
+    config.cd("..");
+  }
+
+  double QuantizedMachine::quantizeInput(const blitz::Array<double,1>& input, int8_t* q) const
+  {
+    const int n_inputs = m_input_sub.extent(0);
+    double max = 0.;
+    for (int k = 0; k < n_inputs; ++k)
+      max = std::max(max, std::fabs((input(k) - m_input_sub(k)) / m_input_div(k)));
+    const double inverse = max > 0. ? 127. / max : 0.;
+    for (int k = 0; k < n_inputs; ++k)
+      q[k] = static_cast<int8_t>(std::lround((input(k) - m_input_sub(k)) / m_input_div(k) * inverse));
+    return max / 127.;
+  }
+
+  void QuantizedMachine::project(const int8_t* q, double scale, blitz::Array<double,1>& output) const
+  {
+    const int n_inputs = m_weight.extent(1);
+    for (int j = 0; j < m_weight.extent(0); ++j)
+      output(j) = m_activation->f(scale * m_scale(j) * dot(q, m_weight.data() + j * n_inputs, n_inputs) + m_bias(j));
+  }
+
+  void QuantizedMachine::forward_(const blitz::Array<double,1>& input, blitz::Array<double,1>& output) const
+  {
+    const double scale = quantizeInput(input, m_buffer.data());
+    project(m_buffer.data(), scale, output);
+  }
+
+  void QuantizedMachine::forward(const blitz::Array<double,1>& input, blitz::Array<double,1>& output) const
+  {
+    if (m_weight.extent(1) != input.extent(0)) { //checks input dimension
+      boost::format m("mismatch on the input dimension: expected a vector of size %d, but you input one with size = %d instead");
+      m % m_weight.extent(1) % input.extent(0);
+      throw std::runtime_error(m.str());
+    }
+    if (m_weight.extent(0) != output.extent(0)) { //checks output dimension
+      boost::format m("mismatch on the output dimension: expected a vector of size %d, but you input one with size = %d instead");
+      m % m_weight.extent(0) % output.extent(0);
+      throw std::runtime_error(m.str());
+    }
+    forward_(input, output);
+  }
+
+  void QuantizedMachine::forward_(const blitz::Array<double,2>& input, blitz::Array<double,2>& output) const
+  {
+    const int n_samples = input.extent(0), n_inputs = m_weight.extent(1), n_outputs = m_weight.extent(0);
+    const blitz::Range all = blitz::Range::all();
+
+    // quantizes the inputs into contiguous rows
+    blitz::Array<int8_t,2> q(n_samples, n_inputs);
+    blitz::Array<double,1> scales(n_samples);
+    for (int i = 0; i < n_samples; ++i)
+      scales(i) = quantizeInput(input(i, all), q.data() + i * n_inputs);
+
+    // projects blocks of inputs on each row of weights
+    for (int start = 0; start < n_samples; start += s_rows) {
+      const int end = std::min(n_samples, start + s_rows);
+      for (int j = 0; j < n_outputs; ++j) {
+        const int8_t* w = m_weight.data() + j * n_inputs;
+        for (int i = start; i < end; ++i)
+          output(i,j) = m_activation->f(scales(i) * m_scale(j) * dot(q.data() + i * n_inputs, w, n_inputs) + m_bias(j));
+      }
+    }
+  }
+
+  void QuantizedMachine::forward(const blitz::Array<double,2>& input, blitz::Array<double,2>& output) const
+  {
+    if (m_weight.extent(1) != input.extent(1)) { //checks input dimension
+      boost::format m("mismatch on the input dimension: expected an array with %d columns, but you input one with %d columns instead");
+      m % m_weight.extent(1) % input.extent(1);
+      throw std::runtime_error(m.str());
+    }
+    if (m_weight.extent(0) != output.extent(1) || input.extent(0) != output.extent(0)) { //checks output dimension
+      boost::format m("mismatch on the output dimension: expected an array of shape (%d,%d), but you input one with shape (%d,%d) instead");
+      m % input.extent(0) % m_weight.extent(0) % output.extent(0) % output.extent(1);
+      throw std::runtime_error(m.str());
+    }
+    forward_(input, output);
+  }
+
+  QuantizationReport QuantizedMachine::accuracy(const Machine& reference, const blitz::Array<double,2>& data) const
+  {
+    if (reference.inputSize() != inputSize() || reference.outputSize() != outputSize()) {
+      boost::format m("the reference machine of shape (%d,%d) does not match the quantized machine of shape (%d,%d)");
+      m % reference.inputSize() % reference.outputSize() % inputSize() % outputSize();
+      throw std::runtime_error(m.str());
+    }
+    const int n_samples = data.extent(0), n_outputs = outputSize();
+    if (!n_samples || !n_outputs) {
+      throw std::runtime_error("the accuracy of a quantized machine requires at least one sample and one output");
+    }
+
+    blitz::Array<double,2> quantized(n_samples, n_outputs);
+    forward(data, quantized);
+
+    const blitz::Range all = blitz::Range::all();
+    const double threshold = reference.getActivation()->f(0.);
+    blitz::Array<double,1> expected(n_outputs);
+    QuantizationReport report = {0., 0., 0., 0., 0.};
+    for (int i = 0; i < n_samples; ++i) {
+      reference.forward_(data(i, all), expected);
+      for (int j = 0; j < n_outputs; ++j) {
+        const double error = std::fabs(quantized(i,j) - expected(j));
+        report.max_error = std::max(report.max_error, error);
+        report.mean_error += error;
+        report.rms_error += error * error;
+        report.max_reference = std::max(report.max_reference, std::fabs(expected(j)));
+      }
+      if (n_outputs == 1) {
+        if ((quantized(i,0) > threshold) == (expected(0) > threshold)) report.agreement += 1.;
+      }
+      else {
+        int q = 0, e = 0;
+        for (int j = 1; j < n_outputs; ++j) {
+          if (quantized(i,j) > quantized(i,q)) q = j;
+          if (expected(j) > expected(e)) e = j;
+        }
+        if (q == e) report.agreement += 1.;
+      }
+    }
+    report.mean_error /= double(n_samples) * n_outputs;
+    report.rms_error = std::sqrt(report.rms_error / (double(n_samples) * n_outputs));
+    report.agreement /= n_samples;
+    return report;
+  }
+
+}}}
@@ -0,0 +1,403 @@
+/**
+ * @date Sun Oct 18 10:12:41 CEST 2026
+ *
+ * @brief A streaming and mergeable accumulator of the mean and the scatter
+ * matrix of a set of samples
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <boost/format.hpp>
+#include <bob.core/array_compare.h>
+#include <bob.core/check.h>
+
+#include <bob.learn.linear/scatter.h>
+
+namespace bob { namespace learn { namespace linear {
+
+  ScatterAccumulator::ScatterAccumulator(size_t n_features):
+    m_n(0),
+    m_weight(0.),
+    m_mean(n_features),
+    m_scatter(n_features, n_features)
+  {
+    m_mean = 0.;
+    m_scatter = 0.;
+  }
+
+  ScatterAccumulator::ScatterAccumulator(const ScatterAccumulator& other):
+    m_n(other.m_n),
+    m_weight(other.m_weight),
+    m_mean(other.m_mean.copy()),
+    m_scatter(other.m_scatter.copy())
+  {
+  }
+
+  ScatterAccumulator::ScatterAccumulator(bob::io::base::HDF5File& config):
+    m_n(0),
+    m_weight(0.)
+  {
+    load(config);
+  }
+
+  ScatterAccumulator::~ScatterAccumulator() {}
+
+  ScatterAccumulator& ScatterAccumulator::operator=(const ScatterAccumulator& other)
+  {
+    if (this != &other) {
+      m_n = other.m_n;
+      m_weight = other.m_weight;
+      m_mean.reference(other.m_mean.copy());
+      m_scatter.reference(other.m_scatter.copy());
+    }
+    return *this;
+  }
+
+  bool ScatterAccumulator::operator==(const ScatterAccumulator& other) const
+  {
+    return m_n == other.m_n && m_weight == other.m_weight &&
+      bob::core::array::isEqual(m_mean, other.m_mean) &&
+      bob::core::array::isEqual(m_scatter, other.m_scatter);
+  }
+
+  bool ScatterAccumulator::operator!=(const ScatterAccumulator& other) const
+  {
+    return !(this->operator==(other));
+  }
+
+  bool ScatterAccumulator::is_similar_to(const ScatterAccumulator& other,
+    const double r_epsilon, const double a_epsilon) const
+  {
+    return m_n == other.m_n &&
+      bob::core::isClose(m_weight, other.m_weight, r_epsilon, a_epsilon) &&
+      bob::core::array::isClose(m_mean, other.m_mean, r_epsilon, a_epsilon) &&
+      bob::core::array::isClose(m_scatter, other.m_scatter, r_epsilon, a_epsilon);
+  }
+
+  void ScatterAccumulator::add(size_t n, double weight,
+    const blitz::Array<double,1>& mean, const blitz::Array<double,2>& scatter)
+  {
+    if (!n || weight <= 0.) return;
+
+    if (!m_mean.extent(0)) {
+      // the first samples define the dimensionality
+      m_mean.resize(mean.extent(0));
+      m_scatter.resize(mean.extent(0), mean.extent(0));
+    }
+    else if (mean.extent(0) != m_mean.extent(0)) {
+      boost::format m("the dimensionality of the samples (%d) does not match the dimensionality of the accumulator (%d)");
+      m % mean.extent(0) % m_mean.extent(0);
+      throw std::runtime_error(m.str());
+    }
+
+    if (!m_n) {
+      m_n = n;
+      m_weight = weight;
+      m_mean = mean;
+      m_scatter = scatter;
+      return;
+    }
+
+    // pairwise update of Chan et al.
+    blitz::firstIndex i;
+    blitz::secondIndex j;
+    const double total = m_weight + weight;
+    blitz::Array<double,1> delta(mean - m_mean);
+    m_scatter += scatter(i,j) + delta(i) * delta(j) * (m_weight * weight / total);
+    m_mean += delta * (weight / total);
+    m_n += n;
+    m_weight = total;
+  }
+
+  /**
+   * Computes the (weighted) mean and scatter matrix of the rows of the given
+   * block, and returns the sum of the weights; all weights are 1 if the
+   * weights are empty. The elements of the block are read through data() and
+   * stride(): views of its rows would modify the reference count of its
+   * memory block, which is not atomic.
+   */
+  static double block_scatter(const blitz::Array<double,2>& block,
+    const blitz::Array<double,1>& weights, blitz::Array<double,2>& scatter,
+    blitz::Array<double,1>& mean)
+  {
+    const int n = block.extent(0), d = block.extent(1);
+    const double* x = block.data();
+    const blitz::diffType row = block.stride(0), column = block.stride(1);
+    const bool weighted = weights.size();
+
+    double total = 0.;
+    mean = 0.;
+    for (int k = 0; k < n; ++k) {
+      const double w = weighted ? weights(k) : 1.;
+      if (w == 0.) continue;
+      for (int i = 0; i < d; ++i) mean(i) += x[k*row + i*column] * w;
+      total += w;
+    }
+    mean /= total;
+
+    // the upper triangle is accumulated and mirrored
+    blitz::Array<double,1> delta(d);
+    scatter = 0.;
+    for (int k = 0; k < n; ++k) {
+      const double w = weighted ? weights(k) : 1.;
+      if (w == 0.) continue;
+      for (int i = 0; i < d; ++i) delta(i) = x[k*row + i*column] - mean(i);
+      for (int i = 0; i < d; ++i) {
+        const double wi = w * delta(i);
+        for (int j = i; j < d; ++j) scatter(i,j) += wi * delta(j);
+      }
+    }
+    for (int i = 0; i < d; ++i)
+      for (int j = 0; j < i; ++j) scatter(i,j) = scatter(j,i);
+    return total;
+  }
+
+  /**
+   * Checks that the given weights are non-negative, that their number
+   * matches the number of samples, and that their sum is positive
+   */
+  static void check_weights(const blitz::Array<double,1>& weights, int n)
+  {
+    if (weights.extent(0) != n) {
+      boost::format m("the number of weights (%d) does not match the number of samples (%d)");
+      m % weights.extent(0) % n;
+      throw std::runtime_error(m.str());
+    }
+    if (blitz::any(weights < 0.))
+      throw std::runtime_error("the sample weights must not be negative");
+    if (blitz::sum(weights) <= 0.)
+      throw std::runtime_error("the sum of the sample weights must be positive");
+  }
+
+  void ScatterAccumulator::update(const blitz::Array<double,2>& block)
+  {
+    const int n = block.extent(0), d = block.extent(1);
+    if (!n) return;
+
+    blitz::Array<double,1> mean(d);
+    blitz::Array<double,2> scatter(d, d);
+    block_scatter(block, blitz::Array<double,1>(), scatter, mean);
+    add(n, n, mean, scatter);
+  }
+
+  void ScatterAccumulator::update(const blitz::Array<double,2>& block,
+    const blitz::Array<double,1>& weights)
+  {
+    const int n = block.extent(0), d = block.extent(1);
+    if (!n) return;
+
+    blitz::Array<double,1> mean(d);
+    blitz::Array<double,2> scatter(d, d);
+    const double weight = weighted_scatter(block, weights, scatter, mean);
+    add(n, weight, mean, scatter);
+  }
+
+  void ScatterAccumulator::update(const blitz::Array<double,1>& sample)
+  {
+    if (!m_n) {
+      blitz::Array<double,2> scatter(sample.extent(0), sample.extent(0));
+      scatter = 0.;
+      add(1, 1., sample, scatter);
+      return;
+    }
+    if (sample.extent(0) != m_mean.extent(0)) {
+      boost::format m("the dimensionality of the sample (%d) does not match the dimensionality of the accumulator (%d)");
+      m % sample.extent(0) % m_mean.extent(0);
+      throw std::runtime_error(m.str());
+    }
+
+    // Welford's update, without allocating a scatter matrix for the sample
+    blitz::firstIndex i;
+    blitz::secondIndex j;
+    blitz::Array<double,1> delta(sample - m_mean);
+    ++m_n;
+    m_weight += 1.;
+    m_mean += delta / m_weight;
+    m_scatter += delta(i) * delta(j) * ((m_weight - 1.) / m_weight);
+  }
+
+  void ScatterAccumulator::merge(const ScatterAccumulator& other)
+  {
+    if (this == &other) {
+      // merging with itself doubles the samples
+      ScatterAccumulator copy(other);
+      add(copy.m_n, copy.m_weight, copy.m_mean, copy.m_scatter);
+      return;
+    }
+    add(other.m_n, other.m_weight, other.m_mean, other.m_scatter);
+  }
+
+  void ScatterAccumulator::subtract(const ScatterAccumulator& other)
+  {
+    if (!other.m_n) return;
+    if (this == &other) {
+      reset();
+      return;
+    }
+    if (other.m_mean.extent(0) != m_mean.extent(0)) {
+      boost::format m("the dimensionality of the samples (%d) does not match the dimensionality of the accumulator (%d)");
+      m % other.m_mean.extent(0) % m_mean.extent(0);
+      throw std::runtime_error(m.str());
+    }
+    if (other.m_n > m_n || other.m_weight > m_weight * (1. + 1e-12)) {
+      boost::format m("cannot subtract %d samples with a sum of weights of %g from an accumulator of %d samples with a sum of weights of %g");
+      m % other.m_n % other.m_weight % m_n % m_weight;
+      throw std::runtime_error(m.str());
+    }
+
+    const size_t n = m_n - other.m_n;
+    const double weight = m_weight - other.m_weight;
+    if (!n || weight <= 0.) {
+      // only samples without weight are left
+      reset();
+      m_n = n;
+      return;
+    }
+
+    // inverse of the pairwise update of Chan et al.
+    blitz::firstIndex i;
+    blitz::secondIndex j;
+    blitz::Array<double,1> mean((m_weight * m_mean - other.m_weight * other.m_mean) / weight);
+    blitz::Array<double,1> delta(other.m_mean - mean);
+    m_scatter -= other.m_scatter(i,j) + delta(i) * delta(j) * (weight * other.m_weight / m_weight);
+    m_mean = mean;
+    m_n = n;
+    m_weight = weight;
+  }
+
+  void ScatterAccumulator::reset()
+  {
+    m_n = 0;
+    m_weight = 0.;
+    m_mean = 0.;
+    m_scatter = 0.;
+  }
+
+  void ScatterAccumulator::scale(const blitz::Array<double,1>& division)
+  {
+    if (division.extent(0) != m_mean.extent(0)) {
+      boost::format m("the number of division factors (%d) does not match the dimensionality of the accumulator (%d)");
+      m % division.extent(0) % m_mean.extent(0);
+      throw std::runtime_error(m.str());
+    }
+    blitz::firstIndex i;
+    blitz::secondIndex j;
+    m_mean /= division;
+    m_scatter /= division(i) * division(j);
+  }
+
+  void ScatterAccumulator::covariance(blitz::Array<double,2>& covariance) const
+  {
+    if (m_n < 2 || m_weight <= 1.) {
+      boost::format m("the covariance matrix requires at least two samples with a sum of weights above 1, but %u samples with a sum of weights of %g were accumulated");
+      m % m_n % m_weight;
+      throw std::runtime_error(m.str());
+    }
+    covariance = m_scatter / (m_weight - 1.);
+  }
+
+  void ScatterAccumulator::load(bob::io::base::HDF5File& config)
+  {
+    m_n = config.read<uint64_t>("n_samples");
+    m_weight = config.contains("sum_of_weights") ? config.read<double>("sum_of_weights") : (double)m_n;
+    m_mean.reference(config.readArray<double,1>("mean"));
+    m_scatter.reference(config.readArray<double,2>("scatter"));
+    if (m_scatter.extent(0) != m_mean.extent(0) || m_scatter.extent(1) != m_mean.extent(0)) {
+      boost::format m("the scatter matrix with shape (%d, %d) does not match the mean with length %d");
+      m % m_scatter.extent(0) % m_scatter.extent(1) % m_mean.extent(0);
+      throw std::runtime_error(m.str());
+    }
+  }
+
+  void ScatterAccumulator::save(bob::io::base::HDF5File& config) const
+  {
+    config.set("n_samples", (uint64_t)m_n);
+    config.set("sum_of_weights", m_weight);
+    config.setArray("mean", m_mean);
+    config.setArray("scatter", m_scatter);
+  }
+
+  double weighted_mean(const blitz::Array<double,2>& data,
+    const blitz::Array<double,1>& weights, blitz::Array<double,1>& mean)
+  {
+    const int n = data.extent(0), d = data.extent(1);
+    check_weights(weights, n);
+
+    double total = 0.;
+    mean = 0.;
+    for (int k = 0; k < n; ++k) {
+      if (weights(k) == 0.) continue;
+      for (int i = 0; i < d; ++i) mean(i) += data(k,i) * weights(k);
+      total += weights(k);
+    }
+    mean /= total;
+    return total;
+  }
+
+  double weighted_scatter(const blitz::Array<double,2>& data,
+    const blitz::Array<double,1>& weights, blitz::Array<double,2>& scatter,
+    blitz::Array<double,1>& mean)
+  {
+    check_weights(weights, data.extent(0));
+    return block_scatter(data, weights, scatter, mean);
+  }
+
+  std::vector<ScatterAccumulator> class_statistics(
+    const std::vector<blitz::Array<double,2> >& data,
+    const std::vector<blitz::Array<double,1> >& weights)
+  {
+    if (weights.size() != data.size()) {
+      boost::format m("the number of weight arrays (%u) does not match the number of classes (%u)");
+      m % weights.size() % data.size();
+      throw std::runtime_error(m.str());
+    }
+    std::vector<ScatterAccumulator> statistics;
+    statistics.reserve(data.size());
+    for (size_t k = 0; k < data.size(); ++k) {
+      statistics.push_back(ScatterAccumulator(data[k].extent(1)));
+      statistics.back().update(data[k], weights[k]);
+    }
+    return statistics;
+  }
+
+  void scatters(const std::vector<ScatterAccumulator>& classes,
+    blitz::Array<double,2>& Sw, blitz::Array<double,2>& Sb,
+    blitz::Array<double,1>& mean)
+  {
+    if (classes.empty())
+      throw std::runtime_error("the scatter matrices require the statistics of at least one class");
+
+    const int n_features = classes[0].numberOfFeatures();
+    double total = 0.;
+    Sw = 0.;
+    mean = 0.;
+    for (size_t k = 0; k < classes.size(); ++k) {
+      if ((int)classes[k].numberOfFeatures() != n_features) {
+        boost::format m("the dimensionality of the accumulator at position %u (%u) differs from the one at position 0 (%d)");
+        m % k % classes[k].numberOfFeatures() % n_features;
+        throw std::runtime_error(m.str());
+      }
+      if (!classes[k].numberOfSamples()) {
+        boost::format m("the accumulator at position %u does not contain any samples");
+        m % k;
+        throw std::runtime_error(m.str());
+      }
+      const double n = classes[k].sumOfWeights();
+      Sw += classes[k].getScatter();
+      mean += classes[k].getMean() * n;
+      total += n;
+    }
+    mean /= total;
+
+    // between-class scatter, weighted by the sum of sample weights per class
+    blitz::firstIndex i;
+    blitz::secondIndex j;
+    blitz::Array<double,1> delta(n_features);
+    Sb = 0.;
+    for (size_t k = 0; k < classes.size(); ++k) {
+      delta = classes[k].getMean() - mean;
+      Sb += delta(i) * delta(j) * classes[k].sumOfWeights();
+    }
+  }
+
+}}}
@@ -0,0 +1,48 @@
+/**
+ * @date Sun Oct 18 16:02:13 CEST 2026
+ *
+ * @brief A sparse matrix in the compressed sparse row (CSR) format
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#include <bob.learn.linear/sparse.h>
+#include <boost/format.hpp>
+#include <stdexcept>
+
+namespace bob { namespace learn { namespace linear {
+
+  CSRMatrix::CSRMatrix(const blitz::Array<double,1>& data,
+      const blitz::Array<int64_t,1>& indices,
+      const blitz::Array<int64_t,1>& indptr,
+      const size_t n_columns):
+    m_data(data),
+    m_indices(indices),
+    m_indptr(indptr),
+    m_n_columns(n_columns)
+  {
+    if (indptr.extent(0) < 1 || indptr(0) != 0) {
+      throw std::runtime_error("the row offsets of a CSR matrix need to start with 0");
+    }
+    if (data.extent(0) != indices.extent(0)) {
+      boost::format m("a CSR matrix needs as many indices as values, but there are %d indices and %d values");
+      m % indices.extent(0) % data.extent(0);
+      throw std::runtime_error(m.str());
+    }
+    for (int i = 1; i < indptr.extent(0); ++i) {
+      if (indptr(i) < indptr(i-1) || indptr(i) > data.extent(0)) {
+        boost::format m("the row offsets of a CSR matrix need to be increasing and at most the number of values (%d), but row %d ends at %d");
+        m % data.extent(0) % (i-1) % indptr(i);
+        throw std::runtime_error(m.str());
+      }
+    }
+    for (int64_t n = 0; n < indptr(indptr.extent(0)-1); ++n) {
+      if (indices(n) < 0 || indices(n) >= (int64_t)n_columns) {
+        boost::format m("the column indices of a CSR matrix need to be in the range [0,%d[, but index %d is %d");
+        m % n_columns % n % indices(n);
+        throw std::runtime_error(m.str());
+      }
+    }
+  }
+
+}}}
@@ -6,35 +6,69 @@
  * Copyright (C) Idiap Research Institute, Martigny, Switzerland
  */
 
+#include <utility>
 #include <boost/make_shared.hpp>
-#include <bob.math/inv.h>
-#include <bob.math/lu.h>
 #include <bob.math/stats.h>
 
 #include <bob.learn.linear/wccn.h>
+#include <bob.learn.linear/whitening.h>
 
 namespace bob { namespace learn { namespace linear {
 
-  WCCNTrainer::WCCNTrainer() {
+  WCCNTrainer::WCCNTrainer(double eigenvalue_floor):
+    m_eigenvalue_floor(eigenvalue_floor) {
   }
 
-  WCCNTrainer::WCCNTrainer(const WCCNTrainer& other) {
+  WCCNTrainer::WCCNTrainer(const WCCNTrainer& other):
+    m_eigenvalue_floor(other.m_eigenvalue_floor) {
   }
 
   WCCNTrainer::~WCCNTrainer() {}
 
   WCCNTrainer& WCCNTrainer::operator= (const WCCNTrainer& other) {
+    if (this != &other) {
+      m_eigenvalue_floor = other.m_eigenvalue_floor;
+    }
     return *this;
   }
 
   bool WCCNTrainer::operator== (const WCCNTrainer& other) const {
-    return true;
+    return m_eigenvalue_floor == other.m_eigenvalue_floor;
   }
 
   bool WCCNTrainer::operator!= (const WCCNTrainer& other) const {
     return !(this->operator==(other));
   }
 
+  /**
+   * Checks that the machine is square with the given number of features
+   */
+  static void check_machine(const Machine& machine, int n_features) {
+    const size_t n_inputs = machine.inputSize();
+    const size_t n_outputs = machine.outputSize();
+
+    if ((int)n_inputs != n_features) {
+      boost::format m("machine input size (%u) does not match the number of columns in input array (%d)");
+      m % n_inputs % n_features;
+      throw std::runtime_error(m.str());
+    }
+    if ((int)n_outputs != n_features) {
+      boost::format m("machine output size (%u) does not match the number of columns in output array (%d)");
+      m % n_outputs % n_features;
+      throw std::runtime_error(m.str());
+    }
+  }
+
+  /**
+   * Hands the given WCCN projection matrix over to the machine
+   */
+  static void set_machine(Machine& machine, blitz::Array<double,2>&& W) {
+    machine.setInputSubtraction(0); // we do not substract the mean
+    machine.setInputDivision(1.);
+    machine.setWeights(std::move(W));
+    machine.setBiases(0);
+    machine.setActivation(boost::make_shared<bob::learn::activation::IdentityActivation>());
+  }
 
   void WCCNTrainer::train(Machine& machine,
       const std::vector<blitz::Array<double, 2> >& data) const {
@@ -58,42 +92,75 @@ namespace bob { namespace learn { namespace linear {
       }
     }
 
-    // machine dimensions
-    const size_t n_inputs = machine.inputSize();
-    const size_t n_outputs = machine.outputSize();
-
     // Checks that the dimensions are matching
-    if ((int)n_inputs != n_features) {
-      boost::format m("machine input size (%u) does not match the number of columns in input array (%d)");
-      m % n_inputs % n_features;
-      throw std::runtime_error(m.str());
-    }
-    if ((int)n_outputs != n_features) {
-      boost::format m("machine output size (%u) does not match the number of columns in output array (%d)");
-      m % n_outputs % n_features;
-      throw std::runtime_error(m.str());
-    }
+    check_machine(machine, n_features);
 
     // 1. Computes the mean vector and the Scatter matrix Sw and Sb
+    TrainingStats::Scope scope(m_stats.get());
+    scope.phase("scatter", sizeof(double) * n_features * (2*n_features + 1));
     blitz::Array<double,1> mean(n_features);
     blitz::Array<double,2> buf1(n_features, n_features); // Sw
     blitz::Array<double,2> buf2(n_features, n_features); // Sb
     bob::math::scatters(data, buf1, buf2, mean); // buf1 = Sw; buf2 = Sb
 
-    // 2. Computes the inverse of (1/N * Sw), Sw is the within-class covariance matrix
+    // 2. Computes cholesky((1/N * Sw)^{-1}) without inverting (1/N * Sw), Sw is the within-class covariance matrix
+    scope.phase("decomposition");
     buf1 /= n_classes;
-    bob::math::inv(buf1, buf2); // buf2 = (1/N * Sw)^{-1}
+    whitening_transform(buf1, buf2, m_eigenvalue_floor, m_stats.get()); // buf2 = cholesky((1/N * Sw)^{-1})
+
+    // 3. Updates the linear machine
+    scope.phase("machine update");
+    set_machine(machine, std::move(buf2));
+  }
+
+  void WCCNTrainer::train(Machine& machine,
+      const std::vector<blitz::Array<double, 2> >& data,
+      const std::vector<blitz::Array<double, 1> >& weights) const {
+    // the accumulation of the weighted statistics is part of the scatter phase
+    TrainingStats::Scope scope(m_stats.get());
+    const size_t n_features = data.empty() ? 0 : data[0].extent(1);
+    scope.phase("scatter", sizeof(double) * data.size() * n_features * (n_features + 1));
+    train(machine, class_statistics(data, weights));
+  }
+
+  void WCCNTrainer::train(Machine& machine,
+      const std::vector<ScatterAccumulator>& statistics) const {
+
+    const size_t n_classes = statistics.size();
+    // if #classes < 2, then throw
+    if (n_classes < 2) {
+      boost::format m("number of classes should be >= 2, but you passed %u");
+      m % n_classes;
+      throw std::runtime_error(m.str());
+    }
+
+    const int n_features = statistics[0].numberOfFeatures();
+    for (size_t cl=0; cl<n_classes; ++cl) {
+      if ((int)statistics[cl].numberOfFeatures() != n_features) {
+        boost::format m("number of features of the statistics for class %u (%u) does not match that of the statistics for class 0 (%d)");
+        m % cl % statistics[cl].numberOfFeatures() % n_features;
+        throw std::runtime_error(m.str());
+      }
+    }
+
+    check_machine(machine, n_features);
 
-  // 3. Computes the Cholesky decomposition of the inverse covariance matrix
-  bob::math::chol(buf2, buf1); //  buf1 = cholesky(buf2)
+    // 1. The within-class scatter matrix Sw is the sum of the class scatters
+    TrainingStats::Scope scope(m_stats.get());
+    scope.phase("scatter", sizeof(double) * n_features * n_features);
+    blitz::Array<double,2> Sw(n_features, n_features);
+    Sw = 0.;
+    for (size_t cl=0; cl<n_classes; ++cl) Sw += statistics[cl].getScatter();
 
-  // 4. Updates the linear machine
-  machine.setInputSubtraction(0); // we do not substract the mean
-  machine.setInputDivision(1.);
-  machine.setWeights(buf1);
-  machine.setBiases(0);
-  machine.setActivation(boost::make_shared<bob::learn::activation::IdentityActivation>());
+    // 2. Computes cholesky((1/N * Sw)^{-1}) without inverting (1/N * Sw)
+    scope.phase("decomposition", sizeof(double) * n_features * n_features);
+    Sw /= n_classes;
+    blitz::Array<double,2> W(n_features, n_features);
+    whitening_transform(Sw, W, m_eigenvalue_floor, m_stats.get());
 
+    // 3. Updates the linear machine
+    scope.phase("machine update");
+    set_machine(machine, std::move(W));
   }
 
 }}}
@@ -5,20 +5,147 @@
  * Copyright (C) Idiap Research Institute, Martigny, Switzerland
  */
 
+#include <algorithm>
+#include <cmath>
+#include <utility>
 #include <boost/make_shared.hpp>
-#include <bob.math/inv.h>
-#include <bob.math/lu.h>
+#include <bob.math/eig.h>
 #include <bob.math/stats.h>
 
 #include <bob.learn.linear/whitening.h>
 
+// Declaration of the external LAPACK functions (Cholesky decomposition and
+// inverse of a triangular matrix)
+extern "C" void dpotrf_(const char* uplo, const int* n, double* A,
+  const int* lda, int* info);
+extern "C" void dtrtri_(const char* uplo, const char* diag, const int* n,
+  double* A, const int* lda, int* info);
+
 namespace bob { namespace learn { namespace linear {
 
-  WhiteningTrainer::WhiteningTrainer()
+  /**
+   * Computes the lower triangular Cholesky factor K of J C J - shift I in
+   * place of the given (C-ordered) D x D matrix, where J reverses the order of
+   * rows and columns. Returns false if the shifted matrix is not positive
+   * definite.
+   */
+  static bool flipped_cholesky(const blitz::Array<double,2>& covariance,
+    double shift, blitz::Array<double,2>& K)
   {
+    const int n = covariance.extent(0);
+    for (int i = 0; i < n; ++i)
+      for (int j = 0; j < n; ++j)
+        K(i,j) = covariance(n-1-i, n-1-j) - (i == j ? shift : 0.);
+
+    // LAPACK sees the transposed (column-major) matrix, so that its upper
+    // triangular factor U = K^T is the lower triangular K in C order
+    const char uplo = 'U';
+    const int lda = std::max(n, 1);
+    int info = 0;
+    dpotrf_(&uplo, &n, K.data(), &lda, &info);
+    if (info < 0) throw std::runtime_error("the Cholesky factorization of the covariance matrix failed");
+    return info == 0;
   }
 
-  WhiteningTrainer::WhiteningTrainer(const WhiteningTrainer& other)
+  void whitening_transform(const blitz::Array<double,2>& covariance,
+    blitz::Array<double,2>& W, double eigenvalue_floor, TrainingStats* stats)
+  {
+    const int n = covariance.extent(0);
+    if (stats) stats->allocated(sizeof(double) * n * n);
+    blitz::Array<double,2> K(n,n);
+
+    // all eigenvalues of C exceed the floor if C - floor I is positive
+    // definite, which is cheaper to test than to decompose C
+    if (eigenvalue_floor > 0. && !flipped_cholesky(covariance, eigenvalue_floor, K)) {
+      if (stats) stats->allocated(sizeof(double) * n);
+      // W = U diag(1/sqrt(max(e, floor))), with C = U diag(e) U^T
+      blitz::Array<double,1> e(n);
+      bob::math::eigSym_(covariance, K, e);
+      e.reverseSelf(0);
+      K.reverseSelf(1);
+
+      blitz::firstIndex i;
+      blitz::secondIndex j;
+      W = K(i,j) / blitz::sqrt(blitz::where(e(j) > eigenvalue_floor, e(j), eigenvalue_floor));
+      return;
+    }
+
+    // cholesky(inv(C)) = J inv(K)^T J, where K = cholesky(J C J)
+    if (!flipped_cholesky(covariance, 0., K))
+      throw std::runtime_error("the covariance matrix is not positive definite; set a positive eigenvalue floor");
+
+    // inverts K in place (as its transpose, see flipped_cholesky())
+    const char uplo = 'U', diag = 'N';
+    const int lda = std::max(n, 1);
+    int info = 0;
+    dtrtri_(&uplo, &diag, &n, K.data(), &lda, &info);
+    if (info != 0) throw std::runtime_error("the Cholesky factor of the covariance matrix is singular");
+
+    // only the lower triangle of inv(K) is set
+    for (int i = 0; i < n; ++i)
+      for (int j = 0; j < n; ++j)
+        W(i,j) = j <= i ? K(n-1-j, n-1-i) : 0.;
+  }
+
+  /**
+   * Computes the PCA (U_k diag(1/sqrt(e_k))) or ZCA (U diag(1/sqrt(e)) U^T)
+   * whitening matrix W of the given covariance matrix from a single
+   * eigendecomposition. In PCA mode, W has as many columns as requested.
+   */
+  static void eigen_whitening(const blitz::Array<double,2>& covariance,
+    blitz::Array<double,2>& W, double eigenvalue_floor, bool zca,
+    TrainingStats* stats)
+  {
+    const int n = covariance.extent(0);
+    const int k = W.extent(1);
+    if (stats) stats->allocated(sizeof(double) * ((size_t)n * (n + 1) * (zca ? 2 : 1) + (zca ? 0 : k)));
+
+    blitz::Array<double,2> U(n,n);
+    blitz::Array<double,1> e(n);
+    bob::math::eigSym_(covariance, U, e);
+    e.reverseSelf(0);
+    U.reverseSelf(1);
+
+    // the scale of each of the used eigenvectors
+    const int used = zca ? n : k;
+    blitz::Array<double,1> scale(used);
+    for (int c = 0; c < used; ++c) {
+      const double value = std::max(e(c), eigenvalue_floor);
+      if (value <= 0.) {
+        boost::format m("the covariance matrix is singular (eigenvalue %d is %g); set a positive eigenvalue floor");
+        m % c % e(c);
+        throw std::runtime_error(m.str());
+      }
+      scale(c) = 1. / std::sqrt(value);
+    }
+
+    blitz::firstIndex i;
+    blitz::secondIndex j;
+    blitz::thirdIndex l;
+    blitz::Range a = blitz::Range::all(), r(0, used-1);
+    if (zca) {
+      // scale the eigenvectors once and multiply with the unscaled ones
+      blitz::Array<double,2> scaled(n,n);
+      scaled = U(i,j) * scale(j);
+      W = blitz::sum(scaled(i,l) * U(j,l), l);
+    } else {
+      blitz::Array<double,2> leading = U(a,r);
+      W = leading(i,j) * scale(j);
+    }
+  }
+
+  WhiteningTrainer::WhiteningTrainer(double eigenvalue_floor, Mode mode,
+      size_t n_components):
+    m_eigenvalue_floor(eigenvalue_floor),
+    m_mode(mode),
+    m_n_components(n_components)
+  {
+  }
+
+  WhiteningTrainer::WhiteningTrainer(const WhiteningTrainer& other):
+    m_eigenvalue_floor(other.m_eigenvalue_floor),
+    m_mode(other.m_mode),
+    m_n_components(other.m_n_components)
   {
   }
 
@@ -26,23 +153,69 @@ namespace bob { namespace learn { namespace linear {
 
   WhiteningTrainer& WhiteningTrainer::operator= (const WhiteningTrainer& other)
   {
+    if (this != &other) {
+      m_eigenvalue_floor = other.m_eigenvalue_floor;
+      m_mode = other.m_mode;
+      m_n_components = other.m_n_components;
+    }
     return *this;
   }
 
   bool WhiteningTrainer::operator== (const WhiteningTrainer& other) const
   {
-    return true;
+    return m_eigenvalue_floor == other.m_eigenvalue_floor &&
+      m_mode == other.m_mode &&
+      m_n_components == other.m_n_components;
   }
 
   bool WhiteningTrainer::operator!= (const WhiteningTrainer& other) const
   {
-    return false;
+    return !(this->operator==(other));
+  }
+
+  size_t WhiteningTrainer::outputSize(size_t n_features) const
+  {
+    if (m_mode == PCA && m_n_components) return m_n_components;
+    return n_features;
   }
 
   void WhiteningTrainer::train(Machine& machine, const blitz::Array<double,2>& ar) const {
-    // training data dimensions
+    // 1. Computes the mean vector and the covariance matrix of the training set
+    check_machine(machine, ar.extent(1));
     const size_t n_samples = ar.extent(0);
     const size_t n_features = ar.extent(1);
+    TrainingStats::Scope scope(m_stats.get());
+    scope.phase("scatter", sizeof(double) * n_features * (n_features + 1));
+    blitz::Array<double,1> mean(n_features);
+    blitz::Array<double,2> cov(n_features,n_features);
+    bob::math::scatter(ar, cov, mean);
+    cov /= (double)(n_samples-1);
+
+    whiten(machine, mean, cov, scope);
+  }
+
+  void WhiteningTrainer::train(Machine& machine, const blitz::Array<double,2>& data,
+      const blitz::Array<double,1>& weights) const {
+    TrainingStats::Scope scope(m_stats.get());
+    scope.phase("scatter", sizeof(double) * data.extent(1) * (data.extent(1) + 1));
+    ScatterAccumulator statistics(data.extent(1));
+    statistics.update(data, weights);
+    train(machine, statistics);
+  }
+
+  void WhiteningTrainer::train(Machine& machine, const ScatterAccumulator& statistics) const {
+    // 1. The mean vector and the covariance matrix are already accumulated
+    check_machine(machine, statistics.numberOfFeatures());
+    const size_t n_features = statistics.numberOfFeatures();
+    TrainingStats::Scope scope(m_stats.get());
+    scope.phase("scatter", sizeof(double) * n_features * n_features);
+    blitz::Array<double,2> cov(n_features, n_features);
+    statistics.covariance(cov);
+
+    whiten(machine, statistics.getMean(), cov, scope);
+  }
+
+  void WhiteningTrainer::check_machine(const Machine& machine, size_t n_features) const {
     // machine dimensions
     const size_t n_inputs = machine.inputSize();
     const size_t n_outputs = machine.outputSize();
@@ -53,30 +226,37 @@ namespace bob { namespace learn { namespace linear {
       m % n_inputs % n_features;
       throw std::runtime_error(m.str());
     }
-    if (n_outputs != n_features) {
-      boost::format m("machine output size (%u) does not match the number of columns in output array (%d)");
-      m % n_outputs % n_features;
+    if (m_mode == PCA && m_n_components > n_features) {
+      boost::format m("the number of components (%u) exceeds the number of columns in input array (%d)");
+      m % m_n_components % n_features;
       throw std::runtime_error(m.str());
     }
+    if (n_outputs != outputSize(n_features)) {
+      boost::format m("machine output size (%u) does not match the expected output size (%d)");
+      m % n_outputs % outputSize(n_features);
+      throw std::runtime_error(m.str());
+    }
+  }
 
-    // 1. Computes the mean vector and the covariance matrix of the training set
-    blitz::Array<double,1> mean(n_features);
-    blitz::Array<double,2> cov(n_features,n_features);
-    bob::math::scatter(ar, cov, mean);
-    cov /= (double)(n_samples-1);
-
-    // 2. Computes the inverse of the covariance matrix
-    blitz::Array<double,2> icov(n_features,n_features);
-    bob::math::inv(cov, icov);
+  void WhiteningTrainer::whiten(Machine& machine, const blitz::Array<double,1>& mean,
+    const blitz::Array<double,2>& cov, TrainingStats::Scope& scope) const {
+    const size_t n_features = cov.extent(0);
+    const size_t n_outputs = machine.outputSize();
 
-    // 3. Computes the Cholesky decomposition of the inverse covariance matrix
-    blitz::Array<double,2> whiten(n_features,n_features);
-    bob::math::chol(icov, whiten);
+    // 2. Computes the whitening matrix; cholesky(inv(cov)) is obtained
+    // without inverting cov
+    scope.phase("decomposition", sizeof(double) * n_features * n_outputs);
+    blitz::Array<double,2> W(n_features,n_outputs);
+    if (m_mode == CHOLESKY)
+      whitening_transform(cov, W, m_eigenvalue_floor, m_stats.get());
+    else
+      eigen_whitening(cov, W, m_eigenvalue_floor, m_mode == ZCA, m_stats.get());
 
-    // 4. Updates the linear machine
+    // 3. Updates the linear machine
+    scope.phase("machine update");
     machine.setInputSubtraction(mean);
     machine.setInputDivision(1.);
-    machine.setWeights(whiten);
+    machine.setWeights(std::move(W));
     machine.setBiases(0);
     machine.setActivation(boost::make_shared<bob::learn::activation::IdentityActivation>());
   }
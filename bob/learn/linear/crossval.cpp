@@ -0,0 +1,192 @@
+/**
+ * @date Sun Oct 18 17:40:27 CEST 2026
+ *
+ * @brief Python bindings to the k-fold cross-validation of the trainers
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#define BOB_LEARN_LINEAR_MODULE
+#include <sstream>
+#include <vector>
+#include <bob.blitz/cppapi.h>
+#include <bob.blitz/cleanup.h>
+#include <bob.learn.linear/api.h>
+#include <bob.core/logging.h>
+#include <bob.learn.linear/crossval.h>
+#include <bob.extension/documentation.h>
+
+static auto cross_validate = bob::extension::FunctionDoc(
+  "cross_validate",
+  "Runs a k-fold cross-validation of a :py:class:`bob.learn.linear.PCATrainer`, :py:class:`bob.learn.linear.FisherLDATrainer` or :py:class:`bob.learn.linear.CGLogRegTrainer`",
+  "Each sample is assigned to a fold by the non-negative integer at the same position of ``folds``, and the number of folds is the largest fold index plus 1. "
+  "For each fold, a machine is trained on the samples of all other folds, and the samples of the fold are projected with this machine to obtain their held-out ``scores``. "
+  "The folds are trained and scored in ``n_threads`` parallel threads, which share the data without copying it; the data must not be modified from other threads meanwhile.\n\n"
+  "The ``data`` and ``folds`` depend on the trainer:\n\n"
+  "* :py:class:`bob.learn.linear.PCATrainer`: a single 2D array of samples and a 1D array of fold indices; ``scores`` is a 2D array\n"
+  "* :py:class:`bob.learn.linear.FisherLDATrainer`: a list with the 2D array of samples of each class, and a list with the 1D array of fold indices of each class; ``scores`` is a list of 2D arrays, one per class\n"
+  "* :py:class:`bob.learn.linear.CGLogRegTrainer`: the ``(negatives, positives)`` pair, and the pair of their fold indices; ``scores`` is the pair of 1D arrays of the scores of the negatives and of the positives\n\n"
+  "For the :py:class:`bob.learn.linear.PCATrainer` and the :py:class:`bob.learn.linear.FisherLDATrainer`, the data is scanned only once to accumulate the statistics of each fold (see :py:class:`bob.learn.linear.ScatterAccumulator`), and the statistics of the training samples of a fold are obtained by subtracting the statistics of the fold from the statistics of all data. "
+  "Hence, the :py:class:`bob.learn.linear.PCATrainer` always uses the covariance method. "
+  "If the machines of the folds have different numbers of outputs, all are truncated to the smallest one.",
+  true
+)
+.add_prototype("trainer, data, folds, [n_threads]", "machines, scores")
+.add_parameter("trainer", ":py:class:`bob.learn.linear.PCATrainer`, :py:class:`bob.learn.linear.FisherLDATrainer` or :py:class:`bob.learn.linear.CGLogRegTrainer`", "The trainer to cross-validate")
+.add_parameter("data", "array_like(2D, float) or [array_like(2D, float)]", "The samples, one per row, or the samples of each class, see above")
+.add_parameter("folds", "array_like(1D, int) or [array_like(1D, int)]", "The fold index of each sample, in the same layout as ``data``")
+.add_parameter("n_threads", "int", "[Default: ``0``] The number of threads; ``0`` runs one thread per processor")
+.add_return("machines", "[:py:class:`bob.learn.linear.Machine`]", "The machine of each fold, trained without the samples of the fold")
+.add_return("scores", "array_like(float) or [array_like(float)]", "The outputs of the machine of its fold for each sample, in the same layout as ``data``")
+;
+
+/**
+ * Converts the given object into a 2D 64-bit float array, which is appended
+ * to data and kept alive in keep
+ */
+static bool convert_data(PyObject* o, std::vector<blitz::Array<double,2> >& data, std::vector<boost::shared_ptr<PyBlitzArrayObject> >& keep) {
+  PyBlitzArrayObject* bz = 0;
+  if (!PyBlitzArray_Converter(o, &bz)) return false;
+  keep.push_back(make_safe(bz));
+  if (bz->ndim != 2 || bz->type_num != NPY_FLOAT64) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for the samples in `data', but an array with %" PY_FORMAT_SIZE_T "d dimensions and with type `%s' was given", cross_validate.name(), bz->ndim, PyBlitzArray_TypenumAsString(bz->type_num));
+    return false;
+  }
+  data.push_back(*PyBlitzArrayCxx_AsBlitz<double,2>(bz)); ///< only a view!
+  return true;
+}
+
+/**
+ * Converts the given object into a 1D array of 64-bit integers, which is
+ * appended to folds and kept alive in keep
+ */
+static bool convert_folds(PyObject* o, std::vector<blitz::Array<int64_t,1> >& folds, std::vector<boost::shared_ptr<PyObject> >& keep) {
+  PyObject* array = PyArray_FROMANY(o, NPY_INT64, 1, 1, NPY_ARRAY_CARRAY_RO);
+  if (!array) return false;
+  keep.push_back(make_safe(array));
+  PyArrayObject* a = reinterpret_cast<PyArrayObject*>(array);
+  folds.push_back(blitz::Array<int64_t,1>(static_cast<int64_t*>(PyArray_DATA(a)), blitz::shape(PyArray_DIM(a, 0)), blitz::neverDeleteData));
+  return true;
+}
+
+/**
+ * Calls convert for each element of the given sequence
+ */
+template <typename T, typename K>
+static bool convert_sequence(PyObject* sequence, std::vector<T>& result, std::vector<K>& keep, bool (*convert)(PyObject*, std::vector<T>&, std::vector<K>&)) {
+  auto iterator = make_xsafe(PyObject_GetIter(sequence));
+  if (!iterator) return false;
+  while (PyObject* item = PyIter_Next(iterator.get())) {
+    auto item_ = make_safe(item);
+    if (!convert(item, result, keep)) return false;
+  }
+  return !PyErr_Occurred();
+}
+
+static PyObject* PyBobLearnLinear_crossValidate(PyObject*, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  char** kwlist = cross_validate.kwlist();
+
+  PyObject* trainer,* data,* folds;
+  Py_ssize_t n_threads = 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOO|n", kwlist,
+        &trainer, &data, &folds, &n_threads)) return 0;
+
+  if (n_threads < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of threads, not %" PY_FORMAT_SIZE_T "d", cross_validate.name(), n_threads);
+    return 0;
+  }
+
+  const bool pca = PyBobLearnLinearPCATrainer_Check(trainer);
+  const bool lda = PyBobLearnLinearFisherLDATrainer_Check(trainer);
+  const bool logreg = PyBobLearnLinearCGLogRegTrainer_Check(trainer);
+  if (!pca && !lda && !logreg) {
+    PyErr_Format(PyExc_TypeError, "`%s' can only cross-validate objects of type `%s', `%s' or `%s', but `%s' was given",
+        cross_validate.name(), PyBobLearnLinearPCATrainer_Type.tp_name, PyBobLearnLinearFisherLDATrainer_Type.tp_name,
+        PyBobLearnLinearCGLogRegTrainer_Type.tp_name, Py_TYPE(trainer)->tp_name);
+    return 0;
+  }
+
+  std::vector<blitz::Array<double,2> > X;
+  std::vector<blitz::Array<int64_t,1> > F;
+  std::vector<boost::shared_ptr<PyBlitzArrayObject> > X_; ///< prevents data deletion
+  std::vector<boost::shared_ptr<PyObject> > F_; ///< prevents data deletion
+  if (pca) {
+    if (!convert_data(data, X, X_) || !convert_folds(folds, F, F_)) return 0;
+  }
+  else {
+    if (!convert_sequence(data, X, X_, convert_data) || !convert_sequence(folds, F, F_, convert_folds)) return 0;
+  }
+
+  // the folds run in parallel threads, which do not need the GIL; the
+  // messages of the solver are logged once the GIL is held again
+  std::ostringstream log;
+  std::vector<bob::learn::linear::Machine> machines;
+  std::vector<blitz::Array<double,2> > scores(1);
+  PyThreadState* state = PyEval_SaveThread();
+  try {
+    if (pca)
+      bob::learn::linear::cross_validate(*reinterpret_cast<PyBobLearnLinearPCATrainerObject*>(trainer)->cxx, X[0], F[0], machines, scores[0], n_threads);
+    else if (lda)
+      bob::learn::linear::cross_validate(*reinterpret_cast<PyBobLearnLinearFisherLDATrainerObject*>(trainer)->cxx, X, F, machines, scores, n_threads);
+    else
+      bob::learn::linear::cross_validate(*reinterpret_cast<PyBobLearnLinearCGLogRegTrainerObject*>(trainer)->cxx, X, F, machines, scores, log, n_threads);
+  }
+  catch (...) {
+    PyEval_RestoreThread(state);
+    throw;
+  }
+  PyEval_RestoreThread(state);
+  bob::core::info << log.str();
+
+  PyObject* machines_list = PyList_New(machines.size());
+  if (!machines_list) return 0;
+  auto machines_list_ = make_safe(machines_list);
+  for (size_t k = 0; k < machines.size(); ++k) {
+    PyObject* machine = PyBobLearnLinearMachine_NewFromSize(0, 0);
+    if (!machine) return 0;
+    *reinterpret_cast<PyBobLearnLinearMachineObject*>(machine)->cxx = machines[k];
+    PyList_SET_ITEM(machines_list, k, machine);
+  }
+
+  if (pca) {
+    auto scores_array = make_xsafe(PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(scores[0])));
+    if (!scores_array) return 0;
+    return Py_BuildValue("(OO)", machines_list, scores_array.get());
+  }
+
+  // the logistic regression has a single score per sample
+  PyObject* scores_list = PyList_New(scores.size());
+  if (!scores_list) return 0;
+  auto scores_list_ = make_safe(scores_list);
+  for (size_t c = 0; c < scores.size(); ++c) {
+    PyObject* array = logreg ?
+      PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(blitz::Array<double,1>(scores[c](blitz::Range::all(), 0)))) :
+      PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(scores[c]));
+    if (!array) return 0;
+    PyList_SET_ITEM(scores_list, c, array);
+  }
+  return Py_BuildValue("(OO)", machines_list, scores_list);
+BOB_CATCH_FUNCTION("cross_validate", 0)
+}
+
+static PyMethodDef PyBobLearnLinearCrossValidation_methods[] = {
+  {
+    cross_validate.name(),
+    (PyCFunction)PyBobLearnLinear_crossValidate,
+    METH_VARARGS|METH_KEYWORDS,
+    cross_validate.doc()
+  },
+  {0} /* Sentinel */
+};
+
+bool init_BobLearnLinearCrossValidation(PyObject* module)
+{
+  // add the cross-validation functions to the module
+  for (PyMethodDef* def = PyBobLearnLinearCrossValidation_methods; def->ml_name; ++def) {
+    PyObject* function = PyCFunction_NewEx(def, 0, 0);
+    if (!function) return false;
+    if (PyModule_AddObject(module, def->ml_name, function) < 0) return false;
+  }
+  return true;
+}
@@ -0,0 +1,904 @@
+/**
+ * @date Sun Oct 18 10:12:41 CEST 2026
+ *
+ * @brief Python bindings to the Geodesic Flow Kernel training and evaluation
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#define BOB_LEARN_LINEAR_MODULE
+#include <bob.blitz/cppapi.h>
+#include <bob.blitz/cleanup.h>
+#include <bob.learn.linear/api.h>
+#include <bob.learn.linear/gfk.h>
+#include <bob.io.base/api.h>
+#include <bob.extension/documentation.h>
+
+/******************************************
+ * Implementation of the kernel functions *
+ ******************************************/
+
+static auto gfk_kernel = bob::extension::FunctionDoc(
+  "gfk_kernel",
+  "Computes the Geodesic Flow Kernel between all pairs of source and target samples",
+  "Source and target samples (one per row) are normalized with the ``input_subtract`` and ``input_divide`` of the ``source_machine`` and the ``target_machine``, respectively. "
+  "Afterwards, the kernel matrix :math:`K = \\tilde{X}_s G \\tilde{X}_t^T` is computed in one shot.\n\n"
+  "The kernel matrix :math:`G` can be given either as a dense ``(D, D)`` matrix, or in factored form :math:`G = U C U^T` with a ``(D, K)`` ``basis`` :math:`U` and a ``(K, K)`` ``core`` matrix :math:`C`. "
+  "In the latter case, the samples are projected only once into the :math:`K`-dimensional space, so that the cost scales with :math:`D \\cdot K` instead of :math:`D^2`."
+)
+.add_prototype("source_machine, target_machine, source, target, G", "kernel")
+.add_prototype("source_machine, target_machine, source, target, basis, core", "kernel")
+.add_parameter("source_machine", ":py:class:`bob.learn.linear.Machine`", "The machine that holds the normalization of the source domain")
+.add_parameter("target_machine", ":py:class:`bob.learn.linear.Machine`", "The machine that holds the normalization of the target domain")
+.add_parameter("source", "array_like(2D, float)", "The source domain samples, one per row")
+.add_parameter("target", "array_like(2D, float)", "The target domain samples, one per row")
+.add_parameter("G", "array_like(2D, float)", "The dense kernel matrix")
+.add_parameter("basis", "array_like(2D, float)", "The basis :math:`U` of the factored kernel matrix")
+.add_parameter("core", "array_like(2D, float)", "The core matrix :math:`C` of the factored kernel matrix")
+.add_return("kernel", "array_like(2D, float)", "The kernel matrix between all source and target samples, with shape ``(source.shape[0], target.shape[0])``")
+;
+static PyObject* PyBobLearnLinear_gfkKernel(PyObject*, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  Py_ssize_t nargs = (args?PyTuple_Size(args):0) + (kwds?PyDict_Size(kwds):0);
+  char** kwlist = gfk_kernel.kwlist(nargs == 6 ? 1 : 0);
+
+  PyBobLearnLinearMachineObject* source_machine,* target_machine;
+  PyBlitzArrayObject* source,* target,* matrix,* core = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!O!O&O&O&|O&", kwlist,
+        &PyBobLearnLinearMachine_Type, &source_machine,
+        &PyBobLearnLinearMachine_Type, &target_machine,
+        &PyBlitzArray_Converter, &source,
+        &PyBlitzArray_Converter, &target,
+        &PyBlitzArray_Converter, &matrix,
+        &PyBlitzArray_Converter, &core
+        ))
+    return 0;
+
+  auto source_ = make_safe(source), target_ = make_safe(target), matrix_ = make_safe(matrix);
+  auto core_ = make_xsafe(core);
+
+  PyBlitzArrayObject* arrays[] = {source, target, matrix, core};
+  const char* names[] = {"source", "target", core ? "basis" : "G", "core"};
+  for (int i = 0; i < 4; ++i) {
+    if (arrays[i] && (arrays[i]->ndim != 2 || arrays[i]->type_num != NPY_FLOAT64)) {
+      PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for input array `%s'", gfk_kernel.name(), names[i]);
+      return 0;
+    }
+  }
+
+  Py_ssize_t shape[2] = {source->shape[0], target->shape[0]};
+  auto kernel = reinterpret_cast<PyBlitzArrayObject*>(PyBlitzArray_SimpleNew(NPY_FLOAT64, 2, shape));
+  auto kernel_ = make_safe(kernel);
+  auto kernel_bz = PyBlitzArrayCxx_AsBlitz<double,2>(kernel);
+
+  if (core) {
+    bob::learn::linear::gfk_kernel(*source_machine->cxx, *target_machine->cxx,
+      *PyBlitzArrayCxx_AsBlitz<double,2>(matrix), *PyBlitzArrayCxx_AsBlitz<double,2>(core),
+      *PyBlitzArrayCxx_AsBlitz<double,2>(source), *PyBlitzArrayCxx_AsBlitz<double,2>(target),
+      *kernel_bz);
+  } else {
+    bob::learn::linear::gfk_kernel(*source_machine->cxx, *target_machine->cxx,
+      *PyBlitzArrayCxx_AsBlitz<double,2>(matrix),
+      *PyBlitzArrayCxx_AsBlitz<double,2>(source), *PyBlitzArrayCxx_AsBlitz<double,2>(target),
+      *kernel_bz);
+  }
+
+  return PyBlitzArray_AsNumpyArray(kernel, 0);
+BOB_CATCH_FUNCTION("gfk_kernel", 0)
+}
+
+/******************************************************************/
+/************ Constructor Section *********************************/
+/******************************************************************/
+
+static auto GFKMachine_doc = bob::extension::ClassDoc(
+  BOB_EXT_MODULE_PREFIX ".GFKMachine",
+  "Geodesic flow Kernel (GFK) Machine",
+  "This is the output of the :py:class:`bob.learn.linear.GFKTrainer`. "
+  "It holds the PCA projections of the source and the target domain (:py:attr:`source_machine` and :py:attr:`target_machine`), which also contain the input normalization of both domains, and the kernel matrix :math:`G`.\n\n"
+  "The kernel matrix :math:`G` can be stored densely (:py:attr:`G`), or in the factored form :math:`G = U C U^T` (:py:attr:`basis` and :py:attr:`core`). "
+  "The :py:attr:`basis` :math:`U = [P_s V_1, R_s V_2]` has shape ``(D, 2d)`` and the :py:attr:`core` :math:`C` is composed of the four diagonal blocks :math:`B_1, \\ldots, B_4`, so that memory and scoring costs scale with :math:`D \\cdot d` instead of :math:`D^2`. "
+  "For machines that only store the factors, :py:attr:`G` is computed on request."
+).add_constructor(
+  bob::extension::FunctionDoc(
+    "__init__",
+    "Creates a GFK Machine",
+    0,
+    true
+  )
+  .add_prototype("", "")
+  .add_prototype("other", "")
+  .add_prototype("hdf5", "")
+  .add_parameter("other", ":py:class:`bob.learn.linear.GFKMachine`", "Another machine to copy")
+  .add_parameter("hdf5", ":py:class:`bob.io.base.HDF5File`", "An HDF5 file open for reading")
+);
+
+static int PyBobLearnLinearGFKMachine_init(PyBobLearnLinearGFKMachineObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist1 = GFKMachine_doc.kwlist(1);
+  char** kwlist2 = GFKMachine_doc.kwlist(2);
+
+  Py_ssize_t nargs = (args?PyTuple_Size(args):0) + (kwargs?PyDict_Size(kwargs):0);
+  if (!nargs) {
+    // empty constructor
+    self->cxx.reset(new bob::learn::linear::GFKMachine());
+    return 0;
+  }
+
+  PyObject* k2 = Py_BuildValue("s", kwlist2[0]);
+  auto k2_ = make_safe(k2);
+  if (
+    (kwargs && PyDict_Contains(kwargs, k2)) ||
+    (args && PyTuple_Size(args) == 1 && PyBobIoHDF5File_Check(PyTuple_GetItem(args, 0)))
+  ){
+    // HDF5
+    PyBobIoHDF5FileObject* hdf5;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&", kwlist2, &PyBobIoHDF5File_Converter, &hdf5)) return -1;
+    auto hdf5_ = make_safe(hdf5);
+    self->cxx.reset(new bob::learn::linear::GFKMachine(*hdf5->f));
+  } else {
+    // copy construction
+    PyBobLearnLinearGFKMachineObject* other;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!", kwlist1, &PyBobLearnLinearGFKMachine_Type, &other)) return -1;
+    self->cxx.reset(new bob::learn::linear::GFKMachine(*other->cxx));
+  }
+  return 0;
+BOB_CATCH_MEMBER("constructor", -1)
+}
+
+static void PyBobLearnLinearGFKMachine_delete(PyBobLearnLinearGFKMachineObject* self) {
+  self->cxx.reset();
+  Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+int PyBobLearnLinearGFKMachine_Check(PyObject* o) {
+  return PyObject_IsInstance(o, reinterpret_cast<PyObject*>(&PyBobLearnLinearGFKMachine_Type));
+}
+
+static PyObject* PyBobLearnLinearGFKMachine_RichCompare(PyBobLearnLinearGFKMachineObject* self, PyObject* other, int op) {
+
+  if (!PyBobLearnLinearGFKMachine_Check(other)) {
+    PyErr_Format(PyExc_TypeError, "cannot compare `%s' with `%s'",
+        Py_TYPE(self)->tp_name, Py_TYPE(other)->tp_name);
+    return 0;
+  }
+
+  auto other_ = reinterpret_cast<PyBobLearnLinearGFKMachineObject*>(other);
+
+  switch (op) {
+    case Py_EQ:
+      if (self->cxx->operator==(*other_->cxx)) Py_RETURN_TRUE;
+      Py_RETURN_FALSE;
+      break;
+    case Py_NE:
+      if (self->cxx->operator!=(*other_->cxx)) Py_RETURN_TRUE;
+      Py_RETURN_FALSE;
+      break;
+    default:
+      Py_INCREF(Py_NotImplemented);
+      return Py_NotImplemented;
+  }
+}
+
+
+static auto GFKTrainer_doc = bob::extension::ClassDoc(
+  BOB_EXT_MODULE_PREFIX ".GFKTrainer",
+  "Trains the Geodesic Flow Kernel (GFK) that models the domain shift from a certain source linear subspace :math:`P_S` to a certain target linear subspace :math:`P_T`",
+  "GFK models the source domain and the target domain with d-dimensional linear subspaces and embeds them onto a Grassmann manifold. "
+  "Specifically, let denote the basis of the PCA subspaces for each of the two domains, respectively. "
+  "The Grassmann manifold :math:`G(d,D)` is the collection of all d-dimensional subspaces of the feature vector space :math:`\\mathbb{R}^D`.\n\n"
+  "The geodesic flow :math:`\\phi(t)` between :math:`P_S, P_T` on the manifold parameterizes a path connecting the two subspaces. "
+  "In the beginning of the flow, the subspace is similar to that of the source domain and in the end of the flow, the subspace is similar to that of the target. "
+  "The original feature :math:`x` is projected into these subspaces and forms a feature vector of infinite dimensions:\n\n"
+  ":math:`z^{\\infty} = \\phi(t)^T x: t \\in [0, 1]`.\n\n"
+  "Using the new feature representation for learning, will force the classifiers to NOT lean towards either the source domain or the target domain, or in other words, will force the classifier to use domain-invariant features. "
+  "The infinite-dimensional feature vector is handled conveniently by their inner product that gives rise to a positive semidefinite kernel defined on the original features,\n\n"
+  ":math:`G(x_i, x_j) = x_{i}^T \\int_0^1 \\! \\phi(t)\\phi(t)^T  \\, \\mathrm{d}t x_{j} = x_i^T G x_j`.\n\n"
+  "The matrix G can be computed efficiently using singular value decomposition. Moreover, computing the kernel does not require any labeled data.\n\n"
+  "The statistics of both domains are gathered in a single pass over the data, without copying it. "
+  "The z-normalization of the inputs is folded into the covariance matrices, and the PCA of the source and the target domain are computed concurrently.\n\n"
+  "More details can be found in:\n\n"
+  "Gong, Boqing, et al. \"Geodesic flow kernel for unsupervised domain adaptation.\" Computer Vision and Pattern Recognition (CVPR), 2012 IEEE Conference on. IEEE, 2012.\n\n"
+  "A very good intuition can be found in: http://www-scf.usc.edu/~boqinggo/domainadaptation.html#gfk_section"
+).add_constructor(
+  bob::extension::FunctionDoc(
+    "__init__",
+    "Creates a GFK Trainer",
+    0,
+    true
+  )
+  .add_prototype("[number_of_subspaces], [subspace_dim_source], [subspace_dim_target], [eps], [factored]", "")
+  .add_parameter("number_of_subspaces", "int", "[default: -1] Number of subspaces for the transfer learning. If set to -1, this value will be estimated automatically. For more information check, Section 3.4.")
+  .add_parameter("subspace_dim_source", "float or int", "[default: 0.99] Energy kept in the source linear subspace (if given as float), or number of source PCA dimensions (if given as int)")
+  .add_parameter("subspace_dim_target", "float or int", "[default: 0.99] Energy kept in the target linear subspace (if given as float), or number of target PCA dimensions (if given as int)")
+  .add_parameter("eps", "float", "[default: 1e-20] Floor value")
+  .add_parameter("factored", "bool", "[default: ``False``] If set, the trained machine stores the kernel matrix in factored form only, see :py:class:`bob.learn.linear.GFKMachine`")
+);
+
+static int PyBobLearnLinearGFKTrainer_init(PyBobLearnLinearGFKTrainerObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = GFKTrainer_doc.kwlist(0);
+
+  int number_of_subspaces = -1;
+  PyObject* source_dim = 0,* target_dim = 0,* factored = 0;
+  double eps = 1e-20;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|iOOdO", kwlist, &number_of_subspaces, &source_dim, &target_dim, &eps, &factored)) return -1;
+
+  // floats define the energy, integers the number of dimensions
+  double source_value = source_dim ? PyFloat_AsDouble(source_dim) : 0.99;
+  double target_value = target_dim ? PyFloat_AsDouble(target_dim) : 0.99;
+  if (PyErr_Occurred()) return -1;
+
+  self->cxx.reset(new bob::learn::linear::GFKTrainer(number_of_subspaces,
+    source_value, !source_dim || PyFloat_Check(source_dim),
+    target_value, !target_dim || PyFloat_Check(target_dim),
+    eps, factored && PyObject_IsTrue(factored)));
+  return 0;
+BOB_CATCH_MEMBER("constructor", -1)
+}
+
+static void PyBobLearnLinearGFKTrainer_delete(PyBobLearnLinearGFKTrainerObject* self) {
+  self->cxx.reset();
+  Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+int PyBobLearnLinearGFKTrainer_Check(PyObject* o) {
+  return PyObject_IsInstance(o, reinterpret_cast<PyObject*>(&PyBobLearnLinearGFKTrainer_Type));
+}
+
+
+/******************************************************************/
+/************ Variables Section ***********************************/
+/******************************************************************/
+
+/**
+ * Returns the given array as a numpy array, or None for empty arrays
+ */
+static PyObject* array_or_none(const blitz::Array<double,2>& array) {
+  if (!array.size()) Py_RETURN_NONE;
+  return PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(array));
+}
+
+/**
+ * Returns a new Python machine holding a copy of the given machine
+ */
+static PyObject* machine_copy(const bob::learn::linear::Machine& machine) {
+  PyBobLearnLinearMachineObject* retval = reinterpret_cast<PyBobLearnLinearMachineObject*>(PyBobLearnLinearMachine_NewFromSize(0, 0));
+  if (!retval) return 0;
+  *retval->cxx = machine;
+  return reinterpret_cast<PyObject*>(retval);
+}
+
+static auto source_machine_doc = bob::extension::VariableDoc(
+  "source_machine",
+  ":py:class:`bob.learn.linear.Machine`",
+  "The PCA projection of the source domain, including the input normalization",
+  "A copy of the machine is returned, so in-place modifications of it are not stored in this machine; assign a new machine instead."
+);
+static PyObject* PyBobLearnLinearGFKMachine_getSourceMachine(PyBobLearnLinearGFKMachineObject* self, void*){
+BOB_TRY
+  return machine_copy(self->cxx->getSourceMachine());
+BOB_CATCH_MEMBER("source_machine", 0)
+}
+static int PyBobLearnLinearGFKMachine_setSourceMachine(PyBobLearnLinearGFKMachineObject* self, PyObject* value, void*){
+BOB_TRY
+  if (!PyBobLearnLinearMachine_Check(value)) {
+    PyErr_Format(PyExc_TypeError, "`%s' expects a `%s' for property `source_machine'", Py_TYPE(self)->tp_name, PyBobLearnLinearMachine_Type.tp_name);
+    return -1;
+  }
+  self->cxx->setSourceMachine(*reinterpret_cast<PyBobLearnLinearMachineObject*>(value)->cxx);
+  return 0;
+BOB_CATCH_MEMBER("source_machine", -1)
+}
+
+static auto target_machine_doc = bob::extension::VariableDoc(
+  "target_machine",
+  ":py:class:`bob.learn.linear.Machine`",
+  "The PCA projection of the target domain, including the input normalization",
+  "A copy of the machine is returned, so in-place modifications of it are not stored in this machine; assign a new machine instead."
+);
+static PyObject* PyBobLearnLinearGFKMachine_getTargetMachine(PyBobLearnLinearGFKMachineObject* self, void*){
+BOB_TRY
+  return machine_copy(self->cxx->getTargetMachine());
+BOB_CATCH_MEMBER("target_machine", 0)
+}
+static int PyBobLearnLinearGFKMachine_setTargetMachine(PyBobLearnLinearGFKMachineObject* self, PyObject* value, void*){
+BOB_TRY
+  if (!PyBobLearnLinearMachine_Check(value)) {
+    PyErr_Format(PyExc_TypeError, "`%s' expects a `%s' for property `target_machine'", Py_TYPE(self)->tp_name, PyBobLearnLinearMachine_Type.tp_name);
+    return -1;
+  }
+  self->cxx->setTargetMachine(*reinterpret_cast<PyBobLearnLinearMachineObject*>(value)->cxx);
+  return 0;
+BOB_CATCH_MEMBER("target_machine", -1)
+}
+
+static auto G_doc = bob::extension::VariableDoc(
+  "G",
+  "array_like(2D, float) or None",
+  "The dense kernel matrix",
+  "For :py:attr:`factored` machines, it is computed from :py:attr:`basis` and :py:attr:`core` on each access. "
+  "Setting it to ``None`` removes the dense kernel matrix."
+);
+static PyObject* PyBobLearnLinearGFKMachine_getG(PyBobLearnLinearGFKMachineObject* self, void*){
+BOB_TRY
+  if (!self->cxx->getG().size() && !self->cxx->getBasis().size()) Py_RETURN_NONE;
+  blitz::Array<double,2> G;
+  self->cxx->computeG(G);
+  return PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(G));
+BOB_CATCH_MEMBER("G", 0)
+}
+static int PyBobLearnLinearGFKMachine_setG(PyBobLearnLinearGFKMachineObject* self, PyObject* value, void*){
+BOB_TRY
+  if (value == Py_None) {
+    self->cxx->setG(blitz::Array<double,2>());
+    return 0;
+  }
+  PyBlitzArrayObject* G = 0;
+  if (!PyBlitzArray_Converter(value, &G)) return -1;
+  auto G_ = make_safe(G);
+  if (G->type_num != NPY_FLOAT64 || G->ndim != 2) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit floats 2D arrays for property array `G'", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+  self->cxx->setG(*PyBlitzArrayCxx_AsBlitz<double,2>(G));
+  return 0;
+BOB_CATCH_MEMBER("G", -1)
+}
+
+static auto basis_doc = bob::extension::VariableDoc(
+  "basis",
+  "array_like(2D, float) or None",
+  "The ``(D, 2d)`` basis :math:`U` of the factored kernel matrix, read-only",
+  "Use :py:meth:`set_factors` to change it."
+);
+static PyObject* PyBobLearnLinearGFKMachine_getBasis(PyBobLearnLinearGFKMachineObject* self, void*){
+BOB_TRY
+  return array_or_none(self->cxx->getBasis());
+BOB_CATCH_MEMBER("basis", 0)
+}
+
+static auto core_doc = bob::extension::VariableDoc(
+  "core",
+  "array_like(2D, float) or None",
+  "The ``(2d, 2d)`` core matrix :math:`C` of the factored kernel matrix, read-only",
+  "Use :py:meth:`set_factors` to change it."
+);
+static PyObject* PyBobLearnLinearGFKMachine_getCore(PyBobLearnLinearGFKMachineObject* self, void*){
+BOB_TRY
+  return array_or_none(self->cxx->getCore());
+BOB_CATCH_MEMBER("core", 0)
+}
+
+static auto factored_doc = bob::extension::VariableDoc(
+  "factored",
+  "bool",
+  "``True`` if this machine stores the kernel matrix in factored form only, read-only"
+);
+static PyObject* PyBobLearnLinearGFKMachine_getFactored(PyBobLearnLinearGFKMachineObject* self, void*){
+BOB_TRY
+  if (self->cxx->isFactored()) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+BOB_CATCH_MEMBER("factored", 0)
+}
+
+static auto input_size_doc = bob::extension::VariableDoc(
+  "input_size",
+  "int",
+  "The expected input dimensionality, read-only"
+);
+static PyObject* PyBobLearnLinearGFKMachine_getInputSize(PyBobLearnLinearGFKMachineObject* self, void*){
+BOB_TRY
+  return Py_BuildValue("n", (Py_ssize_t)self->cxx->inputSize());
+BOB_CATCH_MEMBER("input_size", 0)
+}
+
+static PyGetSetDef PyBobLearnLinearGFKMachine_getseters[] = {
+  {
+    source_machine_doc.name(),
+    (getter)PyBobLearnLinearGFKMachine_getSourceMachine,
+    (setter)PyBobLearnLinearGFKMachine_setSourceMachine,
+    source_machine_doc.doc(),
+    0
+  },
+  {
+    target_machine_doc.name(),
+    (getter)PyBobLearnLinearGFKMachine_getTargetMachine,
+    (setter)PyBobLearnLinearGFKMachine_setTargetMachine,
+    target_machine_doc.doc(),
+    0
+  },
+  {
+    G_doc.name(),
+    (getter)PyBobLearnLinearGFKMachine_getG,
+    (setter)PyBobLearnLinearGFKMachine_setG,
+    G_doc.doc(),
+    0
+  },
+  {
+    basis_doc.name(),
+    (getter)PyBobLearnLinearGFKMachine_getBasis,
+    0,
+    basis_doc.doc(),
+    0
+  },
+  {
+    core_doc.name(),
+    (getter)PyBobLearnLinearGFKMachine_getCore,
+    0,
+    core_doc.doc(),
+    0
+  },
+  {
+    factored_doc.name(),
+    (getter)PyBobLearnLinearGFKMachine_getFactored,
+    0,
+    factored_doc.doc(),
+    0
+  },
+  {
+    input_size_doc.name(),
+    (getter)PyBobLearnLinearGFKMachine_getInputSize,
+    0,
+    input_size_doc.doc(),
+    0
+  },
+  {0}  /* Sentinel */
+};
+
+
+static auto number_of_subspaces_doc = bob::extension::VariableDoc(
+  "number_of_subspaces",
+  "int",
+  "Number of subspaces for the transfer learning; -1 to estimate it automatically"
+);
+static PyObject* PyBobLearnLinearGFKTrainer_getNumberOfSubspaces(PyBobLearnLinearGFKTrainerObject* self, void*){
+BOB_TRY
+  return Py_BuildValue("i", self->cxx->getNumberOfSubspaces());
+BOB_CATCH_MEMBER("number_of_subspaces", 0)
+}
+static int PyBobLearnLinearGFKTrainer_setNumberOfSubspaces(PyBobLearnLinearGFKTrainerObject* self, PyObject* value, void*){
+BOB_TRY
+  int number_of_subspaces = PyLong_AsLong(value);
+  if (PyErr_Occurred()) return -1;
+  self->cxx->setNumberOfSubspaces(number_of_subspaces);
+  return 0;
+BOB_CATCH_MEMBER("number_of_subspaces", -1)
+}
+
+/**
+ * Returns the subspace dimension as float (energy) or int (number of dimensions)
+ */
+static PyObject* subspace_dim(double value, bool energy) {
+  if (energy) return Py_BuildValue("d", value);
+  return Py_BuildValue("i", (int)value);
+}
+
+static auto subspace_dim_source_doc = bob::extension::VariableDoc(
+  "subspace_dim_source",
+  "float or int",
+  "Energy kept in the source linear subspace (float), or number of source PCA dimensions (int)"
+);
+static PyObject* PyBobLearnLinearGFKTrainer_getSubspaceDimSource(PyBobLearnLinearGFKTrainerObject* self, void*){
+BOB_TRY
+  return subspace_dim(self->cxx->getSubspaceDimSource(), self->cxx->getSourceEnergy());
+BOB_CATCH_MEMBER("subspace_dim_source", 0)
+}
+static int PyBobLearnLinearGFKTrainer_setSubspaceDimSource(PyBobLearnLinearGFKTrainerObject* self, PyObject* value, void*){
+BOB_TRY
+  double dim = PyFloat_AsDouble(value);
+  if (PyErr_Occurred()) return -1;
+  self->cxx->setSubspaceDimSource(dim, PyFloat_Check(value));
+  return 0;
+BOB_CATCH_MEMBER("subspace_dim_source", -1)
+}
+
+static auto subspace_dim_target_doc = bob::extension::VariableDoc(
+  "subspace_dim_target",
+  "float or int",
+  "Energy kept in the target linear subspace (float), or number of target PCA dimensions (int)"
+);
+static PyObject* PyBobLearnLinearGFKTrainer_getSubspaceDimTarget(PyBobLearnLinearGFKTrainerObject* self, void*){
+BOB_TRY
+  return subspace_dim(self->cxx->getSubspaceDimTarget(), self->cxx->getTargetEnergy());
+BOB_CATCH_MEMBER("subspace_dim_target", 0)
+}
+static int PyBobLearnLinearGFKTrainer_setSubspaceDimTarget(PyBobLearnLinearGFKTrainerObject* self, PyObject* value, void*){
+BOB_TRY
+  double dim = PyFloat_AsDouble(value);
+  if (PyErr_Occurred()) return -1;
+  self->cxx->setSubspaceDimTarget(dim, PyFloat_Check(value));
+  return 0;
+BOB_CATCH_MEMBER("subspace_dim_target", -1)
+}
+
+static auto eps_doc = bob::extension::VariableDoc(
+  "eps",
+  "float",
+  "Floor value"
+);
+static PyObject* PyBobLearnLinearGFKTrainer_getEps(PyBobLearnLinearGFKTrainerObject* self, void*){
+BOB_TRY
+  return Py_BuildValue("d", self->cxx->getEps());
+BOB_CATCH_MEMBER("eps", 0)
+}
+static int PyBobLearnLinearGFKTrainer_setEps(PyBobLearnLinearGFKTrainerObject* self, PyObject* value, void*){
+BOB_TRY
+  double eps = PyFloat_AsDouble(value);
+  if (PyErr_Occurred()) return -1;
+  self->cxx->setEps(eps);
+  return 0;
+BOB_CATCH_MEMBER("eps", -1)
+}
+
+static auto trainer_factored_doc = bob::extension::VariableDoc(
+  "factored",
+  "bool",
+  "Store the kernel matrix of the trained machines in factored form only?"
+);
+static PyObject* PyBobLearnLinearGFKTrainer_getFactored(PyBobLearnLinearGFKTrainerObject* self, void*){
+BOB_TRY
+  if (self->cxx->getFactored()) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+BOB_CATCH_MEMBER("factored", 0)
+}
+static int PyBobLearnLinearGFKTrainer_setFactored(PyBobLearnLinearGFKTrainerObject* self, PyObject* value, void*){
+BOB_TRY
+  int factored = PyObject_IsTrue(value);
+  if (factored < 0) return -1;
+  self->cxx->setFactored(factored);
+  return 0;
+BOB_CATCH_MEMBER("factored", -1)
+}
+
+static PyGetSetDef PyBobLearnLinearGFKTrainer_getseters[] = {
+  {
+    number_of_subspaces_doc.name(),
+    (getter)PyBobLearnLinearGFKTrainer_getNumberOfSubspaces,
+    (setter)PyBobLearnLinearGFKTrainer_setNumberOfSubspaces,
+    number_of_subspaces_doc.doc(),
+    0
+  },
+  {
+    subspace_dim_source_doc.name(),
+    (getter)PyBobLearnLinearGFKTrainer_getSubspaceDimSource,
+    (setter)PyBobLearnLinearGFKTrainer_setSubspaceDimSource,
+    subspace_dim_source_doc.doc(),
+    0
+  },
+  {
+    subspace_dim_target_doc.name(),
+    (getter)PyBobLearnLinearGFKTrainer_getSubspaceDimTarget,
+    (setter)PyBobLearnLinearGFKTrainer_setSubspaceDimTarget,
+    subspace_dim_target_doc.doc(),
+    0
+  },
+  {
+    eps_doc.name(),
+    (getter)PyBobLearnLinearGFKTrainer_getEps,
+    (setter)PyBobLearnLinearGFKTrainer_setEps,
+    eps_doc.doc(),
+    0
+  },
+  {
+    trainer_factored_doc.name(),
+    (getter)PyBobLearnLinearGFKTrainer_getFactored,
+    (setter)PyBobLearnLinearGFKTrainer_setFactored,
+    trainer_factored_doc.doc(),
+    0
+  },
+  {0}  /* Sentinel */
+};
+
+
+/******************************************************************/
+/************ Functions Section ***********************************/
+/******************************************************************/
+
+static auto kernel_doc = bob::extension::FunctionDoc(
+  "kernel",
+  "Computes the kernel matrix between all pairs of source and target samples",
+  "Both inputs are normalized with the ``input_subtract`` and ``input_divide`` of the :py:attr:`source_machine` and :py:attr:`target_machine`, respectively. "
+  "When the factored form of G is available (i.e., for machines that were just trained), the data is projected only once into the low-dimensional GFK subspace, see :py:func:`bob.learn.linear.gfk_kernel`.",
+  true
+)
+.add_prototype("source, target", "kernel")
+.add_parameter("source", "array_like(2D, float)", "Data from the source domain, one sample per row")
+.add_parameter("target", "array_like(2D, float)", "Data from the target domain, one sample per row")
+.add_return("kernel", "array_like(2D, float)", "The kernel matrix with shape ``(#source samples, #target samples)``")
+;
+static PyObject* PyBobLearnLinearGFKMachine_kernel(PyBobLearnLinearGFKMachineObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = kernel_doc.kwlist();
+
+  PyBlitzArrayObject* source,* target;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&O&", kwlist, &PyBlitzArray_Converter, &source, &PyBlitzArray_Converter, &target)) return 0;
+  auto source_ = make_safe(source), target_ = make_safe(target);
+
+  if (source->ndim != 2 || source->type_num != NPY_FLOAT64 || target->ndim != 2 || target->type_num != NPY_FLOAT64) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for input arrays", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  Py_ssize_t shape[2] = {source->shape[0], target->shape[0]};
+  auto kernel = reinterpret_cast<PyBlitzArrayObject*>(PyBlitzArray_SimpleNew(NPY_FLOAT64, 2, shape));
+  auto kernel_ = make_safe(kernel);
+
+  self->cxx->forward(*PyBlitzArrayCxx_AsBlitz<double,2>(source), *PyBlitzArrayCxx_AsBlitz<double,2>(target), *PyBlitzArrayCxx_AsBlitz<double,2>(kernel));
+  return PyBlitzArray_AsNumpyArray(kernel, 0);
+BOB_CATCH_MEMBER("kernel", 0)
+}
+
+static auto set_factors_doc = bob::extension::FunctionDoc(
+  "set_factors",
+  "Sets the factored form :math:`G = U C U^T` of the kernel matrix",
+  "The dense :py:attr:`G` is left untouched; set it to ``None`` to store the factored form only.",
+  true
+)
+.add_prototype("basis, core")
+.add_parameter("basis", "array_like(2D, float)", "The ``(D, 2d)`` basis :math:`U`")
+.add_parameter("core", "array_like(2D, float)", "The ``(2d, 2d)`` core matrix :math:`C`")
+;
+static PyObject* PyBobLearnLinearGFKMachine_setFactors(PyBobLearnLinearGFKMachineObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = set_factors_doc.kwlist();
+
+  PyBlitzArrayObject* basis,* core;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&O&", kwlist, &PyBlitzArray_Converter, &basis, &PyBlitzArray_Converter, &core)) return 0;
+  auto basis_ = make_safe(basis), core_ = make_safe(core);
+
+  if (basis->ndim != 2 || basis->type_num != NPY_FLOAT64 || core->ndim != 2 || core->type_num != NPY_FLOAT64) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for `basis' and `core'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  self->cxx->setFactors(*PyBlitzArrayCxx_AsBlitz<double,2>(basis), *PyBlitzArrayCxx_AsBlitz<double,2>(core));
+  Py_RETURN_NONE;
+BOB_CATCH_MEMBER("set_factors", 0)
+}
+
+static auto similar_doc = bob::extension::FunctionDoc(
+  "is_similar_to",
+  "Compares this GFKMachine with the ``other`` one to be approximately the same",
+  "The optional values ``r_epsilon`` and ``a_epsilon`` refer to the relative and absolute precision, similarly to :py:func:`numpy.allclose`.",
+  true
+)
+.add_prototype("other, [r_epsilon], [a_epsilon]", "similar")
+.add_parameter("other", ":py:class:`bob.learn.linear.GFKMachine`", "The other GFKMachine to compare with")
+.add_parameter("r_epsilon", "float", "[Default: ``1e-5``] The relative precision")
+.add_parameter("a_epsilon", "float", "[Default: ``1e-8``] The absolute precision")
+.add_return("similar", "bool", "``True`` if the ``other`` machine is similar to this one, otherwise ``False``")
+;
+static PyObject* PyBobLearnLinearGFKMachine_similar(PyBobLearnLinearGFKMachineObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = similar_doc.kwlist();
+
+  PyBobLearnLinearGFKMachineObject* other = 0;
+  double r_epsilon = 1.e-5;
+  double a_epsilon = 1.e-8;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!|dd", kwlist, &PyBobLearnLinearGFKMachine_Type, &other, &r_epsilon, &a_epsilon)) return 0;
+
+  if (self->cxx->is_similar_to(*other->cxx, r_epsilon, a_epsilon))
+    Py_RETURN_TRUE;
+  else
+    Py_RETURN_FALSE;
+BOB_CATCH_MEMBER("is_similar_to", 0)
+}
+
+static auto load_doc = bob::extension::FunctionDoc(
+  "load",
+  "Loads the GFK machine from the given HDF5 file",
+  0,
+  true
+)
+.add_prototype("hdf5")
+.add_parameter("hdf5", ":py:class:`bob.io.base.HDF5File`", "An HDF5 file opened for reading")
+;
+static PyObject* PyBobLearnLinearGFKMachine_load(PyBobLearnLinearGFKMachineObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = load_doc.kwlist();
+  PyBobIoHDF5FileObject* file;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&", kwlist, PyBobIoHDF5File_Converter, &file)) return 0;
+
+  auto file_ = make_safe(file);
+  self->cxx->load(*file->f);
+  Py_RETURN_NONE;
+BOB_CATCH_MEMBER("load", 0)
+}
+
+static auto save_doc = bob::extension::FunctionDoc(
+  "save",
+  "Saves the GFK machine to the given HDF5 file",
+  0,
+  true
+)
+.add_prototype("hdf5")
+.add_parameter("hdf5", ":py:class:`bob.io.base.HDF5File`", "An HDF5 file open for writing")
+;
+static PyObject* PyBobLearnLinearGFKMachine_save(PyBobLearnLinearGFKMachineObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = save_doc.kwlist();
+  PyBobIoHDF5FileObject* file;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&", kwlist, PyBobIoHDF5File_Converter, &file)) return 0;
+
+  auto file_ = make_safe(file);
+  self->cxx->save(*file->f);
+  Py_RETURN_NONE;
+BOB_CATCH_MEMBER("save", 0)
+}
+
+static PyMethodDef PyBobLearnLinearGFKMachine_methods[] = {
+  {
+    kernel_doc.name(),
+    (PyCFunction)PyBobLearnLinearGFKMachine_kernel,
+    METH_VARARGS|METH_KEYWORDS,
+    kernel_doc.doc()
+  },
+  {
+    set_factors_doc.name(),
+    (PyCFunction)PyBobLearnLinearGFKMachine_setFactors,
+    METH_VARARGS|METH_KEYWORDS,
+    set_factors_doc.doc()
+  },
+  {
+    similar_doc.name(),
+    (PyCFunction)PyBobLearnLinearGFKMachine_similar,
+    METH_VARARGS|METH_KEYWORDS,
+    similar_doc.doc()
+  },
+  {
+    load_doc.name(),
+    (PyCFunction)PyBobLearnLinearGFKMachine_load,
+    METH_VARARGS|METH_KEYWORDS,
+    load_doc.doc()
+  },
+  {
+    save_doc.name(),
+    (PyCFunction)PyBobLearnLinearGFKMachine_save,
+    METH_VARARGS|METH_KEYWORDS,
+    save_doc.doc()
+  },
+  {0} /* Sentinel */
+};
+
+
+static auto train_doc = bob::extension::FunctionDoc(
+  "train",
+  "Trains the GFK (:py:class:`bob.learn.linear.GFKMachine`) from unlabeled data of the source and the target domain",
+  "If ``norm_inputs`` is set, the data of both domains is z-normalized. "
+  "When the :py:attr:`number_of_subspaces` is estimated automatically, the inputs are always normalized.",
+  true
+)
+.add_prototype("source_data, target_data, [norm_inputs], [machine]", "machine")
+.add_parameter("source_data", "array_like(2D, float)", "Data from the source domain, one sample per row")
+.add_parameter("target_data", "array_like(2D, float)", "Data from the target domain, one sample per row")
+.add_parameter("norm_inputs", "bool", "[default: ``True``] Z-normalize the data of both domains")
+.add_parameter("machine", ":py:class:`bob.learn.linear.GFKMachine`", "The machine to be trained; if not given, a new machine is created")
+.add_return("machine", ":py:class:`bob.learn.linear.GFKMachine`", "The trained machine")
+;
+static PyObject* PyBobLearnLinearGFKTrainer_train(PyBobLearnLinearGFKTrainerObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = train_doc.kwlist();
+
+  PyBlitzArrayObject* source,* target;
+  PyObject* norm_inputs = 0;
+  PyBobLearnLinearGFKMachineObject* machine = 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&O&|OO!", kwlist,
+        &PyBlitzArray_Converter, &source,
+        &PyBlitzArray_Converter, &target,
+        &norm_inputs,
+        &PyBobLearnLinearGFKMachine_Type, &machine)) return 0;
+  auto source_ = make_safe(source), target_ = make_safe(target);
+  boost::shared_ptr<PyBobLearnLinearGFKMachineObject> machine_;
+
+  if (source->ndim != 2 || source->type_num != NPY_FLOAT64){
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for 'source_data'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+  if (target->ndim != 2 || target->type_num != NPY_FLOAT64){
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for 'target_data'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  if (!machine){
+    // create machine if not given
+    machine = (PyBobLearnLinearGFKMachineObject*)PyBobLearnLinearGFKMachine_Type.tp_alloc(&PyBobLearnLinearGFKMachine_Type, 0);
+    machine_ = make_safe(machine);
+    machine->cxx.reset(new bob::learn::linear::GFKMachine());
+  }
+
+  self->cxx->train(*machine->cxx, *PyBlitzArrayCxx_AsBlitz<double,2>(source), *PyBlitzArrayCxx_AsBlitz<double,2>(target), !norm_inputs || PyObject_IsTrue(norm_inputs));
+  return Py_BuildValue("O", machine);
+BOB_CATCH_MEMBER("train", 0)
+}
+
+static PyMethodDef PyBobLearnLinearGFKTrainer_methods[] = {
+  {
+    train_doc.name(),
+    (PyCFunction)PyBobLearnLinearGFKTrainer_train,
+    METH_VARARGS|METH_KEYWORDS,
+    train_doc.doc()
+  },
+  {0} /* Sentinel */
+};
+
+
+/******************************************************************/
+/************ Module Section **************************************/
+/******************************************************************/
+
+static PyMethodDef PyBobLearnLinearGFK_methods[] = {
+  {
+    gfk_kernel.name(),
+    (PyCFunction)PyBobLearnLinear_gfkKernel,
+    METH_VARARGS|METH_KEYWORDS,
+    gfk_kernel.doc()
+  },
+  {0} /* Sentinel */
+};
+
+// GFK Machine
+PyTypeObject PyBobLearnLinearGFKMachine_Type = {
+  PyVarObject_HEAD_INIT(0,0)
+  0
+};
+
+// GFK Trainer
+PyTypeObject PyBobLearnLinearGFKTrainer_Type = {
+  PyVarObject_HEAD_INIT(0,0)
+  0
+};
+
+bool init_BobLearnLinearGFK(PyObject* module)
+{
+  // GFK Machine
+  PyBobLearnLinearGFKMachine_Type.tp_name = GFKMachine_doc.name();
+  PyBobLearnLinearGFKMachine_Type.tp_basicsize = sizeof(PyBobLearnLinearGFKMachineObject);
+  PyBobLearnLinearGFKMachine_Type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
+  PyBobLearnLinearGFKMachine_Type.tp_doc = GFKMachine_doc.doc();
+
+  // set the functions
+  PyBobLearnLinearGFKMachine_Type.tp_new = PyType_GenericNew;
+  PyBobLearnLinearGFKMachine_Type.tp_init = reinterpret_cast<initproc>(PyBobLearnLinearGFKMachine_init);
+  PyBobLearnLinearGFKMachine_Type.tp_dealloc = reinterpret_cast<destructor>(PyBobLearnLinearGFKMachine_delete);
+  PyBobLearnLinearGFKMachine_Type.tp_methods = PyBobLearnLinearGFKMachine_methods;
+  PyBobLearnLinearGFKMachine_Type.tp_getset = PyBobLearnLinearGFKMachine_getseters;
+  PyBobLearnLinearGFKMachine_Type.tp_richcompare = reinterpret_cast<richcmpfunc>(PyBobLearnLinearGFKMachine_RichCompare);
+
+  // check that everyting is fine
+  if (PyType_Ready(&PyBobLearnLinearGFKMachine_Type) < 0)
+    return false;
+
+  // GFK Trainer
+  PyBobLearnLinearGFKTrainer_Type.tp_name = GFKTrainer_doc.name();
+  PyBobLearnLinearGFKTrainer_Type.tp_basicsize = sizeof(PyBobLearnLinearGFKTrainerObject);
+  PyBobLearnLinearGFKTrainer_Type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
+  PyBobLearnLinearGFKTrainer_Type.tp_doc = GFKTrainer_doc.doc();
+
+  // set the functions
+  PyBobLearnLinearGFKTrainer_Type.tp_new = PyType_GenericNew;
+  PyBobLearnLinearGFKTrainer_Type.tp_init = reinterpret_cast<initproc>(PyBobLearnLinearGFKTrainer_init);
+  PyBobLearnLinearGFKTrainer_Type.tp_dealloc = reinterpret_cast<destructor>(PyBobLearnLinearGFKTrainer_delete);
+  PyBobLearnLinearGFKTrainer_Type.tp_methods = PyBobLearnLinearGFKTrainer_methods;
+  PyBobLearnLinearGFKTrainer_Type.tp_getset = PyBobLearnLinearGFKTrainer_getseters;
+
+  // check that everyting is fine
+  if (PyType_Ready(&PyBobLearnLinearGFKTrainer_Type) < 0)
+    return false;
+
+  // add the kernel functions to the module
+  for (PyMethodDef* def = PyBobLearnLinearGFK_methods; def->ml_name; ++def) {
+    PyObject* function = PyCFunction_NewEx(def, 0, 0);
+    if (!function) return false;
+    if (PyModule_AddObject(module, def->ml_name, function) < 0) return false;
+  }
+
+  // add the types to the module
+  Py_INCREF(&PyBobLearnLinearGFKMachine_Type);
+  Py_INCREF(&PyBobLearnLinearGFKTrainer_Type);
+  return
+    PyModule_AddObject(module, "GFKMachine", (PyObject*)&PyBobLearnLinearGFKMachine_Type) >= 0 &&
+    PyModule_AddObject(module, "GFKTrainer", (PyObject*)&PyBobLearnLinearGFKTrainer_Type) >= 0;
+}
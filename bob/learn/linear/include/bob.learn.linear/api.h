@@ -17,6 +17,11 @@
 #include <bob.learn.linear/whitening.h>
 #include <bob.learn.linear/wccn.h>
 #include <bob.learn.linear/bic.h>
+#include <bob.learn.linear/gfk.h>
+#include <bob.learn.linear/scatter.h>
+#include <bob.learn.linear/bundle.h>
+#include <bob.learn.linear/profile.h>
+#include <bob.learn.linear/quantized.h>
 
 #define BOB_LEARN_LINEAR_MODULE_PREFIX bob.learn.linear
 #define BOB_LEARN_LINEAR_MODULE_NAME _library
@@ -53,6 +58,24 @@ enum _PyBobLearnLinear_ENUM{
   // Bindings for bob.learn.linear.BICTrainer
   PyBobLearnLinearBICTrainer_Type_NUM,
   PyBobLearnLinearBICTrainer_Check_NUM,
+  // Bindings for bob.learn.linear.GFKMachine
+  PyBobLearnLinearGFKMachine_Type_NUM,
+  PyBobLearnLinearGFKMachine_Check_NUM,
+  // Bindings for bob.learn.linear.GFKTrainer
+  PyBobLearnLinearGFKTrainer_Type_NUM,
+  PyBobLearnLinearGFKTrainer_Check_NUM,
+  // Bindings for bob.learn.linear.ScatterAccumulator
+  PyBobLearnLinearScatterAccumulator_Type_NUM,
+  PyBobLearnLinearScatterAccumulator_Check_NUM,
+  // Bindings for bob.learn.linear.MiniBatchLogRegTrainer
+  PyBobLearnLinearMiniBatchLogRegTrainer_Type_NUM,
+  PyBobLearnLinearMiniBatchLogRegTrainer_Check_NUM,
+  // Bindings for bob.learn.linear.MultinomialLogRegTrainer
+  PyBobLearnLinearMultinomialLogRegTrainer_Type_NUM,
+  PyBobLearnLinearMultinomialLogRegTrainer_Check_NUM,
+  // Bindings for bob.learn.linear.QuantizedMachine
+  PyBobLearnLinearQuantizedMachine_Type_NUM,
+  PyBobLearnLinearQuantizedMachine_Check_NUM,
   // Total number of C API pointers
   PyBobLearnLinear_API_pointers
 };
@@ -181,6 +204,96 @@ typedef struct {
 #define PyBobLearnLinearBICTrainer_Check_PROTO (PyObject* o)
 
 
+/**********************************************
+ * Bindings for bob.learn.linear.GFKMachine *
+ **********************************************/
+
+typedef struct {
+  PyObject_HEAD
+  boost::shared_ptr<bob::learn::linear::GFKMachine> cxx;
+} PyBobLearnLinearGFKMachineObject;
+
+#define PyBobLearnLinearGFKMachine_Type_TYPE PyTypeObject
+
+#define PyBobLearnLinearGFKMachine_Check_RET int
+#define PyBobLearnLinearGFKMachine_Check_PROTO (PyObject* o)
+
+
+/**********************************************
+ * Bindings for bob.learn.linear.GFKTrainer *
+ **********************************************/
+
+typedef struct {
+  PyObject_HEAD
+  boost::shared_ptr<bob::learn::linear::GFKTrainer> cxx;
+} PyBobLearnLinearGFKTrainerObject;
+
+#define PyBobLearnLinearGFKTrainer_Type_TYPE PyTypeObject
+
+#define PyBobLearnLinearGFKTrainer_Check_RET int
+#define PyBobLearnLinearGFKTrainer_Check_PROTO (PyObject* o)
+
+
+/******************************************************
+ * Bindings for bob.learn.linear.ScatterAccumulator *
+ ******************************************************/
+
+typedef struct {
+  PyObject_HEAD
+  boost::shared_ptr<bob::learn::linear::ScatterAccumulator> cxx;
+} PyBobLearnLinearScatterAccumulatorObject;
+
+#define PyBobLearnLinearScatterAccumulator_Type_TYPE PyTypeObject
+
+#define PyBobLearnLinearScatterAccumulator_Check_RET int
+#define PyBobLearnLinearScatterAccumulator_Check_PROTO (PyObject* o)
+
+
+/*********************************************************
+ * Bindings for bob.learn.linear.MiniBatchLogRegTrainer *
+ *********************************************************/
+
+typedef struct {
+  PyObject_HEAD
+  bob::learn::linear::MiniBatchLogRegTrainer* cxx;
+} PyBobLearnLinearMiniBatchLogRegTrainerObject;
+
+#define PyBobLearnLinearMiniBatchLogRegTrainer_Type_TYPE PyTypeObject
+
+#define PyBobLearnLinearMiniBatchLogRegTrainer_Check_RET int
+#define PyBobLearnLinearMiniBatchLogRegTrainer_Check_PROTO (PyObject* o)
+
+
+/***********************************************************
+ * Bindings for bob.learn.linear.MultinomialLogRegTrainer *
+ ***********************************************************/
+
+typedef struct {
+  PyObject_HEAD
+  bob::learn::linear::MultinomialLogRegTrainer* cxx;
+} PyBobLearnLinearMultinomialLogRegTrainerObject;
+
+#define PyBobLearnLinearMultinomialLogRegTrainer_Type_TYPE PyTypeObject
+
+#define PyBobLearnLinearMultinomialLogRegTrainer_Check_RET int
+#define PyBobLearnLinearMultinomialLogRegTrainer_Check_PROTO (PyObject* o)
+
+
+/***************************************************
+ * Bindings for bob.learn.linear.QuantizedMachine *
+ ***************************************************/
+
+typedef struct {
+  PyObject_HEAD
+  boost::shared_ptr<bob::learn::linear::QuantizedMachine> cxx;
+} PyBobLearnLinearQuantizedMachineObject;
+
+#define PyBobLearnLinearQuantizedMachine_Type_TYPE PyTypeObject
+
+#define PyBobLearnLinearQuantizedMachine_Check_RET int
+#define PyBobLearnLinearQuantizedMachine_Check_PROTO (PyObject* o)
+
+
 #ifdef BOB_LEARN_LINEAR_MODULE
 
   /* This section is used when compiling `bob.learn.linear' itself */
@@ -257,6 +370,54 @@ typedef struct {
 
   PyBobLearnLinearBICTrainer_Check_RET PyBobLearnLinearBICTrainer_Check PyBobLearnLinearBICTrainer_Check_PROTO;
 
+  /**********************************************
+   * Bindings for bob.learn.linear.GFKMachine *
+   **********************************************/
+
+  extern PyBobLearnLinearGFKMachine_Type_TYPE PyBobLearnLinearGFKMachine_Type;
+
+  PyBobLearnLinearGFKMachine_Check_RET PyBobLearnLinearGFKMachine_Check PyBobLearnLinearGFKMachine_Check_PROTO;
+
+  /**********************************************
+   * Bindings for bob.learn.linear.GFKTrainer *
+   **********************************************/
+
+  extern PyBobLearnLinearGFKTrainer_Type_TYPE PyBobLearnLinearGFKTrainer_Type;
+
+  PyBobLearnLinearGFKTrainer_Check_RET PyBobLearnLinearGFKTrainer_Check PyBobLearnLinearGFKTrainer_Check_PROTO;
+
+  /******************************************************
+   * Bindings for bob.learn.linear.ScatterAccumulator *
+   ******************************************************/
+
+  extern PyBobLearnLinearScatterAccumulator_Type_TYPE PyBobLearnLinearScatterAccumulator_Type;
+
+  PyBobLearnLinearScatterAccumulator_Check_RET PyBobLearnLinearScatterAccumulator_Check PyBobLearnLinearScatterAccumulator_Check_PROTO;
+
+  /*********************************************************
+   * Bindings for bob.learn.linear.MiniBatchLogRegTrainer *
+   *********************************************************/
+
+  extern PyBobLearnLinearMiniBatchLogRegTrainer_Type_TYPE PyBobLearnLinearMiniBatchLogRegTrainer_Type;
+
+  PyBobLearnLinearMiniBatchLogRegTrainer_Check_RET PyBobLearnLinearMiniBatchLogRegTrainer_Check PyBobLearnLinearMiniBatchLogRegTrainer_Check_PROTO;
+
+  /***********************************************************
+   * Bindings for bob.learn.linear.MultinomialLogRegTrainer *
+   ***********************************************************/
+
+  extern PyBobLearnLinearMultinomialLogRegTrainer_Type_TYPE PyBobLearnLinearMultinomialLogRegTrainer_Type;
+
+  PyBobLearnLinearMultinomialLogRegTrainer_Check_RET PyBobLearnLinearMultinomialLogRegTrainer_Check PyBobLearnLinearMultinomialLogRegTrainer_Check_PROTO;
+
+  /***************************************************
+   * Bindings for bob.learn.linear.QuantizedMachine *
+   ***************************************************/
+
+  extern PyBobLearnLinearQuantizedMachine_Type_TYPE PyBobLearnLinearQuantizedMachine_Type;
+
+  PyBobLearnLinearQuantizedMachine_Check_RET PyBobLearnLinearQuantizedMachine_Check PyBobLearnLinearQuantizedMachine_Check_PROTO;
+
 #else
 
   /* This section is used in modules that use `bob.learn.linear's' C-API */
@@ -355,6 +516,54 @@ typedef struct {
 
 # define PyBobLearnLinearBICTrainer_Check (*(PyBobLearnLinearBICTrainer_Check_RET (*)PyBobLearnLinearBICTrainer_Check_PROTO) PyBobLearnLinear_API[PyBobLearnLinearBICTrainer_Check_NUM])
 
+  /**********************************************
+   * Bindings for bob.learn.linear.GFKMachine *
+   **********************************************/
+
+# define PyBobLearnLinearGFKMachine_Type (*(PyBobLearnLinearGFKMachine_Type_TYPE *)PyBobLearnLinear_API[PyBobLearnLinearGFKMachine_Type_NUM])
+
+# define PyBobLearnLinearGFKMachine_Check (*(PyBobLearnLinearGFKMachine_Check_RET (*)PyBobLearnLinearGFKMachine_Check_PROTO) PyBobLearnLinear_API[PyBobLearnLinearGFKMachine_Check_NUM])
+
+  /**********************************************
+   * Bindings for bob.learn.linear.GFKTrainer *
+   **********************************************/
+
+# define PyBobLearnLinearGFKTrainer_Type (*(PyBobLearnLinearGFKTrainer_Type_TYPE *)PyBobLearnLinear_API[PyBobLearnLinearGFKTrainer_Type_NUM])
+
+# define PyBobLearnLinearGFKTrainer_Check (*(PyBobLearnLinearGFKTrainer_Check_RET (*)PyBobLearnLinearGFKTrainer_Check_PROTO) PyBobLearnLinear_API[PyBobLearnLinearGFKTrainer_Check_NUM])
+
+  /******************************************************
+   * Bindings for bob.learn.linear.ScatterAccumulator *
+   ******************************************************/
+
+# define PyBobLearnLinearScatterAccumulator_Type (*(PyBobLearnLinearScatterAccumulator_Type_TYPE *)PyBobLearnLinear_API[PyBobLearnLinearScatterAccumulator_Type_NUM])
+
+# define PyBobLearnLinearScatterAccumulator_Check (*(PyBobLearnLinearScatterAccumulator_Check_RET (*)PyBobLearnLinearScatterAccumulator_Check_PROTO) PyBobLearnLinear_API[PyBobLearnLinearScatterAccumulator_Check_NUM])
+
+  /*********************************************************
+   * Bindings for bob.learn.linear.MiniBatchLogRegTrainer *
+   *********************************************************/
+
+# define PyBobLearnLinearMiniBatchLogRegTrainer_Type (*(PyBobLearnLinearMiniBatchLogRegTrainer_Type_TYPE *)PyBobLearnLinear_API[PyBobLearnLinearMiniBatchLogRegTrainer_Type_NUM])
+
+# define PyBobLearnLinearMiniBatchLogRegTrainer_Check (*(PyBobLearnLinearMiniBatchLogRegTrainer_Check_RET (*)PyBobLearnLinearMiniBatchLogRegTrainer_Check_PROTO) PyBobLearnLinear_API[PyBobLearnLinearMiniBatchLogRegTrainer_Check_NUM])
+
+  /***********************************************************
+   * Bindings for bob.learn.linear.MultinomialLogRegTrainer *
+   ***********************************************************/
+
+# define PyBobLearnLinearMultinomialLogRegTrainer_Type (*(PyBobLearnLinearMultinomialLogRegTrainer_Type_TYPE *)PyBobLearnLinear_API[PyBobLearnLinearMultinomialLogRegTrainer_Type_NUM])
+
+# define PyBobLearnLinearMultinomialLogRegTrainer_Check (*(PyBobLearnLinearMultinomialLogRegTrainer_Check_RET (*)PyBobLearnLinearMultinomialLogRegTrainer_Check_PROTO) PyBobLearnLinear_API[PyBobLearnLinearMultinomialLogRegTrainer_Check_NUM])
+
+  /***************************************************
+   * Bindings for bob.learn.linear.QuantizedMachine *
+   ***************************************************/
+
+# define PyBobLearnLinearQuantizedMachine_Type (*(PyBobLearnLinearQuantizedMachine_Type_TYPE *)PyBobLearnLinear_API[PyBobLearnLinearQuantizedMachine_Type_NUM])
+
+# define PyBobLearnLinearQuantizedMachine_Check (*(PyBobLearnLinearQuantizedMachine_Check_RET (*)PyBobLearnLinearQuantizedMachine_Check_PROTO) PyBobLearnLinear_API[PyBobLearnLinearQuantizedMachine_Check_NUM])
+
 # if !defined(NO_IMPORT_ARRAY)
 
   /**
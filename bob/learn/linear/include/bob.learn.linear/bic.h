@@ -11,6 +11,8 @@
 
 #include <blitz/array.h>
 #include <bob.io.base/HDF5File.h>
+#include <bob.learn.linear/machine.h>
+#include <bob.learn.linear/scatter.h>
 
 namespace bob { namespace learn { namespace linear {
   /**
@@ -64,9 +66,15 @@ namespace bob { namespace learn { namespace linear {
       //! sets the IEC vectors of the given class (used by the trainer only; not bound to python)
       void setIEC(bool clazz, const blitz::Array<double,1>& mean, const blitz::Array<double,1>& variances, bool copy_data = false);
 
+      //! sets the IEC vectors of the given class, taking over the given arrays instead of copying or sharing them (see take_or_copy())
+      void setIEC(bool clazz, blitz::Array<double,1>&& mean, blitz::Array<double,1>&& variances);
+
       //! sets the BIC projection details of the given class (used by the trainer only; not bound to python)
       void setBIC(bool clazz, const blitz::Array<double,1>& mean, const blitz::Array<double,1>& variances, const blitz::Array<double,2>& projection, const double rho, bool copy_data = false);
 
+      //! sets the BIC projection details of the given class, taking over the given arrays instead of copying or sharing them (see take_or_copy())
+      void setBIC(bool clazz, blitz::Array<double,1>&& mean, blitz::Array<double,1>&& variances, blitz::Array<double,2>&& projection, const double rho);
+
       //! loads this machine from the given hdf5 file.
       void load(bob::io::base::HDF5File& hdf5);
 
@@ -82,6 +90,21 @@ namespace bob { namespace learn { namespace linear {
       //! Expected input dimensionality
       int input_size() const {return m_mu_I.extent(0);}
 
+      //! Is the data projected (BIC), or are only mean and variances used (IEC)?
+      bool project_data() const {return m_project_data;}
+
+      //! The mean vector of the given class
+      const blitz::Array<double,1>& mean(bool clazz) const {return clazz ? m_mu_E : m_mu_I;}
+
+      //! The variances (eigenvalues for BIC) of the given class
+      const blitz::Array<double,1>& variances(bool clazz) const {return clazz ? m_lambda_E : m_lambda_I;}
+
+      //! The projection matrix of the given class (BIC only)
+      const blitz::Array<double,2>& projection(bool clazz) const {return clazz ? m_Phi_E : m_Phi_I;}
+
+      //! The average of the residual eigenvalues of the given class (BIC only)
+      double rho(bool clazz) const {return clazz ? m_rho_E : m_rho_I;}
+
     private:
 
       //! initializes internal data storages for the given class
@@ -116,17 +139,38 @@ namespace bob { namespace learn { namespace linear {
       //! initializes a BICTrainer to train BIC (including subspace truncation)
       BICTrainer(int intra_dim, int extra_dim) : m_M_I(intra_dim), m_M_E(extra_dim) {}
 
+      //! trains the intrapersonal and extrapersonal classes of the given BICMachine;
+      //! both classes are estimated concurrently in separate threads, which
+      //! read the differences without copying them, so that the two arrays
+      //! may share their data (or be the same array)
+      void train(BICMachine& machine, const blitz::Array<double,2>& intra_differences, const blitz::Array<double,2>& extra_differences) const;
+
       //! trains the intrapersonal and extrapersonal classes of the given BICMachine
-      void train(BICMachine& machine, const blitz::Array<double,2>& intra_differences, const blitz::Array<double,2>& extra_differences) const {
-        train_single(false, machine, intra_differences);
-        train_single(true, machine, extra_differences);
-      }
+      //! from the accumulated statistics of the difference vectors
+      void train(BICMachine& machine, const ScatterAccumulator& intra_statistics, const ScatterAccumulator& extra_statistics) const;
 
       //! trains the intrapersonal or the extrapersonal class of the given BICMachine
       void train_single(bool clazz, BICMachine& machine, const blitz::Array<double,2>& differences) const;
 
     private:
 
+      //! the parameters estimated for one of the two classes
+      struct ClassModel {
+        blitz::Array<double,1> mean;
+        blitz::Array<double,1> variances;
+        blitz::Array<double,2> projection;
+        double rho;
+      };
+
+      //! estimates the parameters of one class, without touching any machine
+      void estimate(bool clazz, const blitz::Array<double,2>& differences, ClassModel& model) const;
+
+      //! estimates the parameters of one class from the accumulated statistics
+      void estimate(bool clazz, const ScatterAccumulator& statistics, ClassModel& model) const;
+
+      //! hands the estimated parameters of one class over to the given machine
+      void apply(bool clazz, BICMachine& machine, ClassModel&& model) const;
+
       //! dimensions of the intrapersonal and extrapersonal subspace;
       //! zero if training IEC.
       int m_M_I, m_M_E;
@@ -0,0 +1,278 @@
+/**
+ * @date Sun Oct 18 10:12:41 CEST 2026
+ *
+ * @brief A compact binary format that bundles several machines in a single,
+ * memory-mappable file
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LINEAR_BUNDLE_H
+#define BOB_LEARN_LINEAR_BUNDLE_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <bob.learn.linear/machine.h>
+#include <bob.learn.linear/bic.h>
+#include <bob.learn.linear/gfk.h>
+
+namespace bob { namespace learn { namespace linear {
+
+  /**
+   * @brief Maps the given byte range of the file read-only into memory, and
+   * returns a pointer to its first byte, which is empty on failure.
+   *
+   * The mapping is private (MAP_PRIVATE). If the expected status of the
+   * file is given, e.g., of the file that an HDF5 file handle reads, the
+   * file is not mapped if it has been replaced or modified since (as
+   * identified by its device, inode, size and modification time).
+   *
+   * The pointer owns the mapping: the range is unmapped when the last copy
+   * of the pointer is released, so that arrays referring to the mapping need
+   * to keep a copy (see Machine::getStorage()). Identical ranges of the same
+   * version of a file (as identified by its inode, size and modification
+   * time) that are mapped at the same time share a single mapping.
+   */
+  boost::shared_ptr<const char> map_file(const std::string& filename,
+    off_t offset, size_t bytes, const struct stat* expected=0);
+
+  /**
+   * @brief The types of machines that can be stored in a bundle
+   */
+  enum BundleType {
+    BUNDLE_MACHINE = 1,
+    BUNDLE_BIC_MACHINE = 2,
+    BUNDLE_GFK_MACHINE = 3
+  };
+
+  /**
+   * @brief Writes several named machines into a single bundle file.
+   *
+   * The file starts with a fixed 64 byte header holding the magic
+   * "BOBLINB", the format version, a byte order mark, the number of machines
+   * and the position of the index. It is followed by the arrays of all
+   * machines, each stored as native doubles in C order and aligned to
+   * BUNDLE_ALIGNMENT bytes, and by the index, which lists the type, the name,
+   * the scalar parameters and the array descriptors (offset and shape) of
+   * each machine.
+   *
+   * The data is written to a temporary file, which replaces the given file
+   * in close(), so that processes that have mapped an older version of the
+   * file keep reading consistent data.
+   */
+  class BundleWriter {
+
+    public:
+
+      /**
+       * @brief Starts writing a new bundle to the given file
+       */
+      BundleWriter(const std::string& filename);
+
+      /**
+       * @brief Discards the bundle, if close() has not been called, so that
+       * an interrupted write never replaces an existing file
+       */
+      virtual ~BundleWriter();
+
+      /**
+       * @brief Adds the given linear machine with the given (unique) name
+       */
+      void add(const std::string& name, const Machine& machine);
+
+      /**
+       * @brief Adds the given BIC machine with the given (unique) name
+       */
+      void add(const std::string& name, const BICMachine& machine);
+
+      /**
+       * @brief Adds the given GFK machine with the given (unique) name
+       */
+      void add(const std::string& name, const GFKMachine& machine);
+
+      /**
+       * @brief Writes the index and the header, and moves the bundle to its
+       * final place. No machines can be added afterwards.
+       */
+      void close();
+
+    private:
+
+      BundleWriter(const BundleWriter&);
+      BundleWriter& operator=(const BundleWriter&);
+
+      /**
+       * @brief Starts a new index entry with the given name
+       */
+      void begin(const std::string& name);
+
+      /**
+       * @brief Adds the current entry with the given name and type to the
+       * index
+       */
+      void end(const std::string& name, BundleType type);
+
+      /**
+       * @brief Writes the data of the given array aligned to the file and
+       * adds its descriptor to the current index entry
+       */
+      template <int N> void write(const blitz::Array<double,N>& array);
+
+      /**
+       * @brief Adds the parameters of the given linear machine to the current
+       * index entry
+       */
+      void write(const Machine& machine);
+
+      std::string m_filename; ///< the final name of the bundle
+      std::string m_temporary; ///< the name of the file that is written
+      std::ofstream m_file; ///< the file that is written
+      uint64_t m_offset; ///< the current write position
+      std::vector<std::string> m_names; ///< the names of all machines
+      std::vector<char> m_index; ///< the serialized index
+      std::vector<double> m_scalars; ///< the scalars of the current entry
+      std::vector<uint64_t> m_arrays; ///< the array descriptors of the current entry
+
+  };
+
+  /**
+   * @brief Reads machines from a bundle file written with BundleWriter.
+   *
+   * The whole file is mapped read-only into memory with a single call to
+   * mmap (see map_file()). The weights of linear machines (including the
+   * source and target machines of GFK machines) refer to the mapped memory
+   * directly and are only copied when modified, as with Machine::load() from
+   * memory-mapped HDF5 files; all other arrays are copied out of the mapping.
+   *
+   * The mapping is owned by the bundle, its copies and the machines loaded
+   * from it that still refer to it (see Machine::getStorage()), and is
+   * released with the last of them; machines stay valid after the bundle is
+   * destroyed. Bundle files need to be replaced by renaming a new file over
+   * them, as BundleWriter does, and not overwritten in place.
+   */
+  class Bundle {
+
+    public:
+
+      /**
+       * @brief Maps and validates the bundle stored in the given file
+       */
+      Bundle(const std::string& filename);
+
+      /**
+       * @brief Destructor; the mapping is released unless machines loaded
+       * from this bundle still refer to it
+       */
+      virtual ~Bundle();
+
+      /**
+       * @brief The name of the bundle file
+       */
+      const std::string& filename() const { return m_filename; }
+
+      /**
+       * @brief The number of machines in the bundle
+       */
+      size_t size() const { return m_names.size(); }
+
+      /**
+       * @brief The names of all machines, in the order they were added
+       */
+      const std::vector<std::string>& names() const { return m_names; }
+
+      /**
+       * @brief Returns true if the bundle contains a machine with the given
+       * name
+       */
+      bool contains(const std::string& name) const;
+
+      /**
+       * @brief The type of the machine with the given name
+       */
+      BundleType type(const std::string& name) const;
+
+      /**
+       * @brief Loads the linear machine with the given name
+       */
+      void load(const std::string& name, Machine& machine) const;
+
+      /**
+       * @brief Loads the BIC machine with the given name
+       */
+      void load(const std::string& name, BICMachine& machine) const;
+
+      /**
+       * @brief Loads the GFK machine with the given name
+       */
+      void load(const std::string& name, GFKMachine& machine) const;
+
+    private:
+
+      /**
+       * @brief An array stored in the bundle
+       */
+      struct ArrayEntry {
+        const double* data;
+        int ndim;
+        int shape[2];
+      };
+
+      /**
+       * @brief A machine stored in the bundle
+       */
+      struct Entry {
+        BundleType type;
+        std::vector<double> scalars;
+        std::vector<ArrayEntry> arrays;
+      };
+
+      /**
+       * @brief Returns the entry with the given name, checking its type and
+       * the number of its parameters
+       */
+      const Entry& entry(const std::string& name, BundleType type,
+        size_t n_scalars, size_t n_arrays) const;
+
+      /**
+       * @brief Loads a linear machine from the scalars and arrays of an entry,
+       * starting at the given positions
+       */
+      void load(const Entry& entry, size_t scalar, size_t array,
+        Machine& machine) const;
+
+      /**
+       * @brief Returns a read-only view of the given 1D array
+       */
+      static blitz::Array<double,1> array1(const ArrayEntry& array);
+
+      /**
+       * @brief Returns a read-only view of the given 2D array
+       */
+      static blitz::Array<double,2> array2(const ArrayEntry& array);
+
+      std::string m_filename; ///< the name of the bundle file
+      boost::shared_ptr<const char> m_data; ///< the mapping of the file
+      std::vector<std::string> m_names; ///< the names of all machines
+      std::map<std::string, Entry> m_entries; ///< the index
+
+  };
+
+  /**
+   * @brief The alignment of all arrays inside bundle files, in bytes
+   */
+  static const uint64_t BUNDLE_ALIGNMENT = 4096;
+
+  /**
+   * @brief The current version of the bundle format
+   */
+  static const uint32_t BUNDLE_VERSION = 1;
+
+}}}
+
+#endif /* BOB_LEARN_LINEAR_BUNDLE_H */
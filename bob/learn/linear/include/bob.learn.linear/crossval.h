@@ -0,0 +1,96 @@
+/**
+ * @date Sun Oct 18 17:40:27 CEST 2026
+ *
+ * @brief k-fold cross-validation of the trainers, running the folds in
+ * parallel threads
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LINEAR_CROSSVAL_H
+#define BOB_LEARN_LINEAR_CROSSVAL_H
+
+#include <vector>
+#include <ostream>
+#include <stdint.h>
+#include <blitz/array.h>
+
+#include <bob.learn.linear/machine.h>
+#include <bob.learn.linear/pca.h>
+#include <bob.learn.linear/lda.h>
+#include <bob.learn.linear/logreg.h>
+
+namespace bob { namespace learn { namespace linear {
+
+  /**
+   * @brief Runs a k-fold cross-validation of the PCATrainer.
+   *
+   * Each sample (row) of the data is assigned to the fold with the
+   * non-negative index at the same position of folds; the number of folds K
+   * is the largest index plus 1. For each fold k, machines[k] is trained on
+   * the samples of all other folds, and the rows of scores for the samples of
+   * fold k are set to the outputs of machines[k].
+   *
+   * The data is scanned only once: the statistics of each fold are
+   * accumulated in a ScatterAccumulator, and the statistics of the training
+   * samples of fold k are those of all data minus those of fold k. Hence, the
+   * covariance method is always used. The folds are processed in n_threads
+   * parallel threads (0 for one per processor); the data is shared by all
+   * threads and must not be modified until this function returns.
+   *
+   * If the machines of the folds have different numbers of outputs, all are
+   * truncated to the smallest one, see Machine::resize(). The machines and
+   * scores are resized as needed.
+   */
+  void cross_validate(const PCATrainer& trainer,
+      const blitz::Array<double,2>& data,
+      const blitz::Array<int64_t,1>& folds,
+      std::vector<Machine>& machines, blitz::Array<double,2>& scores,
+      size_t n_threads=0);
+
+  /**
+   * @brief Runs a k-fold cross-validation of the FisherLDATrainer on the data
+   * of several classes, with the fold indices of the samples of each class
+   * at the same position of folds, see above. The scores hold the outputs of
+   * the machines for the samples of each class.
+   */
+  void cross_validate(const FisherLDATrainer& trainer,
+      const std::vector<blitz::Array<double,2> >& data,
+      const std::vector<blitz::Array<int64_t,1> >& folds,
+      std::vector<Machine>& machines,
+      std::vector<blitz::Array<double,2> >& scores, size_t n_threads=0);
+
+  /**
+   * @brief Runs a k-fold cross-validation of the CGLogRegTrainer on the
+   * negative and positive samples, which are given in this order in data,
+   * with the fold indices of the samples of each class at the same position
+   * of folds, see above. The scores (one column) hold the outputs of the
+   * machines for the samples of each class.
+   *
+   * The trainer normalizes the training samples of each fold, so that these
+   * are gathered from the shared data in the thread of the fold. Each fold
+   * is trained with its own copy of the trainer, and the messages of the
+   * solver are written to bob::core::info in the order of the folds after
+   * all folds finished.
+   */
+  void cross_validate(const CGLogRegTrainer& trainer,
+      const std::vector<blitz::Array<double,2> >& data,
+      const std::vector<blitz::Array<int64_t,1> >& folds,
+      std::vector<Machine>& machines,
+      std::vector<blitz::Array<double,2> >& scores, size_t n_threads=0);
+
+  /**
+   * @brief Runs the k-fold cross-validation of the CGLogRegTrainer as above,
+   * writing the messages of the solver to the given stream instead, e.g.,
+   * when bob::core::info cannot be used by the calling thread.
+   */
+  void cross_validate(const CGLogRegTrainer& trainer,
+      const std::vector<blitz::Array<double,2> >& data,
+      const std::vector<blitz::Array<int64_t,1> >& folds,
+      std::vector<Machine>& machines,
+      std::vector<blitz::Array<double,2> >& scores, std::ostream& log,
+      size_t n_threads=0);
+
+}}}
+
+#endif /* BOB_LEARN_LINEAR_CROSSVAL_H */
@@ -0,0 +1,335 @@
+/**
+ * @date Sun Oct 18 10:12:41 CEST 2026
+ *
+ * @brief Training and evaluation of the Geodesic Flow Kernel (GFK) between
+ * two sets of samples, see:
+ *
+ * Gong, Boqing, et al. "Geodesic flow kernel for unsupervised domain
+ * adaptation." Computer Vision and Pattern Recognition (CVPR), 2012 IEEE
+ * Conference on. IEEE, 2012.
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LINEAR_GFK_H
+#define BOB_LEARN_LINEAR_GFK_H
+
+#include <blitz/array.h>
+#include <bob.io.base/HDF5File.h>
+#include <bob.learn.linear/machine.h>
+
+namespace bob { namespace learn { namespace linear {
+
+  /**
+   * @brief Computes the kernel matrix between all source and target samples.
+   *
+   * Source and target samples (one per row) are normalized using the input
+   * subtraction and division of the source and target machine, respectively.
+   * Afterwards, kernel(i,j) = source_i * G * target_j^T.
+   *
+   * @param source_machine  The machine holding the source normalization
+   * @param target_machine  The machine holding the target normalization
+   * @param G       The dense D x D kernel matrix
+   * @param source  The source samples, with shape (N_s, D)
+   * @param target  The target samples, with shape (N_t, D)
+   * @param kernel  The output kernel matrix, with shape (N_s, N_t)
+   */
+  void gfk_kernel(const Machine& source_machine, const Machine& target_machine,
+    const blitz::Array<double,2>& G,
+    const blitz::Array<double,2>& source, const blitz::Array<double,2>& target,
+    blitz::Array<double,2>& kernel);
+
+  /**
+   * @brief Computes the kernel matrix between all source and target samples,
+   * where the kernel matrix is given in factored form G = basis * core * basis^T.
+   *
+   * Both sets of samples are projected only once into the low-dimensional
+   * space spanned by the D x K basis, so that the costs scale with D * K
+   * instead of D^2.
+   *
+   * @param source_machine  The machine holding the source normalization
+   * @param target_machine  The machine holding the target normalization
+   * @param basis   The D x K basis of the kernel
+   * @param core    The K x K core matrix of the kernel
+   * @param source  The source samples, with shape (N_s, D)
+   * @param target  The target samples, with shape (N_t, D)
+   * @param kernel  The output kernel matrix, with shape (N_s, N_t)
+   */
+  void gfk_kernel(const Machine& source_machine, const Machine& target_machine,
+    const blitz::Array<double,2>& basis, const blitz::Array<double,2>& core,
+    const blitz::Array<double,2>& source, const blitz::Array<double,2>& target,
+    blitz::Array<double,2>& kernel);
+
+  /**
+   * @brief The Geodesic Flow Kernel machine.
+   *
+   * It holds the PCA projections of the source and the target domain (which
+   * also contain the input normalization of the domains), and the kernel
+   * matrix G. G can be stored densely (D x D), or in the factored form
+   * G = basis * core * basis^T, where the basis has shape D x 2d and the
+   * core consists of four diagonal d x d blocks. When both are available,
+   * the factored form is used to compute the kernel.
+   */
+  class GFKMachine {
+
+    public:
+
+      /**
+       * @brief Default constructor, creates an empty machine
+       */
+      GFKMachine();
+
+      /**
+       * @brief Copy constructor
+       */
+      GFKMachine(const GFKMachine& other);
+
+      /**
+       * @brief Loads the machine from the given HDF5 file
+       */
+      GFKMachine(bob::io::base::HDF5File& config);
+
+      /**
+       * @brief Destructor
+       */
+      virtual ~GFKMachine();
+
+      /**
+       * @brief Assignment operator
+       */
+      GFKMachine& operator=(const GFKMachine& other);
+
+      /**
+       * @brief Equal to
+       */
+      bool operator==(const GFKMachine& other) const;
+
+      /**
+       * @brief Not equal to
+       */
+      bool operator!=(const GFKMachine& other) const;
+
+      /**
+       * @brief Similar to, using the relative and absolute precisions
+       */
+      bool is_similar_to(const GFKMachine& other, const double r_epsilon=1e-5,
+        const double a_epsilon=1e-8) const;
+
+      /**
+       * @brief Loads the machine from the given HDF5 file.
+       *
+       * The layout consists of the groups "source_machine" and
+       * "target_machine", the optional dataset "G" and the optional group
+       * "G_factors" holding the "basis" and the diagonals "B1" to "B4" of
+       * the core matrix.
+       */
+      void load(bob::io::base::HDF5File& config);
+
+      /**
+       * @brief Saves the machine to the given HDF5 file
+       */
+      void save(bob::io::base::HDF5File& config) const;
+
+      /**
+       * @brief Computes the kernel matrix between all source and target
+       * samples, see gfk_kernel()
+       */
+      void forward(const blitz::Array<double,2>& source,
+        const blitz::Array<double,2>& target,
+        blitz::Array<double,2>& kernel) const;
+
+      /**
+       * @brief The dimensionality of the input samples
+       */
+      size_t inputSize() const;
+
+      /**
+       * @brief The PCA projection of the source domain
+       */
+      const Machine& getSourceMachine() const { return m_source_machine; }
+
+      /**
+       * @brief Sets the PCA projection of the source domain
+       */
+      void setSourceMachine(const Machine& machine) { m_source_machine = machine; }
+
+      /**
+       * @brief The PCA projection of the target domain
+       */
+      const Machine& getTargetMachine() const { return m_target_machine; }
+
+      /**
+       * @brief Sets the PCA projection of the target domain
+       */
+      void setTargetMachine(const Machine& machine) { m_target_machine = machine; }
+
+      /**
+       * @brief The dense kernel matrix; empty if only the factored form is
+       * stored
+       */
+      const blitz::Array<double,2>& getG() const { return m_G; }
+
+      /**
+       * @brief Computes the dense D x D kernel matrix, either by copying the
+       * stored one or from its factors
+       */
+      void computeG(blitz::Array<double,2>& G) const;
+
+      /**
+       * @brief Sets the dense kernel matrix; an empty array removes it
+       */
+      void setG(const blitz::Array<double,2>& G);
+
+      /**
+       * @brief The D x 2d basis of the factored kernel matrix; empty if not
+       * available
+       */
+      const blitz::Array<double,2>& getBasis() const { return m_basis; }
+
+      /**
+       * @brief The 2d x 2d core matrix of the factored kernel matrix; empty if
+       * not available
+       */
+      const blitz::Array<double,2>& getCore() const { return m_core; }
+
+      /**
+       * @brief Sets the factored form of the kernel matrix; empty arrays
+       * remove it
+       */
+      void setFactors(const blitz::Array<double,2>& basis, const blitz::Array<double,2>& core);
+
+      /**
+       * @brief Returns true if only the factored form of G is stored
+       */
+      bool isFactored() const { return !m_G.size() && m_basis.size(); }
+
+    private:
+
+      Machine m_source_machine; ///< PCA projection of the source domain
+      Machine m_target_machine; ///< PCA projection of the target domain
+      blitz::Array<double,2> m_G; ///< dense kernel matrix
+      blitz::Array<double,2> m_basis; ///< basis of the factored kernel matrix
+      blitz::Array<double,2> m_core; ///< core of the factored kernel matrix
+
+  };
+
+  /**
+   * @brief Trains a GFKMachine from unlabeled data of a source and a target
+   * domain.
+   *
+   * The statistics of both domains are gathered from the data itself,
+   * without copying it. The z-normalization of the inputs is
+   * folded into the covariance matrices, and the PCA of the source and the
+   * target domain are computed concurrently.
+   */
+  class GFKTrainer {
+
+    public:
+
+      /**
+       * @brief Initializes a new GFK trainer.
+       *
+       * @param number_of_subspaces  The number of subspaces d, or -1 to
+       * estimate d automatically (see section 3.4 of the paper)
+       * @param subspace_dim_source  The number of source PCA dimensions, or
+       * the fraction of the source energy to keep if source_energy is set
+       * @param source_energy  Interpret subspace_dim_source as energy
+       * @param subspace_dim_target  The number of target PCA dimensions, or
+       * the fraction of the target energy to keep if target_energy is set
+       * @param target_energy  Interpret subspace_dim_target as energy
+       * @param eps  The floor value for principal angles
+       * @param factored  Store the kernel matrix in factored form only
+       */
+      GFKTrainer(int number_of_subspaces=-1,
+        double subspace_dim_source=0.99, bool source_energy=true,
+        double subspace_dim_target=0.99, bool target_energy=true,
+        double eps=1e-20, bool factored=false);
+
+      /**
+       * @brief Copy constructor
+       */
+      GFKTrainer(const GFKTrainer& other);
+
+      /**
+       * @brief Destructor
+       */
+      virtual ~GFKTrainer();
+
+      /**
+       * @brief Assignment operator
+       */
+      GFKTrainer& operator=(const GFKTrainer& other);
+
+      /**
+       * @brief Equal to
+       */
+      bool operator==(const GFKTrainer& other) const;
+
+      /**
+       * @brief Not equal to
+       */
+      bool operator!=(const GFKTrainer& other) const;
+
+      /**
+       * @brief Trains the given machine using the source and the target data
+       * (one sample per row).
+       *
+       * If norm_inputs is set, the data of both domains is z-normalized,
+       * otherwise only centered for the PCA. When the number of subspaces is
+       * estimated automatically, the inputs are always normalized.
+       *
+       * The statistics of both domains are accumulated in two threads,
+       * which read the data element by element and never copy it, so that
+       * source and target may share their memory (e.g., two row ranges of
+       * one matrix). The data must not be modified during the training.
+       */
+      void train(GFKMachine& machine, const blitz::Array<double,2>& source,
+        const blitz::Array<double,2>& target, bool norm_inputs=true) const;
+
+      /**
+       * @brief The number of subspaces; -1 for automatic estimation
+       */
+      int getNumberOfSubspaces() const { return m_number_of_subspaces; }
+      void setNumberOfSubspaces(int value) { m_number_of_subspaces = value; }
+
+      /**
+       * @brief The source subspace dimension or energy
+       */
+      double getSubspaceDimSource() const { return m_subspace_dim_source; }
+      bool getSourceEnergy() const { return m_source_energy; }
+      void setSubspaceDimSource(double value, bool energy) { m_subspace_dim_source = value; m_source_energy = energy; }
+
+      /**
+       * @brief The target subspace dimension or energy
+       */
+      double getSubspaceDimTarget() const { return m_subspace_dim_target; }
+      bool getTargetEnergy() const { return m_target_energy; }
+      void setSubspaceDimTarget(double value, bool energy) { m_subspace_dim_target = value; m_target_energy = energy; }
+
+      /**
+       * @brief The floor value
+       */
+      double getEps() const { return m_eps; }
+      void setEps(double value) { m_eps = value; }
+
+      /**
+       * @brief Store the kernel matrix in factored form only?
+       */
+      bool getFactored() const { return m_factored; }
+      void setFactored(bool value) { m_factored = value; }
+
+    private:
+
+      int m_number_of_subspaces;
+      double m_subspace_dim_source;
+      bool m_source_energy;
+      double m_subspace_dim_target;
+      bool m_target_energy;
+      double m_eps;
+      bool m_factored;
+
+  };
+
+}}}
+
+#endif /* BOB_LEARN_LINEAR_GFK_H */
@@ -16,6 +16,9 @@
 
 #include <vector>
 #include <bob.learn.linear/machine.h>
+#include <bob.learn.linear/scatter.h>
+#include <bob.learn.linear/profile.h>
+#include <boost/shared_ptr.hpp>
 
 namespace bob { namespace learn { namespace linear {
 
@@ -93,6 +96,20 @@ namespace bob { namespace learn { namespace linear {
        */
       void setStripToRank (bool v) { m_strip_to_rank = v; }
 
+      /**
+       * @brief Gets the statistics filled by each training, or an empty
+       * pointer if no statistics are collected
+       */
+      boost::shared_ptr<TrainingStats> getStats () const { return m_stats; }
+
+      /**
+       * @brief Sets the statistics that each training fills with the wall
+       * time and the estimated array sizes of its phases (see TrainingStats);
+       * an empty pointer disables the collection. While statistics are set,
+       * the trainer must not be used by several threads at once.
+       */
+      void setStats (const boost::shared_ptr<TrainingStats>& stats) { m_stats = stats; }
+
       /**
        * @brief Trains the LinearMachine to perform Fisher/LDA discrimination.
        * The resulting machine will have the eigen-vectors of the
@@ -124,6 +141,39 @@ namespace bob { namespace learn { namespace linear {
       void train(Machine& machine, blitz::Array<double,1>& eigen_values,
           const std::vector<blitz::Array<double,2> >& X) const;
 
+      /**
+       * @brief Trains the LinearMachine to perform Fisher/LDA discrimination
+       * on weighted samples. Each class comes with a weight array holding
+       * the non-negative frequency weight of each row of its data.
+       */
+      void train(Machine& machine,
+          const std::vector<blitz::Array<double,2> >& X,
+          const std::vector<blitz::Array<double,1> >& weights) const;
+
+      /**
+       * @brief Trains the LinearMachine to perform Fisher/LDA discrimination
+       * on weighted samples, and returns the eigen values.
+       */
+      void train(Machine& machine, blitz::Array<double,1>& eigen_values,
+          const std::vector<blitz::Array<double,2> >& X,
+          const std::vector<blitz::Array<double,1> >& weights) const;
+
+      /**
+       * @brief Trains the LinearMachine to perform Fisher/LDA discrimination
+       * from the accumulated statistics of the classes, one accumulator per
+       * class.
+       */
+      void train(Machine& machine,
+          const std::vector<ScatterAccumulator>& statistics) const;
+
+      /**
+       * @brief Trains the LinearMachine to perform Fisher/LDA discrimination
+       * from the accumulated statistics of the classes, one accumulator per
+       * class, and returns the eigen values.
+       */
+      void train(Machine& machine, blitz::Array<double,1>& eigen_values,
+          const std::vector<ScatterAccumulator>& statistics) const;
+
       /**
        * @brief Returns the expected size of the output given the data.
        *
@@ -133,9 +183,16 @@ namespace bob { namespace learn { namespace linear {
        */
       size_t output_size(const std::vector<blitz::Array<double,2> >& X) const;
 
+      /**
+       * @brief Returns the expected size of the output given the accumulated
+       * statistics of the classes
+       */
+      size_t output_size(const std::vector<ScatterAccumulator>& statistics) const;
+
     private:
       bool m_use_pinv; ///< use the 'pinv' method for LDA
       bool m_strip_to_rank; ///< return rank or full matrix
+      boost::shared_ptr<TrainingStats> m_stats; ///< the statistics of the trainings, if any
   };
 
 }}}
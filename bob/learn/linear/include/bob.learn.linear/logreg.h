@@ -11,17 +11,42 @@
 #ifndef BOB_LEARN_LINEAR_LOGREG_H
 #define BOB_LEARN_LINEAR_LOGREG_H
 
+#include <vector>
+#include <ostream>
 #include <boost/format.hpp>
+#include <boost/function.hpp>
 #include <bob.learn.linear/machine.h>
 
 namespace bob { namespace learn { namespace linear {
 
+  /**
+   * The state of the conjugate gradient optimization of the CGLogRegTrainer
+   * after one iteration
+   */
+  struct CGLogRegIteration {
+    size_t iteration; ///< the iteration number, starting at 0
+    double objective; ///< the (prior-weighted and regularized) negative log-likelihood before the step
+    double gradient_norm; ///< the Euclidean norm of the gradient before the step
+    double weight_change; ///< the maximum absolute change of the weights, which is compared to the convergence threshold
+    double step_size; ///< the step size of the line search along the conjugate direction
+    double seconds; ///< the wall time since the start of the training
+  };
+
+  /**
+   * A function that is called after each iteration of the CGLogRegTrainer;
+   * returning true stops the training with the current weights
+   */
+  typedef boost::function<bool (const CGLogRegIteration&)> CGLogRegCallback;
+
   /**
    * Trains a Linear Logistic Regression model using a conjugate gradient
    * approach. The objective function is normalized with respect to the
    * proportion of elements in class 1 to the ones in class 2, and
    * then weighted with respect to a given synthetic prior, P, as this is
    * done in the FoCal toolkit.
+   * Alternatively, the same objective function is minimized with the
+   * L-BFGS algorithm or with a truncated Newton method, which usually need
+   * fewer passes over badly conditioned data.
    * References:
    *   1/ "A comparison of numerical optimizers for logistic regression",
    *   T. Minka, Unpublished draft, 2003 (revision in 2007),
@@ -32,6 +57,15 @@ namespace bob { namespace learn { namespace linear {
 
     public: //api
 
+      /**
+       * The available optimization algorithms
+       */
+      typedef enum {
+        CG = 0, ///< nonlinear conjugate gradient (Hestenes-Stiefel) with a single Newton step as line search
+        LBFGS, ///< limited-memory BFGS with a line search satisfying the weak Wolfe conditions
+        NEWTON_CG ///< truncated Newton, solving for the Newton direction with linear conjugate gradients on Hessian-vector products
+      } Solver;
+
       /**
        * Default constructor.
        * @param prior The synthetic prior. It should be in the range ]0.,1.[
@@ -43,12 +77,18 @@ namespace bob { namespace learn { namespace linear {
        * @param mean_std_norm Compute mean and standard deviation in training
        *           data and set the input_subtract and input_divide parameters
        *           of the resulting machine
+       * @param solver The optimization algorithm; the convergence threshold
+       *           and the maximum number of iterations apply to all of them
+       * @param warm_start Start the optimization from the weights of the
+       *           machine passed to train(), if it has the right shape
        */
       CGLogRegTrainer(const double prior=0.5,
         const double convergence_threshold=1e-5,
         const size_t max_iterations=10000,
         const double lambda=0.,
-        const bool mean_std_norm=false);
+        const bool mean_std_norm=false,
+        const Solver solver=CG,
+        const bool warm_start=false);
 
       /**
        * Copy constructor
@@ -82,6 +122,8 @@ namespace bob { namespace learn { namespace linear {
       size_t getMaxIterations() const { return m_max_iterations; }
       double getLambda() const { return m_lambda; }
       bool getNorm() const { return m_mean_std_norm; }
+      Solver getSolver() const { return m_solver; }
+      bool getWarmStart() const { return m_warm_start; }
 
       /**
        * Setters
@@ -101,6 +143,8 @@ namespace bob { namespace learn { namespace linear {
       void setLambda(const double lambda)
       { m_lambda = lambda; }
       void setNorm(const bool mean_std_norm) { m_mean_std_norm = mean_std_norm; }
+      void setSolver(const Solver solver) { m_solver = solver; }
+      void setWarmStart(const bool warm_start) { m_warm_start = warm_start; }
 
       /**
        * Trains the LinearMachine to perform Linear Logistic Regression
@@ -109,9 +153,337 @@ namespace bob { namespace learn { namespace linear {
           const blitz::Array<double,2>& negatives,
           const blitz::Array<double,2>& positives) const;
 
+      /**
+       * Trains the LinearMachine to perform Linear Logistic Regression,
+       * calling the given function after each iteration. If the function
+       * returns true, the training stops and the machine is set to the
+       * current weights.
+       */
+      virtual void train(Machine& machine,
+          const blitz::Array<double,2>& negatives,
+          const blitz::Array<double,2>& positives,
+          const CGLogRegCallback& callback) const;
+
+      /**
+       * Trains the LinearMachine as above, writing the messages of the
+       * solver to the given stream instead of bob::core::info. Threads that
+       * train concurrently need to use their own streams, since
+       * bob::core::info is not thread-safe (and may call into Python).
+       */
+      virtual void train(Machine& machine,
+          const blitz::Array<double,2>& negatives,
+          const blitz::Array<double,2>& positives,
+          const CGLogRegCallback& callback,
+          std::ostream& log) const;
+
+      /**
+       * Trains the LinearMachine on sparse data, one sample per row. The
+       * mean and standard deviation normalization is applied implicitly, so
+       * that the data is never densified; columns that are constant are not
+       * scaled.
+       */
+      virtual void train(Machine& machine,
+          const CSRMatrix& negatives,
+          const CSRMatrix& positives) const;
+
+      /**
+       * Trains the LinearMachine on sparse data, calling the given function
+       * after each iteration, see above
+       */
+      virtual void train(Machine& machine,
+          const CSRMatrix& negatives,
+          const CSRMatrix& positives,
+          const CGLogRegCallback& callback) const;
+
+      /**
+       * Trains one LinearMachine for each of the given regularization
+       * factors, which replace the lambda of this trainer. The data is
+       * normalized only once, and each optimization starts from the solution
+       * of the previous factor, so that decreasing factors are the most
+       * efficient order.
+       */
+      virtual void trainPath(std::vector<Machine>& machines,
+          const blitz::Array<double,2>& negatives,
+          const blitz::Array<double,2>& positives,
+          const std::vector<double>& lambdas) const;
+
+    private:
+      // Attributes
+      double m_prior;
+      double m_convergence_threshold;
+      size_t m_max_iterations;
+      double m_lambda;
+      bool m_mean_std_norm;
+      Solver m_solver;
+      bool m_warm_start;
+  };
+
+  /**
+   * Trains a Linear Logistic Regression model with the same objective
+   * function as the CGLogRegTrainer, using mini-batch stochastic gradients
+   * with the Adam update rule. The data is presented in chunks of arbitrary
+   * size, so that the memory does not depend on the number of samples:
+   *
+   *   1/ initialize() starts a new training,
+   *   2/ accumulate() collects the number of samples in each class and,
+   *      optionally, their mean and standard deviation, in a first pass over
+   *      all chunks,
+   *   3/ update() performs the Adam steps on the mini-batches of one chunk,
+   *      in as many passes (epochs) over all chunks as desired,
+   *   4/ finalize() writes the weights into the machine.
+   *
+   * The objective function is divided by the number of samples, so that the
+   * gradient of a mini-batch is an unbiased estimate of its gradient. The
+   * learning rate decays with the square root of the number of epochs.
+   * Each mini-batch contains the same proportion of both classes as the
+   * chunk, but the order of the samples in the chunks is not shuffled.
+   * References:
+   *   1/ "Adam: A Method for Stochastic Optimization", D. P. Kingma and
+   *   J. Ba, ICLR 2015
+   */
+  class MiniBatchLogRegTrainer {
+
+    public: //api
+
+      /**
+       * Default constructor.
+       * @param prior The synthetic prior. It should be in the range ]0.,1.[
+       * @param lambda The regularization factor
+       * @param mean_std_norm Compute mean and standard deviation in training
+       *           data and set the input_subtract and input_divide parameters
+       *           of the resulting machine
+       * @param batch_size The number of samples in each mini-batch
+       * @param learning_rate The initial step size of the Adam updates
+       * @param epochs The number of passes over the data in train()
+       */
+      MiniBatchLogRegTrainer(const double prior=0.5,
+        const double lambda=0.,
+        const bool mean_std_norm=false,
+        const size_t batch_size=256,
+        const double learning_rate=0.01,
+        const size_t epochs=10);
+
+      /**
+       * Copy constructor, which copies the state of the training, too
+       */
+      MiniBatchLogRegTrainer(const MiniBatchLogRegTrainer& other);
+
+      /**
+       * Destructor
+       */
+      virtual ~MiniBatchLogRegTrainer();
+
+      /**
+       * Assignment operator
+       */
+      MiniBatchLogRegTrainer& operator=(const MiniBatchLogRegTrainer& other);
+
+      /**
+       * @brief Equal to, comparing the parameters only
+       */
+      bool operator==(const MiniBatchLogRegTrainer& b) const;
+      /**
+       * @brief Not equal to
+       */
+      bool operator!=(const MiniBatchLogRegTrainer& b) const;
+
+      /**
+       * Getters
+       */
+      double getPrior() const { return m_prior; }
+      double getLambda() const { return m_lambda; }
+      bool getNorm() const { return m_mean_std_norm; }
+      size_t getBatchSize() const { return m_batch_size; }
+      double getLearningRate() const { return m_learning_rate; }
+      size_t getEpochs() const { return m_epochs; }
+
+      /**
+       * Setters
+       */
+      void setPrior(const double prior);
+      void setLambda(const double lambda) { m_lambda = lambda; }
+      void setNorm(const bool mean_std_norm) { m_mean_std_norm = mean_std_norm; }
+      void setBatchSize(const size_t batch_size);
+      void setLearningRate(const double learning_rate) { m_learning_rate = learning_rate; }
+      void setEpochs(const size_t epochs) { m_epochs = epochs; }
+
+      /**
+       * Starts a new training for samples of the given dimensionality,
+       * forgetting the accumulated statistics and the weights. If the
+       * dimensionality is 0, it is set by the first call to accumulate().
+       */
+      void initialize(const size_t n_features=0);
+
+      /**
+       * Adds the given chunk of samples (one per row) to the statistics of
+       * the first pass. All chunks must be accumulated before the first call
+       * to update().
+       */
+      void accumulate(const blitz::Array<double,2>& negatives,
+          const blitz::Array<double,2>& positives);
+
+      /**
+       * Performs one Adam step on each mini-batch of the given chunk of
+       * samples (one per row). Returns the average prior-weighted negative
+       * log-likelihood of the samples of the chunk, each evaluated before the
+       * step of its mini-batch.
+       */
+      double update(const blitz::Array<double,2>& negatives,
+          const blitz::Array<double,2>& positives);
+
+      /**
+       * Writes the current weights, and the normalization, into the machine
+       */
+      void finalize(Machine& machine) const;
+
+      /**
+       * The dimensionality of the samples, or 0 before the first chunk
+       */
+      size_t numberOfFeatures() const { return m_mean.extent(0); }
+
+      /**
+       * The number of accumulated negative and positive samples
+       */
+      size_t numberOfNegatives() const { return m_n_negatives; }
+      size_t numberOfPositives() const { return m_n_positives; }
+
+      /**
+       * The number of Adam steps performed since initialize()
+       */
+      size_t numberOfSteps() const { return m_steps; }
+
+      /**
+       * Trains the LinearMachine to perform Linear Logistic Regression on
+       * data in memory, by presenting the data as a single chunk in each of
+       * the given number of epochs
+       */
+      virtual void train(Machine& machine,
+          const blitz::Array<double,2>& negatives,
+          const blitz::Array<double,2>& positives);
+
     private:
+
+      /**
+       * The normalization of the samples, i.e., their mean and standard
+       * deviation if mean_std_norm is set, 0 and 1 otherwise
+       */
+      void normalization(blitz::Array<double,1>& mean,
+          blitz::Array<double,1>& std_dev) const;
+
       // Attributes
       double m_prior;
+      double m_lambda;
+      bool m_mean_std_norm;
+      size_t m_batch_size;
+      double m_learning_rate;
+      size_t m_epochs;
+
+      // State of the training
+      size_t m_n_negatives; ///< the number of accumulated negatives
+      size_t m_n_positives; ///< the number of accumulated positives
+      blitz::Array<double,1> m_mean; ///< the mean of the accumulated samples
+      blitz::Array<double,1> m_scatter; ///< the sum of squared deviations from the mean, per feature
+      blitz::Array<double,1> m_w; ///< the weights, followed by the bias
+      blitz::Array<double,1> m_moment1; ///< the first moment estimate of the gradient
+      blitz::Array<double,1> m_moment2; ///< the second (raw) moment estimate of the gradient
+      size_t m_steps; ///< the number of Adam steps
+      double m_seen; ///< the number of samples presented to update()
+  };
+
+  /**
+   * Trains a multinomial (softmax) Logistic Regression model for K classes,
+   * i.e., a Machine with K outputs, whose softmax is the posterior
+   * probability of the classes. All K columns of the weights are learned in
+   * a single optimization of the regularized negative log-likelihood with
+   * the L-BFGS algorithm, where the margins of all classes are computed with
+   * one matrix product per evaluation.
+   * The resulting machine has the identity activation, i.e., it outputs the
+   * logits of the classes, which are only defined up to a common constant.
+   * The samples are not weighted, so that the class priors are the
+   * proportions of the classes in the training data.
+   */
+  class MultinomialLogRegTrainer {
+
+    public: //api
+
+      /**
+       * Default constructor.
+       * @param convergence_threshold The threshold to detect the convergence
+       *           on the maximum change of the weights
+       * @param max_iterations The maximum number of iterations of the
+       *           L-BFGS algorithm (0 <-> infinity)
+       * @param lambda The regularization factor
+       * @param mean_std_norm Compute mean and standard deviation in training
+       *           data and set the input_subtract and input_divide parameters
+       *           of the resulting machine
+       */
+      MultinomialLogRegTrainer(const double convergence_threshold=1e-5,
+        const size_t max_iterations=10000,
+        const double lambda=0.,
+        const bool mean_std_norm=false);
+
+      /**
+       * Copy constructor
+       */
+      MultinomialLogRegTrainer(const MultinomialLogRegTrainer& other);
+
+      /**
+       * Destructor
+       */
+      virtual ~MultinomialLogRegTrainer();
+
+      /**
+       * Assignment operator
+       */
+      MultinomialLogRegTrainer& operator=(const MultinomialLogRegTrainer& other);
+
+      /**
+       * @brief Equal to
+       */
+      bool operator==(const MultinomialLogRegTrainer& b) const;
+      /**
+       * @brief Not equal to
+       */
+      bool operator!=(const MultinomialLogRegTrainer& b) const;
+
+      /**
+       * Getters
+       */
+      double getConvergenceThreshold() const { return m_convergence_threshold; }
+      size_t getMaxIterations() const { return m_max_iterations; }
+      double getLambda() const { return m_lambda; }
+      bool getNorm() const { return m_mean_std_norm; }
+
+      /**
+       * Setters
+       */
+      void setConvergenceThreshold(const double convergence_threshold)
+      { m_convergence_threshold = convergence_threshold; }
+      void setMaxIterations(const size_t max_iterations)
+      { m_max_iterations = max_iterations; }
+      void setLambda(const double lambda)
+      { m_lambda = lambda; }
+      void setNorm(const bool mean_std_norm) { m_mean_std_norm = mean_std_norm; }
+
+      /**
+       * Trains the LinearMachine to perform multinomial Logistic Regression
+       * on the data of (at least two) classes, one sample per row
+       */
+      virtual void train(Machine& machine,
+          const std::vector<blitz::Array<double,2> >& data) const;
+
+      /**
+       * Trains the LinearMachine to perform multinomial Logistic Regression,
+       * calling the given function after each iteration. If the function
+       * returns true, the training stops and the machine is set to the
+       * current weights.
+       */
+      virtual void train(Machine& machine,
+          const std::vector<blitz::Array<double,2> >& data,
+          const CGLogRegCallback& callback) const;
+
+    private:
+      // Attributes
       double m_convergence_threshold;
       size_t m_max_iterations;
       double m_lambda;
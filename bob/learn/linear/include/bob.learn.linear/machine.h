@@ -17,12 +17,30 @@
 #ifndef BOB_LEARN_LINEAR_MACHINE_H
 #define BOB_LEARN_LINEAR_MACHINE_H
 
+#include <boost/shared_ptr.hpp>
 #include <blitz/array.h>
+#include <bob.core/array_check.h>
+#include <bob.core/array_copy.h>
 #include <bob.io.base/HDF5File.h>
 #include <bob.learn.activation/Activation.h>
+#include <bob.learn.linear/sparse.h>
 
 namespace bob { namespace learn { namespace linear {
 
+  /**
+   * Makes the array to reference the data of the from array, if no other
+   * array refers to that data and it is stored contiguously in C order with
+   * zero-based indices; otherwise, the data is copied. Setters taking rvalue
+   * references use this to avoid copying arrays that are used nowhere else.
+   */
+  template <typename T, int N>
+  void take_or_copy(blitz::Array<T,N>& to, blitz::Array<T,N>& from) {
+    if (from.numReferences() == 1 && bob::core::array::isCZeroBaseContiguous(from))
+      to.reference(from);
+    else
+      to.reference(bob::core::array::ccopy(from));
+  }
+
   /**
    * A linear classifier. See C. M. Bishop, "Pattern Recognition and Machine
    * Learning", chapter 4 for more details.
@@ -55,7 +73,19 @@ namespace bob { namespace learn { namespace linear {
       Machine(const blitz::Array<double,2>& weight);
 
       /**
-       * Copies another machine
+       * Builds a new machine with a set of weights, taking over the given
+       * array instead of copying it, see take_or_copy()
+       */
+      Machine(blitz::Array<double,2>&& weight);
+
+      /**
+       * Copies another machine. The weight matrix is not copied, but shared
+       * between both machines until one of them modifies it in place (see
+       * updateWeights()), so that copies are cheap in time and memory
+       * independently of the size of the weights. All other parameters are
+       * copied. The shared weights are owned by an atomically counted
+       * boost::shared_ptr (see getStorage()), so that the copies can be used,
+       * modified and destroyed in different threads.
        */
       Machine (const Machine& other);
 
@@ -70,7 +100,8 @@ namespace bob { namespace learn { namespace linear {
       virtual ~Machine();
 
       /**
-       * Assigns from a different machine
+       * Assigns from a different machine, sharing its weights as the copy
+       * constructor does
        */
       Machine& operator= (const Machine& other);
 
@@ -91,8 +122,28 @@ namespace bob { namespace learn { namespace linear {
       /**
        * Loads data from an existing configuration object. Resets the current
        * state.
+       *
+       * If map_weights is set, the weight matrix is memory-mapped read-only
+       * from the file instead of being read into memory, so that loading is
+       * almost instantaneous and the pages are shared between all processes
+       * mapping the same file. This requires the weights to be stored
+       * contiguously and uncompressed as native doubles, which is the case
+       * for files written by save(); otherwise, the weights are read as
+       * usual (see isMapped()). The position of the weights is taken from
+       * the open file, and they are only mapped if the file on disk is still
+       * the one that the given file reads; otherwise, they are read.
+       *
+       * The (private) mapping is shared by all machines that map the same weights of
+       * the same version of the file, and by copies of these machines; it is
+       * released when the last of them releases it, i.e., when it is
+       * destroyed, loads other weights or copies the weights into memory,
+       * which methods that modify the weights in place do first. Files must
+       * not be overwritten in place while mapped, as this changes the weights
+       * of the loaded machines or, if the file shrinks, makes them crash;
+       * write a new file and rename it over the old one instead, which keeps
+       * the old version alive for the machines that map it.
        */
-      void load (bob::io::base::HDF5File& config);
+      void load (bob::io::base::HDF5File& config, bool map_weights=false);
 
       /**
        * Saves an existing machine to a Configuration object.
@@ -119,6 +170,25 @@ namespace bob { namespace learn { namespace linear {
       void forward (const blitz::Array<double,1>& input,
           blitz::Array<double,1>& output) const;
 
+      /**
+       * Forwards the rows of a sparse matrix through the network, writing
+       * one row of output per row of input. Only the stored values of the
+       * input are visited: the input subtraction is folded into the biases,
+       * so that the input is never densified.
+       *
+       * The input and output are NOT checked for compatibility each time. It
+       * is your responsibility to do it.
+       */
+      void forward_ (const CSRMatrix& input,
+          blitz::Array<double,2>& output) const;
+
+      /**
+       * Forwards the rows of a sparse matrix through the network, see
+       * forward_(). The input and output are checked for compatibility.
+       */
+      void forward (const CSRMatrix& input,
+          blitz::Array<double,2>& output) const;
+
       /**
        * Resizes the machine. If either the input or output increases in size,
        * the weights and other factors should be considered uninitialized. If
@@ -156,6 +226,12 @@ namespace bob { namespace learn { namespace linear {
        */
       void setInputSubtraction(const blitz::Array<double,1>& v);
 
+      /**
+       * Sets the current input subtraction factor, taking over the given
+       * array instead of copying it, see take_or_copy()
+       */
+      void setInputSubtraction(blitz::Array<double,1>&& v);
+
       /**
        * Returns the current input subtraction factor in order to be updated.
        * @warning Use with care. Only trainers should use this function for
@@ -182,6 +258,12 @@ namespace bob { namespace learn { namespace linear {
        */
       void setInputDivision(const blitz::Array<double,1>& v);
 
+      /**
+       * Sets the current input division factor, taking over the given array
+       * instead of copying it, see take_or_copy()
+       */
+      void setInputDivision(blitz::Array<double,1>&& v);
+
       /**
        * Returns the current input division factor in order to be updated.
        * @warning Use with care. Only trainers should use this function for
@@ -211,20 +293,60 @@ namespace bob { namespace learn { namespace linear {
        */
       void setWeights(const blitz::Array<double,2>& weight);
 
+      /**
+       * Sets the current weights, taking over the given array instead of
+       * copying it, see take_or_copy(). Trainers should compute the weights
+       * in an array of their own and hand it over with std::move().
+       */
+      void setWeights(blitz::Array<double,2>&& weight);
+
       /**
        * Returns the current weight representation in order to be updated.
        * Each column should be considered as a vector from which each of the
        * output values is derived by projecting the input onto such a vector.
+       * If the weights are shared with other machines or memory-mapped, they
+       * are copied first, so that the modifications only affect this machine.
        * @warning Use with care. Only trainers should use this function for
-       * efficiency reasons.
+       * efficiency reasons. The returned reference must not be used to
+       * modify the weights after this machine has been copied, and the array
+       * must not be resized or made to reference other data.
        */
       inline blitz::Array<double, 2>& updateWeights()
-      { return m_weight; }
+      { detach(); return m_weight; }
 
       /**
        * Sets all weights to a single specific value.
        */
-      inline void setWeights(double v) { m_weight = v; }
+      inline void setWeights(double v) { detach(); m_weight = v; }
+
+      /**
+       * Returns true if the weights are memory-mapped from a file, see load()
+       */
+      inline bool isMapped() const { return m_mapped; }
+
+      /**
+       * Returns the owner of the memory of the weights, i.e., of the memory
+       * mapping if the weights are memory-mapped. The owner is shared by all
+       * copies of this machine that share the weights. Views of getWeights()
+       * do not own the memory; code that keeps such a view beyond the
+       * lifetime of this machine (or of its current weights) must keep a
+       * copy of the owner, which also makes this machine copy the weights
+       * before modifying them.
+       */
+      inline const boost::shared_ptr<const void>& getStorage() const
+      { return m_storage; }
+
+      /**
+       * Refers to the given read-only weights instead of copying them, as
+       * load() does for memory-mapped files. The memory must stay valid as
+       * long as the given owner of the mapping (see map_file() in bundle.h)
+       * is alive, which this machine keeps until the weights are copied or
+       * replaced. The input subtraction, input division and biases are
+       * resized to the shape of the weights as with resize(), and need to be
+       * set afterwards.
+       */
+      void mapWeights(const blitz::Array<double,2>& weight,
+          const boost::shared_ptr<const void>& mapping);
 
       /**
        * Returns the biases of this classifier.
@@ -239,6 +361,12 @@ namespace bob { namespace learn { namespace linear {
        */
       void setBiases(const blitz::Array<double,1>& bias);
 
+      /**
+       * Sets the current biases, taking over the given array instead of
+       * copying it, see take_or_copy()
+       */
+      void setBiases(blitz::Array<double,1>&& bias);
+
       /**
        * Sets all output bias values to a specific value.
        */
@@ -256,11 +384,27 @@ namespace bob { namespace learn { namespace linear {
 
     private: //representation
 
+      /**
+       * Copies memory-mapped weights or weights shared with other machines
+       * (or arrays) into memory owned by this machine only, so that they can
+       * be modified
+       */
+      void detach();
+
+      /**
+       * Takes the given weights over (see take_or_copy()) into a new owner,
+       * and makes the weights refer to its memory. The given array is left
+       * empty.
+       */
+      void own(blitz::Array<double,2>& weight);
+
       typedef double (*actfun_t)(double); ///< activation function type
 
       blitz::Array<double, 1> m_input_sub; ///< input subtraction
       blitz::Array<double, 1> m_input_div; ///< input division
-      blitz::Array<double, 2> m_weight; ///< weights
+      blitz::Array<double, 2> m_weight; ///< weights, referring to the memory of m_storage without owning it
+      boost::shared_ptr<const void> m_storage; ///< the owner of the memory of the weights, shared by copies
+      bool m_mapped; ///< are the weights memory-mapped (read-only)?
       blitz::Array<double, 1> m_bias; ///< biases for the output
       boost::shared_ptr<bob::learn::activation::Activation> m_activation; ///< currently set activation type
 
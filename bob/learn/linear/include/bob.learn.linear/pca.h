@@ -14,6 +14,9 @@
 #define BOB_LEARN_LINEAR_PCA_H
 
 #include <bob.learn.linear/machine.h>
+#include <bob.learn.linear/scatter.h>
+#include <bob.learn.linear/profile.h>
+#include <boost/shared_ptr.hpp>
 
 namespace bob { namespace learn { namespace linear {
 
@@ -97,6 +100,21 @@ namespace bob { namespace learn { namespace linear {
        */
       void setSafeSVD (bool value) { m_safe_svd = value; }
 
+      /**
+       * @brief Gets the statistics filled by each training, or an empty
+       * pointer if no statistics are collected
+       */
+      boost::shared_ptr<TrainingStats> getStats () const { return m_stats; }
+
+      /**
+       * @brief Sets the statistics that each training fills with the wall
+       * time and the estimated array sizes of its phases (see TrainingStats);
+       * an empty pointer disables the collection. The statistics are not
+       * copied with the trainer. While statistics are set, the trainer must
+       * not be used by several threads at once.
+       */
+      void setStats (const boost::shared_ptr<TrainingStats>& stats) { m_stats = stats; }
+
       /**
        * @brief Trains the LinearMachine to perform the KLT. The resulting
        * machine will have the eigen-vectors of the covariance matrix arranged
@@ -116,6 +134,45 @@ namespace bob { namespace learn { namespace linear {
           blitz::Array<double,1>& eigen_values,
           const blitz::Array<double,2>& X) const;
 
+      /**
+       * @brief Trains the LinearMachine to perform the KLT on weighted
+       * samples. Each row of X is weighted with the non-negative frequency
+       * weight at the same position, i.e., as if the row was repeated
+       * accordingly; the covariance matrix is normalized by the sum of the
+       * weights minus one.
+       */
+      virtual void train(Machine& machine,
+          const blitz::Array<double,2>& X,
+          const blitz::Array<double,1>& weights) const;
+
+      /**
+       * @brief Trains the LinearMachine to perform the KLT on weighted
+       * samples, and returns the eigen values of the weighted covariance
+       * matrix.
+       */
+      virtual void train(Machine& machine,
+          blitz::Array<double,1>& eigen_values,
+          const blitz::Array<double,2>& X,
+          const blitz::Array<double,1>& weights) const;
+
+      /**
+       * @brief Trains the LinearMachine to perform the KLT from the
+       * accumulated statistics of the data. The covariance method is always
+       * used, independently of the SVD flag.
+       */
+      virtual void train(Machine& machine,
+          const ScatterAccumulator& statistics) const;
+
+      /**
+       * @brief Trains the LinearMachine to perform the KLT from the
+       * accumulated statistics of the data, and returns the eigen values of
+       * the covariance matrix. The covariance method is always used,
+       * independently of the SVD flag.
+       */
+      virtual void train(Machine& machine,
+          blitz::Array<double,1>& eigen_values,
+          const ScatterAccumulator& statistics) const;
+
       /**
        * @brief Calculates the maximum possible rank for the covariance matrix
        * of X, given X.
@@ -126,11 +183,18 @@ namespace bob { namespace learn { namespace linear {
        */
       size_t output_size(const blitz::Array<double,2>& X) const;
 
+      /**
+       * @brief Calculates the maximum possible rank for the covariance matrix
+       * of the data, given its accumulated statistics
+       */
+      size_t output_size(const ScatterAccumulator& statistics) const;
+
     private: //representation
 
       bool m_use_svd; ///< if this trainer should be using SVD or Covariance
       bool m_safe_svd; ///< if svd is set, tells which LAPACK function to use
                        ///  among dgesdd (false) and dgesvd (true)
+      boost::shared_ptr<TrainingStats> m_stats; ///< the statistics of the trainings, if any
 
   };
 
@@ -0,0 +1,139 @@
+/**
+ * @date Sun Oct 18 10:12:41 CEST 2026
+ *
+ * @brief Opt-in timing statistics of the phases of a training
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LINEAR_PROFILE_H
+#define BOB_LEARN_LINEAR_PROFILE_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+namespace bob { namespace learn { namespace linear {
+
+  /**
+   * @brief Records the wall time and the estimated size of the arrays
+   * allocated in the phases of a training, e.g., the computation of the
+   * scatter matrices, the decomposition, the truncation and normalization of
+   * the eigenvectors and the update of the machine.
+   *
+   * Trainers fill the statistics set with their setStats() method in each
+   * call to train(). The estimated size of a phase is computed by the trainer
+   * from the shapes of the arrays it allocates in the phase; it is not a
+   * measurement of the memory of the process, and memory allocated inside
+   * LAPACK is not included.
+   *
+   * The statistics are not synchronized: they are modified by the (const)
+   * train() methods, so that a trainer with statistics, or statistics set in
+   * several trainers, must not be used by several threads at once.
+   */
+  class TrainingStats {
+
+    public:
+
+      /**
+       * @brief One phase of the training
+       */
+      struct Phase {
+        std::string name; ///< the name of the phase
+        double seconds; ///< the wall time spent in the phase
+        size_t estimated_bytes; ///< the estimated size of the arrays allocated in the phase
+      };
+
+      /**
+       * @brief The scope of a training.
+       *
+       * The outermost scope resets the statistics and stops the last phase
+       * when it ends, so that trainers that call other train() methods
+       * record a single list of phases. All methods do nothing if no
+       * statistics are given.
+       */
+      class Scope {
+
+        public:
+
+          /**
+           * @brief Opens a scope on the given statistics, which may be 0
+           */
+          Scope(TrainingStats* stats);
+
+          /**
+           * @brief Closes the scope
+           */
+          ~Scope();
+
+          /**
+           * @brief Starts the phase with the given name, in which arrays of
+           * the given (estimated) size in bytes are allocated; see
+           * TrainingStats::start()
+           */
+          void phase(const std::string& name, size_t bytes=0);
+
+        private:
+
+          Scope(const Scope&);
+          Scope& operator=(const Scope&);
+
+          TrainingStats* m_stats; ///< the statistics, or 0
+      };
+
+      /**
+       * @brief Creates empty statistics
+       */
+      TrainingStats();
+
+      /**
+       * @brief Removes all phases
+       */
+      void reset();
+
+      /**
+       * @brief Starts the phase with the given name, stopping the current
+       * one. If the current phase has the same name, it is continued.
+       */
+      void start(const std::string& name, size_t bytes=0);
+
+      /**
+       * @brief Adds the given estimated size of allocated arrays (in bytes)
+       * to the current phase
+       */
+      void allocated(size_t bytes);
+
+      /**
+       * @brief Stops the current phase, if any
+       */
+      void stop();
+
+      /**
+       * @brief The recorded phases, in the order of their start
+       */
+      const std::vector<Phase>& phases() const { return m_phases; }
+
+      /**
+       * @brief The wall time of all phases, in seconds
+       */
+      double totalSeconds() const;
+
+      /**
+       * @brief The estimated size of the arrays allocated in all phases, in
+       * bytes; as most arrays are kept until the end of the training, this
+       * approximates the memory that the trainer needs for its arrays
+       */
+      size_t totalEstimatedBytes() const;
+
+    private:
+
+      std::vector<Phase> m_phases; ///< the recorded phases
+      std::chrono::steady_clock::time_point m_start; ///< start of the current phase
+      bool m_running; ///< is the last phase running?
+      int m_depth; ///< the number of open scopes
+
+  };
+
+}}}
+
+#endif /* BOB_LEARN_LINEAR_PROFILE_H */
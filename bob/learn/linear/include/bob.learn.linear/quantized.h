@@ -0,0 +1,231 @@
+/**
+ * @date Sun Oct 18 19:05:12 CEST 2026
+ *
+ * @brief A linear machine with 8-bit integer weights, for fast and compact
+ * inference
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LINEAR_QUANTIZED_H
+#define BOB_LEARN_LINEAR_QUANTIZED_H
+
+#include <stdint.h>
+#include <blitz/array.h>
+#include <bob.core/array_copy.h>
+#include <bob.io.base/HDF5File.h>
+#include <bob.learn.activation/Activation.h>
+#include <bob.learn.linear/machine.h>
+
+namespace bob { namespace learn { namespace linear {
+
+  /**
+   * @brief The deviation of the outputs of a QuantizedMachine from the
+   * outputs of the Machine it was quantized from, see
+   * QuantizedMachine::accuracy()
+   */
+  struct QuantizationReport {
+    double max_error; ///< largest absolute difference of an output
+    double mean_error; ///< mean absolute difference of the outputs
+    double rms_error; ///< root mean square difference of the outputs
+    double max_reference; ///< largest absolute output of the reference
+    double agreement; ///< fraction of samples with the same decision
+  };
+
+  /**
+   * @brief A read-only copy of a trained Machine, whose weights are quantized
+   * to 8-bit integers.
+   *
+   * The weights of each output j are scaled with s_j = max(|W(:,j)|) / 127
+   * and rounded to int8, so that the weights take 8 times less memory than
+   * in the Machine. At projection time, each normalized input
+   * x' = (x - input_sub) / input_div is quantized the same way with its own
+   * scale s_x = max(|x'|) / 127, and the outputs are computed from integer
+   * dot products as f(s_x * s_j * sum(q_x * q_j) + b_j). The dot products
+   * accumulate 8-bit products in 32-bit integers, which compilers turn into
+   * integer SIMD instructions.
+   *
+   * The relative error of the outputs is in the order of 1 / 127 of the
+   * largest output, see accuracy().
+   */
+  class QuantizedMachine {
+
+    public:
+
+      /**
+       * @brief Builds an empty 0 x 0 machine
+       */
+      QuantizedMachine();
+
+      /**
+       * @brief Quantizes the given machine
+       */
+      explicit QuantizedMachine(const Machine& machine);
+
+      /**
+       * @brief Loads the quantized machine from the given HDF5 file
+       */
+      QuantizedMachine(bob::io::base::HDF5File& config);
+
+      /**
+       * @brief Copy constructor
+       */
+      QuantizedMachine(const QuantizedMachine& other);
+
+      /**
+       * @brief Destructor
+       */
+      virtual ~QuantizedMachine();
+
+      /**
+       * @brief Assignment operator
+       */
+      QuantizedMachine& operator=(const QuantizedMachine& other);
+
+      /**
+       * @brief Equal to
+       */
+      bool operator==(const QuantizedMachine& other) const;
+
+      /**
+       * @brief Not equal to
+       */
+      bool operator!=(const QuantizedMachine& other) const;
+
+      /**
+       * @brief Replaces the current state with the quantization of the given
+       * machine
+       */
+      void quantize(const Machine& machine);
+
+      /**
+       * @brief Loads the quantized machine from the given HDF5 file.
+       *
+       * The layout consists of the int8 dataset "weights" with one row per
+       * output (i.e., the transposed layout of the Machine), the float
+       * datasets "scales", "input_sub", "input_div" and "biases", and the
+       * group "activation".
+       */
+      void load(bob::io::base::HDF5File& config);
+
+      /**
+       * @brief Saves the quantized machine to the given HDF5 file
+       */
+      void save(bob::io::base::HDF5File& config) const;
+
+      /**
+       * @brief Projects the given input. The input and output are NOT checked
+       * for compatibility.
+       */
+      void forward_(const blitz::Array<double,1>& input,
+          blitz::Array<double,1>& output) const;
+
+      /**
+       * @brief Projects the given input, checking the input and output
+       * dimensions
+       */
+      void forward(const blitz::Array<double,1>& input,
+          blitz::Array<double,1>& output) const;
+
+      /**
+       * @brief Projects the given inputs (one per row) into the rows of the
+       * output. All inputs are quantized first, and blocks of inputs are
+       * projected on each row of weights, which hence is read from the cache.
+       * The input and output are NOT checked for compatibility.
+       */
+      void forward_(const blitz::Array<double,2>& input,
+          blitz::Array<double,2>& output) const;
+
+      /**
+       * @brief Projects the given inputs (one per row), checking the input
+       * and output dimensions
+       */
+      void forward(const blitz::Array<double,2>& input,
+          blitz::Array<double,2>& output) const;
+
+      /**
+       * @brief Compares the outputs of this machine for the given data (one
+       * sample per row) with the outputs of the given reference machine,
+       * which usually is the machine this machine was quantized from.
+       *
+       * Decisions agree when the largest output is at the same position for
+       * machines with several outputs, or when both outputs are on the same
+       * side of the activation of 0 for machines with a single output.
+       */
+      QuantizationReport accuracy(const Machine& reference,
+          const blitz::Array<double,2>& data) const;
+
+      /**
+       * @brief The number of inputs expected by this machine
+       */
+      size_t inputSize() const { return m_weight.extent(1); }
+
+      /**
+       * @brief The number of outputs generated by this machine
+       */
+      size_t outputSize() const { return m_weight.extent(0); }
+
+      /**
+       * @brief A copy of the quantized weights in the layout of the Machine,
+       * i.e., with one column per output
+       */
+      blitz::Array<int8_t,2> getWeights() const
+      { return bob::core::array::ccopy(m_weight.transpose(1,0)); }
+
+      /**
+       * @brief The scale of the quantized weights of each output
+       */
+      const blitz::Array<double,1>& getScales() const { return m_scale; }
+
+      /**
+       * @brief The input subtraction factor
+       */
+      const blitz::Array<double,1>& getInputSubtraction() const
+      { return m_input_sub; }
+
+      /**
+       * @brief The input division factor
+       */
+      const blitz::Array<double,1>& getInputDivision() const
+      { return m_input_div; }
+
+      /**
+       * @brief The biases of the outputs
+       */
+      const blitz::Array<double,1>& getBiases() const { return m_bias; }
+
+      /**
+       * @brief The activation function of the outputs
+       */
+      boost::shared_ptr<bob::learn::activation::Activation> getActivation() const
+      { return m_activation; }
+
+    private:
+
+      /**
+       * @brief Quantizes the normalized input into the given contiguous
+       * memory, and returns its scale
+       */
+      double quantizeInput(const blitz::Array<double,1>& input, int8_t* q) const;
+
+      /**
+       * @brief Computes the outputs from the quantized input with the given
+       * scale
+       */
+      void project(const int8_t* q, double scale,
+          blitz::Array<double,1>& output) const;
+
+      blitz::Array<double,1> m_input_sub; ///< input subtraction
+      blitz::Array<double,1> m_input_div; ///< input division
+      blitz::Array<int8_t,2> m_weight; ///< quantized weights, one row per output
+      blitz::Array<double,1> m_scale; ///< scale of the weights of each output
+      blitz::Array<double,1> m_bias; ///< biases of the outputs
+      boost::shared_ptr<bob::learn::activation::Activation> m_activation; ///< activation function
+
+      mutable blitz::Array<int8_t,1> m_buffer; ///< the quantized input
+
+  };
+
+}}}
+
+#endif /* BOB_LEARN_LINEAR_QUANTIZED_H */
@@ -0,0 +1,242 @@
+/**
+ * @date Sun Oct 18 10:12:41 CEST 2026
+ *
+ * @brief A streaming and mergeable accumulator of the mean and the scatter
+ * matrix of a set of samples
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LINEAR_SCATTER_H
+#define BOB_LEARN_LINEAR_SCATTER_H
+
+#include <vector>
+#include <blitz/array.h>
+#include <bob.io.base/HDF5File.h>
+
+namespace bob { namespace learn { namespace linear {
+
+  /**
+   * @brief Accumulates the number of samples, the mean and the scatter matrix
+   * sum((x - mean) * (x - mean)^T) of a set of samples.
+   *
+   * Samples can be added in blocks of arbitrary size, and the accumulated
+   * statistics of several accumulators (e.g., computed on different parts of
+   * the data, possibly in different processes) can be merged. The statistics
+   * of each block are combined with the pairwise update of Chan et al., so
+   * that the mean and the scatter stay numerically stable, independently of
+   * the number of blocks.
+   *
+   * Samples may carry frequency weights, i.e., a sample with weight 2
+   * contributes as if it was added twice. The covariance matrix is hence
+   * normalized by the sum of the weights minus one.
+   *
+   * The accumulators can be passed to the trainers in place of the data
+   * itself, so that a single pass over the data can feed several trainers.
+   */
+  class ScatterAccumulator {
+
+    public:
+
+      /**
+       * @brief Creates an empty accumulator for samples of the given
+       * dimensionality. If the dimensionality is 0, it is set by the first
+       * call to update().
+       */
+      ScatterAccumulator(size_t n_features=0);
+
+      /**
+       * @brief Copy constructor
+       */
+      ScatterAccumulator(const ScatterAccumulator& other);
+
+      /**
+       * @brief Loads the accumulated statistics from the given HDF5 file
+       */
+      ScatterAccumulator(bob::io::base::HDF5File& config);
+
+      /**
+       * @brief Destructor
+       */
+      virtual ~ScatterAccumulator();
+
+      /**
+       * @brief Assignment operator
+       */
+      ScatterAccumulator& operator=(const ScatterAccumulator& other);
+
+      /**
+       * @brief Equal to
+       */
+      bool operator==(const ScatterAccumulator& other) const;
+
+      /**
+       * @brief Not equal to
+       */
+      bool operator!=(const ScatterAccumulator& other) const;
+
+      /**
+       * @brief Similar to, using the relative and absolute precisions
+       */
+      bool is_similar_to(const ScatterAccumulator& other,
+        const double r_epsilon=1e-5, const double a_epsilon=1e-8) const;
+
+      /**
+       * @brief Adds the given block of samples (one sample per row).
+       *
+       * The samples are read element by element, without creating views of
+       * the block, so that several threads may accumulate blocks that share
+       * their memory (e.g., row ranges of one matrix) concurrently.
+       */
+      void update(const blitz::Array<double,2>& block);
+
+      /**
+       * @brief Adds the given block of samples (one sample per row), each
+       * weighted with the non-negative frequency weight of the same row
+       */
+      void update(const blitz::Array<double,2>& block,
+        const blitz::Array<double,1>& weights);
+
+      /**
+       * @brief Adds a single sample
+       */
+      void update(const blitz::Array<double,1>& sample);
+
+      /**
+       * @brief Adds the statistics of the other accumulator, as if all its
+       * samples were added to this accumulator
+       */
+      void merge(const ScatterAccumulator& other);
+
+      /**
+       * @brief Removes the statistics of the other accumulator, whose samples
+       * need to be part of this accumulator, as if they were never added.
+       *
+       * This inverts merge(), e.g., to obtain the statistics of all but one
+       * part of the data from the statistics of the whole data. The
+       * subtraction is less stable than the merge when the removed samples
+       * dominate the accumulator.
+       */
+      void subtract(const ScatterAccumulator& other);
+
+      /**
+       * @brief Removes all samples, keeping the dimensionality
+       */
+      void reset();
+
+      /**
+       * @brief Scales the statistics as if each sample x had been added as
+       * x / division (elementwise), e.g., to normalize the features by their
+       * standard deviation
+       */
+      void scale(const blitz::Array<double,1>& division);
+
+      /**
+       * @brief Loads the accumulated statistics from the given HDF5 file.
+       *
+       * The layout consists of the scalars "n_samples" and "sum_of_weights"
+       * and the datasets "mean" and "scatter". Files without
+       * "sum_of_weights" hold unweighted statistics.
+       */
+      void load(bob::io::base::HDF5File& config);
+
+      /**
+       * @brief Saves the accumulated statistics to the given HDF5 file
+       */
+      void save(bob::io::base::HDF5File& config) const;
+
+      /**
+       * @brief The dimensionality of the samples
+       */
+      size_t numberOfFeatures() const { return m_mean.extent(0); }
+
+      /**
+       * @brief The number of accumulated samples
+       */
+      size_t numberOfSamples() const { return m_n; }
+
+      /**
+       * @brief The sum of the weights of the accumulated samples; identical to
+       * the number of samples if no weights were used
+       */
+      double sumOfWeights() const { return m_weight; }
+
+      /**
+       * @brief The mean of the accumulated samples
+       */
+      const blitz::Array<double,1>& getMean() const { return m_mean; }
+
+      /**
+       * @brief The scatter matrix sum((x - mean) * (x - mean)^T) of the
+       * accumulated samples
+       */
+      const blitz::Array<double,2>& getScatter() const { return m_scatter; }
+
+      /**
+       * @brief Computes the unbiased covariance matrix
+       * scatter / (sumOfWeights() - 1); requires the sum of weights to be
+       * above 1
+       */
+      void covariance(blitz::Array<double,2>& covariance) const;
+
+    private:
+
+      /**
+       * @brief Adds statistics of n samples with the given sum of weights,
+       * mean and scatter
+       */
+      void add(size_t n, double weight, const blitz::Array<double,1>& mean,
+        const blitz::Array<double,2>& scatter);
+
+      size_t m_n; ///< number of accumulated samples
+      double m_weight; ///< sum of the weights of the accumulated samples
+      blitz::Array<double,1> m_mean; ///< mean of the accumulated samples
+      blitz::Array<double,2> m_scatter; ///< scatter of the accumulated samples
+
+  };
+
+  /**
+   * @brief Computes the weighted mean sum(w * x) / sum(w) of the given
+   * samples (one per row), and returns the sum of the weights.
+   *
+   * The weights must be non-negative, and their sum must be positive. The
+   * mean must be allocated with the dimensionality of the samples.
+   */
+  double weighted_mean(const blitz::Array<double,2>& data,
+    const blitz::Array<double,1>& weights, blitz::Array<double,1>& mean);
+
+  /**
+   * @brief Computes the weighted mean sum(w * x) / sum(w) and the weighted
+   * scatter matrix sum(w * (x - mean) * (x - mean)^T) of the given samples
+   * (one per row), and returns the sum of the weights.
+   *
+   * The weights must be non-negative, and their sum must be positive. The
+   * output arrays must be allocated with the dimensionality of the samples.
+   */
+  double weighted_scatter(const blitz::Array<double,2>& data,
+    const blitz::Array<double,1>& weights, blitz::Array<double,2>& scatter,
+    blitz::Array<double,1>& mean);
+
+  /**
+   * @brief Accumulates the statistics of the data of several classes (one
+   * sample per row), where each sample is weighted with the frequency weight
+   * at the same position of the weights of its class. Returns one accumulator
+   * per class.
+   */
+  std::vector<ScatterAccumulator> class_statistics(
+    const std::vector<blitz::Array<double,2> >& data,
+    const std::vector<blitz::Array<double,1> >& weights);
+
+  /**
+   * @brief Computes the within-class scatter Sw, the between-class scatter Sb
+   * and the overall mean from the accumulators of several classes, as
+   * bob::math::scatters() does for the data of the classes. Classes and
+   * their means are weighted by the sum of their sample weights.
+   */
+  void scatters(const std::vector<ScatterAccumulator>& classes,
+    blitz::Array<double,2>& Sw, blitz::Array<double,2>& Sb,
+    blitz::Array<double,1>& mean);
+
+}}}
+
+#endif /* BOB_LEARN_LINEAR_SCATTER_H */
@@ -0,0 +1,79 @@
+/**
+ * @date Sun Oct 18 16:02:13 CEST 2026
+ *
+ * @brief A sparse matrix in the compressed sparse row (CSR) format
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#ifndef BOB_LEARN_LINEAR_SPARSE_H
+#define BOB_LEARN_LINEAR_SPARSE_H
+
+#include <blitz/array.h>
+#include <stdint.h>
+
+namespace bob { namespace learn { namespace linear {
+
+  /**
+   * @brief A matrix in the compressed sparse row (CSR) format, as used by
+   * scipy.sparse.csr_matrix, with one sample per row.
+   *
+   * The non-zero values of row i are data(indptr(i)) to
+   * data(indptr(i+1)-1), and indices holds their columns. The arrays are
+   * referenced and not copied, so the data needs to stay valid while the
+   * matrix is used.
+   */
+  class CSRMatrix {
+
+    public:
+
+      /**
+       * Refers to the given arrays, which are checked for consistency; the
+       * number of rows is given by the size of indptr minus 1
+       */
+      CSRMatrix(const blitz::Array<double,1>& data,
+          const blitz::Array<int64_t,1>& indices,
+          const blitz::Array<int64_t,1>& indptr,
+          const size_t n_columns);
+
+      /**
+       * The number of rows, i.e., of samples
+       */
+      size_t rows() const { return m_indptr.extent(0) - 1; }
+
+      /**
+       * The number of columns, i.e., of features
+       */
+      size_t columns() const { return m_n_columns; }
+
+      /**
+       * The number of stored values
+       */
+      size_t nonZeros() const { return m_indptr(m_indptr.extent(0)-1); }
+
+      /**
+       * The stored values
+       */
+      const blitz::Array<double,1>& data() const { return m_data; }
+
+      /**
+       * The columns of the stored values
+       */
+      const blitz::Array<int64_t,1>& indices() const { return m_indices; }
+
+      /**
+       * The offsets of the rows in data() and indices()
+       */
+      const blitz::Array<int64_t,1>& indptr() const { return m_indptr; }
+
+    private:
+
+      blitz::Array<double,1> m_data; ///< the non-zero values
+      blitz::Array<int64_t,1> m_indices; ///< the columns of the values
+      blitz::Array<int64_t,1> m_indptr; ///< the row offsets
+      size_t m_n_columns; ///< the number of columns
+  };
+
+}}}
+
+#endif /* BOB_LEARN_LINEAR_SPARSE_H */
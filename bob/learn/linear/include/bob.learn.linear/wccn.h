@@ -10,6 +10,9 @@
 #define BOB_LEARN_LINEAR_WCCN_H
 
 #include <bob.learn.linear/machine.h>
+#include <bob.learn.linear/scatter.h>
+#include <bob.learn.linear/profile.h>
+#include <boost/shared_ptr.hpp>
 
 namespace bob { namespace learn { namespace linear {
 
@@ -35,8 +38,12 @@ namespace bob { namespace learn { namespace linear {
 
       /**
        * @brief Initializes a new WCCN trainer.
+       *
+       * @param eigenvalue_floor  If positive, the eigenvalues of the
+       *   within-class covariance matrix are floored to this value, see
+       *   whitening_transform()
        */
-      WCCNTrainer();
+      WCCNTrainer(double eigenvalue_floor=0.);
 
       /**
        * @brief Copy constructor
@@ -67,6 +74,48 @@ namespace bob { namespace learn { namespace linear {
        */
       virtual void train(Machine& machine, const std::vector<blitz::Array<double, 2>>& data) const;
 
+      /**
+       * @brief Trains the LinearMachine to perform the WCCN on weighted
+       * samples; each class comes with the frequency weights of its rows
+       */
+      virtual void train(Machine& machine, const std::vector<blitz::Array<double, 2>>& data,
+        const std::vector<blitz::Array<double, 1>>& weights) const;
+
+      /**
+       * @brief Trains the LinearMachine to perform the WCCN from the
+       * accumulated statistics of the classes, one accumulator per class
+       */
+      virtual void train(Machine& machine, const std::vector<ScatterAccumulator>& statistics) const;
+
+      /**
+       * @brief The eigenvalue floor; 0 if the Cholesky factorization is used
+       */
+      double getEigenvalueFloor() const { return m_eigenvalue_floor; }
+
+      /**
+       * @brief Sets the eigenvalue floor
+       */
+      void setEigenvalueFloor(double value) { m_eigenvalue_floor = value; }
+
+      /**
+       * @brief Gets the statistics filled by each training, or an empty
+       * pointer if no statistics are collected
+       */
+      boost::shared_ptr<TrainingStats> getStats() const { return m_stats; }
+
+      /**
+       * @brief Sets the statistics that each training fills with the wall
+       * time and the estimated array sizes of its phases (see TrainingStats);
+       * an empty pointer disables the collection. While statistics are set,
+       * the trainer must not be used by several threads at once.
+       */
+      void setStats(const boost::shared_ptr<TrainingStats>& stats) { m_stats = stats; }
+
+    private:
+
+      double m_eigenvalue_floor;
+      boost::shared_ptr<TrainingStats> m_stats; ///< the statistics of the trainings, if any
+
   };
 
 }}}
@@ -9,9 +9,35 @@
 #define BOB_LEARN_LINEAR_WHITENING_H
 
 #include <bob.learn.linear/machine.h>
+#include <bob.learn.linear/scatter.h>
+#include <bob.learn.linear/profile.h>
+#include <boost/shared_ptr.hpp>
 
 namespace bob { namespace learn { namespace linear {
 
+  /**
+   * @brief Computes the whitening matrix W of the given covariance matrix C,
+   * such that W^T C W = I.
+   *
+   * W = cholesky(inv(C)) (lower triangular) is obtained from a single
+   * Cholesky factorization of C and a (LAPACK) triangular inverse, without
+   * inverting C explicitly. Only if an eigenvalue of C falls below a positive
+   * eigenvalue floor (i.e., if C - floor I is not positive definite),
+   * W = U diag(1/sqrt(max(e, floor))) is computed from the eigendecomposition
+   * C = U diag(e) U^T instead, which also handles singular covariance
+   * matrices.
+   *
+   * @param covariance  The symmetric D x D covariance matrix C
+   * @param W  The D x D whitening matrix (output)
+   * @param eigenvalue_floor  The lower bound for the eigenvalues of C; 0 to
+   *   always use the Cholesky factorization
+   * @param stats  If given, the size of the temporary arrays is added to the
+   *   current phase of these statistics
+   */
+  void whitening_transform(const blitz::Array<double,2>& covariance,
+    blitz::Array<double,2>& W, double eigenvalue_floor=0.,
+    TrainingStats* stats=0);
+
   /**
    * @brief Sets a linear machine to perform a Whitening transform\n
    *
@@ -23,15 +49,40 @@ namespace bob { namespace learn { namespace linear {
    * Given a training set X, this will compute the W matrix such that:\n
    *   \f$W = cholesky(inv(cov(X_{n},X_{n}^{T})))\f$, where \f$X_{n}\f$
    *   corresponds to the center data
+   *
+   * Alternatively, the whitening is computed from the eigendecomposition
+   * \f$cov = U diag(e) U^T\f$, either as PCA whitening
+   * \f$W = U_k diag(1/\sqrt{e_k})\f$, which keeps only the k leading
+   * eigenvectors and hence reduces the dimensionality, or as ZCA whitening
+   * \f$W = U diag(1/\sqrt{e}) U^T\f$, which keeps the whitened data as close
+   * as possible to the input data.
    */
   class WhiteningTrainer {
 
     public: //api
 
+      /**
+       * @brief The available whitening transforms
+       */
+      typedef enum {
+        CHOLESKY = 0, ///< W = cholesky(inv(cov)), see whitening_transform()
+        PCA, ///< W = U_k diag(1/sqrt(e_k)), for the k leading eigenvectors
+        ZCA ///< W = U diag(1/sqrt(e)) U^T
+      } Mode;
+
       /**
        * @brief Initializes a new Whitening trainer.
+       *
+       * @param eigenvalue_floor  If positive, the eigenvalues of the
+       *   covariance matrix are floored to this value; in CHOLESKY mode, the
+       *   whitening is then computed from the eigendecomposition, see
+       *   whitening_transform()
+       * @param mode  The whitening transform to compute
+       * @param n_components  The number of output dimensions in PCA mode; 0
+       *   keeps all dimensions. Ignored in the other modes.
        */
-      WhiteningTrainer();
+      WhiteningTrainer(double eigenvalue_floor=0., Mode mode=CHOLESKY,
+        size_t n_components=0);
 
       /**
        * @brief Copy constructor
@@ -58,9 +109,95 @@ namespace bob { namespace learn { namespace linear {
       bool operator!=(const WhiteningTrainer& other) const;
 
       /**
-       * @brief Trains the LinearMachine to perform the Whitening
+       * @brief Trains the LinearMachine to perform the Whitening.
+       *
+       * The machine needs to have outputSize(D) outputs, where D is the
+       * dimensionality of the data.
        */
       virtual void train(Machine& machine, const blitz::Array<double,2>& data) const;
+
+      /**
+       * @brief Trains the LinearMachine to perform the Whitening on weighted
+       * samples, where each row of the data has the frequency weight at the
+       * same position
+       */
+      virtual void train(Machine& machine, const blitz::Array<double,2>& data,
+        const blitz::Array<double,1>& weights) const;
+
+      /**
+       * @brief Trains the LinearMachine to perform the Whitening from the
+       * accumulated statistics of the data
+       */
+      virtual void train(Machine& machine, const ScatterAccumulator& statistics) const;
+
+      /**
+       * @brief The number of outputs of the trained machine for data with the
+       * given number of features
+       */
+      size_t outputSize(size_t n_features) const;
+
+      /**
+       * @brief The eigenvalue floor; 0 if the Cholesky factorization is used
+       */
+      double getEigenvalueFloor() const { return m_eigenvalue_floor; }
+
+      /**
+       * @brief Sets the eigenvalue floor
+       */
+      void setEigenvalueFloor(double value) { m_eigenvalue_floor = value; }
+
+      /**
+       * @brief The whitening transform that is computed
+       */
+      Mode getMode() const { return m_mode; }
+
+      /**
+       * @brief Sets the whitening transform that is computed
+       */
+      void setMode(Mode value) { m_mode = value; }
+
+      /**
+       * @brief The number of output dimensions in PCA mode; 0 for all
+       */
+      size_t getNComponents() const { return m_n_components; }
+
+      /**
+       * @brief Sets the number of output dimensions in PCA mode
+       */
+      void setNComponents(size_t value) { m_n_components = value; }
+
+      /**
+       * @brief Gets the statistics filled by each training, or an empty
+       * pointer if no statistics are collected
+       */
+      boost::shared_ptr<TrainingStats> getStats() const { return m_stats; }
+
+      /**
+       * @brief Sets the statistics that each training fills with the wall
+       * time and the estimated array sizes of its phases (see TrainingStats);
+       * an empty pointer disables the collection. While statistics are set,
+       * the trainer must not be used by several threads at once.
+       */
+      void setStats(const boost::shared_ptr<TrainingStats>& stats) { m_stats = stats; }
+
+    private:
+
+      /**
+       * @brief Checks the machine dimensions for the given number of features
+       */
+      void check_machine(const Machine& machine, size_t n_features) const;
+
+      /**
+       * @brief Sets the whitening of the given mean and covariance matrix in
+       * the machine
+       */
+      void whiten(Machine& machine, const blitz::Array<double,1>& mean,
+        const blitz::Array<double,2>& cov, TrainingStats::Scope& scope) const;
+
+      double m_eigenvalue_floor;
+      Mode m_mode;
+      size_t m_n_components;
+      boost::shared_ptr<TrainingStats> m_stats; ///< the statistics of the trainings, if any
   };
 
 }}}
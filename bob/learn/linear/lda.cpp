@@ -11,9 +11,12 @@
 #include <bob.blitz/cppapi.h>
 #include <bob.blitz/cleanup.h>
 #include <bob.learn.linear/api.h>
+#include <boost/make_shared.hpp>
 #include <structmember.h>
 #include <bob.extension/documentation.h>
 
+extern PyObject* PyBobLearnLinear_TrainingStats(const boost::shared_ptr<bob::learn::linear::TrainingStats>& stats);
+
 /*************************************************
  * Implementation of FisherLDATrainer base class *
  *************************************************/
@@ -185,15 +188,19 @@ static auto train = bob::extension::FunctionDoc(
   "If provided, machine should have the correct number of inputs and outputs matching, respectively, the number of columns in the input data arrays ``X`` and the output of the method :py:meth:`output_size`.\n\n"
   "The value of ``X`` should be a sequence over as many 2D 64-bit floating point number arrays as classes in the problem. "
   "All arrays will be checked for conformance (identical number of columns). "
-  "To accomplish this, either prepare a list with all your class observations organized in 2D arrays or pass a 3D array in which the first dimension (depth) contains as many elements as classes you want to discriminate.\n\n"
+  "To accomplish this, either prepare a list with all your class observations organized in 2D arrays or pass a 3D array in which the first dimension (depth) contains as many elements as classes you want to discriminate. "
+  "Instead of the data, a list with one :py:class:`bob.learn.linear.ScatterAccumulator` per class can be given.\n\n"
+  "Optionally, the samples can be weighted with non-negative frequency ``weights``, given as a sequence with one 1D array per class holding the weights of the rows of the class data. "
+  "This allows, e.g., to balance the classes without copying the data.\n\n"
   ".. note::\n\n"
   "   We set at most :py:meth:`output_size` eigen-values and vectors on the passed machine.\n"
   "   You can compress the machine output further using :py:meth:`Machine.resize` if necessary.",
   true
 )
-.add_prototype("X, [machine]", "machine, eigen_values")
-.add_parameter("X", "[array_like(2D, floats)] or array_like(3D, floats)", "The input data, separated to contain the training data per class in the first dimension")
+.add_prototype("X, [machine], [weights]", "machine, eigen_values")
+.add_parameter("X", "[array_like(2D, floats)] or array_like(3D, floats) or [:py:class:`bob.learn.linear.ScatterAccumulator`]", "The input data, separated to contain the training data per class in the first dimension, or the statistics accumulated per class")
 .add_parameter("machine", ":py:class:`bob.learn.linear.Machine`", "The machine to be trained; this machine will be returned by this function")
+.add_parameter("weights", "[array_like(1D, floats)]", "[optional] The frequency weights of the samples, one array per class")
 .add_return("machine", ":py:class:`bob.learn.linear.Machine`", "The machine that has been trained; if given, identical to the ``machine`` parameter")
 .add_return("eigen_values", "array_like(1D, floats)", "The eigen-values of the LDA projection.")
 ;
@@ -207,9 +214,10 @@ BOB_TRY
 
   PyObject* X = 0;
   PyObject* machine = 0;
+  PyObject* weights = 0;
 
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O!", kwlist,
-        &X, &PyBobLearnLinearMachine_Type, &machine)) return 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O!O", kwlist,
+        &X, &PyBobLearnLinearMachine_Type, &machine, &weights)) return 0;
 
   /**
   // Note: strangely, if you pass dict.values(), this check does not work
@@ -222,6 +230,7 @@ BOB_TRY
   /* Checks and converts all entries */
   std::vector<blitz::Array<double,2> > Xseq;
   std::vector<boost::shared_ptr<PyBlitzArrayObject>> Xseq_;
+  std::vector<bob::learn::linear::ScatterAccumulator> stats;
 
   PyObject* iterator = PyObject_GetIter(X);
   if (!iterator) return 0;
@@ -230,6 +239,19 @@ BOB_TRY
   while (PyObject* item = PyIter_Next(iterator)) {
     auto item_ = make_safe(item);
 
+    if (PyBobLearnLinearScatterAccumulator_Check(item)) {
+      if (!Xseq.empty()) {
+        PyErr_Format(PyExc_TypeError, "`%s' cannot mix arrays and accumulated statistics in input sequence `X', but at position %" PY_FORMAT_SIZE_T "d I have found a `%s'", Py_TYPE(self)->tp_name, Xseq.size(), Py_TYPE(item)->tp_name);
+        return 0;
+      }
+      stats.push_back(*reinterpret_cast<PyBobLearnLinearScatterAccumulatorObject*>(item)->cxx);
+      continue;
+    }
+    if (!stats.empty()) {
+      PyErr_Format(PyExc_TypeError, "`%s' cannot mix arrays and accumulated statistics in input sequence `X', but at position %" PY_FORMAT_SIZE_T "d I have found a `%s'", Py_TYPE(self)->tp_name, stats.size(), Py_TYPE(item)->tp_name);
+      return 0;
+    }
+
     PyBlitzArrayObject* bz = 0;
 
     if (!PyBlitzArray_Converter(item, &bz)) {
@@ -249,27 +271,61 @@ BOB_TRY
 
   if (PyErr_Occurred()) return 0;
 
-  if (Xseq.size() < 2) {
-    PyErr_Format(PyExc_RuntimeError, "`%s' requires an iterable for parameter `X' leading to, at least, two entries (representing two classes), but you have passed something that has only %" PY_FORMAT_SIZE_T "d entries", Py_TYPE(self)->tp_name, Xseq.size());
+  const size_t n_classes = stats.empty() ? Xseq.size() : stats.size();
+  if (n_classes < 2) {
+    PyErr_Format(PyExc_RuntimeError, "`%s' requires an iterable for parameter `X' leading to, at least, two entries (representing two classes), but you have passed something that has only %" PY_FORMAT_SIZE_T "d entries", Py_TYPE(self)->tp_name, n_classes);
     return 0;
   }
 
+  /* Checks and converts the weights of all classes */
+  std::vector<blitz::Array<double,1> > Wseq;
+  std::vector<boost::shared_ptr<PyBlitzArrayObject>> Wseq_;
+  if (weights) {
+    if (!stats.empty()) {
+      PyErr_Format(PyExc_TypeError, "`%s' cannot apply `weights' to accumulated statistics; weight the samples when accumulating them instead", Py_TYPE(self)->tp_name);
+      return 0;
+    }
+
+    PyObject* witerator = PyObject_GetIter(weights);
+    if (!witerator) return 0;
+    auto witerator_ = make_safe(witerator);
+
+    while (PyObject* item = PyIter_Next(witerator)) {
+      auto item_ = make_safe(item);
+
+      PyBlitzArrayObject* bz = 0;
+      if (!PyBlitzArray_Converter(item, &bz)) return 0;
+      Wseq_.push_back(make_safe(bz)); ///< prevents data deletion
+
+      if (bz->ndim != 1 || bz->type_num != NPY_FLOAT64) {
+        PyErr_Format(PyExc_TypeError, "`%s' only supports 1D 64-bit float arrays for input sequence `weights', but at position %" PY_FORMAT_SIZE_T "d I have found an object with %" PY_FORMAT_SIZE_T "d dimensions and with type `%s' which is not compatible - check your input", Py_TYPE(self)->tp_name, Wseq.size(), bz->ndim, PyBlitzArray_TypenumAsString(bz->type_num));
+        return 0;
+      }
+      Wseq.push_back(*PyBlitzArrayCxx_AsBlitz<double,1>(bz)); ///< only a view!
+    }
+
+    if (PyErr_Occurred()) return 0;
+  }
+
   // evaluates the expected rank for the output, allocate eigens value array
-  Py_ssize_t rank = self->cxx->output_size(Xseq);
+  Py_ssize_t rank = stats.empty() ? self->cxx->output_size(Xseq) : self->cxx->output_size(stats);
   auto eigval = reinterpret_cast<PyBlitzArrayObject*>(PyBlitzArray_SimpleNew(NPY_FLOAT64, 1, &rank));
   auto eigval_ = make_safe(eigval); ///< auto-delete in case of problems
 
   // allocates a new machine if that was not given by the user
   boost::shared_ptr<PyObject> machine_;
   if (!machine) {
-    machine = PyBobLearnLinearMachine_NewFromSize(Xseq[0].extent(1), rank);
+    Py_ssize_t n_features = stats.empty() ? Xseq[0].extent(1) : stats[0].numberOfFeatures();
+    machine = PyBobLearnLinearMachine_NewFromSize(n_features, rank);
     machine_ = make_safe(machine); ///< auto-delete in case of problems
   }
 
   auto pymac = reinterpret_cast<PyBobLearnLinearMachineObject*>(machine);
 
   auto eigval_bz = PyBlitzArrayCxx_AsBlitz<double,1>(eigval);
-  self->cxx->train(*pymac->cxx, *eigval_bz, Xseq);
+  if (!stats.empty()) self->cxx->train(*pymac->cxx, *eigval_bz, stats);
+  else if (weights) self->cxx->train(*pymac->cxx, *eigval_bz, Xseq, Wseq);
+  else self->cxx->train(*pymac->cxx, *eigval_bz, Xseq);
 
   // all went fine, pack machine and eigen-values to return
   return Py_BuildValue("ON", machine, PyBlitzArray_AsNumpyArray(eigval, 0));
@@ -287,7 +343,7 @@ static auto output_size = bob::extension::FunctionDoc(
   true
 )
 .add_prototype("X","size")
-.add_parameter("X", "[array_like(2D, floats)] or array_like(3D, floats)", "The input data, separated to contain the training data per class in the first dimension")
+.add_parameter("X", "[array_like(2D, floats)] or array_like(3D, floats) or [:py:class:`bob.learn.linear.ScatterAccumulator`]", "The input data, separated to contain the training data per class in the first dimension, or the statistics accumulated per class")
 .add_return("size", "int", "The number of eigen-vectors/values that will be created in a call to :py:meth:`train`, given the same input data ``X``")
 ;
 static PyObject* PyBobLearnLinearFisherLDATrainer_OutputSize
@@ -310,6 +366,7 @@ BOB_TRY
   /* Checks and converts all entries */
   std::vector<blitz::Array<double,2> > Xseq;
   std::vector<boost::shared_ptr<PyBlitzArrayObject>> Xseq_;
+  std::vector<bob::learn::linear::ScatterAccumulator> stats;
   Py_ssize_t size = PySequence_Fast_GET_SIZE(X);
 
   if (size < 2) {
@@ -325,6 +382,11 @@ BOB_TRY
     PyBlitzArrayObject* bz = 0;
     PyObject* borrowed = PySequence_Fast_GET_ITEM(X, k);
 
+    if (PyBobLearnLinearScatterAccumulator_Check(borrowed)) {
+      stats.push_back(*reinterpret_cast<PyBobLearnLinearScatterAccumulatorObject*>(borrowed)->cxx);
+      continue;
+    }
+
     if (!PyBlitzArray_Converter(borrowed, &bz)) {
       PyErr_Format(PyExc_TypeError, "`%s' could not convert object of type `%s' at position %" PY_FORMAT_SIZE_T "d of input sequence `X' into an array - check your input", Py_TYPE(self)->tp_name, Py_TYPE(borrowed)->tp_name, k);
       return 0;
@@ -341,6 +403,14 @@ BOB_TRY
 
   }
 
+  if (!stats.empty()) {
+    if (!Xseq.empty()) {
+      PyErr_Format(PyExc_TypeError, "`%s' cannot mix arrays and accumulated statistics in input sequence `X'", Py_TYPE(self)->tp_name);
+      return 0;
+    }
+    return Py_BuildValue("n", self->cxx->output_size(stats));
+  }
+
   return Py_BuildValue("n", self->cxx->output_size(Xseq));
 BOB_CATCH_MEMBER("output_size", 0)
 }
@@ -417,6 +487,49 @@ BOB_TRY
 BOB_CATCH_MEMBER("strip_to_rank", -1)
 }
 
+static auto collect_stats = bob::extension::VariableDoc(
+  "collect_stats",
+  "bool",
+  "Collect timing statistics of the trainings?",
+  "If enabled, each call to :py:meth:`train` records the wall time and the estimated size of the arrays of its phases in :py:attr:`stats`. "
+  "The statistics are shared by all calls, so that the trainer must not be used by several threads at once while they are collected. "
+  "By default, no statistics are collected."
+);
+static PyObject* PyBobLearnLinearFisherLDATrainer_getCollectStats
+(PyBobLearnLinearFisherLDATrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  if (self->cxx->getStats()) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+BOB_CATCH_MEMBER("collect_stats", 0)
+}
+
+static int PyBobLearnLinearFisherLDATrainer_setCollectStats
+(PyBobLearnLinearFisherLDATrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  int istrue = PyObject_IsTrue(o);
+
+  if (istrue == -1) return -1;
+  if (!istrue) self->cxx->setStats(boost::shared_ptr<bob::learn::linear::TrainingStats>());
+  else if (!self->cxx->getStats()) self->cxx->setStats(boost::make_shared<bob::learn::linear::TrainingStats>());
+  return 0;
+BOB_CATCH_MEMBER("collect_stats", -1)
+}
+
+static auto stats = bob::extension::VariableDoc(
+  "stats",
+  "[dict] or None",
+  "The timing statistics of the last training",
+  "A list with one dictionary per phase of the last call to :py:meth:`train`, in the order of execution, i.e., ``scatter``, ``decomposition``, ``truncation`` (if any) and ``machine update``. "
+  "Each dictionary contains the ``phase`` name, its wall time in ``seconds`` and the size of the arrays that the trainer allocated in the phase in ``estimated_bytes``, as computed from their shapes; this is not a measurement of the memory of the process, e.g., memory allocated inside LAPACK is not included. "
+  "``None`` if :py:attr:`collect_stats` is disabled."
+);
+static PyObject* PyBobLearnLinearFisherLDATrainer_getStats
+(PyBobLearnLinearFisherLDATrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return PyBobLearnLinear_TrainingStats(self->cxx->getStats());
+BOB_CATCH_MEMBER("stats", 0)
+}
+
 static PyGetSetDef PyBobLearnLinearFisherLDATrainer_getseters[] = {
     {
       use_pinv.name(),
@@ -432,6 +545,20 @@ static PyGetSetDef PyBobLearnLinearFisherLDATrainer_getseters[] = {
       strip_to_rank.doc(),
       0
     },
+    {
+      collect_stats.name(),
+      (getter)PyBobLearnLinearFisherLDATrainer_getCollectStats,
+      (setter)PyBobLearnLinearFisherLDATrainer_setCollectStats,
+      collect_stats.doc(),
+      0
+    },
+    {
+      stats.name(),
+      (getter)PyBobLearnLinearFisherLDATrainer_getStats,
+      0,
+      stats.doc(),
+      0
+    },
     {0}  /* Sentinel */
 };
 
@@ -2,7 +2,7 @@
  * @author Andre Anjos <andre.anjos@idiap.ch>
  * @date Thu 16 Jan 2014 14:27:40 CET
  *
- * @brief Python bindings to CGLogReg trainer
+ * @brief Python bindings to the logistic regression trainers
  *
  * Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
  */
@@ -13,6 +13,10 @@
 #include <bob.learn.linear/api.h>
 #include <bob.extension/documentation.h>
 #include <structmember.h>
+#include <vector>
+
+extern bool PyBobLearnLinear_IsCSRMatrix(PyObject* o);
+extern boost::shared_ptr<bob::learn::linear::CSRMatrix> PyBobLearnLinear_AsCSRMatrix(PyObject* o, std::vector<boost::shared_ptr<PyObject> >& keep);
 
 /************************************************
  * Implementation of CGLogRegTrainer base class *
@@ -31,17 +35,43 @@ static auto CGLogReg_doc = bob::extension::ClassDoc(
   "There are two initializers for objects of this class. "
   "In the first variant, the user passes the discrete training parameters, including the classes prior, convergence threshold and the maximum number of conjugate gradient (CG) iterations among other parameters. "
   "If ``mean_std_norm`` is set to ``True``, your input data will be mean/standard-deviation normalized and the according values will be set as normalization factors to the resulting machine. "
+  "The optimization algorithm is chosen with the ``solver``: ``'cg'`` uses nonlinear conjugate gradients with a single Newton step as line search, "
+  "``'lbfgs'`` the limited-memory BFGS algorithm with a line search satisfying the Wolfe conditions, and ``'newton-cg'`` a truncated Newton method, which solves for the Newton direction with linear conjugate gradients on Hessian-vector products. "
+  "All of them minimize the same objective function and result in the same machine, but L-BFGS and truncated Newton usually need far fewer passes over badly conditioned data. "
+  "If ``warm_start`` is set to ``True``, the optimization starts from the weights of the machine passed to :py:meth:`train` instead of from zero. "
   "The second initialization form copy constructs a new trainer from an existing one."
 )
-.add_prototype("[prior], [convergence_threshold], [max_iterations], [reg], [mean_std_norm]", "")
+.add_prototype("[prior], [convergence_threshold], [max_iterations], [reg], [mean_std_norm], [solver], [warm_start]", "")
 .add_prototype("other", "")
 .add_parameter("prior", "float", "[Default: ``0.5``] The synthetic prior (should be in range :math:`]0.,1.[`)")
 .add_parameter("convergence_threshold", "float", "[Default: ``1e-5``] The convergence threshold for the conjugate gradient algorithm")
 .add_parameter("max_iterations", "int", "[Default: ``10000``] The maximum number of iterations for the conjugate gradient algorithm")
 .add_parameter("reg", "float", "[Default: ``0.``] The regularization factor lambda. If you set this to the value of ``0.``, then the algorithm will apply **no** regularization whatsoever")\
 .add_parameter("mean_std_norm", "bool", "[Default: ``False``] Performs mean and standard-deviation normalization (whitening) of the input data before training the (resulting) :py:class:`bob.learn.linear.Machine`. Setting this to ``True`` is recommended for large data sets with significant amplitude variations between dimensions")
+.add_parameter("solver", "str", "[Default: ``'cg'``] The optimization algorithm; one of ``'cg'``, ``'lbfgs'`` or ``'newton-cg'``")
+.add_parameter("warm_start", "bool", "[Default: ``False``] Starts the optimization from the weights of the machine passed to :py:meth:`train`")
 .add_parameter("other", ":py:class:`CGLogRegTrainer`", "If you decide to copy construct from another object of the same type, pass it using this parameter")
 );
+
+static const char* solver_name(bob::learn::linear::CGLogRegTrainer::Solver solver) {
+  switch (solver) {
+    case bob::learn::linear::CGLogRegTrainer::LBFGS: return "lbfgs";
+    case bob::learn::linear::CGLogRegTrainer::NEWTON_CG: return "newton-cg";
+    default: return "cg";
+  }
+}
+
+static bool solver_from_name(const char* name, bob::learn::linear::CGLogRegTrainer::Solver& solver) {
+  std::string n(name);
+  if (n == "cg") solver = bob::learn::linear::CGLogRegTrainer::CG;
+  else if (n == "lbfgs") solver = bob::learn::linear::CGLogRegTrainer::LBFGS;
+  else if (n == "newton-cg") solver = bob::learn::linear::CGLogRegTrainer::NEWTON_CG;
+  else {
+    PyErr_Format(PyExc_ValueError, "logistic regression solver `%s' is not known; use one of 'cg', 'lbfgs' or 'newton-cg'", name);
+    return false;
+  }
+  return true;
+}
 static int PyBobLearnLinearCGLogRegTrainer_init_parameters
 (PyBobLearnLinearCGLogRegTrainerObject* self, PyObject* args, PyObject* kwds) {
 BOB_TRY
@@ -53,15 +83,23 @@ BOB_TRY
   Py_ssize_t max_iterations = 10000;
   double lambda = 0.;
   PyObject* mean_std_norm = Py_False;
+  const char* name = "cg";
+  PyObject* warm_start = Py_False;
 
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "|ddndO", kwlist,
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "|ddndOsO", kwlist,
         &prior, &convergence_threshold, &max_iterations,
-        &lambda, &mean_std_norm)) return -1;
+        &lambda, &mean_std_norm, &name, &warm_start)) return -1;
 
   int mean_std_norm_ = PyObject_IsTrue(mean_std_norm);
   if (mean_std_norm_ == -1) return -1; //error on conversion
 
-  self->cxx = new bob::learn::linear::CGLogRegTrainer(prior, convergence_threshold, max_iterations, lambda, mean_std_norm_);
+  int warm_start_ = PyObject_IsTrue(warm_start);
+  if (warm_start_ == -1) return -1; //error on conversion
+
+  bob::learn::linear::CGLogRegTrainer::Solver solver;
+  if (!solver_from_name(name, solver)) return -1;
+
+  self->cxx = new bob::learn::linear::CGLogRegTrainer(prior, convergence_threshold, max_iterations, lambda, mean_std_norm_, solver, warm_start_);
   return 0;
 BOB_CATCH_MEMBER("constructor", -1)
 }
@@ -139,16 +177,42 @@ static PyObject* PyBobLearnLinearCGLogRegTrainer_RichCompare
   }
 }
 
+/**
+ * Wraps the given Python callable, which is called with a dictionary
+ * describing the state after each iteration; failed is set if it raises
+ */
+static bob::learn::linear::CGLogRegCallback python_callback(PyObject* callback, bool& failed) {
+  return [callback, &failed](const bob::learn::linear::CGLogRegIteration& state) -> bool {
+    PyObject* result = PyObject_CallFunction(callback, const_cast<char*>("({s:n,s:d,s:d,s:d,s:d,s:d})"),
+        "iteration", (Py_ssize_t)state.iteration, "objective", state.objective,
+        "gradient_norm", state.gradient_norm, "weight_change", state.weight_change,
+        "step_size", state.step_size, "seconds", state.seconds);
+    if (!result) return failed = true;
+    auto result_ = make_safe(result);
+    int stop = PyObject_IsTrue(result);
+    if (stop == -1) return failed = true;
+    return stop;
+  };
+}
+
 static auto train = bob::extension::FunctionDoc(
   "train",
   "Trains a linear machine to perform linear logistic regression",
   "The resulting machine will have the same number of inputs as columns in ``negatives`` and ``positives`` and a single output. "
-  "This method always returns a machine, which will be identical to the one provided (if the user passed one) or a new one allocated internally.",
+  "This method always returns a machine, which will be identical to the one provided (if the user passed one) or a new one allocated internally. "
+  "Both ``negatives`` and ``positives`` can also be sparse matrices in the compressed sparse row format, such as :py:class:`scipy.sparse.csr_matrix`, which are never converted into dense arrays: "
+  "the mean and standard deviation normalization of :py:attr:`mean_std_norm` is applied implicitly, and features that are zero in all samples are not scaled.\n\n"
+  "If :py:attr:`warm_start` is enabled and the given machine has the right shape, its weights and bias are the starting point of the optimization.\n\n"
+  "If a ``callback`` is given, it is called after each iteration of the :py:attr:`solver` with a dictionary containing the ``iteration`` number (starting at 0), the ``objective`` (the prior-weighted and regularized negative log-likelihood before the step), the ``gradient_norm``, the ``weight_change`` (the maximum absolute change of the weights, which is compared to the :py:attr:`convergence_threshold`), the ``step_size`` of the line search and the wall time in ``seconds`` since the start of the training. "
+  "If the callback returns ``True``, the training stops and the machine is set to the current weights. "
+  "For example, ``trainer.train(negatives, positives, callback=trace.append)`` records the convergence of the training in the list ``trace``. "
+  "Exceptions raised by the callback stop the training and are passed on.",
   true
 )
-.add_prototype("negatives, positives, [machine]", "machine")
-.add_parameter("negatives, positives", "array_like(2D, float)", "``negatives`` and ``positives`` should be arrays organized in such a way that every row corresponds to a new observation of the phenomena (i.e., a new sample) and every column corresponds to a different feature")
+.add_prototype("negatives, positives, [machine], [callback]", "machine")
+.add_parameter("negatives, positives", "array_like(2D, float) or sparse matrix", "``negatives`` and ``positives`` should be arrays organized in such a way that every row corresponds to a new observation of the phenomena (i.e., a new sample) and every column corresponds to a different feature")
 .add_parameter("machine", ":py:class:`bob.learn.linear.Machine`", "The user may provide or not a machine that will be set by this method. If provided, the machine should have 1 output and the  number of inputs matching the number of columns in the input data arrays")
+.add_parameter("callback", "callable", "[Default: ``None``] A function that is called with a dictionary describing the state of the training after each iteration; returning ``True`` stops the training")
 .add_return("machine", ":py:class:`bob.learn.linear.Machine`", "The trained linear machine; identical to the ``machine`` parameter, if given")
 ;
 static PyObject* PyBobLearnLinearCGLogRegTrainer_Train
@@ -157,14 +221,122 @@ BOB_TRY
   /* Parses input arguments in a single shot */
   char** kwlist = train.kwlist();
 
+  PyObject* negatives_object = 0;
+  PyObject* positives_object = 0;
+  PyBobLearnLinearMachineObject* machine = 0;
+  PyObject* callback = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO|O!O", kwlist,
+        &negatives_object,
+        &positives_object,
+        &PyBobLearnLinearMachine_Type, &machine,
+        &callback
+        ))
+    return 0;
+
+  // sparse matrices are used as they are, everything else as dense arrays
+  const bool sparse = PyBobLearnLinear_IsCSRMatrix(negatives_object);
+  if (sparse != PyBobLearnLinear_IsCSRMatrix(positives_object)) {
+    PyErr_Format(PyExc_TypeError, "`%s' requires input matrices `negatives' and `positives' to be either both sparse or both dense", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  std::vector<boost::shared_ptr<PyObject> > keep;
+  boost::shared_ptr<bob::learn::linear::CSRMatrix> sparse_negatives, sparse_positives;
   PyBlitzArrayObject* negatives = 0;
   PyBlitzArrayObject* positives = 0;
-  PyBobLearnLinearMachineObject* machine = 0;
+  boost::shared_ptr<PyBlitzArrayObject> negatives_, positives_; ///< auto-delete in case of problems
+  Py_ssize_t n_features;
 
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&O&|O!", kwlist,
+  if (sparse) {
+    sparse_negatives = PyBobLearnLinear_AsCSRMatrix(negatives_object, keep);
+    if (!sparse_negatives) return 0;
+    sparse_positives = PyBobLearnLinear_AsCSRMatrix(positives_object, keep);
+    if (!sparse_positives) return 0;
+
+    if (sparse_negatives->columns() != sparse_positives->columns()) {
+      PyErr_Format(PyExc_TypeError, "`%s' requires input matrices `negatives' and `positives' to have the same number of columns (i.e. feature dimensions) but `negatives' has %" PY_FORMAT_SIZE_T "d columns and `positives' has %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, sparse_negatives->columns(), sparse_positives->columns());
+      return 0;
+    }
+    n_features = sparse_negatives->columns();
+  }
+  else {
+    if (!PyBlitzArray_Converter(negatives_object, &negatives)) return 0;
+    negatives_ = make_safe(negatives);
+    if (!PyBlitzArray_Converter(positives_object, &positives)) return 0;
+    positives_ = make_safe(positives);
+
+    if (negatives->ndim != 2 || negatives->type_num != NPY_FLOAT64) {
+      PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for input array `negatives'", Py_TYPE(self)->tp_name);
+      return 0;
+    }
+
+    if (positives->ndim != 2 || positives->type_num != NPY_FLOAT64) {
+      PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for input array `positives'", Py_TYPE(self)->tp_name);
+      return 0;
+    }
+
+    if (negatives->shape[1] != positives->shape[1]) {
+      PyErr_Format(PyExc_TypeError, "`%s' requires input matrices `negatives' and `positives' to have the same number of columns (i.e. feature dimensions) but `negatives' has %" PY_FORMAT_SIZE_T "d columns and `positives' has %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, negatives->shape[1], positives->shape[1]);
+      return 0;
+    }
+    n_features = negatives->shape[1];
+  }
+
+  if (callback == Py_None) callback = 0;
+  if (callback && !PyCallable_Check(callback)) {
+    PyErr_Format(PyExc_TypeError, "`%s' requires the `callback' to be callable, but an object of type `%s' was given", Py_TYPE(self)->tp_name, Py_TYPE(callback)->tp_name);
+    return 0;
+  }
+
+  // allocates a new machine if that was not given by the user
+  boost::shared_ptr<PyBobLearnLinearMachineObject> machine_;
+  if (!machine) {
+    machine = reinterpret_cast<PyBobLearnLinearMachineObject*>(PyBobLearnLinearMachine_NewFromSize(n_features, 1));
+    machine_ = make_safe(machine); ///< auto-delete in case of problems
+  }
+
+  // a Python error in the callback stops the training, and is raised after
+  // the trainer returns
+  bool failed = false;
+  const bob::learn::linear::CGLogRegCallback cxx_callback = callback ? python_callback(callback, failed) : bob::learn::linear::CGLogRegCallback();
+  if (sparse)
+    self->cxx->train(*machine->cxx, *sparse_negatives, *sparse_positives, cxx_callback);
+  else
+    self->cxx->train(*machine->cxx, *PyBlitzArrayCxx_AsBlitz<double,2>(negatives), *PyBlitzArrayCxx_AsBlitz<double,2>(positives), cxx_callback);
+  if (failed) return 0;
+
+  return Py_BuildValue("O", machine);
+BOB_CATCH_MEMBER("train", 0)
+}
+
+static auto train_path = bob::extension::FunctionDoc(
+  "train_path",
+  "Trains one linear machine for each of several regularization factors",
+  "The data is normalized only once, and the optimization for each regularization factor starts from the solution of the previous one, so that the whole regularization path costs only a little more than a single training. "
+  "The factors are processed in the given order; the path is most efficient in decreasing order, starting from the simplest model. "
+  "The :py:attr:`reg` of this trainer is ignored.",
+  true
+)
+.add_prototype("negatives, positives, lambdas", "machines")
+.add_parameter("negatives, positives", "array_like(2D, float)", "``negatives`` and ``positives`` should be arrays organized in such a way that every row corresponds to a new observation of the phenomena (i.e., a new sample) and every column corresponds to a different feature")
+.add_parameter("lambdas", "[float]", "The sequence of regularization factors")
+.add_return("machines", "[:py:class:`bob.learn.linear.Machine`]", "One trained linear machine for each regularization factor")
+;
+static PyObject* PyBobLearnLinearCGLogRegTrainer_TrainPath
+(PyBobLearnLinearCGLogRegTrainerObject* self, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  /* Parses input arguments in a single shot */
+  char** kwlist = train_path.kwlist();
+
+  PyBlitzArrayObject* negatives = 0;
+  PyBlitzArrayObject* positives = 0;
+  PyObject* lambdas = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&O&O", kwlist,
         &PyBlitzArray_Converter, &negatives,
         &PyBlitzArray_Converter, &positives,
-        &PyBobLearnLinearMachine_Type, &machine
+        &lambdas
         ))
     return 0;
 
@@ -186,17 +358,33 @@ BOB_TRY
     return 0;
   }
 
-  // allocates a new machine if that was not given by the user
-  boost::shared_ptr<PyBobLearnLinearMachineObject> machine_;
-  if (!machine) {
-    machine = reinterpret_cast<PyBobLearnLinearMachineObject*>(PyBobLearnLinearMachine_NewFromSize(negatives->shape[1], 1));
-    machine_ = make_safe(machine); ///< auto-delete in case of problems
+  std::vector<double> lambdas_;
+  PyObject* iterator = PyObject_GetIter(lambdas);
+  if (!iterator) return 0;
+  auto iterator_ = make_safe(iterator);
+  while (PyObject* item = PyIter_Next(iterator)) {
+    auto item_ = make_safe(item);
+    const double lambda = PyFloat_AsDouble(item);
+    if (PyErr_Occurred()) return 0;
+    lambdas_.push_back(lambda);
   }
+  if (PyErr_Occurred()) return 0;
 
-  self->cxx->train(*machine->cxx, *PyBlitzArrayCxx_AsBlitz<double,2>(negatives), *PyBlitzArrayCxx_AsBlitz<double,2>(positives));
+  std::vector<bob::learn::linear::Machine> machines;
+  self->cxx->trainPath(machines, *PyBlitzArrayCxx_AsBlitz<double,2>(negatives), *PyBlitzArrayCxx_AsBlitz<double,2>(positives), lambdas_);
 
-  return Py_BuildValue("O", machine);
-BOB_CATCH_MEMBER("train", 0)
+  PyObject* retval = PyList_New(machines.size());
+  if (!retval) return 0;
+  auto retval_ = make_safe(retval);
+  for (size_t l = 0; l < machines.size(); ++l) {
+    PyObject* machine = PyBobLearnLinearMachine_NewFromSize(0, 0);
+    if (!machine) return 0;
+    *reinterpret_cast<PyBobLearnLinearMachineObject*>(machine)->cxx = machines[l];
+    PyList_SET_ITEM(retval, l, machine);
+  }
+
+  return Py_BuildValue("O", retval);
+BOB_CATCH_MEMBER("train_path", 0)
 }
 
 static PyMethodDef PyBobLearnLinearCGLogRegTrainer_methods[] = {
@@ -206,6 +394,12 @@ static PyMethodDef PyBobLearnLinearCGLogRegTrainer_methods[] = {
     METH_VARARGS|METH_KEYWORDS,
     train.doc()
   },
+  {
+    train_path.name(),
+    (PyCFunction)PyBobLearnLinearCGLogRegTrainer_TrainPath,
+    METH_VARARGS|METH_KEYWORDS,
+    train_path.doc()
+  },
   {0} /* Sentinel */
 };
 
@@ -332,6 +526,57 @@ BOB_TRY
 BOB_CATCH_MEMBER("mean_std_norm", -1)
 }
 
+static auto solver = bob::extension::VariableDoc(
+  "solver",
+  "str",
+  "The optimization algorithm; one of ``'cg'``, ``'lbfgs'`` or ``'newton-cg'``"
+);
+static PyObject* PyBobLearnLinearCGLogRegTrainer_getSolver
+(PyBobLearnLinearCGLogRegTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return Py_BuildValue("s", solver_name(self->cxx->getSolver()));
+BOB_CATCH_MEMBER("solver", 0)
+}
+
+static int PyBobLearnLinearCGLogRegTrainer_setSolver
+(PyBobLearnLinearCGLogRegTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  const char* name;
+  if (!PyArg_Parse(o, "s", &name)) return -1;
+  bob::learn::linear::CGLogRegTrainer::Solver value;
+  if (!solver_from_name(name, value)) return -1;
+  self->cxx->setSolver(value);
+  return 0;
+BOB_CATCH_MEMBER("solver", -1)
+}
+
+static auto warm_start = bob::extension::VariableDoc(
+  "warm_start",
+  "bool",
+  "Start the optimization from the machine passed to :py:meth:`train`?",
+  "If set to ``True``, the weights and the bias of the machine passed to :py:meth:`train` are the starting point of the optimization, if the machine has the right shape. "
+  "A different normalization of the machine is taken into account. "
+  "Otherwise, the optimization starts from zero weights."
+);
+static PyObject* PyBobLearnLinearCGLogRegTrainer_getWarmStart
+(PyBobLearnLinearCGLogRegTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  if (self->cxx->getWarmStart()) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+BOB_CATCH_MEMBER("warm_start", 0)
+}
+
+static int PyBobLearnLinearCGLogRegTrainer_setWarmStart
+(PyBobLearnLinearCGLogRegTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  int istrue = PyObject_IsTrue(o);
+  if (istrue == -1) return -1;
+
+  self->cxx->setWarmStart(istrue);
+  return 0;
+BOB_CATCH_MEMBER("warm_start", -1)
+}
+
 static PyGetSetDef PyBobLearnLinearCGLogRegTrainer_getseters[] = {
     {
       prior.name(),
@@ -368,35 +613,1032 @@ static PyGetSetDef PyBobLearnLinearCGLogRegTrainer_getseters[] = {
       whiten.doc(),
       0
     },
+    {
+      solver.name(),
+      (getter)PyBobLearnLinearCGLogRegTrainer_getSolver,
+      (setter)PyBobLearnLinearCGLogRegTrainer_setSolver,
+      solver.doc(),
+      0
+    },
+    {
+      warm_start.name(),
+      (getter)PyBobLearnLinearCGLogRegTrainer_getWarmStart,
+      (setter)PyBobLearnLinearCGLogRegTrainer_setWarmStart,
+      warm_start.doc(),
+      0
+    },
     {0}  /* Sentinel */
 };
 
-// Linear Logistic Regression Trainer
-PyTypeObject PyBobLearnLinearCGLogRegTrainer_Type = {
-  PyVarObject_HEAD_INIT(0,0)
-  0
-};
+/*******************************************************
+ * Implementation of MiniBatchLogRegTrainer base class *
+ *******************************************************/
 
-bool init_BobLearnLinearCGLogReg(PyObject* module)
-{
-  // Linear Logistic Regression Trainer
-  PyBobLearnLinearCGLogRegTrainer_Type.tp_name = CGLogReg_doc.name();
-  PyBobLearnLinearCGLogRegTrainer_Type.tp_basicsize = sizeof(PyBobLearnLinearCGLogRegTrainerObject);
-  PyBobLearnLinearCGLogRegTrainer_Type.tp_flags = Py_TPFLAGS_DEFAULT;
-  PyBobLearnLinearCGLogRegTrainer_Type.tp_doc = CGLogReg_doc.doc();
+static auto MiniBatchLogReg_doc = bob::extension::ClassDoc(
+  BOB_EXT_MODULE_PREFIX ".MiniBatchLogRegTrainer",
+  "Trains a linear machine to perform Linear Logistic Regression on data presented in chunks",
+  "This trainer minimizes the same objective function as :py:class:`CGLogRegTrainer`, with the same meaning of the ``prior``, ``reg`` and ``mean_std_norm`` parameters, but it uses mini-batch stochastic gradients with the Adam update rule. "
+  "Since the data is presented in chunks of arbitrary size, the memory needed for the training does not depend on the number of samples. "
+  "The first pass over the chunks accumulates the number of samples in each class and, if ``mean_std_norm`` is enabled, their mean and standard deviation. "
+  "Each of the following :py:attr:`epochs` passes performs one Adam step on every mini-batch of ``batch_size`` samples. "
+  "Each mini-batch contains the same proportion of negatives and positives as its chunk, but the samples are not shuffled, so chunks should not be sorted by any criterion.\n\n"
+  "For details about the Adam update rule, please see: Adam: A Method for Stochastic Optimization, D. P. Kingma and J. Ba, ICLR 2015"
+).add_constructor(bob::extension::FunctionDoc(
+  "MiniBatchLogRegTrainer",
+  "Creates a new trainer to perform Linear Logistic Regression on data presented in chunks",
+  "There are two initializers for objects of this class. "
+  "In the first variant, the user passes the training parameters. "
+  "The second initialization form copy constructs a new trainer from an existing one, including the state of an ongoing training."
+)
+.add_prototype("[prior], [reg], [mean_std_norm], [batch_size], [learning_rate], [epochs]", "")
+.add_prototype("other", "")
+.add_parameter("prior", "float", "[Default: ``0.5``] The synthetic prior (should be in range :math:`]0.,1.[`)")
+.add_parameter("reg", "float", "[Default: ``0.``] The regularization factor lambda. If you set this to the value of ``0.``, then the algorithm will apply **no** regularization whatsoever")
+.add_parameter("mean_std_norm", "bool", "[Default: ``False``] Performs mean and standard-deviation normalization (whitening) of the input data before training the (resulting) :py:class:`bob.learn.linear.Machine`")
+.add_parameter("batch_size", "int", "[Default: ``256``] The number of samples in each mini-batch")
+.add_parameter("learning_rate", "float", "[Default: ``0.01``] The initial step size of the Adam updates")
+.add_parameter("epochs", "int", "[Default: ``10``] The number of passes over the data in :py:meth:`train`")
+.add_parameter("other", ":py:class:`MiniBatchLogRegTrainer`", "If you decide to copy construct from another object of the same type, pass it using this parameter")
+);
 
-  // set the functions
-  PyBobLearnLinearCGLogRegTrainer_Type.tp_new = PyType_GenericNew;
-  PyBobLearnLinearCGLogRegTrainer_Type.tp_init = reinterpret_cast<initproc>(PyBobLearnLinearCGLogRegTrainer_init);
-  PyBobLearnLinearCGLogRegTrainer_Type.tp_dealloc = reinterpret_cast<destructor>(PyBobLearnLinearCGLogRegTrainer_delete);
-  PyBobLearnLinearCGLogRegTrainer_Type.tp_methods = PyBobLearnLinearCGLogRegTrainer_methods;
-  PyBobLearnLinearCGLogRegTrainer_Type.tp_getset = PyBobLearnLinearCGLogRegTrainer_getseters;
-  PyBobLearnLinearCGLogRegTrainer_Type.tp_richcompare = reinterpret_cast<richcmpfunc>(PyBobLearnLinearCGLogRegTrainer_RichCompare);
+static int PyBobLearnLinearMiniBatchLogRegTrainer_init_parameters
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  /* Parses input arguments in a single shot */
+  char** kwlist = MiniBatchLogReg_doc.kwlist(0);
 
-  // check that everyting is fine
-  if (PyType_Ready(&PyBobLearnLinearCGLogRegTrainer_Type) < 0) return false;
+  double prior = 0.5;
+  double lambda = 0.;
+  PyObject* mean_std_norm = Py_False;
+  Py_ssize_t batch_size = 256;
+  double learning_rate = 0.01;
+  Py_ssize_t epochs = 10;
 
-  // add the type to the module
-  Py_INCREF(&PyBobLearnLinearCGLogRegTrainer_Type);
-  return PyModule_AddObject(module, "CGLogRegTrainer", (PyObject*)&PyBobLearnLinearCGLogRegTrainer_Type) >= 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "|ddOndn", kwlist,
+        &prior, &lambda, &mean_std_norm, &batch_size,
+        &learning_rate, &epochs)) return -1;
+
+  int mean_std_norm_ = PyObject_IsTrue(mean_std_norm);
+  if (mean_std_norm_ == -1) return -1; //error on conversion
+
+  if (batch_size <= 0 || epochs < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a positive `batch_size' and a non-negative number of `epochs'", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  self->cxx = new bob::learn::linear::MiniBatchLogRegTrainer(prior, lambda, mean_std_norm_, batch_size, learning_rate, epochs);
+  return 0;
+BOB_CATCH_MEMBER("constructor", -1)
+}
+
+static int PyBobLearnLinearMiniBatchLogRegTrainer_init_copy
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  /* Parses input arguments in a single shot */
+  char** kwlist = MiniBatchLogReg_doc.kwlist(1);
+
+  PyBobLearnLinearMiniBatchLogRegTrainerObject* other = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!", kwlist,
+        &PyBobLearnLinearMiniBatchLogRegTrainer_Type, &other)) return -1;
+
+  self->cxx = new bob::learn::linear::MiniBatchLogRegTrainer(*other->cxx);
+  return 0;
+BOB_CATCH_MEMBER("constructor", -1)
+}
+
+int PyBobLearnLinearMiniBatchLogRegTrainer_Check(PyObject* o) {
+  return PyObject_IsInstance(o, reinterpret_cast<PyObject*>(&PyBobLearnLinearMiniBatchLogRegTrainer_Type));
+}
+
+static int PyBobLearnLinearMiniBatchLogRegTrainer_init
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* args, PyObject* kwds) {
+
+  PyObject* arg = 0; ///< borrowed (don't delete)
+  if (PyTuple_Size(args)) arg = PyTuple_GET_ITEM(args, 0);
+  else {
+    if (!kwds)
+      return PyBobLearnLinearMiniBatchLogRegTrainer_init_parameters(self, args, kwds);
+    PyObject* tmp = PyDict_Values(kwds);
+    auto tmp_ = make_safe(tmp);
+    arg = PyList_GET_ITEM(tmp, 0);
+  }
+
+  if (PyBobLearnLinearMiniBatchLogRegTrainer_Check(arg)) {
+    return PyBobLearnLinearMiniBatchLogRegTrainer_init_copy(self, args, kwds);
+  }
+
+  return PyBobLearnLinearMiniBatchLogRegTrainer_init_parameters(self, args, kwds);
+}
+
+static void PyBobLearnLinearMiniBatchLogRegTrainer_delete
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self) {
+
+  delete self->cxx;
+  Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject* PyBobLearnLinearMiniBatchLogRegTrainer_RichCompare
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* other, int op) {
+
+  if (!PyBobLearnLinearMiniBatchLogRegTrainer_Check(other)) {
+    PyErr_Format(PyExc_TypeError, "cannot compare `%s' with `%s'",
+        Py_TYPE(self)->tp_name, Py_TYPE(other)->tp_name);
+    return 0;
+  }
+
+  auto other_ = reinterpret_cast<PyBobLearnLinearMiniBatchLogRegTrainerObject*>(other);
+
+  switch (op) {
+    case Py_EQ:
+      if (self->cxx->operator==(*other_->cxx)) Py_RETURN_TRUE;
+      Py_RETURN_FALSE;
+      break;
+    case Py_NE:
+      if (self->cxx->operator!=(*other_->cxx)) Py_RETURN_TRUE;
+      Py_RETURN_FALSE;
+      break;
+    default:
+      Py_INCREF(Py_NotImplemented);
+      return Py_NotImplemented;
+  }
+}
+
+/**
+ * Checks that the negatives and positives of a chunk are 2D 64-bit float
+ * arrays with the same number of columns
+ */
+static bool check_chunk(PyObject* self, PyBlitzArrayObject* negatives, PyBlitzArrayObject* positives) {
+  if (negatives->ndim != 2 || negatives->type_num != NPY_FLOAT64) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for input array `negatives'", Py_TYPE(self)->tp_name);
+    return false;
+  }
+
+  if (positives->ndim != 2 || positives->type_num != NPY_FLOAT64) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for input array `positives'", Py_TYPE(self)->tp_name);
+    return false;
+  }
+
+  if (negatives->shape[1] != positives->shape[1]) {
+    PyErr_Format(PyExc_TypeError, "`%s' requires input matrices `negatives' and `positives' to have the same number of columns (i.e. feature dimensions) but `negatives' has %" PY_FORMAT_SIZE_T "d columns and `positives' has %" PY_FORMAT_SIZE_T "d", Py_TYPE(self)->tp_name, negatives->shape[1], positives->shape[1]);
+    return false;
+  }
+  return true;
+}
+
+static auto mini_batch_train = bob::extension::FunctionDoc(
+  "train",
+  "Trains a linear machine to perform linear logistic regression",
+  "The data is either given as two arrays in memory, which are presented as a single chunk in each of the :py:attr:`epochs`, or as a function ``chunks`` without arguments. "
+  "In the latter case, the function is called once for the first pass and once for each epoch, and it has to return an iterable over ``(negatives, positives)`` pairs of arrays, e.g., a generator reading the chunks from files. "
+  "Every call should iterate over the same data.\n\n"
+  "The resulting machine will have the same number of inputs as columns in the data and a single output. "
+  "This method always returns a machine, which will be identical to the one provided (if the user passed one) or a new one allocated internally. "
+  "The training can also be controlled chunk by chunk with :py:meth:`initialize`, :py:meth:`accumulate`, :py:meth:`update` and :py:meth:`finalize`.",
+  true
+)
+.add_prototype("negatives, positives, [machine]", "machine")
+.add_prototype("chunks, [machine]", "machine")
+.add_parameter("negatives, positives", "array_like(2D, float)", "``negatives`` and ``positives`` should be arrays organized in such a way that every row corresponds to a new observation of the phenomena (i.e., a new sample) and every column corresponds to a different feature")
+.add_parameter("chunks", "callable", "A function returning an iterable over the chunks of the data, each given as a ``(negatives, positives)`` pair of 2D arrays")
+.add_parameter("machine", ":py:class:`bob.learn.linear.Machine`", "The user may provide or not a machine that will be set by this method")
+.add_return("machine", ":py:class:`bob.learn.linear.Machine`", "The trained linear machine; identical to the ``machine`` parameter, if given")
+;
+static PyObject* PyBobLearnLinearMiniBatchLogRegTrainer_TrainChunks
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  /* Parses input arguments in a single shot */
+  char** kwlist = mini_batch_train.kwlist(1);
+
+  PyObject* chunks = 0;
+  PyBobLearnLinearMachineObject* machine = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O!", kwlist,
+        &chunks,
+        &PyBobLearnLinearMachine_Type, &machine
+        ))
+    return 0;
+
+  self->cxx->initialize();
+
+  // the first pass accumulates the statistics, the others update the weights
+  const Py_ssize_t epochs = self->cxx->getEpochs();
+  for (Py_ssize_t epoch = -1; epoch < epochs; ++epoch) {
+    PyObject* iterable = PyObject_CallObject(chunks, 0);
+    if (!iterable) return 0;
+    auto iterable_ = make_safe(iterable);
+    PyObject* iterator = PyObject_GetIter(iterable);
+    if (!iterator) return 0;
+    auto iterator_ = make_safe(iterator);
+
+    while (PyObject* chunk = PyIter_Next(iterator)) {
+      auto chunk_ = make_safe(chunk);
+      PyObject* pair = PySequence_Tuple(chunk);
+      if (!pair) return 0;
+      auto pair_ = make_safe(pair);
+
+      PyBlitzArrayObject* negatives = 0;
+      PyBlitzArrayObject* positives = 0;
+      if (!PyArg_ParseTuple(pair, "O&O&:chunk",
+            &PyBlitzArray_Converter, &negatives,
+            &PyBlitzArray_Converter, &positives
+            ))
+        return 0;
+      auto negatives_ = make_safe(negatives); ///< auto-delete in case of problems
+      auto positives_ = make_safe(positives); ///< auto-delete in case of problems
+      if (!check_chunk((PyObject*)self, negatives, positives)) return 0;
+
+      if (epoch < 0)
+        self->cxx->accumulate(*PyBlitzArrayCxx_AsBlitz<double,2>(negatives), *PyBlitzArrayCxx_AsBlitz<double,2>(positives));
+      else
+        self->cxx->update(*PyBlitzArrayCxx_AsBlitz<double,2>(negatives), *PyBlitzArrayCxx_AsBlitz<double,2>(positives));
+    }
+    if (PyErr_Occurred()) return 0;
+  }
+
+  // allocates a new machine if that was not given by the user
+  boost::shared_ptr<PyBobLearnLinearMachineObject> machine_;
+  if (!machine) {
+    machine = reinterpret_cast<PyBobLearnLinearMachineObject*>(PyBobLearnLinearMachine_NewFromSize(self->cxx->numberOfFeatures(), 1));
+    machine_ = make_safe(machine); ///< auto-delete in case of problems
+  }
+
+  self->cxx->finalize(*machine->cxx);
+
+  return Py_BuildValue("O", machine);
+BOB_CATCH_MEMBER("train", 0)
+}
+
+static PyObject* PyBobLearnLinearMiniBatchLogRegTrainer_Train
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  // a callable as first argument selects the second prototype
+  PyObject* first = 0; ///< borrowed (don't delete)
+  if (PyTuple_Size(args)) first = PyTuple_GET_ITEM(args, 0);
+  else if (kwds) first = PyDict_GetItemString(kwds, "chunks");
+  if (first && PyCallable_Check(first))
+    return PyBobLearnLinearMiniBatchLogRegTrainer_TrainChunks(self, args, kwds);
+
+  /* Parses input arguments in a single shot */
+  char** kwlist = mini_batch_train.kwlist(0);
+
+  PyBlitzArrayObject* negatives = 0;
+  PyBlitzArrayObject* positives = 0;
+  PyBobLearnLinearMachineObject* machine = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&O&|O!", kwlist,
+        &PyBlitzArray_Converter, &negatives,
+        &PyBlitzArray_Converter, &positives,
+        &PyBobLearnLinearMachine_Type, &machine
+        ))
+    return 0;
+
+  auto negatives_ = make_safe(negatives); ///< auto-delete in case of problems
+  auto positives_ = make_safe(positives); ///< auto-delete in case of problems
+  if (!check_chunk((PyObject*)self, negatives, positives)) return 0;
+
+  // allocates a new machine if that was not given by the user
+  boost::shared_ptr<PyBobLearnLinearMachineObject> machine_;
+  if (!machine) {
+    machine = reinterpret_cast<PyBobLearnLinearMachineObject*>(PyBobLearnLinearMachine_NewFromSize(negatives->shape[1], 1));
+    machine_ = make_safe(machine); ///< auto-delete in case of problems
+  }
+
+  self->cxx->train(*machine->cxx, *PyBlitzArrayCxx_AsBlitz<double,2>(negatives), *PyBlitzArrayCxx_AsBlitz<double,2>(positives));
+
+  return Py_BuildValue("O", machine);
+BOB_CATCH_MEMBER("train", 0)
+}
+
+static auto initialize = bob::extension::FunctionDoc(
+  "initialize",
+  "Starts a new training",
+  "The accumulated statistics and the weights of a previous training are discarded. "
+  "If ``n_features`` is not given, the dimensionality of the samples is defined by the first call to :py:meth:`accumulate`.",
+  true
+)
+.add_prototype("[n_features]")
+.add_parameter("n_features", "int", "[Default: ``0``] The dimensionality of the samples")
+;
+static PyObject* PyBobLearnLinearMiniBatchLogRegTrainer_Initialize
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  char** kwlist = initialize.kwlist();
+
+  Py_ssize_t n_features = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "|n", kwlist, &n_features)) return 0;
+
+  if (n_features < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of features", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  self->cxx->initialize(n_features);
+  Py_RETURN_NONE;
+BOB_CATCH_MEMBER("initialize", 0)
+}
+
+static auto accumulate = bob::extension::FunctionDoc(
+  "accumulate",
+  "Adds a chunk of samples to the statistics of the first pass",
+  "The number of samples in each class, and their mean and standard deviation, are accumulated over all chunks. "
+  "All chunks must be accumulated before the first call to :py:meth:`update`.",
+  true
+)
+.add_prototype("negatives, positives")
+.add_parameter("negatives, positives", "array_like(2D, float)", "The samples of the chunk, one per row")
+;
+static PyObject* PyBobLearnLinearMiniBatchLogRegTrainer_Accumulate
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  char** kwlist = accumulate.kwlist();
+
+  PyBlitzArrayObject* negatives = 0;
+  PyBlitzArrayObject* positives = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&O&", kwlist,
+        &PyBlitzArray_Converter, &negatives,
+        &PyBlitzArray_Converter, &positives
+        ))
+    return 0;
+
+  auto negatives_ = make_safe(negatives); ///< auto-delete in case of problems
+  auto positives_ = make_safe(positives); ///< auto-delete in case of problems
+  if (!check_chunk((PyObject*)self, negatives, positives)) return 0;
+
+  self->cxx->accumulate(*PyBlitzArrayCxx_AsBlitz<double,2>(negatives), *PyBlitzArrayCxx_AsBlitz<double,2>(positives));
+  Py_RETURN_NONE;
+BOB_CATCH_MEMBER("accumulate", 0)
+}
+
+static auto update = bob::extension::FunctionDoc(
+  "update",
+  "Performs one Adam step on each mini-batch of a chunk of samples",
+  "The statistics of all chunks must have been accumulated with :py:meth:`accumulate` before.",
+  true
+)
+.add_prototype("negatives, positives", "loss")
+.add_parameter("negatives, positives", "array_like(2D, float)", "The samples of the chunk, one per row")
+.add_return("loss", "float", "The average prior-weighted negative log-likelihood of the samples of the chunk, each evaluated before the step of its mini-batch")
+;
+static PyObject* PyBobLearnLinearMiniBatchLogRegTrainer_Update
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  char** kwlist = update.kwlist();
+
+  PyBlitzArrayObject* negatives = 0;
+  PyBlitzArrayObject* positives = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&O&", kwlist,
+        &PyBlitzArray_Converter, &negatives,
+        &PyBlitzArray_Converter, &positives
+        ))
+    return 0;
+
+  auto negatives_ = make_safe(negatives); ///< auto-delete in case of problems
+  auto positives_ = make_safe(positives); ///< auto-delete in case of problems
+  if (!check_chunk((PyObject*)self, negatives, positives)) return 0;
+
+  const double loss = self->cxx->update(*PyBlitzArrayCxx_AsBlitz<double,2>(negatives), *PyBlitzArrayCxx_AsBlitz<double,2>(positives));
+  return Py_BuildValue("d", loss);
+BOB_CATCH_MEMBER("update", 0)
+}
+
+static auto finalize = bob::extension::FunctionDoc(
+  "finalize",
+  "Writes the current weights into a linear machine",
+  "This method always returns a machine, which will be identical to the one provided (if the user passed one) or a new one allocated internally.",
+  true
+)
+.add_prototype("[machine]", "machine")
+.add_parameter("machine", ":py:class:`bob.learn.linear.Machine`", "The user may provide or not a machine that will be set by this method")
+.add_return("machine", ":py:class:`bob.learn.linear.Machine`", "The trained linear machine; identical to the ``machine`` parameter, if given")
+;
+static PyObject* PyBobLearnLinearMiniBatchLogRegTrainer_Finalize
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  char** kwlist = finalize.kwlist();
+
+  PyBobLearnLinearMachineObject* machine = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O!", kwlist,
+        &PyBobLearnLinearMachine_Type, &machine)) return 0;
+
+  // allocates a new machine if that was not given by the user
+  boost::shared_ptr<PyBobLearnLinearMachineObject> machine_;
+  if (!machine) {
+    machine = reinterpret_cast<PyBobLearnLinearMachineObject*>(PyBobLearnLinearMachine_NewFromSize(self->cxx->numberOfFeatures(), 1));
+    machine_ = make_safe(machine); ///< auto-delete in case of problems
+  }
+
+  self->cxx->finalize(*machine->cxx);
+
+  return Py_BuildValue("O", machine);
+BOB_CATCH_MEMBER("finalize", 0)
+}
+
+static PyMethodDef PyBobLearnLinearMiniBatchLogRegTrainer_methods[] = {
+  {
+    mini_batch_train.name(),
+    (PyCFunction)PyBobLearnLinearMiniBatchLogRegTrainer_Train,
+    METH_VARARGS|METH_KEYWORDS,
+    mini_batch_train.doc()
+  },
+  {
+    initialize.name(),
+    (PyCFunction)PyBobLearnLinearMiniBatchLogRegTrainer_Initialize,
+    METH_VARARGS|METH_KEYWORDS,
+    initialize.doc()
+  },
+  {
+    accumulate.name(),
+    (PyCFunction)PyBobLearnLinearMiniBatchLogRegTrainer_Accumulate,
+    METH_VARARGS|METH_KEYWORDS,
+    accumulate.doc()
+  },
+  {
+    update.name(),
+    (PyCFunction)PyBobLearnLinearMiniBatchLogRegTrainer_Update,
+    METH_VARARGS|METH_KEYWORDS,
+    update.doc()
+  },
+  {
+    finalize.name(),
+    (PyCFunction)PyBobLearnLinearMiniBatchLogRegTrainer_Finalize,
+    METH_VARARGS|METH_KEYWORDS,
+    finalize.doc()
+  },
+  {0} /* Sentinel */
+};
+
+
+static PyObject* PyBobLearnLinearMiniBatchLogRegTrainer_getPrior
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return Py_BuildValue("d", self->cxx->getPrior());
+BOB_CATCH_MEMBER("prior", 0)
+}
+
+static int PyBobLearnLinearMiniBatchLogRegTrainer_setPrior
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  double v = PyFloat_AsDouble(o);
+  if (PyErr_Occurred()) return -1;
+  self->cxx->setPrior(v);
+  return 0;
+BOB_CATCH_MEMBER("prior", -1)
+}
+
+static PyObject* PyBobLearnLinearMiniBatchLogRegTrainer_getLambda
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return Py_BuildValue("d", self->cxx->getLambda());
+BOB_CATCH_MEMBER("reg", 0)
+}
+
+static int PyBobLearnLinearMiniBatchLogRegTrainer_setLambda
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  double v = PyFloat_AsDouble(o);
+  if (PyErr_Occurred()) return -1;
+  self->cxx->setLambda(v);
+  return 0;
+BOB_CATCH_MEMBER("reg", -1)
+}
+
+static PyObject* PyBobLearnLinearMiniBatchLogRegTrainer_getNorm
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  if (self->cxx->getNorm()) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+BOB_CATCH_MEMBER("mean_std_norm", 0)
+}
+
+static int PyBobLearnLinearMiniBatchLogRegTrainer_setNorm
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  int istrue = PyObject_IsTrue(o);
+  if (istrue == -1) return -1;
+  self->cxx->setNorm(istrue);
+  return 0;
+BOB_CATCH_MEMBER("mean_std_norm", -1)
+}
+
+static auto batch_size = bob::extension::VariableDoc(
+  "batch_size",
+  "int",
+  "The number of samples in each mini-batch"
+);
+static PyObject* PyBobLearnLinearMiniBatchLogRegTrainer_getBatchSize
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return Py_BuildValue("n", self->cxx->getBatchSize());
+BOB_CATCH_MEMBER("batch_size", 0)
+}
+
+static int PyBobLearnLinearMiniBatchLogRegTrainer_setBatchSize
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  Py_ssize_t v = PyNumber_AsSsize_t(o, PyExc_OverflowError);
+  if (PyErr_Occurred()) return -1;
+  if (v <= 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a positive `batch_size'", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+  self->cxx->setBatchSize(v);
+  return 0;
+BOB_CATCH_MEMBER("batch_size", -1)
+}
+
+static auto learning_rate = bob::extension::VariableDoc(
+  "learning_rate",
+  "float",
+  "The initial step size of the Adam updates",
+  "The step size decays with the square root of the number of epochs."
+);
+static PyObject* PyBobLearnLinearMiniBatchLogRegTrainer_getLearningRate
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return Py_BuildValue("d", self->cxx->getLearningRate());
+BOB_CATCH_MEMBER("learning_rate", 0)
+}
+
+static int PyBobLearnLinearMiniBatchLogRegTrainer_setLearningRate
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  double v = PyFloat_AsDouble(o);
+  if (PyErr_Occurred()) return -1;
+  self->cxx->setLearningRate(v);
+  return 0;
+BOB_CATCH_MEMBER("learning_rate", -1)
+}
+
+static auto epochs = bob::extension::VariableDoc(
+  "epochs",
+  "int",
+  "The number of passes over the data in :py:meth:`train`"
+);
+static PyObject* PyBobLearnLinearMiniBatchLogRegTrainer_getEpochs
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return Py_BuildValue("n", self->cxx->getEpochs());
+BOB_CATCH_MEMBER("epochs", 0)
+}
+
+static int PyBobLearnLinearMiniBatchLogRegTrainer_setEpochs
+(PyBobLearnLinearMiniBatchLogRegTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  Py_ssize_t v = PyNumber_AsSsize_t(o, PyExc_OverflowError);
+  if (v < 0) return -1;
+  self->cxx->setEpochs(v);
+  return 0;
+BOB_CATCH_MEMBER("epochs", -1)
+}
+
+static PyGetSetDef PyBobLearnLinearMiniBatchLogRegTrainer_getseters[] = {
+    {
+      prior.name(),
+      (getter)PyBobLearnLinearMiniBatchLogRegTrainer_getPrior,
+      (setter)PyBobLearnLinearMiniBatchLogRegTrainer_setPrior,
+      prior.doc(),
+      0
+    },
+    {
+      reg.name(),
+      (getter)PyBobLearnLinearMiniBatchLogRegTrainer_getLambda,
+      (setter)PyBobLearnLinearMiniBatchLogRegTrainer_setLambda,
+      reg.doc(),
+      0
+    },
+    {
+      whiten.name(),
+      (getter)PyBobLearnLinearMiniBatchLogRegTrainer_getNorm,
+      (setter)PyBobLearnLinearMiniBatchLogRegTrainer_setNorm,
+      whiten.doc(),
+      0
+    },
+    {
+      batch_size.name(),
+      (getter)PyBobLearnLinearMiniBatchLogRegTrainer_getBatchSize,
+      (setter)PyBobLearnLinearMiniBatchLogRegTrainer_setBatchSize,
+      batch_size.doc(),
+      0
+    },
+    {
+      learning_rate.name(),
+      (getter)PyBobLearnLinearMiniBatchLogRegTrainer_getLearningRate,
+      (setter)PyBobLearnLinearMiniBatchLogRegTrainer_setLearningRate,
+      learning_rate.doc(),
+      0
+    },
+    {
+      epochs.name(),
+      (getter)PyBobLearnLinearMiniBatchLogRegTrainer_getEpochs,
+      (setter)PyBobLearnLinearMiniBatchLogRegTrainer_setEpochs,
+      epochs.doc(),
+      0
+    },
+    {0}  /* Sentinel */
+};
+
+/*********************************************************
+ * Implementation of MultinomialLogRegTrainer base class *
+ *********************************************************/
+
+static auto MultinomialLogReg_doc = bob::extension::ClassDoc(
+  BOB_EXT_MODULE_PREFIX ".MultinomialLogRegTrainer",
+  "Trains a linear machine to perform multinomial (softmax) Logistic Regression",
+  "The training stage places the weights (and biases) of all classes in a single linear machine with one output per class. "
+  "All columns are learned together, by minimizing the regularized negative log-likelihood of the classes with the L-BFGS algorithm, so that each iteration needs a single pass over the data of all classes. "
+  "The resulting machine has the :py:class:`bob.learn.activation.Identity` activation, i.e., it outputs the logits of the classes. "
+  "The index of the largest output is the most probable class, and the softmax of the outputs, ``numpy.exp(o - o.max()) / numpy.exp(o - o.max()).sum()``, are the posterior probabilities of the classes. "
+  "The samples are not weighted, so that the priors of the classes are their proportions in the training data."
+).add_constructor(bob::extension::FunctionDoc(
+  "MultinomialLogRegTrainer",
+  "Creates a new trainer to perform multinomial Logistic Regression",
+  "There are two initializers for objects of this class. "
+  "In the first variant, the user passes the training parameters, which have the same meaning as for :py:class:`CGLogRegTrainer`. "
+  "The second initialization form copy constructs a new trainer from an existing one."
+)
+.add_prototype("[convergence_threshold], [max_iterations], [reg], [mean_std_norm]", "")
+.add_prototype("other", "")
+.add_parameter("convergence_threshold", "float", "[Default: ``1e-5``] The convergence threshold on the maximum change of the weights in one iteration")
+.add_parameter("max_iterations", "int", "[Default: ``10000``] The maximum number of iterations of the L-BFGS algorithm")
+.add_parameter("reg", "float", "[Default: ``0.``] The regularization factor lambda. If you set this to the value of ``0.``, then the algorithm will apply **no** regularization whatsoever")
+.add_parameter("mean_std_norm", "bool", "[Default: ``False``] Performs mean and standard-deviation normalization (whitening) of the input data before training the (resulting) :py:class:`bob.learn.linear.Machine`")
+.add_parameter("other", ":py:class:`MultinomialLogRegTrainer`", "If you decide to copy construct from another object of the same type, pass it using this parameter")
+);
+
+static int PyBobLearnLinearMultinomialLogRegTrainer_init_parameters
+(PyBobLearnLinearMultinomialLogRegTrainerObject* self, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  /* Parses input arguments in a single shot */
+  char** kwlist = MultinomialLogReg_doc.kwlist(0);
+
+  double convergence_threshold = 1e-5;
+  Py_ssize_t max_iterations = 10000;
+  double lambda = 0.;
+  PyObject* mean_std_norm = Py_False;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "|dndO", kwlist,
+        &convergence_threshold, &max_iterations, &lambda, &mean_std_norm)) return -1;
+
+  int mean_std_norm_ = PyObject_IsTrue(mean_std_norm);
+  if (mean_std_norm_ == -1) return -1; //error on conversion
+
+  self->cxx = new bob::learn::linear::MultinomialLogRegTrainer(convergence_threshold, max_iterations, lambda, mean_std_norm_);
+  return 0;
+BOB_CATCH_MEMBER("constructor", -1)
+}
+
+static int PyBobLearnLinearMultinomialLogRegTrainer_init_copy
+(PyBobLearnLinearMultinomialLogRegTrainerObject* self, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  /* Parses input arguments in a single shot */
+  char** kwlist = MultinomialLogReg_doc.kwlist(1);
+
+  PyBobLearnLinearMultinomialLogRegTrainerObject* other = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!", kwlist,
+        &PyBobLearnLinearMultinomialLogRegTrainer_Type, &other)) return -1;
+
+  self->cxx = new bob::learn::linear::MultinomialLogRegTrainer(*other->cxx);
+  return 0;
+BOB_CATCH_MEMBER("constructor", -1)
+}
+
+int PyBobLearnLinearMultinomialLogRegTrainer_Check(PyObject* o) {
+  return PyObject_IsInstance(o, reinterpret_cast<PyObject*>(&PyBobLearnLinearMultinomialLogRegTrainer_Type));
+}
+
+static int PyBobLearnLinearMultinomialLogRegTrainer_init
+(PyBobLearnLinearMultinomialLogRegTrainerObject* self, PyObject* args, PyObject* kwds) {
+
+  PyObject* arg = 0; ///< borrowed (don't delete)
+  if (PyTuple_Size(args)) arg = PyTuple_GET_ITEM(args, 0);
+  else {
+    if (!kwds)
+      return PyBobLearnLinearMultinomialLogRegTrainer_init_parameters(self, args, kwds);
+    PyObject* tmp = PyDict_Values(kwds);
+    auto tmp_ = make_safe(tmp);
+    arg = PyList_GET_ITEM(tmp, 0);
+  }
+
+  if (PyBobLearnLinearMultinomialLogRegTrainer_Check(arg)) {
+    return PyBobLearnLinearMultinomialLogRegTrainer_init_copy(self, args, kwds);
+  }
+
+  return PyBobLearnLinearMultinomialLogRegTrainer_init_parameters(self, args, kwds);
+}
+
+static void PyBobLearnLinearMultinomialLogRegTrainer_delete
+(PyBobLearnLinearMultinomialLogRegTrainerObject* self) {
+
+  delete self->cxx;
+  Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static PyObject* PyBobLearnLinearMultinomialLogRegTrainer_RichCompare
+(PyBobLearnLinearMultinomialLogRegTrainerObject* self, PyObject* other, int op) {
+
+  if (!PyBobLearnLinearMultinomialLogRegTrainer_Check(other)) {
+    PyErr_Format(PyExc_TypeError, "cannot compare `%s' with `%s'",
+        Py_TYPE(self)->tp_name, Py_TYPE(other)->tp_name);
+    return 0;
+  }
+
+  auto other_ = reinterpret_cast<PyBobLearnLinearMultinomialLogRegTrainerObject*>(other);
+
+  switch (op) {
+    case Py_EQ:
+      if (self->cxx->operator==(*other_->cxx)) Py_RETURN_TRUE;
+      Py_RETURN_FALSE;
+      break;
+    case Py_NE:
+      if (self->cxx->operator!=(*other_->cxx)) Py_RETURN_TRUE;
+      Py_RETURN_FALSE;
+      break;
+    default:
+      Py_INCREF(Py_NotImplemented);
+      return Py_NotImplemented;
+  }
+}
+
+static auto multinomial_train = bob::extension::FunctionDoc(
+  "train",
+  "Trains a linear machine to perform multinomial logistic regression",
+  "The resulting machine will have the same number of inputs as columns in the arrays of ``X`` and one output per class, in the order of ``X``. "
+  "This method always returns a machine, which will be identical to the one provided (if the user passed one) or a new one allocated internally.\n\n"
+  "If a ``callback`` is given, it is called after each iteration with the same dictionary as in :py:meth:`CGLogRegTrainer.train`; returning ``True`` stops the training.",
+  true
+)
+.add_prototype("X, [machine], [callback]", "machine")
+.add_parameter("X", "[array_like(2D, float)]", "A sequence of the data of (at least two) classes, where every row of an array corresponds to a sample and every column to a feature")
+.add_parameter("machine", ":py:class:`bob.learn.linear.Machine`", "The user may provide or not a machine that will be set by this method")
+.add_parameter("callback", "callable", "[Default: ``None``] A function that is called with a dictionary describing the state of the training after each iteration; returning ``True`` stops the training")
+.add_return("machine", ":py:class:`bob.learn.linear.Machine`", "The trained linear machine; identical to the ``machine`` parameter, if given")
+;
+static PyObject* PyBobLearnLinearMultinomialLogRegTrainer_Train
+(PyBobLearnLinearMultinomialLogRegTrainerObject* self, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  /* Parses input arguments in a single shot */
+  char** kwlist = multinomial_train.kwlist();
+
+  PyObject* X = 0;
+  PyBobLearnLinearMachineObject* machine = 0;
+  PyObject* callback = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O!O", kwlist,
+        &X, &PyBobLearnLinearMachine_Type, &machine, &callback)) return 0;
+
+  if (callback == Py_None) callback = 0;
+  if (callback && !PyCallable_Check(callback)) {
+    PyErr_Format(PyExc_TypeError, "`%s' requires the `callback' to be callable, but an object of type `%s' was given", Py_TYPE(self)->tp_name, Py_TYPE(callback)->tp_name);
+    return 0;
+  }
+
+  /* Checks and converts all entries */
+  std::vector<blitz::Array<double,2> > Xseq;
+  std::vector<boost::shared_ptr<PyBlitzArrayObject>> Xseq_;
+
+  PyObject* iterator = PyObject_GetIter(X);
+  if (!iterator) return 0;
+  auto iterator_ = make_safe(iterator);
+
+  while (PyObject* item = PyIter_Next(iterator)) {
+    auto item_ = make_safe(item);
+
+    PyBlitzArrayObject* bz = 0;
+
+    if (!PyBlitzArray_Converter(item, &bz)) {
+      PyErr_Format(PyExc_TypeError, "`%s' could not convert object of type `%s' at position %" PY_FORMAT_SIZE_T "d of input sequence `X' into an array - check your input", Py_TYPE(self)->tp_name, Py_TYPE(item)->tp_name, Xseq.size());
+      return 0;
+    }
+    Xseq_.push_back(make_safe(bz)); ///< prevents data deletion
+
+    if (bz->ndim != 2 || bz->type_num != NPY_FLOAT64) {
+      PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for input sequence `X' (or any other object coercible to that), but at position %" PY_FORMAT_SIZE_T "d I have found an object with %" PY_FORMAT_SIZE_T "d dimensions and with type `%s' which is not compatible - check your input", Py_TYPE(self)->tp_name, Xseq.size(), bz->ndim, PyBlitzArray_TypenumAsString(bz->type_num));
+      return 0;
+    }
+
+    Xseq.push_back(*PyBlitzArrayCxx_AsBlitz<double,2>(bz)); ///< only a view!
+  }
+
+  if (PyErr_Occurred()) return 0;
+
+  if (Xseq.size() < 2) {
+    PyErr_Format(PyExc_RuntimeError, "`%s' requires an iterable for parameter `X' leading to, at least, two entries (representing two classes), but you have passed something that has only %" PY_FORMAT_SIZE_T "d entries", Py_TYPE(self)->tp_name, Xseq.size());
+    return 0;
+  }
+
+  // allocates a new machine if that was not given by the user
+  boost::shared_ptr<PyBobLearnLinearMachineObject> machine_;
+  if (!machine) {
+    machine = reinterpret_cast<PyBobLearnLinearMachineObject*>(PyBobLearnLinearMachine_NewFromSize(Xseq[0].extent(1), Xseq.size()));
+    machine_ = make_safe(machine); ///< auto-delete in case of problems
+  }
+
+  if (!callback) {
+    self->cxx->train(*machine->cxx, Xseq);
+    return Py_BuildValue("O", machine);
+  }
+
+  // a Python error in the callback stops the training, and is raised after
+  // the trainer returns
+  bool failed = false;
+  self->cxx->train(*machine->cxx, Xseq, python_callback(callback, failed));
+  if (failed) return 0;
+
+  return Py_BuildValue("O", machine);
+BOB_CATCH_MEMBER("train", 0)
+}
+
+static PyMethodDef PyBobLearnLinearMultinomialLogRegTrainer_methods[] = {
+  {
+    multinomial_train.name(),
+    (PyCFunction)PyBobLearnLinearMultinomialLogRegTrainer_Train,
+    METH_VARARGS|METH_KEYWORDS,
+    multinomial_train.doc()
+  },
+  {0} /* Sentinel */
+};
+
+static PyObject* PyBobLearnLinearMultinomialLogRegTrainer_getConvergenceThreshold
+(PyBobLearnLinearMultinomialLogRegTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return Py_BuildValue("d", self->cxx->getConvergenceThreshold());
+BOB_CATCH_MEMBER("convergence_threshold", 0)
+}
+
+static int PyBobLearnLinearMultinomialLogRegTrainer_setConvergenceThreshold
+(PyBobLearnLinearMultinomialLogRegTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  double v = PyFloat_AsDouble(o);
+  if (PyErr_Occurred()) return -1;
+  self->cxx->setConvergenceThreshold(v);
+  return 0;
+BOB_CATCH_MEMBER("convergence_threshold", -1)
+}
+
+static PyObject* PyBobLearnLinearMultinomialLogRegTrainer_getMaxIterations
+(PyBobLearnLinearMultinomialLogRegTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return Py_BuildValue("n", self->cxx->getMaxIterations());
+BOB_CATCH_MEMBER("max_iterations", 0)
+}
+
+static int PyBobLearnLinearMultinomialLogRegTrainer_setMaxIterations
+(PyBobLearnLinearMultinomialLogRegTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  Py_ssize_t v = PyNumber_AsSsize_t(o, PyExc_OverflowError);
+  if (v < 0) return -1;
+  self->cxx->setMaxIterations(v);
+  return 0;
+BOB_CATCH_MEMBER("max_iterations", -1)
+}
+
+static PyObject* PyBobLearnLinearMultinomialLogRegTrainer_getLambda
+(PyBobLearnLinearMultinomialLogRegTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return Py_BuildValue("d", self->cxx->getLambda());
+BOB_CATCH_MEMBER("reg", 0)
+}
+
+static int PyBobLearnLinearMultinomialLogRegTrainer_setLambda
+(PyBobLearnLinearMultinomialLogRegTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  double v = PyFloat_AsDouble(o);
+  if (PyErr_Occurred()) return -1;
+  self->cxx->setLambda(v);
+  return 0;
+BOB_CATCH_MEMBER("reg", -1)
+}
+
+static PyObject* PyBobLearnLinearMultinomialLogRegTrainer_getNorm
+(PyBobLearnLinearMultinomialLogRegTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  if (self->cxx->getNorm()) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+BOB_CATCH_MEMBER("mean_std_norm", 0)
+}
+
+static int PyBobLearnLinearMultinomialLogRegTrainer_setNorm
+(PyBobLearnLinearMultinomialLogRegTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  int istrue = PyObject_IsTrue(o);
+  if (istrue == -1) return -1;
+  self->cxx->setNorm(istrue);
+  return 0;
+BOB_CATCH_MEMBER("mean_std_norm", -1)
+}
+
+static PyGetSetDef PyBobLearnLinearMultinomialLogRegTrainer_getseters[] = {
+    {
+      convergence_threshold.name(),
+      (getter)PyBobLearnLinearMultinomialLogRegTrainer_getConvergenceThreshold,
+      (setter)PyBobLearnLinearMultinomialLogRegTrainer_setConvergenceThreshold,
+      convergence_threshold.doc(),
+      0
+    },
+    {
+      max_iterations.name(),
+      (getter)PyBobLearnLinearMultinomialLogRegTrainer_getMaxIterations,
+      (setter)PyBobLearnLinearMultinomialLogRegTrainer_setMaxIterations,
+      max_iterations.doc(),
+      0
+    },
+    {
+      reg.name(),
+      (getter)PyBobLearnLinearMultinomialLogRegTrainer_getLambda,
+      (setter)PyBobLearnLinearMultinomialLogRegTrainer_setLambda,
+      reg.doc(),
+      0
+    },
+    {
+      whiten.name(),
+      (getter)PyBobLearnLinearMultinomialLogRegTrainer_getNorm,
+      (setter)PyBobLearnLinearMultinomialLogRegTrainer_setNorm,
+      whiten.doc(),
+      0
+    },
+    {0}  /* Sentinel */
+};
+
+// Linear Logistic Regression Trainer
+PyTypeObject PyBobLearnLinearCGLogRegTrainer_Type = {
+  PyVarObject_HEAD_INIT(0,0)
+  0
+};
+
+// Mini-batch Linear Logistic Regression Trainer
+PyTypeObject PyBobLearnLinearMiniBatchLogRegTrainer_Type = {
+  PyVarObject_HEAD_INIT(0,0)
+  0
+};
+
+// Multinomial Logistic Regression Trainer
+PyTypeObject PyBobLearnLinearMultinomialLogRegTrainer_Type = {
+  PyVarObject_HEAD_INIT(0,0)
+  0
+};
+
+bool init_BobLearnLinearCGLogReg(PyObject* module)
+{
+  // Linear Logistic Regression Trainer
+  PyBobLearnLinearCGLogRegTrainer_Type.tp_name = CGLogReg_doc.name();
+  PyBobLearnLinearCGLogRegTrainer_Type.tp_basicsize = sizeof(PyBobLearnLinearCGLogRegTrainerObject);
+  PyBobLearnLinearCGLogRegTrainer_Type.tp_flags = Py_TPFLAGS_DEFAULT;
+  PyBobLearnLinearCGLogRegTrainer_Type.tp_doc = CGLogReg_doc.doc();
+
+  // set the functions
+  PyBobLearnLinearCGLogRegTrainer_Type.tp_new = PyType_GenericNew;
+  PyBobLearnLinearCGLogRegTrainer_Type.tp_init = reinterpret_cast<initproc>(PyBobLearnLinearCGLogRegTrainer_init);
+  PyBobLearnLinearCGLogRegTrainer_Type.tp_dealloc = reinterpret_cast<destructor>(PyBobLearnLinearCGLogRegTrainer_delete);
+  PyBobLearnLinearCGLogRegTrainer_Type.tp_methods = PyBobLearnLinearCGLogRegTrainer_methods;
+  PyBobLearnLinearCGLogRegTrainer_Type.tp_getset = PyBobLearnLinearCGLogRegTrainer_getseters;
+  PyBobLearnLinearCGLogRegTrainer_Type.tp_richcompare = reinterpret_cast<richcmpfunc>(PyBobLearnLinearCGLogRegTrainer_RichCompare);
+
+  // Mini-batch Linear Logistic Regression Trainer
+  PyBobLearnLinearMiniBatchLogRegTrainer_Type.tp_name = MiniBatchLogReg_doc.name();
+  PyBobLearnLinearMiniBatchLogRegTrainer_Type.tp_basicsize = sizeof(PyBobLearnLinearMiniBatchLogRegTrainerObject);
+  PyBobLearnLinearMiniBatchLogRegTrainer_Type.tp_flags = Py_TPFLAGS_DEFAULT;
+  PyBobLearnLinearMiniBatchLogRegTrainer_Type.tp_doc = MiniBatchLogReg_doc.doc();
+
+  // set the functions
+  PyBobLearnLinearMiniBatchLogRegTrainer_Type.tp_new = PyType_GenericNew;
+  PyBobLearnLinearMiniBatchLogRegTrainer_Type.tp_init = reinterpret_cast<initproc>(PyBobLearnLinearMiniBatchLogRegTrainer_init);
+  PyBobLearnLinearMiniBatchLogRegTrainer_Type.tp_dealloc = reinterpret_cast<destructor>(PyBobLearnLinearMiniBatchLogRegTrainer_delete);
+  PyBobLearnLinearMiniBatchLogRegTrainer_Type.tp_methods = PyBobLearnLinearMiniBatchLogRegTrainer_methods;
+  PyBobLearnLinearMiniBatchLogRegTrainer_Type.tp_getset = PyBobLearnLinearMiniBatchLogRegTrainer_getseters;
+  PyBobLearnLinearMiniBatchLogRegTrainer_Type.tp_richcompare = reinterpret_cast<richcmpfunc>(PyBobLearnLinearMiniBatchLogRegTrainer_RichCompare);
+
+  // Multinomial Logistic Regression Trainer
+  PyBobLearnLinearMultinomialLogRegTrainer_Type.tp_name = MultinomialLogReg_doc.name();
+  PyBobLearnLinearMultinomialLogRegTrainer_Type.tp_basicsize = sizeof(PyBobLearnLinearMultinomialLogRegTrainerObject);
+  PyBobLearnLinearMultinomialLogRegTrainer_Type.tp_flags = Py_TPFLAGS_DEFAULT;
+  PyBobLearnLinearMultinomialLogRegTrainer_Type.tp_doc = MultinomialLogReg_doc.doc();
+
+  // set the functions
+  PyBobLearnLinearMultinomialLogRegTrainer_Type.tp_new = PyType_GenericNew;
+  PyBobLearnLinearMultinomialLogRegTrainer_Type.tp_init = reinterpret_cast<initproc>(PyBobLearnLinearMultinomialLogRegTrainer_init);
+  PyBobLearnLinearMultinomialLogRegTrainer_Type.tp_dealloc = reinterpret_cast<destructor>(PyBobLearnLinearMultinomialLogRegTrainer_delete);
+  PyBobLearnLinearMultinomialLogRegTrainer_Type.tp_methods = PyBobLearnLinearMultinomialLogRegTrainer_methods;
+  PyBobLearnLinearMultinomialLogRegTrainer_Type.tp_getset = PyBobLearnLinearMultinomialLogRegTrainer_getseters;
+  PyBobLearnLinearMultinomialLogRegTrainer_Type.tp_richcompare = reinterpret_cast<richcmpfunc>(PyBobLearnLinearMultinomialLogRegTrainer_RichCompare);
+
+  // check that everyting is fine
+  if (PyType_Ready(&PyBobLearnLinearCGLogRegTrainer_Type) < 0) return false;
+  if (PyType_Ready(&PyBobLearnLinearMiniBatchLogRegTrainer_Type) < 0) return false;
+  if (PyType_Ready(&PyBobLearnLinearMultinomialLogRegTrainer_Type) < 0) return false;
+
+  // add the types to the module
+  Py_INCREF(&PyBobLearnLinearCGLogRegTrainer_Type);
+  if (PyModule_AddObject(module, "CGLogRegTrainer", (PyObject*)&PyBobLearnLinearCGLogRegTrainer_Type) < 0) return false;
+
+  Py_INCREF(&PyBobLearnLinearMiniBatchLogRegTrainer_Type);
+  if (PyModule_AddObject(module, "MiniBatchLogRegTrainer", (PyObject*)&PyBobLearnLinearMiniBatchLogRegTrainer_Type) < 0) return false;
+
+  Py_INCREF(&PyBobLearnLinearMultinomialLogRegTrainer_Type);
+  return PyModule_AddObject(module, "MultinomialLogRegTrainer", (PyObject*)&PyBobLearnLinearMultinomialLogRegTrainer_Type) >= 0;
 }
@@ -8,6 +8,9 @@
  */
 
 #define BOB_LEARN_LINEAR_MODULE
+#include <cstring>
+#include <utility>
+#include <vector>
 #include <bob.blitz/cppapi.h>
 #include <bob.blitz/cleanup.h>
 #include <bob.extension/defines.h>
@@ -216,10 +219,47 @@ static auto weights = bob::extension::VariableDoc(
   "Weight matrix to which the input is projected to",
   "The output of the projection is fed subject to bias and activation before being output"
 );
+/**
+ * Releases the owner of the weights held by a numpy array
+ */
+static void release_storage(PyObject* capsule) {
+  delete static_cast<boost::shared_ptr<const void>*>(PyCapsule_GetPointer(capsule, 0));
+}
+
+/**
+ * Wraps the weights of the given machine into a read-only numpy array.
+ * The weights are not owned by a blitz array, so that the numpy array keeps
+ * their owner alive by itself, after the machine has copied its weights,
+ * loaded other weights or was destroyed.
+ */
+static PyObject* weights_array(const bob::learn::linear::Machine& machine) {
+  const blitz::Array<double,2>& weights = machine.getWeights();
+  auto storage = new boost::shared_ptr<const void>(machine.getStorage());
+  PyObject* capsule = PyCapsule_New(storage, 0, release_storage);
+  if (!capsule) {
+    delete storage;
+    return 0;
+  }
+  npy_intp shape[2] = {weights.extent(0), weights.extent(1)};
+  npy_intp strides[2] = {(npy_intp)(weights.stride(0) * sizeof(double)), (npy_intp)(weights.stride(1) * sizeof(double))};
+  PyObject* array = PyArray_New(&PyArray_Type, 2, shape, NPY_FLOAT64, strides,
+      const_cast<double*>(weights.data()), 0, NPY_ARRAY_ALIGNED, 0);
+  if (!array) {
+    Py_DECREF(capsule);
+    return 0;
+  }
+  // steals the reference to the capsule, also on failure
+  if (PyArray_SetBaseObject(reinterpret_cast<PyArrayObject*>(array), capsule) < 0) {
+    Py_DECREF(array);
+    return 0;
+  }
+  return array;
+}
+
 static PyObject* PyBobLearnLinearMachine_getWeights
 (PyBobLearnLinearMachineObject* self, void* /*closure*/) {
 BOB_TRY
-  return PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(self->cxx->getWeights()));
+  return weights_array(*self->cxx);
 BOB_CATCH_MEMBER("weights", 0)
 }
 
@@ -377,6 +417,23 @@ BOB_TRY
 BOB_CATCH_MEMBER("shape", -1)
 }
 
+static auto is_mapped = bob::extension::VariableDoc(
+  "is_mapped",
+  "bool",
+  "Are the :py:attr:`weights` memory-mapped from a file?",
+  "This is the case after a successful call to :py:meth:`load` with ``mmap=True``, or for machines loaded with :py:func:`load_bundle`. "
+  "Modifying the weights (e.g., by setting :py:attr:`weights` or :py:attr:`shape`) copies them into memory. "
+  "The mapping is released when neither this machine, nor its copies, nor any :py:attr:`weights` array obtained from them refer to it anymore. "
+  "Mapped files must not be overwritten in place; write a new file and rename it over the old one instead."
+);
+static PyObject* PyBobLearnLinearMachine_getIsMapped
+(PyBobLearnLinearMachineObject* self, void* /*closure*/) {
+BOB_TRY
+  if (self->cxx->isMapped()) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+BOB_CATCH_MEMBER("is_mapped", 0)
+}
+
 static auto activation = bob::extension::VariableDoc(
   "activation",
   ":py:class:`bob.learn.activation.Activation` or one of its derivatives",
@@ -447,6 +504,13 @@ static PyGetSetDef PyBobLearnLinearMachine_getseters[] = {
       activation.doc(),
       0
     },
+    {
+      is_mapped.name(),
+      (getter)PyBobLearnLinearMachine_getIsMapped,
+      0,
+      is_mapped.doc(),
+      0
+    },
     {0}  /* Sentinel */
 };
 
@@ -568,6 +632,54 @@ PyObject* PyBobLearnLinearMachine_Str(PyBobLearnLinearMachineObject* self) {
 
 }
 
+/**
+ * Returns true if the given object looks like a sparse matrix in the CSR
+ * format, i.e., has the ``indptr`` attribute of a scipy.sparse.csr_matrix
+ */
+bool PyBobLearnLinear_IsCSRMatrix(PyObject* o) {
+  return PyObject_HasAttrString(o, "indptr");
+}
+
+/**
+ * Refers to the ``data``, ``indices``, ``indptr`` and ``shape`` of the given
+ * sparse matrix in the CSR format, such as a scipy.sparse.csr_matrix. The
+ * values are not copied, unless they need to be converted to 64-bit floats
+ * and the indices to 64-bit integers; the arrays that the matrix refers to
+ * are appended to ``keep``, which needs to live as long as the matrix.
+ * Returns an empty pointer and sets a Python exception on errors.
+ */
+boost::shared_ptr<bob::learn::linear::CSRMatrix> PyBobLearnLinear_AsCSRMatrix(PyObject* o, std::vector<boost::shared_ptr<PyObject> >& keep) {
+  boost::shared_ptr<bob::learn::linear::CSRMatrix> matrix;
+
+  auto shape = make_xsafe(PyObject_GetAttrString(o, "shape"));
+  if (!shape) return matrix;
+  Py_ssize_t rows, columns;
+  if (!PyArg_ParseTuple(shape.get(), "nn", &rows, &columns)) return matrix;
+
+  const char* names[] = {"data", "indices", "indptr"};
+  const int types[] = {NPY_FLOAT64, NPY_INT64, NPY_INT64};
+  PyArrayObject* arrays[3];
+  for (int k = 0; k < 3; ++k) {
+    auto attribute = make_xsafe(PyObject_GetAttrString(o, names[k]));
+    if (!attribute) return matrix;
+    PyObject* array = PyArray_FROMANY(attribute.get(), types[k], 1, 1, NPY_ARRAY_CARRAY_RO);
+    if (!array) return matrix;
+    keep.push_back(make_safe(array));
+    arrays[k] = reinterpret_cast<PyArrayObject*>(array);
+  }
+
+  if (PyArray_DIM(arrays[2], 0) != rows + 1) {
+    PyErr_Format(PyExc_RuntimeError, "sparse matrix of shape (%" PY_FORMAT_SIZE_T "d, %" PY_FORMAT_SIZE_T "d) should have %" PY_FORMAT_SIZE_T "d row offsets in `indptr', not %" PY_FORMAT_SIZE_T "d", rows, columns, rows + 1, PyArray_DIM(arrays[2], 0));
+    return matrix;
+  }
+
+  blitz::Array<double,1> data(static_cast<double*>(PyArray_DATA(arrays[0])), blitz::shape(PyArray_DIM(arrays[0], 0)), blitz::neverDeleteData);
+  blitz::Array<int64_t,1> indices(static_cast<int64_t*>(PyArray_DATA(arrays[1])), blitz::shape(PyArray_DIM(arrays[1], 0)), blitz::neverDeleteData);
+  blitz::Array<int64_t,1> indptr(static_cast<int64_t*>(PyArray_DATA(arrays[2])), blitz::shape(PyArray_DIM(arrays[2], 0)), blitz::neverDeleteData);
+  matrix.reset(new bob::learn::linear::CSRMatrix(data, indices, indptr, columns));
+  return matrix;
+}
+
 static auto forward = bob::extension::FunctionDoc(
   "forward",
   "Projects ``input`` through its internal weights and biases",
@@ -575,11 +687,12 @@ static auto forward = bob::extension::FunctionDoc(
   "If one provides a 1D array, the ``output`` array, if provided, should also be 1D, matching the output size of this machine. "
   "If one provides a 2D array, it is considered a set of vertically stacked 1D arrays (one input per row) and a 2D array is produced or expected in ``output``. "
   "The ``output`` array in this case shall have the same number of rows as the ``input`` array and as many columns as the output size for this machine.\n\n"
+  "The ``input`` can also be a sparse matrix in the compressed sparse row format, such as a :py:class:`scipy.sparse.csr_matrix`, with one input per row; it is processed as the equivalent 2D array, but only the stored values are visited and the input is never converted into a dense array.\n\n"
   ".. note:: The ``__call__`` method is an alias for this method.",
   true
 )
 .add_prototype("input, [output]", "output")
-.add_parameter("input", "array_like(1D or 2D, float)", "The array that should be projected; must be compatible with :py:attr:`shape` [0]")
+.add_parameter("input", "array_like(1D or 2D, float) or sparse matrix", "The array that should be projected; must be compatible with :py:attr:`shape` [0]")
 .add_parameter("output", "array_like(1D or 2D, float)", "The output array that will be filled. If given, must be compatible with ``input`` and :py:attr:`shape` [1]")
 .add_return("output", "array_like(1D or 2D, float)", "The projected data; identical to the ``output`` parameter, if given")
 ;
@@ -588,25 +701,48 @@ static PyObject* PyBobLearnLinearMachine_forward
 BOB_TRY
   char** kwlist = forward.kwlist();
 
-  PyBlitzArrayObject* input = 0;
+  PyObject* input_object = 0;
   PyBlitzArrayObject* output = 0;
 
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|O&", kwlist,
-        &PyBlitzArray_Converter, &input,
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O&", kwlist,
+        &input_object,
         &PyBlitzArray_OutputConverter, &output
         )) return 0;
 
-  //protects acquired resources through this scope
-  auto input_ = make_safe(input);
   auto output_ = make_xsafe(output);
 
-  if (input->type_num != NPY_FLOAT64) {
-    PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit float arrays for input array `input'", Py_TYPE(self)->tp_name);
+  if (output && output->type_num != NPY_FLOAT64) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit float arrays for output array `output'", Py_TYPE(self)->tp_name);
     return 0;
   }
 
-  if (output && output->type_num != NPY_FLOAT64) {
-    PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit float arrays for output array `output'", Py_TYPE(self)->tp_name);
+  /** sparse matrices are projected row by row, without densifying them **/
+  if (PyBobLearnLinear_IsCSRMatrix(input_object)) {
+    std::vector<boost::shared_ptr<PyObject> > keep;
+    auto input = PyBobLearnLinear_AsCSRMatrix(input_object, keep);
+    if (!input) return 0;
+    if (output && output->ndim != 2) {
+      PyErr_Format(PyExc_RuntimeError, "`output' array should be 2D for a sparse `input' matrix, not %" PY_FORMAT_SIZE_T "dD", output->ndim);
+      return 0;
+    }
+    if (!output) {
+      Py_ssize_t osize[2] = {(Py_ssize_t)input->rows(), (Py_ssize_t)self->cxx->outputSize()};
+      output = (PyBlitzArrayObject*)PyBlitzArray_SimpleNew(NPY_FLOAT64, 2, osize);
+      output_ = make_safe(output);
+    }
+    self->cxx->forward(*input, *PyBlitzArrayCxx_AsBlitz<double,2>(output));
+    Py_INCREF(output);
+    return PyBlitzArray_NUMPY_WRAP(reinterpret_cast<PyObject*>(output));
+  }
+
+  PyBlitzArrayObject* input = 0;
+  if (!PyBlitzArray_Converter(input_object, &input)) return 0;
+
+  //protects acquired resources through this scope
+  auto input_ = make_safe(input);
+
+  if (input->type_num != NPY_FLOAT64) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit float arrays for input array `input'", Py_TYPE(self)->tp_name);
     return 0;
   }
 
@@ -682,20 +818,26 @@ BOB_CATCH_MEMBER("forward", 0)
 static auto load = bob::extension::FunctionDoc(
   "load",
   "Loads the machine from the given HDF5 file",
-  0,
+  "If ``mmap`` is set, the :py:attr:`weights` are memory-mapped read-only from the file instead of being read, so that loading large machines is almost instantaneous and the memory pages are shared between all processes that map the same file. "
+  "This requires the weights to be stored contiguously and uncompressed, which is the case for files written by :py:meth:`save`; otherwise, a warning is logged and the weights are read as usual, see :py:attr:`is_mapped`.\n\n"
+  ".. note::\n\n"
+  "   The mapping is released once no machine and no :py:attr:`weights` array refers to it anymore. "
+  "The file must not be overwritten in place while it is mapped, which changes or invalidates the weights of loaded machines; write a new file and rename it over the old one instead.",
   true
 )
-.add_prototype("hdf5")
+.add_prototype("hdf5, [mmap]")
 .add_parameter("hdf5", ":py:class:`bob.io.base.HDF5File`", "An HDF5 file opened for reading")
+.add_parameter("mmap", "bool", "[Default: ``False``] Memory-map the weights from the file?")
 ;
 static PyObject* PyBobLearnLinearMachine_Load(PyBobLearnLinearMachineObject* self, PyObject* args, PyObject* kwargs) {
 BOB_TRY
   char** kwlist = load.kwlist();
   PyBobIoHDF5FileObject* file;
-  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&", kwlist, PyBobIoHDF5File_Converter, &file)) return 0;
+  PyObject* mmap = 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&|O", kwlist, PyBobIoHDF5File_Converter, &file, &mmap)) return 0;
 
   auto file_ = make_safe(file);
-  self->cxx->load(*file->f);
+  self->cxx->load(*file->f, mmap && PyObject_IsTrue(mmap));
   Py_RETURN_NONE;
 BOB_CATCH_MEMBER("load", 0)
 }
@@ -788,6 +930,171 @@ BOB_TRY
 BOB_CATCH_MEMBER("resize", 0)
 }
 
+/**
+ * Wraps the given numpy array (whose reference is stolen) into a
+ * pickle.PickleBuffer for pickle protocol 5 or higher, so that the data can
+ * be transferred out-of-band without being copied. The array is only copied
+ * if it is not C-contiguous.
+ */
+static PyObject* pickle_numpy(PyObject* array, int protocol) {
+  auto numpy = make_xsafe(array);
+  if (!numpy) return 0;
+  if (!PyArray_IS_C_CONTIGUOUS(reinterpret_cast<PyArrayObject*>(numpy.get())))
+    return PyArray_NewCopy(reinterpret_cast<PyArrayObject*>(numpy.get()), NPY_CORDER);
+#if PY_VERSION_HEX >= 0x03080000
+  if (protocol >= 5) return PyPickleBuffer_FromObject(numpy.get());
+#endif
+  Py_INCREF(numpy.get());
+  return numpy.get();
+}
+
+template <int N>
+static PyObject* pickle_array(const blitz::Array<double,N>& array, int protocol) {
+  return pickle_numpy(PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(array)), protocol);
+}
+
+PyObject* PyBobLearnLinear_PickleArray(const blitz::Array<double,1>& array, int protocol) {
+  return pickle_array(array, protocol);
+}
+
+PyObject* PyBobLearnLinear_PickleArray(const blitz::Array<double,2>& array, int protocol) {
+  return pickle_array(array, protocol);
+}
+
+/**
+ * Copies the data of the given object, which supports the buffer protocol
+ * (e.g., a numpy array, or the buffer that replaces a pickle.PickleBuffer
+ * when unpickling), into the given, already allocated array. Returns false
+ * and sets a Python exception if the data cannot be read or its size does
+ * not match.
+ */
+template <int N>
+static bool unpickle_array(PyObject* buffer, blitz::Array<double,N>& array, const char* name) {
+  Py_buffer view;
+  if (PyObject_GetBuffer(buffer, &view, PyBUF_C_CONTIGUOUS) < 0) return false;
+  const Py_ssize_t expected = array.size() * sizeof(double);
+  const bool ok = view.len == expected;
+  if (ok) std::memcpy(array.data(), view.buf, expected);
+  else PyErr_Format(PyExc_ValueError, "the pickled array `%s' has %" PY_FORMAT_SIZE_T "d bytes, but %" PY_FORMAT_SIZE_T "d bytes were expected", name, view.len, expected);
+  PyBuffer_Release(&view);
+  return ok;
+}
+
+bool PyBobLearnLinear_UnpickleArray(PyObject* buffer, blitz::Array<double,1>& array, const char* name) {
+  return unpickle_array(buffer, array, name);
+}
+
+bool PyBobLearnLinear_UnpickleArray(PyObject* buffer, blitz::Array<double,2>& array, const char* name) {
+  return unpickle_array(buffer, array, name);
+}
+
+static auto reduce_ex = bob::extension::FunctionDoc(
+  "__reduce_ex__",
+  "Prepares the machine for pickling",
+  "The state of the machine consists of its :py:attr:`shape`, the :py:attr:`weights`, :py:attr:`biases`, :py:attr:`input_subtract` and :py:attr:`input_divide` arrays, the :py:attr:`activation` and the attributes of derived Python classes. "
+  "With pickle protocol 5 or higher, the arrays are handed to :py:mod:`pickle` as :py:class:`pickle.PickleBuffer` objects that refer to the memory of this machine, so that they can be transferred out-of-band without being copied, e.g., by :py:mod:`multiprocessing` or Dask. "
+  "When unpickling, :py:meth:`__setstate__` copies the data once into memory owned by the new machine.",
+  true
+)
+.add_prototype("protocol", "reduced")
+.add_parameter("protocol", "int", "The pickle protocol")
+.add_return("reduced", "tuple", "The class of this machine, the (empty) arguments of its constructor and its state")
+;
+static PyObject* PyBobLearnLinearMachine_ReduceEx
+(PyBobLearnLinearMachineObject* self, PyObject* args, PyObject* kwds) {
+BOB_TRY
+  /* Parses input arguments in a single shot */
+  char** kwlist = reduce_ex.kwlist();
+
+  int protocol;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "i", kwlist, &protocol)) return 0;
+
+  // memory-mapped weights stay mapped as long as pickle refers to them
+  auto weights = make_xsafe(pickle_numpy(weights_array(*self->cxx), protocol));
+  auto biases = make_xsafe(PyBobLearnLinear_PickleArray(self->cxx->getBiases(), protocol));
+  auto input_sub = make_xsafe(PyBobLearnLinear_PickleArray(self->cxx->getInputSubtraction(), protocol));
+  auto input_div = make_xsafe(PyBobLearnLinear_PickleArray(self->cxx->getInputDivision(), protocol));
+  if (!weights || !biases || !input_sub || !input_div) return 0;
+  auto activation = make_xsafe(PyBobLearnLinearMachine_getActivation(self, 0));
+  if (!activation) return 0;
+
+  // attributes of derived Python classes, if any
+  PyObject* dict = PyObject_GetAttrString(reinterpret_cast<PyObject*>(self), "__dict__");
+  if (!dict) {
+    PyErr_Clear();
+    Py_INCREF(Py_None);
+    dict = Py_None;
+  }
+  auto dict_ = make_safe(dict);
+
+  // machines returned by the trainers are unpickled as instances of the
+  // bob.learn.linear.Machine class, which pickle can find by name
+  PyObject* type = reinterpret_cast<PyObject*>(Py_TYPE(self));
+  if (Py_TYPE(self) == &PyBobLearnLinearMachine_Type) {
+    auto module = make_xsafe(PyImport_ImportModule(BOB_EXT_MODULE_PREFIX));
+    if (!module) return 0;
+    type = PyObject_GetAttrString(module.get(), "Machine");
+  }
+  else Py_INCREF(type);
+  if (!type) return 0;
+  auto type_ = make_safe(type);
+
+  return Py_BuildValue("O()(nnOOOOOO)", type,
+      (Py_ssize_t)self->cxx->inputSize(), (Py_ssize_t)self->cxx->outputSize(),
+      weights.get(), biases.get(), input_sub.get(), input_div.get(),
+      activation.get(), dict);
+BOB_CATCH_MEMBER("__reduce_ex__", 0)
+}
+
+static auto setstate = bob::extension::FunctionDoc(
+  "__setstate__",
+  "Restores the machine from the state that was pickled by :py:meth:`__reduce_ex__`",
+  0,
+  true
+)
+.add_prototype("state")
+.add_parameter("state", "tuple", "The state of the machine")
+;
+static PyObject* PyBobLearnLinearMachine_SetState
+(PyBobLearnLinearMachineObject* self, PyObject* state) {
+BOB_TRY
+  Py_ssize_t input, output;
+  PyObject* weights,* biases,* input_sub,* input_div,* activation,* dict;
+
+  if (!PyArg_ParseTuple(state, "nnOOOOOO:__setstate__", &input, &output,
+        &weights, &biases, &input_sub, &input_div, &activation, &dict)) return 0;
+
+  if (!PyBobLearnActivation_Check(activation)) {
+    PyErr_Format(PyExc_TypeError, "`%s' requires an object of type `Activation' in the pickled state, not `%s'", Py_TYPE(self)->tp_name, Py_TYPE(activation)->tp_name);
+    return 0;
+  }
+
+  blitz::Array<double,2> weights_(input, output);
+  blitz::Array<double,1> biases_(output), input_sub_(input), input_div_(input);
+  if (!PyBobLearnLinear_UnpickleArray(weights, weights_, "weights") ||
+      !PyBobLearnLinear_UnpickleArray(biases, biases_, "biases") ||
+      !PyBobLearnLinear_UnpickleArray(input_sub, input_sub_, "input_subtract") ||
+      !PyBobLearnLinear_UnpickleArray(input_div, input_div_, "input_divide")) return 0;
+
+  // the arrays are handed over to the machine without further copies
+  if (!self->cxx) self->cxx = new bob::learn::linear::Machine(input, output);
+  else self->cxx->resize(input, output);
+  self->cxx->setWeights(std::move(weights_));
+  self->cxx->setBiases(std::move(biases_));
+  self->cxx->setInputSubtraction(std::move(input_sub_));
+  self->cxx->setInputDivision(std::move(input_div_));
+  self->cxx->setActivation(reinterpret_cast<PyBobLearnActivationObject*>(activation)->cxx);
+
+  if (dict != Py_None) {
+    auto self_dict = make_xsafe(PyObject_GetAttrString(reinterpret_cast<PyObject*>(self), "__dict__"));
+    if (!self_dict || PyDict_Update(self_dict.get(), dict) < 0) return 0;
+  }
+
+  Py_RETURN_NONE;
+BOB_CATCH_MEMBER("__setstate__", 0)
+}
+
 static PyMethodDef PyBobLearnLinearMachine_methods[] = {
   {
     forward.name(),
@@ -819,6 +1126,18 @@ static PyMethodDef PyBobLearnLinearMachine_methods[] = {
     METH_VARARGS|METH_KEYWORDS,
     resize.doc()
   },
+  {
+    reduce_ex.name(),
+    (PyCFunction)PyBobLearnLinearMachine_ReduceEx,
+    METH_VARARGS|METH_KEYWORDS,
+    reduce_ex.doc()
+  },
+  {
+    setstate.name(),
+    (PyCFunction)PyBobLearnLinearMachine_SetState,
+    METH_O,
+    setstate.doc()
+  },
   {0} /* Sentinel */
 };
 
@@ -43,6 +43,11 @@ extern bool init_BobLearnLinearCGLogReg(PyObject* module);
 extern bool init_BobLearnLinearWCCN(PyObject* module);
 extern bool init_BobLearnLinearWhitening(PyObject* module);
 extern bool init_BobLearnLinearBIC(PyObject* module);
+extern bool init_BobLearnLinearGFK(PyObject* module);
+extern bool init_BobLearnLinearScatter(PyObject* module);
+extern bool init_BobLearnLinearBundle(PyObject* module);
+extern bool init_BobLearnLinearCrossValidation(PyObject* module);
+extern bool init_BobLearnLinearQuantized(PyObject* module);
 
 static PyObject* create_module (void) {
 
@@ -64,6 +69,11 @@ static PyObject* create_module (void) {
   if (!init_BobLearnLinearWCCN(module)) return 0;
   if (!init_BobLearnLinearWhitening(module)) return 0;
   if (!init_BobLearnLinearBIC(module)) return 0;
+  if (!init_BobLearnLinearGFK(module)) return 0;
+  if (!init_BobLearnLinearScatter(module)) return 0;
+  if (!init_BobLearnLinearBundle(module)) return 0;
+  if (!init_BobLearnLinearCrossValidation(module)) return 0;
+  if (!init_BobLearnLinearQuantized(module)) return 0;
   static void* PyBobLearnLinear_API[PyBobLearnLinear_API_pointers];
 
   /* exhaustive list of C APIs */
@@ -124,6 +134,54 @@ static PyObject* create_module (void) {
 
   PyBobLearnLinear_API[PyBobLearnLinearWCCNTrainer_Check_NUM] = (void *)&PyBobLearnLinearWCCNTrainer_Check;
 
+  /**********************************************
+   * Bindings for bob.learn.linear.GFKMachine *
+   **********************************************/
+
+  PyBobLearnLinear_API[PyBobLearnLinearGFKMachine_Type_NUM] = (void *)&PyBobLearnLinearGFKMachine_Type;
+
+  PyBobLearnLinear_API[PyBobLearnLinearGFKMachine_Check_NUM] = (void *)&PyBobLearnLinearGFKMachine_Check;
+
+  /**********************************************
+   * Bindings for bob.learn.linear.GFKTrainer *
+   **********************************************/
+
+  PyBobLearnLinear_API[PyBobLearnLinearGFKTrainer_Type_NUM] = (void *)&PyBobLearnLinearGFKTrainer_Type;
+
+  PyBobLearnLinear_API[PyBobLearnLinearGFKTrainer_Check_NUM] = (void *)&PyBobLearnLinearGFKTrainer_Check;
+
+  /******************************************************
+   * Bindings for bob.learn.linear.ScatterAccumulator *
+   ******************************************************/
+
+  PyBobLearnLinear_API[PyBobLearnLinearScatterAccumulator_Type_NUM] = (void *)&PyBobLearnLinearScatterAccumulator_Type;
+
+  PyBobLearnLinear_API[PyBobLearnLinearScatterAccumulator_Check_NUM] = (void *)&PyBobLearnLinearScatterAccumulator_Check;
+
+  /*********************************************************
+   * Bindings for bob.learn.linear.MiniBatchLogRegTrainer *
+   *********************************************************/
+
+  PyBobLearnLinear_API[PyBobLearnLinearMiniBatchLogRegTrainer_Type_NUM] = (void *)&PyBobLearnLinearMiniBatchLogRegTrainer_Type;
+
+  PyBobLearnLinear_API[PyBobLearnLinearMiniBatchLogRegTrainer_Check_NUM] = (void *)&PyBobLearnLinearMiniBatchLogRegTrainer_Check;
+
+  /***********************************************************
+   * Bindings for bob.learn.linear.MultinomialLogRegTrainer *
+   ***********************************************************/
+
+  PyBobLearnLinear_API[PyBobLearnLinearMultinomialLogRegTrainer_Type_NUM] = (void *)&PyBobLearnLinearMultinomialLogRegTrainer_Type;
+
+  PyBobLearnLinear_API[PyBobLearnLinearMultinomialLogRegTrainer_Check_NUM] = (void *)&PyBobLearnLinearMultinomialLogRegTrainer_Check;
+
+  /***************************************************
+   * Bindings for bob.learn.linear.QuantizedMachine *
+   ***************************************************/
+
+  PyBobLearnLinear_API[PyBobLearnLinearQuantizedMachine_Type_NUM] = (void *)&PyBobLearnLinearQuantizedMachine_Type;
+
+  PyBobLearnLinear_API[PyBobLearnLinearQuantizedMachine_Check_NUM] = (void *)&PyBobLearnLinearQuantizedMachine_Check;
+
 #if PY_VERSION_HEX >= 0x02070000
 
   /* defines the PyCapsule */
@@ -11,9 +11,31 @@
 #include <bob.blitz/cppapi.h>
 #include <bob.blitz/cleanup.h>
 #include <bob.learn.linear/api.h>
+#include <boost/make_shared.hpp>
 #include <bob.extension/documentation.h>
 #include <structmember.h>
 
+/**
+ * Converts the given training statistics into a list of dictionaries, or
+ * returns None if no statistics are collected; used by all trainers
+ */
+PyObject* PyBobLearnLinear_TrainingStats(const boost::shared_ptr<bob::learn::linear::TrainingStats>& stats) {
+  if (!stats) Py_RETURN_NONE;
+
+  const std::vector<bob::learn::linear::TrainingStats::Phase>& phases = stats->phases();
+  PyObject* retval = PyList_New(phases.size());
+  if (!retval) return 0;
+  auto retval_ = make_safe(retval);
+  for (size_t i = 0; i < phases.size(); ++i) {
+    PyObject* phase = Py_BuildValue("{s:s,s:d,s:n}", "phase", phases[i].name.c_str(),
+        "seconds", phases[i].seconds, "estimated_bytes", (Py_ssize_t)phases[i].estimated_bytes);
+    if (!phase) return 0;
+    PyList_SET_ITEM(retval, i, phase);
+  }
+  Py_INCREF(retval);
+  return retval;
+}
+
 /*******************************************
  * Implementation of PCATrainer base class *
  *******************************************/
@@ -172,14 +194,19 @@ static auto train = bob::extension::FunctionDoc(
   "The vectors are arranged by decreasing eigen-value automatically -- there is no need to sort the results.\n\n"
   "The user may provide or not an object of type :py:class:`bob.learn.linear.Machine` that will be set by this method. "
   "If provided, machine should have the correct number of inputs and outputs matching, respectively, the number of columns in the input data array ``X`` and the output of the method :py:meth:`output_size`.\n\n"
-  "The input data matrix ``X`` should correspond to a 64-bit floating point array organized in such a way that every row corresponds to a new observation of the phenomena (i.e., a new sample) and every column corresponds to a different feature.\n\n"
+  "The input data matrix ``X`` should correspond to a 64-bit floating point array organized in such a way that every row corresponds to a new observation of the phenomena (i.e., a new sample) and every column corresponds to a different feature. "
+  "Instead of the data, the statistics accumulated on it in a :py:class:`bob.learn.linear.ScatterAccumulator` can be given, e.g., after merging the statistics of several parts of the data. "
+  "In this case, the covariance method is used, independently of :py:attr:`use_svd`.\n\n"
+  "Optionally, each row of ``X`` can be weighted with a non-negative frequency ``weight``, as if the row was repeated accordingly, e.g., to balance the data without copying it. "
+  "The covariance matrix is then normalized by the sum of the weights minus one.\n\n"
   "This method returns a tuple consisting of the trained machine and a 1D 64-bit floating point array containing the eigen-values calculated while computing the KLT. "
   "The eigen-value ordering matches that of eigen-vectors set in the machine.",
   true
 )
-.add_prototype("X, [machine]", "machine, eigen_values")
-.add_parameter("X", "array_like(2D, floats)", "The input data to train on")
+.add_prototype("X, [machine], [weights]", "machine, eigen_values")
+.add_parameter("X", "array_like(2D, floats) or :py:class:`bob.learn.linear.ScatterAccumulator`", "The input data to train on, or the statistics accumulated on it")
 .add_parameter("machine", ":py:class:`bob.learn.linear.Machine`", "The machine to be trained; this machine will be returned by this function")
+.add_parameter("weights", "array_like(1D, floats)", "[optional] The frequency weights of the rows of ``X``")
 .add_return("machine", ":py:class:`bob.learn.linear.Machine`", "The machine that has been trained; if given, identical to the ``machine`` parameter")
 .add_return("eigen_values", "array_like(1D, floats)", "The eigen-values of the PCA projection.")
 ;
@@ -189,39 +216,67 @@ BOB_TRY
   /* Parses input arguments in a single shot */
   char** kwlist = train.kwlist();
 
-  PyBlitzArrayObject* X = 0;
+  PyObject* X = 0;
   PyObject* machine = 0;
+  PyBlitzArrayObject* weights = 0;
 
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|O!", kwlist,
-        &PyBlitzArray_Converter, &X,
-        &PyBobLearnLinearMachine_Type, &machine
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O!O&", kwlist,
+        &X,
+        &PyBobLearnLinearMachine_Type, &machine,
+        &PyBlitzArray_Converter, &weights
         ))
     return 0;
 
-  auto X_ = make_safe(X); ///< auto-delete in case of problems
+  auto weights_ = make_xsafe(weights); ///< auto-delete in case of problems
 
-  if (X->ndim != 2 || X->type_num != NPY_FLOAT64) {
+  // the data is either given as accumulated statistics or as a 2D array
+  bob::learn::linear::ScatterAccumulator* stats = 0;
+  PyBlitzArrayObject* data = 0;
+  if (PyBobLearnLinearScatterAccumulator_Check(X)) {
+    stats = reinterpret_cast<PyBobLearnLinearScatterAccumulatorObject*>(X)->cxx.get();
+  }
+  else if (!PyBlitzArray_Converter(X, &data)) return 0;
+  auto data_ = make_xsafe(data); ///< auto-delete in case of problems
+
+  if (data && (data->ndim != 2 || data->type_num != NPY_FLOAT64)) {
     PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for input array `X'", Py_TYPE(self)->tp_name);
     return 0;
   }
+  if (weights && stats) {
+    PyErr_Format(PyExc_TypeError, "`%s' cannot apply `weights' to accumulated statistics; weight the samples when accumulating them instead", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+  if (weights && (weights->ndim != 1 || weights->type_num != NPY_FLOAT64)) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 1D 64-bit float arrays for `weights'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
 
   // evaluates the expected rank for the output, allocate eigens value array
-  auto X_bz = PyBlitzArrayCxx_AsBlitz<double,2>(X);
-  Py_ssize_t rank = self->cxx->output_size(*X_bz);
+  Py_ssize_t rank, n_features;
+  if (stats) {
+    rank = self->cxx->output_size(*stats);
+    n_features = stats->numberOfFeatures();
+  } else {
+    auto data_bz = PyBlitzArrayCxx_AsBlitz<double,2>(data);
+    rank = self->cxx->output_size(*data_bz);
+    n_features = data_bz->extent(1);
+  }
   auto eigval = reinterpret_cast<PyBlitzArrayObject*>(PyBlitzArray_SimpleNew(NPY_FLOAT64, 1, &rank));
   auto eigval_ = make_safe(eigval); ///< auto-delete in case of problems
 
   // allocates a new machine if that was not given by the user
   boost::shared_ptr<PyObject> machine_;
   if (!machine) {
-    machine = PyBobLearnLinearMachine_NewFromSize(X_bz->extent(1), rank);
+    machine = PyBobLearnLinearMachine_NewFromSize(n_features, rank);
     machine_ = make_safe(machine); ///< auto-delete in case of problems
   }
 
   auto pymac = reinterpret_cast<PyBobLearnLinearMachineObject*>(machine);
 
   auto eigval_bz = PyBlitzArrayCxx_AsBlitz<double,1>(eigval);
-  self->cxx->train(*pymac->cxx, *eigval_bz, *X_bz);
+  if (stats) self->cxx->train(*pymac->cxx, *eigval_bz, *stats);
+  else if (weights) self->cxx->train(*pymac->cxx, *eigval_bz, *PyBlitzArrayCxx_AsBlitz<double,2>(data), *PyBlitzArrayCxx_AsBlitz<double,1>(weights));
+  else self->cxx->train(*pymac->cxx, *eigval_bz, *PyBlitzArrayCxx_AsBlitz<double,2>(data));
 
   // all went fine, pack machine and eigen-values to return
   return Py_BuildValue("ON", machine, PyBlitzArray_AsNumpyArray(eigval, 0));
@@ -237,7 +292,7 @@ static auto output_size = bob::extension::FunctionDoc(
   true
 )
 .add_prototype("X","size")
-.add_parameter("X", "array_like(2D, floats)", "The input data that should be trained on")
+.add_parameter("X", "array_like(2D, floats) or :py:class:`bob.learn.linear.ScatterAccumulator`", "The input data that should be trained on, or the statistics accumulated on it")
 .add_return("size", "int", "The number of eigen-vectors/values that will be created in a call to :py:meth:`train`, given the same input data ``X``")
 ;
 static PyObject* PyBobLearnLinearPCATrainer_OutputSize
@@ -246,22 +301,28 @@ BOB_TRY
   /* Parses input arguments in a single shot */
   char** kwlist = output_size.kwlist();
 
-  PyBlitzArrayObject* X = 0;
+  PyObject* X = 0;
 
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&", kwlist,
-        &PyBlitzArray_Converter, &X)) return 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", kwlist, &X)) return 0;
 
-  auto X_ = make_safe(X); ///< auto-delete in case of problems
+  if (PyBobLearnLinearScatterAccumulator_Check(X)) {
+    auto stats = reinterpret_cast<PyBobLearnLinearScatterAccumulatorObject*>(X);
+    return Py_BuildValue("n", self->cxx->output_size(*stats->cxx));
+  }
 
-  if (X->ndim != 2 || X->type_num != NPY_FLOAT64) {
+  PyBlitzArrayObject* data = 0;
+  if (!PyBlitzArray_Converter(X, &data)) return 0;
+  auto data_ = make_safe(data); ///< auto-delete in case of problems
+
+  if (data->ndim != 2 || data->type_num != NPY_FLOAT64) {
     PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for input array `X'", Py_TYPE(self)->tp_name);
     return 0;
   }
 
   // evaluates the expected rank for the output, allocate eigens value array
-  auto X_bz = PyBlitzArrayCxx_AsBlitz<double,2>(X);
+  auto data_bz = PyBlitzArrayCxx_AsBlitz<double,2>(data);
 
-  return Py_BuildValue("n", self->cxx->output_size(*X_bz));
+  return Py_BuildValue("n", self->cxx->output_size(*data_bz));
 BOB_CATCH_MEMBER("output_size", 0)
 }
 
@@ -332,6 +393,49 @@ BOB_TRY
 BOB_CATCH_MEMBER("safe_svd", -1)
 }
 
+static auto collect_stats = bob::extension::VariableDoc(
+  "collect_stats",
+  "bool",
+  "Collect timing statistics of the trainings?",
+  "If enabled, each call to :py:meth:`train` records the wall time and the estimated size of the arrays of its phases in :py:attr:`stats`. "
+  "The statistics are shared by all calls, so that the trainer must not be used by several threads at once while they are collected. "
+  "By default, no statistics are collected."
+);
+static PyObject* PyBobLearnLinearPCATrainer_getCollectStats
+(PyBobLearnLinearPCATrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  if (self->cxx->getStats()) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+BOB_CATCH_MEMBER("collect_stats", 0)
+}
+
+static int PyBobLearnLinearPCATrainer_setCollectStats
+(PyBobLearnLinearPCATrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  int istrue = PyObject_IsTrue(o);
+
+  if (istrue == -1) return -1;
+  if (!istrue) self->cxx->setStats(boost::shared_ptr<bob::learn::linear::TrainingStats>());
+  else if (!self->cxx->getStats()) self->cxx->setStats(boost::make_shared<bob::learn::linear::TrainingStats>());
+  return 0;
+BOB_CATCH_MEMBER("collect_stats", -1)
+}
+
+static auto stats = bob::extension::VariableDoc(
+  "stats",
+  "[dict] or None",
+  "The timing statistics of the last training",
+  "A list with one dictionary per phase of the last call to :py:meth:`train`, in the order of execution, i.e., ``scatter``, ``decomposition``, ``truncation`` (if any) and ``machine update``. "
+  "Each dictionary contains the ``phase`` name, its wall time in ``seconds`` and the size of the arrays that the trainer allocated in the phase in ``estimated_bytes``, as computed from their shapes; this is not a measurement of the memory of the process, e.g., memory allocated inside LAPACK is not included. "
+  "``None`` if :py:attr:`collect_stats` is disabled."
+);
+static PyObject* PyBobLearnLinearPCATrainer_getStats
+(PyBobLearnLinearPCATrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return PyBobLearnLinear_TrainingStats(self->cxx->getStats());
+BOB_CATCH_MEMBER("stats", 0)
+}
+
 static PyGetSetDef PyBobLearnLinearPCATrainer_getseters[] = {
     {
       use_svd.name(),
@@ -347,6 +451,20 @@ static PyGetSetDef PyBobLearnLinearPCATrainer_getseters[] = {
       safe_svd.doc(),
       0
     },
+    {
+      collect_stats.name(),
+      (getter)PyBobLearnLinearPCATrainer_getCollectStats,
+      (setter)PyBobLearnLinearPCATrainer_setCollectStats,
+      collect_stats.doc(),
+      0
+    },
+    {
+      stats.name(),
+      (getter)PyBobLearnLinearPCATrainer_getStats,
+      0,
+      stats.doc(),
+      0
+    },
     {0}  /* Sentinel */
 };
 
@@ -0,0 +1,476 @@
+/**
+ * @date Sun Oct 18 19:05:12 CEST 2026
+ *
+ * @brief Python bindings to the linear machine with 8-bit integer weights
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#define BOB_LEARN_LINEAR_MODULE
+#include <bob.blitz/cppapi.h>
+#include <bob.blitz/cleanup.h>
+#include <bob.io.base/api.h>
+#include <bob.learn.activation/api.h>
+#include <bob.learn.linear/api.h>
+#include <bob.learn.linear/quantized.h>
+#include <bob.extension/documentation.h>
+
+/******************************************************************/
+/************ Constructor Section *********************************/
+/******************************************************************/
+
+static auto QuantizedMachine_doc = bob::extension::ClassDoc(
+  BOB_EXT_MODULE_PREFIX ".QuantizedMachine",
+  "A read-only copy of a trained :py:class:`bob.learn.linear.Machine` with 8-bit integer weights",
+  "The weights of each output :math:`j` are scaled with :math:`s_j = \\max_k |W_{kj}| / 127` and rounded to 8-bit integers, so that the weights take 8 times less memory than in the :py:class:`bob.learn.linear.Machine`. "
+  "At projection time, each normalized input :math:`x' = (x - \\mathrm{input\\_subtract}) / \\mathrm{input\\_divide}` is quantized the same way with its own scale :math:`s_x = \\max_k |x'_k| / 127`, hence no calibration data is required. "
+  "The outputs are computed from integer dot products as :math:`f(s_x s_j \\sum_k q_{x,k} q_{kj} + b_j)`, where :math:`f` is the :py:attr:`activation`.\n\n"
+  "The error of the outputs is in the order of 1/127 of the largest output, and can be measured on a set of samples with :py:meth:`accuracy`. "
+  "Quantized machines can be written to and read from HDF5 files (:py:meth:`save`, :py:meth:`load`); the file layout differs from the one of the :py:class:`bob.learn.linear.Machine`."
+).add_constructor(
+  bob::extension::FunctionDoc(
+    "__init__",
+    "Quantizes a machine, or copies or loads a quantized machine",
+    0,
+    true
+  )
+  .add_prototype("machine", "")
+  .add_prototype("other", "")
+  .add_prototype("hdf5", "")
+  .add_parameter("machine", ":py:class:`bob.learn.linear.Machine`", "The trained machine to quantize")
+  .add_parameter("other", ":py:class:`bob.learn.linear.QuantizedMachine`", "Another quantized machine to copy")
+  .add_parameter("hdf5", ":py:class:`bob.io.base.HDF5File`", "An HDF5 file open for reading")
+);
+
+static int PyBobLearnLinearQuantizedMachine_init(PyBobLearnLinearQuantizedMachineObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist0 = QuantizedMachine_doc.kwlist(0);
+  char** kwlist1 = QuantizedMachine_doc.kwlist(1);
+  char** kwlist2 = QuantizedMachine_doc.kwlist(2);
+
+  Py_ssize_t nargs = (args?PyTuple_Size(args):0) + (kwargs?PyDict_Size(kwargs):0);
+  if (nargs != 1) {
+    PyErr_Format(PyExc_RuntimeError, "number of arguments mismatch - `%s' requires 1 argument, but you provided %" PY_FORMAT_SIZE_T "d (see help)", Py_TYPE(self)->tp_name, nargs);
+    return -1;
+  }
+
+  PyObject* arg = 0; ///< borrowed (don't delete)
+  if (args && PyTuple_Size(args)) arg = PyTuple_GET_ITEM(args, 0);
+  else {
+    PyObject* tmp = PyDict_Values(kwargs);
+    auto tmp_ = make_safe(tmp);
+    arg = PyList_GET_ITEM(tmp, 0);
+  }
+
+  if (PyBobIoHDF5File_Check(arg)) {
+    PyBobIoHDF5FileObject* hdf5;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&", kwlist2, &PyBobIoHDF5File_Converter, &hdf5)) return -1;
+    auto hdf5_ = make_safe(hdf5);
+    self->cxx.reset(new bob::learn::linear::QuantizedMachine(*hdf5->f));
+  } else if (PyBobLearnLinearQuantizedMachine_Check(arg)) {
+    PyBobLearnLinearQuantizedMachineObject* other;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!", kwlist1, &PyBobLearnLinearQuantizedMachine_Type, &other)) return -1;
+    self->cxx.reset(new bob::learn::linear::QuantizedMachine(*other->cxx));
+  } else {
+    PyBobLearnLinearMachineObject* machine;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!", kwlist0, &PyBobLearnLinearMachine_Type, &machine)) return -1;
+    self->cxx.reset(new bob::learn::linear::QuantizedMachine(*machine->cxx));
+  }
+  return 0;
+BOB_CATCH_MEMBER("constructor", -1)
+}
+
+static void PyBobLearnLinearQuantizedMachine_delete(PyBobLearnLinearQuantizedMachineObject* self) {
+  self->cxx.reset();
+  Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+int PyBobLearnLinearQuantizedMachine_Check(PyObject* o) {
+  return PyObject_IsInstance(o, reinterpret_cast<PyObject*>(&PyBobLearnLinearQuantizedMachine_Type));
+}
+
+static PyObject* PyBobLearnLinearQuantizedMachine_RichCompare(PyBobLearnLinearQuantizedMachineObject* self, PyObject* other, int op) {
+
+  if (!PyBobLearnLinearQuantizedMachine_Check(other)) {
+    PyErr_Format(PyExc_TypeError, "cannot compare `%s' with `%s'",
+        Py_TYPE(self)->tp_name, Py_TYPE(other)->tp_name);
+    return 0;
+  }
+
+  auto other_ = reinterpret_cast<PyBobLearnLinearQuantizedMachineObject*>(other);
+
+  switch (op) {
+    case Py_EQ:
+      if (self->cxx->operator==(*other_->cxx)) Py_RETURN_TRUE;
+      Py_RETURN_FALSE;
+      break;
+    case Py_NE:
+      if (self->cxx->operator!=(*other_->cxx)) Py_RETURN_TRUE;
+      Py_RETURN_FALSE;
+      break;
+    default:
+      Py_INCREF(Py_NotImplemented);
+      return Py_NotImplemented;
+  }
+}
+
+
+/******************************************************************/
+/************ Variables Section ***********************************/
+/******************************************************************/
+
+static auto shape_doc = bob::extension::VariableDoc(
+  "shape",
+  "(int, int)",
+  "The number of inputs and outputs in the format ``(input, output)``, read-only"
+);
+static PyObject* PyBobLearnLinearQuantizedMachine_getShape(PyBobLearnLinearQuantizedMachineObject* self, void*){
+BOB_TRY
+  return Py_BuildValue("(nn)", self->cxx->inputSize(), self->cxx->outputSize());
+BOB_CATCH_MEMBER("shape", 0)
+}
+
+static auto weights_doc = bob::extension::VariableDoc(
+  "weights",
+  "array_like(2D, int8)",
+  "A copy of the quantized weights, with one column per output as in :py:attr:`bob.learn.linear.Machine.weights`, read-only",
+  "The weights of the machine are approximately ``weights * scales``."
+);
+static PyObject* PyBobLearnLinearQuantizedMachine_getWeights(PyBobLearnLinearQuantizedMachineObject* self, void*){
+BOB_TRY
+  return PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(self->cxx->getWeights()));
+BOB_CATCH_MEMBER("weights", 0)
+}
+
+static auto scales_doc = bob::extension::VariableDoc(
+  "scales",
+  "array_like(1D, float)",
+  "The scale of the quantized :py:attr:`weights` of each output, read-only"
+);
+static PyObject* PyBobLearnLinearQuantizedMachine_getScales(PyBobLearnLinearQuantizedMachineObject* self, void*){
+BOB_TRY
+  return PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(self->cxx->getScales()));
+BOB_CATCH_MEMBER("scales", 0)
+}
+
+static auto input_subtract_doc = bob::extension::VariableDoc(
+  "input_subtract",
+  "array_like(1D, float)",
+  "The value subtracted from each input before the projection, read-only"
+);
+static PyObject* PyBobLearnLinearQuantizedMachine_getInputSubtract(PyBobLearnLinearQuantizedMachineObject* self, void*){
+BOB_TRY
+  return PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(self->cxx->getInputSubtraction()));
+BOB_CATCH_MEMBER("input_subtract", 0)
+}
+
+static auto input_divide_doc = bob::extension::VariableDoc(
+  "input_divide",
+  "array_like(1D, float)",
+  "The value each input is divided by before the projection, read-only"
+);
+static PyObject* PyBobLearnLinearQuantizedMachine_getInputDivide(PyBobLearnLinearQuantizedMachineObject* self, void*){
+BOB_TRY
+  return PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(self->cxx->getInputDivision()));
+BOB_CATCH_MEMBER("input_divide", 0)
+}
+
+static auto biases_doc = bob::extension::VariableDoc(
+  "biases",
+  "array_like(1D, float)",
+  "The biases added to the outputs before the :py:attr:`activation` is applied, read-only"
+);
+static PyObject* PyBobLearnLinearQuantizedMachine_getBiases(PyBobLearnLinearQuantizedMachineObject* self, void*){
+BOB_TRY
+  return PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(self->cxx->getBiases()));
+BOB_CATCH_MEMBER("biases", 0)
+}
+
+static auto activation_doc = bob::extension::VariableDoc(
+  "activation",
+  ":py:class:`bob.learn.activation.Activation` or one of its derivatives",
+  "The activation function, read-only"
+);
+static PyObject* PyBobLearnLinearQuantizedMachine_getActivation(PyBobLearnLinearQuantizedMachineObject* self, void*){
+BOB_TRY
+  return PyBobLearnActivation_NewFromActivation(self->cxx->getActivation());
+BOB_CATCH_MEMBER("activation", 0)
+}
+
+static PyGetSetDef PyBobLearnLinearQuantizedMachine_getseters[] = {
+  {
+    shape_doc.name(),
+    (getter)PyBobLearnLinearQuantizedMachine_getShape,
+    0,
+    shape_doc.doc(),
+    0
+  },
+  {
+    weights_doc.name(),
+    (getter)PyBobLearnLinearQuantizedMachine_getWeights,
+    0,
+    weights_doc.doc(),
+    0
+  },
+  {
+    scales_doc.name(),
+    (getter)PyBobLearnLinearQuantizedMachine_getScales,
+    0,
+    scales_doc.doc(),
+    0
+  },
+  {
+    input_subtract_doc.name(),
+    (getter)PyBobLearnLinearQuantizedMachine_getInputSubtract,
+    0,
+    input_subtract_doc.doc(),
+    0
+  },
+  {
+    input_divide_doc.name(),
+    (getter)PyBobLearnLinearQuantizedMachine_getInputDivide,
+    0,
+    input_divide_doc.doc(),
+    0
+  },
+  {
+    biases_doc.name(),
+    (getter)PyBobLearnLinearQuantizedMachine_getBiases,
+    0,
+    biases_doc.doc(),
+    0
+  },
+  {
+    activation_doc.name(),
+    (getter)PyBobLearnLinearQuantizedMachine_getActivation,
+    0,
+    activation_doc.doc(),
+    0
+  },
+  {0}  /* Sentinel */
+};
+
+
+/******************************************************************/
+/************ Functions Section ***********************************/
+/******************************************************************/
+
+static auto forward_doc = bob::extension::FunctionDoc(
+  "forward",
+  "Projects ``input`` through the quantized weights and the biases",
+  "The ``input`` (and ``output``) arrays can be either 1D or 2D 64-bit float arrays, as for :py:meth:`bob.learn.linear.Machine.forward`. "
+  "A 2D array is projected at once, which is faster than projecting its rows one by one.\n\n"
+  ".. note:: The ``__call__`` method is an alias for this method.",
+  true
+)
+.add_prototype("input, [output]", "output")
+.add_parameter("input", "array_like(1D or 2D, float)", "The array that should be projected; must be compatible with :py:attr:`shape` [0]")
+.add_parameter("output", "array_like(1D or 2D, float)", "The output array that will be filled. If given, must be compatible with ``input`` and :py:attr:`shape` [1]")
+.add_return("output", "array_like(1D or 2D, float)", "The projected data; identical to the ``output`` parameter, if given")
+;
+static PyObject* PyBobLearnLinearQuantizedMachine_forward(PyBobLearnLinearQuantizedMachineObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = forward_doc.kwlist();
+
+  PyBlitzArrayObject* input = 0;
+  PyBlitzArrayObject* output = 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&|O&", kwlist,
+        &PyBlitzArray_Converter, &input,
+        &PyBlitzArray_OutputConverter, &output
+        )) return 0;
+
+  auto input_ = make_safe(input);
+  auto output_ = make_xsafe(output);
+
+  if (input->type_num != NPY_FLOAT64 || (output && output->type_num != NPY_FLOAT64)) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 64-bit float arrays for `input' and `output'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  if (input->ndim < 1 || input->ndim > 2) {
+    PyErr_Format(PyExc_TypeError, "`%s' only accepts 1 or 2-dimensional arrays (not %" PY_FORMAT_SIZE_T "dD arrays)", Py_TYPE(self)->tp_name, input->ndim);
+    return 0;
+  }
+
+  if (output && input->ndim != output->ndim) {
+    PyErr_Format(PyExc_RuntimeError, "Input and output arrays should have matching number of dimensions, but input array `input' has %" PY_FORMAT_SIZE_T "d dimensions while output array `output' has %" PY_FORMAT_SIZE_T "d dimensions", input->ndim, output->ndim);
+    return 0;
+  }
+
+  /** if ``output`` was not pre-allocated, do it now **/
+  if (!output) {
+    Py_ssize_t osize[2];
+    if (input->ndim == 1) {
+      osize[0] = self->cxx->outputSize();
+    }
+    else {
+      osize[0] = input->shape[0];
+      osize[1] = self->cxx->outputSize();
+    }
+    output = (PyBlitzArrayObject*)PyBlitzArray_SimpleNew(NPY_FLOAT64, input->ndim, osize);
+    output_ = make_safe(output);
+  }
+
+  /** the C++ machine checks the dimensions **/
+  if (input->ndim == 1) {
+    self->cxx->forward(*PyBlitzArrayCxx_AsBlitz<double,1>(input),
+        *PyBlitzArrayCxx_AsBlitz<double,1>(output));
+  }
+  else {
+    self->cxx->forward(*PyBlitzArrayCxx_AsBlitz<double,2>(input),
+        *PyBlitzArrayCxx_AsBlitz<double,2>(output));
+  }
+  Py_INCREF(output);
+  return PyBlitzArray_NUMPY_WRAP(reinterpret_cast<PyObject*>(output));
+BOB_CATCH_MEMBER("forward", 0)
+}
+
+static auto accuracy_doc = bob::extension::FunctionDoc(
+  "accuracy",
+  "Compares the outputs of this machine with the outputs of the given machine",
+  "Both machines project the given samples, and the differences of their outputs are summarized in a dictionary with the keys:\n\n"
+  "* ``max_error``: the largest absolute difference of an output\n"
+  "* ``mean_error``: the mean absolute difference of the outputs\n"
+  "* ``rms_error``: the root mean square difference of the outputs\n"
+  "* ``max_reference``: the largest absolute output of ``machine``, to which the errors relate\n"
+  "* ``agreement``: the fraction of samples for which both machines take the same decision, i.e., the largest output is at the same position or, for machines with a single output, both outputs are on the same side of the :py:attr:`activation` of 0",
+  true
+)
+.add_prototype("machine, data", "report")
+.add_parameter("machine", ":py:class:`bob.learn.linear.Machine`", "The reference machine, usually the one this machine was quantized from")
+.add_parameter("data", "array_like(2D, float)", "The samples to project, one per row")
+.add_return("report", "dict", "The deviation of the outputs, see above")
+;
+static PyObject* PyBobLearnLinearQuantizedMachine_accuracy(PyBobLearnLinearQuantizedMachineObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = accuracy_doc.kwlist();
+
+  PyBobLearnLinearMachineObject* machine;
+  PyBlitzArrayObject* data;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!O&", kwlist,
+        &PyBobLearnLinearMachine_Type, &machine,
+        &PyBlitzArray_Converter, &data
+        )) return 0;
+
+  auto data_ = make_safe(data);
+  if (data->ndim != 2 || data->type_num != NPY_FLOAT64) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for `data'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  auto report = self->cxx->accuracy(*machine->cxx, *PyBlitzArrayCxx_AsBlitz<double,2>(data));
+  return Py_BuildValue("{s:d,s:d,s:d,s:d,s:d}",
+      "max_error", report.max_error,
+      "mean_error", report.mean_error,
+      "rms_error", report.rms_error,
+      "max_reference", report.max_reference,
+      "agreement", report.agreement);
+BOB_CATCH_MEMBER("accuracy", 0)
+}
+
+static auto load_doc = bob::extension::FunctionDoc(
+  "load",
+  "Loads the quantized machine from the given HDF5 file",
+  0,
+  true
+)
+.add_prototype("hdf5")
+.add_parameter("hdf5", ":py:class:`bob.io.base.HDF5File`", "An HDF5 file opened for reading")
+;
+static PyObject* PyBobLearnLinearQuantizedMachine_load(PyBobLearnLinearQuantizedMachineObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = load_doc.kwlist();
+  PyBobIoHDF5FileObject* file;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&", kwlist, PyBobIoHDF5File_Converter, &file)) return 0;
+
+  auto file_ = make_safe(file);
+  self->cxx->load(*file->f);
+  Py_RETURN_NONE;
+BOB_CATCH_MEMBER("load", 0)
+}
+
+static auto save_doc = bob::extension::FunctionDoc(
+  "save",
+  "Saves the quantized machine to the given HDF5 file",
+  "The 8-bit weights are stored as such, so that the file is about 8 times smaller than the one of the original machine.",
+  true
+)
+.add_prototype("hdf5")
+.add_parameter("hdf5", ":py:class:`bob.io.base.HDF5File`", "An HDF5 file open for writing")
+;
+static PyObject* PyBobLearnLinearQuantizedMachine_save(PyBobLearnLinearQuantizedMachineObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = save_doc.kwlist();
+  PyBobIoHDF5FileObject* file;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&", kwlist, PyBobIoHDF5File_Converter, &file)) return 0;
+
+  auto file_ = make_safe(file);
+  self->cxx->save(*file->f);
+  Py_RETURN_NONE;
+BOB_CATCH_MEMBER("save", 0)
+}
+
+static PyMethodDef PyBobLearnLinearQuantizedMachine_methods[] = {
+  {
+    forward_doc.name(),
+    (PyCFunction)PyBobLearnLinearQuantizedMachine_forward,
+    METH_VARARGS|METH_KEYWORDS,
+    forward_doc.doc()
+  },
+  {
+    accuracy_doc.name(),
+    (PyCFunction)PyBobLearnLinearQuantizedMachine_accuracy,
+    METH_VARARGS|METH_KEYWORDS,
+    accuracy_doc.doc()
+  },
+  {
+    load_doc.name(),
+    (PyCFunction)PyBobLearnLinearQuantizedMachine_load,
+    METH_VARARGS|METH_KEYWORDS,
+    load_doc.doc()
+  },
+  {
+    save_doc.name(),
+    (PyCFunction)PyBobLearnLinearQuantizedMachine_save,
+    METH_VARARGS|METH_KEYWORDS,
+    save_doc.doc()
+  },
+  {0} /* Sentinel */
+};
+
+
+/******************************************************************/
+/************ Module Section **************************************/
+/******************************************************************/
+
+// Quantized Machine
+PyTypeObject PyBobLearnLinearQuantizedMachine_Type = {
+  PyVarObject_HEAD_INIT(0,0)
+  0
+};
+
+bool init_BobLearnLinearQuantized(PyObject* module)
+{
+  // Quantized Machine
+  PyBobLearnLinearQuantizedMachine_Type.tp_name = QuantizedMachine_doc.name();
+  PyBobLearnLinearQuantizedMachine_Type.tp_basicsize = sizeof(PyBobLearnLinearQuantizedMachineObject);
+  PyBobLearnLinearQuantizedMachine_Type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
+  PyBobLearnLinearQuantizedMachine_Type.tp_doc = QuantizedMachine_doc.doc();
+
+  // set the functions
+  PyBobLearnLinearQuantizedMachine_Type.tp_new = PyType_GenericNew;
+  PyBobLearnLinearQuantizedMachine_Type.tp_init = reinterpret_cast<initproc>(PyBobLearnLinearQuantizedMachine_init);
+  PyBobLearnLinearQuantizedMachine_Type.tp_dealloc = reinterpret_cast<destructor>(PyBobLearnLinearQuantizedMachine_delete);
+  PyBobLearnLinearQuantizedMachine_Type.tp_methods = PyBobLearnLinearQuantizedMachine_methods;
+  PyBobLearnLinearQuantizedMachine_Type.tp_getset = PyBobLearnLinearQuantizedMachine_getseters;
+  PyBobLearnLinearQuantizedMachine_Type.tp_call = reinterpret_cast<ternaryfunc>(PyBobLearnLinearQuantizedMachine_forward);
+  PyBobLearnLinearQuantizedMachine_Type.tp_richcompare = reinterpret_cast<richcmpfunc>(PyBobLearnLinearQuantizedMachine_RichCompare);
+
+  // check that everyting is fine
+  if (PyType_Ready(&PyBobLearnLinearQuantizedMachine_Type) < 0)
+    return false;
+
+  // add the type to the module
+  Py_INCREF(&PyBobLearnLinearQuantizedMachine_Type);
+  return PyModule_AddObject(module, "QuantizedMachine", (PyObject*)&PyBobLearnLinearQuantizedMachine_Type) >= 0;
+}
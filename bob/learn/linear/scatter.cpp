@@ -0,0 +1,499 @@
+/**
+ * @date Sun Oct 18 10:12:41 CEST 2026
+ *
+ * @brief Python bindings to the streaming scatter accumulator
+ *
+ * Copyright (C) Idiap Research Institute, Martigny, Switzerland
+ */
+
+#define BOB_LEARN_LINEAR_MODULE
+#include <bob.blitz/cppapi.h>
+#include <bob.blitz/cleanup.h>
+#include <bob.learn.linear/api.h>
+#include <bob.learn.linear/scatter.h>
+#include <bob.io.base/api.h>
+#include <bob.extension/documentation.h>
+
+/******************************************************************/
+/************ Constructor Section *********************************/
+/******************************************************************/
+
+static auto ScatterAccumulator_doc = bob::extension::ClassDoc(
+  BOB_EXT_MODULE_PREFIX ".ScatterAccumulator",
+  "Accumulates the mean and the scatter matrix of a stream of samples",
+  "The accumulator keeps the number of samples :math:`N`, their mean :math:`\\mu` and their scatter matrix :math:`S = \\sum_n (x_n - \\mu)(x_n - \\mu)^T`. "
+  "Samples can be added in blocks of arbitrary size using :py:meth:`update`, so that the data never needs to be held in memory at once. "
+  "Accumulators that were filled with different parts of the data -- possibly in different processes or on different machines -- can be combined with :py:meth:`merge`. "
+  "Both operations use the pairwise update of Chan et al., which stays numerically stable independently of the number of blocks.\n\n"
+  "The state of an accumulator can be written to and read from HDF5 files (:py:meth:`save`, :py:meth:`load`). "
+  "Accumulators can be passed to the ``train`` methods of :py:class:`PCATrainer`, :py:class:`WhiteningTrainer` and :py:class:`BICTrainer` in place of the training data, and lists of accumulators (one per class) to :py:class:`FisherLDATrainer` and :py:class:`WCCNTrainer`. "
+  "A distributed training hence consists of accumulating the statistics of each shard of the data, saving them to HDF5, merging the loaded accumulators and training from the merged statistics."
+).add_constructor(
+  bob::extension::FunctionDoc(
+    "__init__",
+    "Creates a scatter accumulator",
+    0,
+    true
+  )
+  .add_prototype("[n_features]", "")
+  .add_prototype("other", "")
+  .add_prototype("hdf5", "")
+  .add_parameter("n_features", "int", "[Default: ``0``] The dimensionality of the samples; if ``0``, it is set by the first call to :py:meth:`update`")
+  .add_parameter("other", ":py:class:`bob.learn.linear.ScatterAccumulator`", "Another accumulator to copy")
+  .add_parameter("hdf5", ":py:class:`bob.io.base.HDF5File`", "An HDF5 file open for reading")
+);
+
+static int PyBobLearnLinearScatterAccumulator_init(PyBobLearnLinearScatterAccumulatorObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist0 = ScatterAccumulator_doc.kwlist(0);
+  char** kwlist1 = ScatterAccumulator_doc.kwlist(1);
+  char** kwlist2 = ScatterAccumulator_doc.kwlist(2);
+
+  Py_ssize_t nargs = (args?PyTuple_Size(args):0) + (kwargs?PyDict_Size(kwargs):0);
+  if (!nargs) {
+    // empty constructor
+    self->cxx.reset(new bob::learn::linear::ScatterAccumulator());
+    return 0;
+  }
+
+  PyObject* arg = 0; ///< borrowed (don't delete)
+  if (args && PyTuple_Size(args)) arg = PyTuple_GET_ITEM(args, 0);
+  else {
+    PyObject* tmp = PyDict_Values(kwargs);
+    auto tmp_ = make_safe(tmp);
+    arg = PyList_GET_ITEM(tmp, 0);
+  }
+
+  if (PyBobIoHDF5File_Check(arg)) {
+    PyBobIoHDF5FileObject* hdf5;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&", kwlist2, &PyBobIoHDF5File_Converter, &hdf5)) return -1;
+    auto hdf5_ = make_safe(hdf5);
+    self->cxx.reset(new bob::learn::linear::ScatterAccumulator(*hdf5->f));
+  } else if (PyBobLearnLinearScatterAccumulator_Check(arg)) {
+    PyBobLearnLinearScatterAccumulatorObject* other;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!", kwlist1, &PyBobLearnLinearScatterAccumulator_Type, &other)) return -1;
+    self->cxx.reset(new bob::learn::linear::ScatterAccumulator(*other->cxx));
+  } else {
+    Py_ssize_t n_features = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "n", kwlist0, &n_features)) return -1;
+    if (n_features < 0) {
+      PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of features", Py_TYPE(self)->tp_name);
+      return -1;
+    }
+    self->cxx.reset(new bob::learn::linear::ScatterAccumulator(n_features));
+  }
+  return 0;
+BOB_CATCH_MEMBER("constructor", -1)
+}
+
+static void PyBobLearnLinearScatterAccumulator_delete(PyBobLearnLinearScatterAccumulatorObject* self) {
+  self->cxx.reset();
+  Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+int PyBobLearnLinearScatterAccumulator_Check(PyObject* o) {
+  return PyObject_IsInstance(o, reinterpret_cast<PyObject*>(&PyBobLearnLinearScatterAccumulator_Type));
+}
+
+static PyObject* PyBobLearnLinearScatterAccumulator_RichCompare(PyBobLearnLinearScatterAccumulatorObject* self, PyObject* other, int op) {
+
+  if (!PyBobLearnLinearScatterAccumulator_Check(other)) {
+    PyErr_Format(PyExc_TypeError, "cannot compare `%s' with `%s'",
+        Py_TYPE(self)->tp_name, Py_TYPE(other)->tp_name);
+    return 0;
+  }
+
+  auto other_ = reinterpret_cast<PyBobLearnLinearScatterAccumulatorObject*>(other);
+
+  switch (op) {
+    case Py_EQ:
+      if (self->cxx->operator==(*other_->cxx)) Py_RETURN_TRUE;
+      Py_RETURN_FALSE;
+      break;
+    case Py_NE:
+      if (self->cxx->operator!=(*other_->cxx)) Py_RETURN_TRUE;
+      Py_RETURN_FALSE;
+      break;
+    default:
+      Py_INCREF(Py_NotImplemented);
+      return Py_NotImplemented;
+  }
+}
+
+
+/******************************************************************/
+/************ Variables Section ***********************************/
+/******************************************************************/
+
+static auto n_features_doc = bob::extension::VariableDoc(
+  "n_features",
+  "int",
+  "The dimensionality of the samples, read-only"
+);
+static PyObject* PyBobLearnLinearScatterAccumulator_getNFeatures(PyBobLearnLinearScatterAccumulatorObject* self, void*){
+BOB_TRY
+  return Py_BuildValue("n", (Py_ssize_t)self->cxx->numberOfFeatures());
+BOB_CATCH_MEMBER("n_features", 0)
+}
+
+static auto n_samples_doc = bob::extension::VariableDoc(
+  "n_samples",
+  "int",
+  "The number of accumulated samples, read-only"
+);
+static PyObject* PyBobLearnLinearScatterAccumulator_getNSamples(PyBobLearnLinearScatterAccumulatorObject* self, void*){
+BOB_TRY
+  return Py_BuildValue("n", (Py_ssize_t)self->cxx->numberOfSamples());
+BOB_CATCH_MEMBER("n_samples", 0)
+}
+
+static auto sum_of_weights_doc = bob::extension::VariableDoc(
+  "sum_of_weights",
+  "float",
+  "The sum of the weights of the accumulated samples, read-only",
+  "Without weights, this is identical to :py:attr:`n_samples`."
+);
+static PyObject* PyBobLearnLinearScatterAccumulator_getSumOfWeights(PyBobLearnLinearScatterAccumulatorObject* self, void*){
+BOB_TRY
+  return Py_BuildValue("d", self->cxx->sumOfWeights());
+BOB_CATCH_MEMBER("sum_of_weights", 0)
+}
+
+static auto mean_doc = bob::extension::VariableDoc(
+  "mean",
+  "array_like(1D, float)",
+  "The mean of the accumulated samples, read-only"
+);
+static PyObject* PyBobLearnLinearScatterAccumulator_getMean(PyBobLearnLinearScatterAccumulatorObject* self, void*){
+BOB_TRY
+  return PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(self->cxx->getMean()));
+BOB_CATCH_MEMBER("mean", 0)
+}
+
+static auto scatter_doc = bob::extension::VariableDoc(
+  "scatter",
+  "array_like(2D, float)",
+  "The scatter matrix :math:`\\sum_n (x_n - \\mu)(x_n - \\mu)^T` of the accumulated samples, read-only"
+);
+static PyObject* PyBobLearnLinearScatterAccumulator_getScatter(PyBobLearnLinearScatterAccumulatorObject* self, void*){
+BOB_TRY
+  return PyBlitzArray_NUMPY_WRAP(PyBlitzArrayCxx_NewFromConstArray(self->cxx->getScatter()));
+BOB_CATCH_MEMBER("scatter", 0)
+}
+
+static auto covariance_doc = bob::extension::VariableDoc(
+  "covariance",
+  "array_like(2D, float)",
+  "The unbiased covariance matrix :py:attr:`scatter` / (:py:attr:`sum_of_weights` - 1), read-only",
+  "At least two samples with a sum of weights above 1 need to be accumulated."
+);
+static PyObject* PyBobLearnLinearScatterAccumulator_getCovariance(PyBobLearnLinearScatterAccumulatorObject* self, void*){
+BOB_TRY
+  Py_ssize_t shape[2] = {(Py_ssize_t)self->cxx->numberOfFeatures(), (Py_ssize_t)self->cxx->numberOfFeatures()};
+  auto covariance = reinterpret_cast<PyBlitzArrayObject*>(PyBlitzArray_SimpleNew(NPY_FLOAT64, 2, shape));
+  auto covariance_ = make_safe(covariance);
+  self->cxx->covariance(*PyBlitzArrayCxx_AsBlitz<double,2>(covariance));
+  return PyBlitzArray_AsNumpyArray(covariance, 0);
+BOB_CATCH_MEMBER("covariance", 0)
+}
+
+static PyGetSetDef PyBobLearnLinearScatterAccumulator_getseters[] = {
+  {
+    n_features_doc.name(),
+    (getter)PyBobLearnLinearScatterAccumulator_getNFeatures,
+    0,
+    n_features_doc.doc(),
+    0
+  },
+  {
+    n_samples_doc.name(),
+    (getter)PyBobLearnLinearScatterAccumulator_getNSamples,
+    0,
+    n_samples_doc.doc(),
+    0
+  },
+  {
+    sum_of_weights_doc.name(),
+    (getter)PyBobLearnLinearScatterAccumulator_getSumOfWeights,
+    0,
+    sum_of_weights_doc.doc(),
+    0
+  },
+  {
+    mean_doc.name(),
+    (getter)PyBobLearnLinearScatterAccumulator_getMean,
+    0,
+    mean_doc.doc(),
+    0
+  },
+  {
+    scatter_doc.name(),
+    (getter)PyBobLearnLinearScatterAccumulator_getScatter,
+    0,
+    scatter_doc.doc(),
+    0
+  },
+  {
+    covariance_doc.name(),
+    (getter)PyBobLearnLinearScatterAccumulator_getCovariance,
+    0,
+    covariance_doc.doc(),
+    0
+  },
+  {0}  /* Sentinel */
+};
+
+
+/******************************************************************/
+/************ Functions Section ***********************************/
+/******************************************************************/
+
+static auto update_doc = bob::extension::FunctionDoc(
+  "update",
+  "Adds the given samples to the accumulator",
+  "The samples can be given as a 2D array with one sample per row, or as a single 1D sample. "
+  "Each row of a 2D array can be weighted with a non-negative frequency weight, i.e., a sample with weight 2 contributes as if it was added twice.",
+  true
+)
+.add_prototype("X, [weights]")
+.add_parameter("X", "array_like(1D or 2D, float)", "The samples to add")
+.add_parameter("weights", "array_like(1D, float)", "[optional] The frequency weights of the rows of ``X``")
+;
+static PyObject* PyBobLearnLinearScatterAccumulator_update(PyBobLearnLinearScatterAccumulatorObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = update_doc.kwlist();
+
+  PyBlitzArrayObject* X,* weights = 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&|O&", kwlist, &PyBlitzArray_Converter, &X, &PyBlitzArray_Converter, &weights)) return 0;
+  auto X_ = make_safe(X);
+  auto weights_ = make_xsafe(weights);
+
+  if ((X->ndim != 1 && X->ndim != 2) || X->type_num != NPY_FLOAT64) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 1D or 2D 64-bit float arrays for input array `X'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+
+  if (weights) {
+    if (weights->ndim != 1 || weights->type_num != NPY_FLOAT64 || X->ndim != 2) {
+      PyErr_Format(PyExc_TypeError, "`%s' only supports 1D 64-bit float arrays for `weights' of a 2D input array `X'", Py_TYPE(self)->tp_name);
+      return 0;
+    }
+    self->cxx->update(*PyBlitzArrayCxx_AsBlitz<double,2>(X), *PyBlitzArrayCxx_AsBlitz<double,1>(weights));
+  }
+  else if (X->ndim == 1) self->cxx->update(*PyBlitzArrayCxx_AsBlitz<double,1>(X));
+  else self->cxx->update(*PyBlitzArrayCxx_AsBlitz<double,2>(X));
+  Py_RETURN_NONE;
+BOB_CATCH_MEMBER("update", 0)
+}
+
+static auto merge_doc = bob::extension::FunctionDoc(
+  "merge",
+  "Adds the statistics of the ``other`` accumulator to this one",
+  "Afterwards, this accumulator holds the statistics of the samples of both accumulators, as if all of them had been added to this accumulator.",
+  true
+)
+.add_prototype("other")
+.add_parameter("other", ":py:class:`bob.learn.linear.ScatterAccumulator`", "The accumulator to merge into this one")
+;
+static PyObject* PyBobLearnLinearScatterAccumulator_merge(PyBobLearnLinearScatterAccumulatorObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = merge_doc.kwlist();
+
+  PyBobLearnLinearScatterAccumulatorObject* other;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!", kwlist, &PyBobLearnLinearScatterAccumulator_Type, &other)) return 0;
+
+  self->cxx->merge(*other->cxx);
+  Py_RETURN_NONE;
+BOB_CATCH_MEMBER("merge", 0)
+}
+
+static auto subtract_doc = bob::extension::FunctionDoc(
+  "subtract",
+  "Removes the statistics of the ``other`` accumulator from this one",
+  "The samples of ``other`` need to be part of this accumulator. "
+  "Afterwards, this accumulator holds the statistics of its remaining samples, as if the samples of ``other`` had never been added, which inverts :py:meth:`merge`. "
+  "For example, the statistics of all data but one fold can be obtained by subtracting the statistics of the fold from the statistics of all data.",
+  true
+)
+.add_prototype("other")
+.add_parameter("other", ":py:class:`bob.learn.linear.ScatterAccumulator`", "The accumulator to subtract from this one")
+;
+static PyObject* PyBobLearnLinearScatterAccumulator_subtract(PyBobLearnLinearScatterAccumulatorObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = subtract_doc.kwlist();
+
+  PyBobLearnLinearScatterAccumulatorObject* other;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!", kwlist, &PyBobLearnLinearScatterAccumulator_Type, &other)) return 0;
+
+  self->cxx->subtract(*other->cxx);
+  Py_RETURN_NONE;
+BOB_CATCH_MEMBER("subtract", 0)
+}
+
+static auto reset_doc = bob::extension::FunctionDoc(
+  "reset",
+  "Removes all samples from the accumulator, keeping its dimensionality",
+  0,
+  true
+)
+.add_prototype("")
+;
+static PyObject* PyBobLearnLinearScatterAccumulator_reset(PyBobLearnLinearScatterAccumulatorObject* self) {
+BOB_TRY
+  self->cxx->reset();
+  Py_RETURN_NONE;
+BOB_CATCH_MEMBER("reset", 0)
+}
+
+static auto similar_doc = bob::extension::FunctionDoc(
+  "is_similar_to",
+  "Compares this accumulator with the ``other`` one to be approximately the same",
+  "The optional values ``r_epsilon`` and ``a_epsilon`` refer to the relative and absolute precision, similarly to :py:func:`numpy.allclose`.",
+  true
+)
+.add_prototype("other, [r_epsilon], [a_epsilon]", "similar")
+.add_parameter("other", ":py:class:`bob.learn.linear.ScatterAccumulator`", "The other accumulator to compare with")
+.add_parameter("r_epsilon", "float", "[Default: ``1e-5``] The relative precision")
+.add_parameter("a_epsilon", "float", "[Default: ``1e-8``] The absolute precision")
+.add_return("similar", "bool", "``True`` if the ``other`` accumulator is similar to this one, otherwise ``False``")
+;
+static PyObject* PyBobLearnLinearScatterAccumulator_similar(PyBobLearnLinearScatterAccumulatorObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = similar_doc.kwlist();
+
+  PyBobLearnLinearScatterAccumulatorObject* other = 0;
+  double r_epsilon = 1.e-5;
+  double a_epsilon = 1.e-8;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!|dd", kwlist, &PyBobLearnLinearScatterAccumulator_Type, &other, &r_epsilon, &a_epsilon)) return 0;
+
+  if (self->cxx->is_similar_to(*other->cxx, r_epsilon, a_epsilon))
+    Py_RETURN_TRUE;
+  else
+    Py_RETURN_FALSE;
+BOB_CATCH_MEMBER("is_similar_to", 0)
+}
+
+static auto load_doc = bob::extension::FunctionDoc(
+  "load",
+  "Loads the accumulated statistics from the given HDF5 file",
+  0,
+  true
+)
+.add_prototype("hdf5")
+.add_parameter("hdf5", ":py:class:`bob.io.base.HDF5File`", "An HDF5 file opened for reading")
+;
+static PyObject* PyBobLearnLinearScatterAccumulator_load(PyBobLearnLinearScatterAccumulatorObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = load_doc.kwlist();
+  PyBobIoHDF5FileObject* file;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&", kwlist, PyBobIoHDF5File_Converter, &file)) return 0;
+
+  auto file_ = make_safe(file);
+  self->cxx->load(*file->f);
+  Py_RETURN_NONE;
+BOB_CATCH_MEMBER("load", 0)
+}
+
+static auto save_doc = bob::extension::FunctionDoc(
+  "save",
+  "Saves the accumulated statistics to the given HDF5 file",
+  0,
+  true
+)
+.add_prototype("hdf5")
+.add_parameter("hdf5", ":py:class:`bob.io.base.HDF5File`", "An HDF5 file open for writing")
+;
+static PyObject* PyBobLearnLinearScatterAccumulator_save(PyBobLearnLinearScatterAccumulatorObject* self, PyObject* args, PyObject* kwargs) {
+BOB_TRY
+  char** kwlist = save_doc.kwlist();
+  PyBobIoHDF5FileObject* file;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&", kwlist, PyBobIoHDF5File_Converter, &file)) return 0;
+
+  auto file_ = make_safe(file);
+  self->cxx->save(*file->f);
+  Py_RETURN_NONE;
+BOB_CATCH_MEMBER("save", 0)
+}
+
+static PyMethodDef PyBobLearnLinearScatterAccumulator_methods[] = {
+  {
+    update_doc.name(),
+    (PyCFunction)PyBobLearnLinearScatterAccumulator_update,
+    METH_VARARGS|METH_KEYWORDS,
+    update_doc.doc()
+  },
+  {
+    merge_doc.name(),
+    (PyCFunction)PyBobLearnLinearScatterAccumulator_merge,
+    METH_VARARGS|METH_KEYWORDS,
+    merge_doc.doc()
+  },
+  {
+    subtract_doc.name(),
+    (PyCFunction)PyBobLearnLinearScatterAccumulator_subtract,
+    METH_VARARGS|METH_KEYWORDS,
+    subtract_doc.doc()
+  },
+  {
+    reset_doc.name(),
+    (PyCFunction)PyBobLearnLinearScatterAccumulator_reset,
+    METH_NOARGS,
+    reset_doc.doc()
+  },
+  {
+    similar_doc.name(),
+    (PyCFunction)PyBobLearnLinearScatterAccumulator_similar,
+    METH_VARARGS|METH_KEYWORDS,
+    similar_doc.doc()
+  },
+  {
+    load_doc.name(),
+    (PyCFunction)PyBobLearnLinearScatterAccumulator_load,
+    METH_VARARGS|METH_KEYWORDS,
+    load_doc.doc()
+  },
+  {
+    save_doc.name(),
+    (PyCFunction)PyBobLearnLinearScatterAccumulator_save,
+    METH_VARARGS|METH_KEYWORDS,
+    save_doc.doc()
+  },
+  {0} /* Sentinel */
+};
+
+
+/******************************************************************/
+/************ Module Section **************************************/
+/******************************************************************/
+
+// Scatter Accumulator
+PyTypeObject PyBobLearnLinearScatterAccumulator_Type = {
+  PyVarObject_HEAD_INIT(0,0)
+  0
+};
+
+bool init_BobLearnLinearScatter(PyObject* module)
+{
+  // Scatter Accumulator
+  PyBobLearnLinearScatterAccumulator_Type.tp_name = ScatterAccumulator_doc.name();
+  PyBobLearnLinearScatterAccumulator_Type.tp_basicsize = sizeof(PyBobLearnLinearScatterAccumulatorObject);
+  PyBobLearnLinearScatterAccumulator_Type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE;
+  PyBobLearnLinearScatterAccumulator_Type.tp_doc = ScatterAccumulator_doc.doc();
+
+  // set the functions
+  PyBobLearnLinearScatterAccumulator_Type.tp_new = PyType_GenericNew;
+  PyBobLearnLinearScatterAccumulator_Type.tp_init = reinterpret_cast<initproc>(PyBobLearnLinearScatterAccumulator_init);
+  PyBobLearnLinearScatterAccumulator_Type.tp_dealloc = reinterpret_cast<destructor>(PyBobLearnLinearScatterAccumulator_delete);
+  PyBobLearnLinearScatterAccumulator_Type.tp_methods = PyBobLearnLinearScatterAccumulator_methods;
+  PyBobLearnLinearScatterAccumulator_Type.tp_getset = PyBobLearnLinearScatterAccumulator_getseters;
+  PyBobLearnLinearScatterAccumulator_Type.tp_richcompare = reinterpret_cast<richcmpfunc>(PyBobLearnLinearScatterAccumulator_RichCompare);
+
+  // check that everyting is fine
+  if (PyType_Ready(&PyBobLearnLinearScatterAccumulator_Type) < 0)
+    return false;
+
+  // add the type to the module
+  Py_INCREF(&PyBobLearnLinearScatterAccumulator_Type);
+  return PyModule_AddObject(module, "ScatterAccumulator", (PyObject*)&PyBobLearnLinearScatterAccumulator_Type) >= 0;
+}
@@ -0,0 +1,209 @@
+#!/usr/bin/env python
+# vim: set fileencoding=utf-8 :
+# Sun Oct 18 10:12:41 CEST 2026
+#
+# Copyright (C) Idiap Research Institute, Martigny, Switzerland
+
+"""Measures the performance of the linear machines and trainers on synthetic
+data, and reports the results in JSON format.
+
+The following benchmarks are available:
+
+forward
+  Latency and throughput of :py:class:`bob.learn.linear.Machine` for several
+  input and output sizes and batch sizes
+train
+  Training time of the PCA, LDA, WCCN and whitening trainers versus the number
+  of samples N and the dimensionality D
+logreg
+  Time per iteration of the :py:class:`bob.learn.linear.CGLogRegTrainer`
+bic
+  Scoring throughput of the :py:class:`bob.learn.linear.BICMachine`, in pairs
+  per second
+
+Each measurement is repeated, and the minimum and median times are reported,
+so that results of different releases (see the ``version`` field) can be
+compared.
+"""
+
+from __future__ import print_function
+
+import sys
+import json
+import timeit
+import platform
+import argparse
+import numpy
+
+from .. import Machine, PCATrainer, FisherLDATrainer, WCCNTrainer, \
+    WhiteningTrainer, CGLogRegTrainer, BICTrainer, BICMachine
+from ..version import module as version
+
+
+def measure(function, repeat):
+  """Calls the function ``repeat`` times, and returns the minimum and the
+  median of the wall times in seconds"""
+  times = []
+  for _ in range(repeat):
+    start = timeit.default_timer()
+    function()
+    times.append(timeit.default_timer() - start)
+  return min(times), float(numpy.median(times))
+
+
+def result(benchmark, parameters, times, count=None, unit=None):
+  """Builds one entry of the results; if a count is given, the throughput in
+  the given unit per second is added"""
+  entry = {
+    'benchmark': benchmark,
+    'parameters': parameters,
+    'min_seconds': times[0],
+    'median_seconds': times[1],
+  }
+  if count is not None:
+    entry['throughput'] = count / times[1] if times[1] > 0 else float('inf')
+    entry['unit'] = unit + '/s'
+  return entry
+
+
+def bench_forward(sizes, repeat):
+  results = []
+  for D, O in sizes['forward_shapes']:
+    machine = Machine(numpy.random.normal(0., 1., (D, O)))
+    for batch in sizes['batches']:
+      data = numpy.random.normal(0., 1., (batch, D))
+      output = numpy.ndarray((batch, O))
+      if batch == 1:
+        data, output = data[0], output[0]
+      times = measure(lambda: machine(data, output), repeat)
+      results.append(result('forward', {'input': D, 'output': O, 'batch': batch}, times, batch, 'samples'))
+  return results
+
+
+def bench_train(sizes, repeat):
+  results = []
+  for N, D in sizes['train_shapes']:
+    data = numpy.random.normal(0., 1., (N, D))
+    classes = [numpy.random.normal(float(k), 1., (N // 5, D)) for k in range(5)]
+    trainers = (
+      ('pca', PCATrainer(), data),
+      ('pca_covariance', PCATrainer(False), data),
+      ('whitening', WhiteningTrainer(), data),
+      ('lda', FisherLDATrainer(), classes),
+      ('wccn', WCCNTrainer(), classes),
+    )
+    for name, trainer, inputs in trainers:
+      times = measure(lambda: trainer.train(inputs), repeat)
+      results.append(result('train', {'trainer': name, 'samples': N, 'features': D}, times, N, 'samples'))
+  return results
+
+
+def bench_logreg(sizes, repeat):
+  results = []
+  iterations = sizes['logreg_iterations']
+  for N, D in sizes['logreg_shapes']:
+    negatives = numpy.random.normal(0., 1., (N // 2, D))
+    positives = numpy.random.normal(.5, 1., (N - N // 2, D))
+    # with a zero threshold, the trainer practically runs all iterations; the
+    # iterations that were actually run are counted by the callback
+    trainer = CGLogRegTrainer(0.5, 0., iterations, 1e-3)
+    trace = []
+    def train():
+      del trace[:]
+      trainer.train(negatives, positives, callback=trace.append)
+    times = measure(train, repeat)
+    run = max(len(trace), 1)
+    entry = result('logreg', {'samples': N, 'features': D, 'iterations': iterations}, times, run, 'iterations')
+    entry['iterations_run'] = len(trace)
+    entry['seconds_per_iteration'] = times[1] / run
+    results.append(entry)
+  return results
+
+
+def bench_bic(sizes, repeat):
+  results = []
+  for D, M in sizes['bic_shapes']:
+    intra = numpy.random.normal(0., 1., (max(4 * D, 50), D))
+    extra = numpy.random.normal(0., 2., (max(4 * D, 50), D))
+    machines = (
+      ('iec', BICTrainer().train(intra, extra, BICMachine())),
+      ('bic', BICTrainer(M, M).train(intra, extra, BICMachine())),
+      ('bic_dffs', BICTrainer(M, M).train(intra, extra, BICMachine(True))),
+    )
+    pairs = numpy.random.normal(0., 1., (sizes['bic_pairs'], D))
+    for name, machine in machines:
+      # all pairs are scored in a single call
+      times = measure(lambda: machine(pairs), repeat)
+      results.append(result('bic', {'model': name, 'features': D, 'subspace': M}, times, len(pairs), 'pairs'))
+  return results
+
+
+BENCHMARKS = {
+  'forward': bench_forward,
+  'train': bench_train,
+  'logreg': bench_logreg,
+  'bic': bench_bic,
+}
+
+SIZES = {
+  'full': {
+    'forward_shapes': [(64, 8), (256, 64), (1024, 256), (4096, 512)],
+    'batches': [1, 16, 256, 4096],
+    'train_shapes': [(1000, 32), (10000, 32), (1000, 256), (10000, 256), (5000, 1024)],
+    'logreg_shapes': [(1000, 32), (10000, 128)],
+    'logreg_iterations': 20,
+    'bic_shapes': [(64, 8), (512, 32)],
+    'bic_pairs': 2000,
+  },
+  'quick': {
+    'forward_shapes': [(16, 4)],
+    'batches': [1, 32],
+    'train_shapes': [(100, 8)],
+    'logreg_shapes': [(100, 4)],
+    'logreg_iterations': 5,
+    'bic_shapes': [(8, 2)],
+    'bic_pairs': 20,
+  },
+}
+
+
+def main(command_line_options=None):
+
+  parser = argparse.ArgumentParser(description=__doc__.split('\n\n')[0],
+      formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+  parser.add_argument('-b', '--benchmarks', nargs='+', choices=sorted(BENCHMARKS), default=sorted(BENCHMARKS),
+      help='The benchmarks to run')
+  parser.add_argument('-o', '--output', help='Write the results to this JSON file instead of the standard output')
+  parser.add_argument('-r', '--repeat', type=int, default=5, help='The number of repetitions of each measurement')
+  parser.add_argument('-s', '--seed', type=int, default=42, help='The seed of the random number generator for the synthetic data')
+  parser.add_argument('-q', '--quick', action='store_true', help='Use small problem sizes only, e.g., to check that the benchmarks run')
+  args = parser.parse_args(command_line_options)
+
+  numpy.random.seed(args.seed)
+  sizes = SIZES['quick' if args.quick else 'full']
+
+  results = []
+  for name in args.benchmarks:
+    results.extend(BENCHMARKS[name](sizes, max(args.repeat, 1)))
+
+  report = {
+    'package': 'bob.learn.linear',
+    'version': version,
+    'python': platform.python_version(),
+    'numpy': numpy.__version__,
+    'platform': platform.platform(),
+    'machine': platform.machine(),
+    'repeat': args.repeat,
+    'seed': args.seed,
+    'quick': args.quick,
+    'results': results,
+  }
+
+  if args.output:
+    with open(args.output, 'w') as f:
+      json.dump(report, f, indent=2, sort_keys=True)
+  else:
+    json.dump(report, sys.stdout, indent=2, sort_keys=True)
+    print()
+
+  return 0
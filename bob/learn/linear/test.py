@@ -14,12 +14,13 @@ import math
 import numpy
 
 from . import Machine, PCATrainer, FisherLDATrainer, CGLogRegTrainer, \
-    WhiteningTrainer, WCCNTrainer
+    MiniBatchLogRegTrainer, MultinomialLogRegTrainer, WhiteningTrainer, \
+    WCCNTrainer
 
 import bob.io.base
 from bob.learn.activation import HyperbolicTangent, Identity
 from bob.io.base import HDF5File
-from bob.io.base.test_utils import datafile
+from bob.io.base.test_utils import datafile, temporary_filename
 
 def F(f):
   """Returns the test file on the "data" subdirectory"""
@@ -228,6 +229,150 @@ def test_comparisons():
   assert m1 != m6
   assert not m1.is_similar_to(m6)
 
+def test_mmap():
+
+  # Tests loading a machine with memory-mapped weights
+  numpy.random.seed(42)
+  m = Machine(numpy.random.normal(0., 1., (20, 5)))
+  m.input_subtract = numpy.random.normal(0., 1., (20,))
+  m.biases = numpy.random.normal(0., 1., (5,))
+  filename = temporary_filename()
+  m.save(HDF5File(filename, 'w'))
+
+  mapped = Machine()
+  mapped.load(HDF5File(filename), mmap=True)
+  assert mapped.is_mapped
+  assert not Machine(HDF5File(filename)).is_mapped
+  assert mapped == m
+  probe = numpy.random.normal(0., 1., (20,))
+  assert numpy.allclose(mapped(probe), m(probe))
+
+  # copies share the mapping, modifications do not use it
+  copied = Machine(mapped)
+  assert copied.is_mapped
+  mapped.shape = (20, 3)
+  assert not mapped.is_mapped
+  assert numpy.allclose(mapped.weights, m.weights[:,:3])
+  assert copied.is_mapped
+  assert copied == m
+
+  # views of the weights keep the mapping alive
+  weights = copied.weights
+  del copied
+  assert numpy.array_equal(weights, m.weights)
+
+  # replacing the file by renaming keeps the weights of loaded machines
+  mapped = Machine()
+  mapped.load(HDF5File(filename), mmap=True)
+  other = Machine(numpy.random.normal(0., 1., (20, 5)))
+  replacement = temporary_filename()
+  other.save(HDF5File(replacement, 'w'))
+  os.rename(replacement, filename)
+  assert mapped == m
+  reloaded = Machine()
+  reloaded.load(HDF5File(filename), mmap=True)
+  assert reloaded.is_mapped
+  assert reloaded == other
+
+  # the weights of a file that was replaced after it was opened are read
+  hdf5 = HDF5File(filename)
+  replacement = temporary_filename()
+  m.save(HDF5File(replacement, 'w'))
+  os.rename(replacement, filename)
+  stale = Machine()
+  stale.load(hdf5, mmap=True)
+  assert not stale.is_mapped
+  assert stale == other
+  del hdf5
+
+  os.unlink(filename)
+
+def test_shared_weights():
+
+  # Copies share the weights until they are modified
+  import copy
+  numpy.random.seed(42)
+  m = Machine(numpy.random.normal(0., 1., (20, 5)))
+  m.input_subtract = numpy.random.normal(0., 1., (20,))
+  m.activation = HyperbolicTangent()
+  for copied in (Machine(m), copy.copy(m), copy.deepcopy(m)):
+    assert copied == m
+    assert numpy.shares_memory(copied.weights, m.weights)
+    assert not numpy.shares_memory(copied.input_subtract, m.input_subtract)
+
+  # modifying a copy does not modify the original
+  copied = copy.copy(m)
+  weights = m.weights.copy()
+  copied.shape = (20, 3)
+  copied.weights = numpy.zeros((20, 3))
+  copied.input_subtract = numpy.zeros((20,))
+  assert numpy.array_equal(m.weights, weights)
+  assert m.shape == (20, 5)
+  assert m != copied
+
+def test_bundle():
+
+  # Stores several machines of all types in a single bundle
+  from . import BICTrainer, BICMachine, GFKMachine, save_bundle, load_bundle
+  numpy.random.seed(42)
+  linear = Machine(numpy.random.normal(0., 1., (20, 5)))
+  linear.input_subtract = numpy.random.normal(0., 1., (20,))
+  linear.biases = numpy.random.normal(0., 1., (5,))
+  linear.activation = HyperbolicTangent()
+
+  intra = numpy.random.normal(0., 1., (30, 6))
+  extra = numpy.random.normal(1., 2., (30, 6))
+  iec = BICTrainer().train(intra, extra, BICMachine())
+  bic = BICTrainer(2, 3).train(intra, extra, BICMachine(True))
+
+  gfk = GFKMachine()
+  gfk.source_machine = Machine(numpy.random.normal(0., 1., (6, 2)))
+  gfk.target_machine = Machine(numpy.random.normal(0., 1., (6, 2)))
+  gfk.G = numpy.random.normal(0., 1., (6, 6))
+
+  filename = temporary_filename()
+  save_bundle(filename, [('linear', linear), ('iec', iec), ('bic', bic), ('gfk', gfk)])
+  machines = load_bundle(filename)
+  nose.tools.eq_(list(machines.keys()), ['linear', 'iec', 'bic', 'gfk'])
+
+  assert isinstance(machines['linear'], Machine)
+  assert machines['linear'] == linear
+  assert machines['linear'].is_mapped
+  probe = numpy.random.normal(0., 1., (20,))
+  assert numpy.allclose(machines['linear'](probe), linear(probe))
+
+  assert machines['iec'] == iec
+  assert machines['bic'] == bic
+  assert machines['bic'].use_DFFS
+
+  assert isinstance(machines['gfk'], GFKMachine)
+  assert machines['gfk'] == gfk
+  assert machines['gfk'].source_machine.is_mapped
+
+  # single machines can be loaded by name; modifications do not use the mapping
+  loaded = load_bundle(filename, ['linear'])['linear']
+  loaded.shape = (20, 3)
+  assert not loaded.is_mapped
+  assert machines['linear'] == linear
+
+  nose.tools.assert_raises(RuntimeError, load_bundle, filename, ['unknown'])
+  nose.tools.assert_raises(RuntimeError, save_bundle, filename, [('a', linear), ('a', linear)])
+  nose.tools.assert_raises(TypeError, save_bundle, filename, {'a': PCATrainer()})
+  assert load_bundle(filename)['linear'] == linear
+
+  # saving a new bundle under the same name keeps the loaded machines
+  other = Machine(numpy.random.normal(0., 1., (20, 5)))
+  save_bundle(filename, [('linear', other)])
+  assert machines['linear'] == linear
+  assert machines['gfk'] == gfk
+  assert load_bundle(filename)['linear'] == other
+
+  # the weights of released machines stay valid
+  weights = machines['linear'].weights
+  del machines
+  assert numpy.array_equal(weights, linear.weights)
+  os.unlink(filename)
+
 def test_pca_settings():
 
   T = PCATrainer()
@@ -645,6 +790,74 @@ def test_whitening_train():
   assert numpy.allclose(m2.weights, whit_ref, eps, eps)
   assert numpy.allclose(s2, sample_whitened_ref, eps, eps)
 
+def test_whitening_eigenvalue_floor():
+
+  # Singular data cannot be whitened by the Cholesky factorization
+  numpy.random.seed(42)
+  data = numpy.random.normal(0., 1., (20, 3))
+  data = numpy.hstack((data, data[:,:1] + data[:,1:2]))
+
+  nose.tools.assert_raises(RuntimeError, WhiteningTrainer().train, data)
+
+  # ... but with an eigenvalue floor
+  t = WhiteningTrainer(eigenvalue_floor=1e-8)
+  assert t.eigenvalue_floor == 1e-8
+  assert t != WhiteningTrainer()
+  assert t == WhiteningTrainer(t)
+  m = t.train(data)
+  whitened = numpy.array([m(d) for d in data])
+  covariance = numpy.cov(whitened, rowvar=False)
+  # the non-singular part is whitened, the null space is suppressed
+  assert numpy.allclose(covariance[:3,:3], numpy.eye(3))
+  assert numpy.allclose(covariance[3,3], 0.)
+
+  # on regular data, the floor is not reached and the Cholesky factor is kept
+  data = data[:,:3]
+  for t in (WhiteningTrainer(), WhiteningTrainer(1e-12)):
+    m = t.train(data)
+    whitened = numpy.array([m(d) for d in data])
+    assert numpy.allclose(numpy.cov(whitened, rowvar=False), numpy.eye(3))
+    assert numpy.allclose(m.weights, numpy.tril(m.weights))
+
+def test_whitening_modes():
+
+  numpy.random.seed(42)
+  mixing = numpy.random.normal(0., 1., (5, 5))
+  data = numpy.dot(numpy.random.normal(0., 1., (50, 5)), mixing)
+  covariance = numpy.cov(data, rowvar=False)
+
+  # PCA whitening with dimensionality reduction
+  t = WhiteningTrainer(mode='pca', n_components=3)
+  assert t.mode == 'pca'
+  assert t.n_components == 3
+  assert t != WhiteningTrainer()
+  assert t == WhiteningTrainer(t)
+  m = t.train(data)
+  assert m.shape == (5, 3)
+  whitened = numpy.array([m(d) for d in data])
+  assert numpy.allclose(numpy.cov(whitened, rowvar=False), numpy.eye(3))
+  # ... which spans the leading principal subspace
+  eigenvalues, eigenvectors = numpy.linalg.eigh(covariance)
+  leading = eigenvectors[:,::-1][:,:3]
+  assert numpy.allclose(numpy.abs(numpy.dot(leading.T, m.weights)), numpy.diag(1./numpy.sqrt(eigenvalues[::-1][:3])))
+
+  # ZCA whitening is symmetric
+  t.mode = 'zca'
+  m = t.train(data)
+  assert m.shape == (5, 5)
+  assert numpy.allclose(m.weights, m.weights.T)
+  whitened = numpy.array([m(d) for d in data])
+  assert numpy.allclose(numpy.cov(whitened, rowvar=False), numpy.eye(5))
+
+  # all modes agree up to a rotation
+  t.mode = 'cholesky'
+  c = t.train(data)
+  rotation = numpy.dot(numpy.linalg.inv(m.weights), c.weights)
+  assert numpy.allclose(numpy.dot(rotation.T, rotation), numpy.eye(5))
+
+  nose.tools.assert_raises(ValueError, WhiteningTrainer, mode='unknown')
+  nose.tools.assert_raises(RuntimeError, WhiteningTrainer(mode='pca', n_components=6).train, data)
+
 def test_wccn_initialization():
 
   # Constructors and comparison operators
@@ -967,6 +1180,274 @@ def test_cglogreg_norm_slow():
   assert abs(machine(test2) - res2) < 1e-3
 
 
+def test_cglogreg_callback():
+
+  numpy.random.seed(42)
+  negatives = numpy.random.normal(0., 1., (100, 3))
+  positives = numpy.random.normal(1., 1., (100, 3))
+
+  # records the convergence of the full training
+  trace = []
+  T = CGLogRegTrainer(0.5, 1e-8, 1000)
+  reference = T.train(negatives, positives)
+  machine = T.train(negatives, positives, callback=trace.append)
+  assert numpy.allclose(machine.weights, reference.weights)
+  assert numpy.allclose(machine.biases, reference.biases)
+
+  assert len(trace) > 2
+  nose.tools.eq_([t['iteration'] for t in trace], list(range(len(trace))))
+  for t in trace:
+    nose.tools.eq_(sorted(t.keys()), ['gradient_norm', 'iteration', 'objective', 'seconds', 'step_size', 'weight_change'])
+  # the objective decreases, and the training stops at convergence
+  assert trace[-1]['objective'] < trace[0]['objective']
+  assert trace[-1]['weight_change'] <= 1e-8
+  assert all(t['weight_change'] > 1e-8 for t in trace[:-1])
+  assert all(trace[k]['seconds'] <= trace[k+1]['seconds'] for k in range(len(trace)-1))
+
+  # early stop requested by the callback
+  calls = []
+  def stop_after_two(state):
+    calls.append(state)
+    return state['iteration'] == 1
+  T.train(negatives, positives, callback=stop_after_two)
+  nose.tools.eq_(len(calls), 2)
+
+  # exceptions in the callback are passed on
+  def fail(state):
+    raise ValueError("stop")
+  nose.tools.assert_raises(ValueError, T.train, negatives, positives, callback=fail)
+  nose.tools.assert_raises(TypeError, T.train, negatives, positives, callback=1)
+
+
+def test_cglogreg_solvers():
+
+  numpy.random.seed(42)
+  # badly conditioned data, with very different scales of the features
+  scales = numpy.array([1., 10., 0.1, 100.])
+  negatives = numpy.random.normal(0., 1., (200, 4)) * scales
+  positives = numpy.random.normal(0.5, 1., (200, 4)) * scales
+
+  for reg in (0., 1.):
+    reference = CGLogRegTrainer(0.5, 1e-12, 100000, reg).train(negatives, positives)
+    for solver in ('lbfgs', 'newton-cg'):
+      T = CGLogRegTrainer(0.5, 1e-12, 1000, reg, solver=solver)
+      nose.tools.eq_(T.solver, solver)
+      trace = []
+      machine = T.train(negatives, positives, callback=trace.append)
+      assert numpy.allclose(machine.weights, reference.weights, rtol=1e-5, atol=1e-8), (solver, machine.weights, reference.weights)
+      assert numpy.allclose(machine.biases, reference.biases, rtol=1e-5, atol=1e-8), (solver, machine.biases, reference.biases)
+      assert trace[-1]['objective'] <= trace[0]['objective']
+
+  T = CGLogRegTrainer()
+  nose.tools.eq_(T.solver, 'cg')
+  T.solver = 'newton-cg'
+  nose.tools.eq_(CGLogRegTrainer(T).solver, 'newton-cg')
+  assert T != CGLogRegTrainer()
+  nose.tools.assert_raises(ValueError, setattr, T, 'solver', 'sgd')
+  nose.tools.assert_raises(ValueError, CGLogRegTrainer, solver='sgd')
+
+
+def test_minibatch_logreg():
+
+  numpy.random.seed(0)
+  negatives = numpy.random.normal(0., 1., (1000, 3))
+  positives = numpy.random.normal(0.7, 1., (1000, 3))
+  negatives[:,2] *= 20.
+  positives[:,2] *= 20.
+
+  for norm in (False, True):
+    for reg in (0., 1.):
+      reference = CGLogRegTrainer(0.3, 1e-10, 100000, reg, norm).train(negatives, positives)
+      T = MiniBatchLogRegTrainer(0.3, reg, norm, batch_size=64, epochs=50)
+      machine = T.train(negatives, positives)
+      assert numpy.allclose(machine.input_subtract, reference.input_subtract)
+      assert numpy.allclose(machine.input_divide, reference.input_divide)
+      assert numpy.allclose(machine.weights, reference.weights, atol=0.03), (machine.weights, reference.weights)
+      assert numpy.allclose(machine.biases, reference.biases, atol=0.03), (machine.biases, reference.biases)
+
+  # training on chunks, which are read again in each epoch
+  def chunks():
+    for i in range(0, 1000, 300):
+      yield negatives[i:i+300], positives[i:i+300]
+
+  T = MiniBatchLogRegTrainer(0.3, 1., True, batch_size=64, epochs=5)
+  machine = T.train(chunks)
+
+  # ... is identical to controlling the training chunk by chunk
+  T.initialize()
+  for n, p in chunks():
+    T.accumulate(n, p)
+  losses = []
+  for epoch in range(5):
+    losses.append(sum(T.update(n, p) for n, p in chunks()))
+  manual = T.finalize()
+  assert numpy.allclose(manual.weights, machine.weights, rtol=1e-12, atol=1e-12)
+  assert numpy.allclose(manual.biases, machine.biases, rtol=1e-12, atol=1e-12)
+  assert numpy.allclose(manual.input_subtract, reference.input_subtract)
+  assert numpy.allclose(manual.input_divide, reference.input_divide)
+  assert losses[-1] < losses[0]
+
+  # the copy keeps the state of the training
+  C = MiniBatchLogRegTrainer(T)
+  assert C == T
+  n, p = next(chunks())
+  nose.tools.eq_(C.update(n, p), T.update(n, p))
+
+  # parameters and errors
+  nose.tools.eq_((T.prior, T.reg, T.mean_std_norm, T.batch_size, T.epochs), (0.3, 1., True, 64, 5))
+  T.learning_rate = 0.1
+  assert T != C
+  nose.tools.assert_raises(ValueError, MiniBatchLogRegTrainer, batch_size=0)
+  nose.tools.assert_raises(RuntimeError, MiniBatchLogRegTrainer, prior=1.)
+  nose.tools.assert_raises(RuntimeError, T.accumulate, n, p)
+  T.initialize()
+  nose.tools.assert_raises(RuntimeError, T.update, n, p)
+  nose.tools.assert_raises(TypeError, T.accumulate, n, p[:,:2])
+
+
+def test_multinomial_logreg():
+
+  numpy.random.seed(1)
+  negatives = numpy.random.normal(0., 1., (150, 3))
+  positives = numpy.random.normal(1., 1., (100, 3))
+
+  # for two classes, the difference of the logits is the two-class solution,
+  # where the synthetic prior is the proportion of the positives
+  machine = MultinomialLogRegTrainer(1e-10).train([negatives, positives])
+  nose.tools.eq_(machine.shape, (3, 2))
+  assert isinstance(machine.activation, Identity)
+  prior = 100. / 250.
+  reference = CGLogRegTrainer(prior, 1e-12, 100000).train(negatives, positives)
+  assert numpy.allclose(machine.weights[:,1] - machine.weights[:,0], reference.weights[:,0], rtol=1e-5, atol=1e-8)
+  assert numpy.allclose(machine.biases[1] - machine.biases[0], reference.biases[0] + math.log(prior / (1. - prior)), rtol=1e-5, atol=1e-8)
+
+  # three classes: the gradient of the regularized negative log-likelihood
+  # vanishes at the solution
+  data = [numpy.random.normal(m, 1., (n, 2)) for m, n in ((0., 80), (2., 50), (-2., 70))]
+  for reg, norm in ((0., False), (1., True)):
+    trace = []
+    T = MultinomialLogRegTrainer(1e-10, 1000, reg, norm)
+    machine = T.train(data, callback=trace.append)
+    assert trace[-1]['objective'] < trace[0]['objective']
+    x = numpy.vstack([(d - machine.input_subtract) / machine.input_divide for d in data])
+    x = numpy.hstack([x, numpy.ones((len(x), 1))])
+    labels = numpy.hstack([[k] * len(d) for k, d in enumerate(data)])
+    W = numpy.vstack([machine.weights, machine.biases])
+    logits = numpy.dot(x, W)
+    probabilities = numpy.exp(logits - logits.max(1)[:,numpy.newaxis])
+    probabilities /= probabilities.sum(1)[:,numpy.newaxis]
+    probabilities[numpy.arange(len(labels)), labels] -= 1.
+    assert numpy.allclose(numpy.dot(x.T, probabilities) + reg * W, 0., atol=1e-6)
+    # the machine outputs the logits
+    assert numpy.allclose(machine(numpy.vstack(data)), logits)
+    assert numpy.mean(numpy.argmax(machine(numpy.vstack(data)), 1) == labels) > 0.8
+
+  C = MultinomialLogRegTrainer(T)
+  assert C == T
+  C.reg = 0.5
+  assert C != T
+  nose.tools.eq_((T.convergence_threshold, T.max_iterations, T.reg, T.mean_std_norm), (1e-10, 1000, 1., True))
+  nose.tools.assert_raises(RuntimeError, T.train, data[:1])
+  nose.tools.assert_raises(TypeError, T.train, data, callback=1)
+
+
+def test_cglogreg_warm_start():
+
+  numpy.random.seed(3)
+  negatives = numpy.random.normal(0., 1., (200, 3)) * [1., 5., 0.2]
+  positives = numpy.random.normal(0.5, 1., (150, 3)) * [1., 5., 0.2]
+
+  T = CGLogRegTrainer(0.5, 1e-10, 10000, 0.1, solver='lbfgs')
+  reference = T.train(negatives, positives)
+  nose.tools.eq_(T.warm_start, False)
+
+  # starting from the solution, even with another normalization, the
+  # objective does not change
+  for norm in (False, True):
+    W = CGLogRegTrainer(0.5, 1e-10, 10000, 0.1, norm, 'lbfgs', True)
+    assert W.warm_start
+    machine = Machine(reference)
+    trace = []
+    W.train(negatives, positives, machine, callback=trace.append)
+    assert len(trace) <= 3, len(trace)
+    assert abs(trace[0]['objective'] - trace[-1]['objective']) < 1e-8 * abs(trace[-1]['objective'])
+    if not norm:
+      assert numpy.allclose(machine.weights, reference.weights, rtol=1e-6, atol=1e-10)
+      assert numpy.allclose(machine.biases, reference.biases, rtol=1e-6, atol=1e-10)
+  assert W != CGLogRegTrainer(0.5, 1e-10, 10000, 0.1, norm, 'lbfgs')
+
+  # the regularization path gives the same machines as separate trainings
+  lambdas = [100., 10., 1., 0.1, 0.]
+  for solver in ('cg', 'lbfgs', 'newton-cg'):
+    T = CGLogRegTrainer(0.5, 1e-10, 100000, 5., True, solver)
+    machines = T.train_path(negatives, positives, lambdas)
+    nose.tools.eq_(len(machines), len(lambdas))
+    nose.tools.eq_(T.reg, 5.)
+    for machine, reg in zip(machines, lambdas):
+      T.reg = reg
+      reference = T.train(negatives, positives)
+      assert numpy.allclose(machine.weights, reference.weights, rtol=1e-5, atol=1e-7), (solver, reg)
+      assert numpy.allclose(machine.biases, reference.biases, rtol=1e-5, atol=1e-7), (solver, reg)
+      assert numpy.allclose(machine.input_subtract, reference.input_subtract)
+      assert numpy.allclose(machine.input_divide, reference.input_divide)
+  nose.tools.eq_(T.train_path(negatives, positives, []), [])
+
+
+class _CSRMatrix:
+  """A minimal sparse matrix in the CSR format, as scipy.sparse.csr_matrix"""
+
+  def __init__(self, dense):
+    self.shape = dense.shape
+    rows, self.indices = numpy.nonzero(dense)
+    self.data = dense[rows, self.indices]
+    self.indptr = numpy.searchsorted(rows, numpy.arange(dense.shape[0]+1)).astype(numpy.int32)
+    self.indices = self.indices.astype(numpy.int32)
+
+
+def test_cglogreg_sparse():
+
+  numpy.random.seed(5)
+  negatives = numpy.random.normal(0., 1., (200, 6)) * (numpy.random.uniform(size=(200, 6)) < 0.3)
+  positives = numpy.random.normal(0.8, 1., (150, 6)) * (numpy.random.uniform(size=(150, 6)) < 0.3)
+
+  # sparse training gives the same machines as dense training, including the
+  # implicit mean and standard deviation normalization
+  for norm in (False, True):
+    for solver in ('cg', 'lbfgs', 'newton-cg'):
+      T = CGLogRegTrainer(0.3, 1e-10, 100000, 0.1, norm, solver)
+      reference = T.train(negatives, positives)
+      machine = T.train(_CSRMatrix(negatives), _CSRMatrix(positives))
+      assert numpy.allclose(machine.weights, reference.weights, rtol=1e-5, atol=1e-7), (norm, solver)
+      assert numpy.allclose(machine.biases, reference.biases, rtol=1e-5, atol=1e-7), (norm, solver)
+      assert numpy.allclose(machine.input_subtract, reference.input_subtract)
+      assert numpy.allclose(machine.input_divide, reference.input_divide)
+
+      # the projection of sparse data is the one of the dense data
+      data = numpy.vstack((negatives, positives))
+      assert numpy.allclose(machine(_CSRMatrix(data)), machine(data))
+
+  # features that are zero throughout are not scaled
+  negatives[:,2] = 0.
+  positives[:,2] = 0.
+  T = CGLogRegTrainer(0.3, 1e-10, 100000, 0.1, True, 'lbfgs')
+  machine = T.train(_CSRMatrix(negatives), _CSRMatrix(positives))
+  nose.tools.eq_(machine.input_divide[2], 1.)
+  nose.tools.eq_(machine.weights[2,0], 0.)
+  assert numpy.all(numpy.isfinite(machine.weights))
+  nose.tools.assert_raises(TypeError, T.train, _CSRMatrix(negatives), positives)
+
+  # sparse projection with several outputs and an activation
+  machine = Machine(numpy.random.normal(size=(6, 3)))
+  machine.input_subtract = numpy.random.normal(size=6)
+  machine.input_divide = numpy.random.uniform(0.5, 2., size=6)
+  machine.biases = numpy.random.normal(size=3)
+  machine.activation = HyperbolicTangent()
+  output = numpy.ndarray((200, 3), 'float64')
+  machine(_CSRMatrix(negatives), output)
+  assert numpy.allclose(output, machine(negatives))
+  nose.tools.assert_raises(RuntimeError, machine, _CSRMatrix(negatives[:,:5]))
+
+
 def test_pca_signal():
 
    data = numpy.array([[3,-3,100], [4,-4,50], [3.5,-3.5,-50], [3.8,-3.7,-100]], dtype='float64')
@@ -991,3 +1472,44 @@ def test_pca_signal_safe():
                               [-1.,    -0.003, -0.   ]])   
    assert (abs(machine.weights - weights_ref) < 1e-3).all()
 
+
+
+def test_training_stats():
+
+  numpy.random.seed(42)
+  data = numpy.random.normal(0., 1., (50, 5))
+  classes = [numpy.random.normal(float(k), 1., (20, 5)) for k in range(3)]
+  weights = [numpy.ones(len(c)) for c in classes]
+
+  trainers = (
+    (PCATrainer(), (data,), {}, ['scatter', 'decomposition', 'truncation', 'machine update']),
+    (PCATrainer(False), (data,), {'weights': numpy.ones(len(data))}, ['scatter', 'decomposition', 'truncation', 'machine update']),
+    (FisherLDATrainer(), (classes,), {}, ['scatter', 'decomposition', 'truncation', 'machine update']),
+    (FisherLDATrainer(), (classes,), {'weights': weights}, ['scatter', 'decomposition', 'truncation', 'machine update']),
+    (WCCNTrainer(), (classes,), {}, ['scatter', 'decomposition', 'machine update']),
+    (WCCNTrainer(), (classes,), {'weights': weights}, ['scatter', 'decomposition', 'machine update']),
+    (WhiteningTrainer(), (data,), {}, ['scatter', 'decomposition', 'machine update']),
+  )
+
+  for trainer, args, kwargs, phases in trainers:
+    # no statistics are collected by default
+    nose.tools.eq_(trainer.collect_stats, False)
+    nose.tools.eq_(trainer.stats, None)
+
+    trainer.collect_stats = True
+    nose.tools.eq_(trainer.stats, [])
+    trainer.train(*args, **kwargs)
+    stats = trainer.stats
+    nose.tools.eq_([s['phase'] for s in stats], phases)
+    for s in stats:
+      assert s['seconds'] >= 0.
+      assert s['estimated_bytes'] >= 0
+    # the scatter matrices are allocated in the first phase
+    assert stats[0]['estimated_bytes'] >= 5 * 5 * 8
+
+    # each training replaces the statistics of the previous one
+    trainer.train(*args, **kwargs)
+    nose.tools.eq_(len(trainer.stats), len(phases))
+
+    trainer.collect_stats = False
+    nose.tools.eq_(trainer.stats, None)
@@ -0,0 +1,32 @@
+#!/usr/bin/env python
+# vim: set fileencoding=utf-8 :
+# Sun Oct 18 10:12:41 CEST 2026
+#
+# Copyright (C) Idiap Research Institute, Martigny, Switzerland
+
+"""Test the benchmark script
+"""
+
+import os
+import json
+from bob.io.base.test_utils import temporary_filename
+
+from .script.benchmark import main
+
+
+def test_benchmark():
+
+  filename = temporary_filename(suffix='.json')
+  assert main(['--quick', '--repeat', '1', '--output', filename]) == 0
+  with open(filename) as f:
+    report = json.load(f)
+  os.unlink(filename)
+
+  benchmarks = set(r['benchmark'] for r in report['results'])
+  assert benchmarks == set(('forward', 'train', 'logreg', 'bic'))
+  for r in report['results']:
+    assert r['min_seconds'] <= r['median_seconds']
+    assert r['throughput'] > 0
+    if r['benchmark'] == 'logreg':
+      assert 0 < r['iterations_run'] <= r['parameters']['iterations']
+  assert report['package'] == 'bob.learn.linear'
@@ -97,6 +97,12 @@ def test_BIC():
   # while a positive vector should give a positive result
   assert machine(eval_data(1)) > 0.
 
+  # several inputs are scored in a single call
+  inputs = numpy.vstack((eval_data(0), eval_data(1), intra_data))
+  scores = machine(inputs)
+  assert scores.shape == (7,)
+  assert numpy.allclose(scores, [machine(i) for i in inputs])
+
   machine2 = trainer.train(intra_data, extra_data)
   # For some reason, the == test fails on 32 bit machines
 #  assert machine == machine2
@@ -155,3 +161,31 @@ def test_bic_split_between_factors():
         for f1 in factor1[i1]:
           for f2 in factor2[i2]:
             assert (f1, f2) in extra_pairs
+
+def test_BIC_high_dimensional():
+  # Tests the BIC training with less data than dimensions, compared to a direct numpy implementation
+  numpy.random.seed(42)
+  intra_data = numpy.random.normal(0., 1., (10, 20))
+  extra_data = numpy.random.normal(0., 3., (12, 20))
+
+  trainer = bob.learn.linear.BICTrainer(3,4)
+  machine = bob.learn.linear.BICMachine(True)
+  trainer.train(intra_data, extra_data, machine)
+
+  def reference(data, dim):
+    mean = numpy.mean(data, axis=0)
+    eigenvalues, eigenvectors = numpy.linalg.eigh(numpy.cov(data, rowvar=False))
+    eigenvalues, eigenvectors = eigenvalues[::-1], eigenvectors[:,::-1]
+    rho = numpy.mean(eigenvalues[dim:data.shape[0]-1])
+    return mean, eigenvalues[:dim], eigenvectors[:,:dim], rho
+
+  def distance(probe, model):
+    mean, variances, projection, rho = model
+    diff = probe - mean
+    projected = numpy.dot(diff, projection)
+    return numpy.sum(projected**2 / variances) + (numpy.sum(diff**2) - numpy.sum(projected**2)) / rho
+
+  intra, extra = reference(intra_data, 3), reference(extra_data, 4)
+  for probe in numpy.random.normal(0., 2., (5, 20)):
+    expected = (distance(probe, extra) - distance(probe, intra)) / 7.
+    assert abs(machine(probe) - expected) < 1e-8 * max(1., abs(expected))
@@ -0,0 +1,81 @@
+#!/usr/bin/env python
+# vim: set fileencoding=utf-8 :
+# Sun Oct 18 17:40:27 CEST 2026
+#
+# Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+
+"""Test the k-fold cross-validation of the trainers
+"""
+
+import numpy
+import nose.tools
+
+from . import cross_validate, PCATrainer, FisherLDATrainer, CGLogRegTrainer
+
+
+def test_cross_validate_pca():
+
+  numpy.random.seed(42)
+  data = numpy.random.normal(0., 1., (60, 5)) * [1., 2., 3., 4., 5.]
+  folds = numpy.arange(60) % 4
+
+  trainer = PCATrainer(False)
+  machines, scores = cross_validate(trainer, data, folds, 3)
+  nose.tools.eq_(len(machines), 4)
+  nose.tools.eq_(scores.shape, (60, 5))
+  for k, machine in enumerate(machines):
+    reference, _ = trainer.train(data[folds != k])
+    assert numpy.allclose(abs(machine.weights), abs(reference.weights))
+    assert numpy.allclose(machine.input_subtract, reference.input_subtract)
+    assert numpy.allclose(scores[folds == k], machine(data[folds == k]))
+
+  # the number of threads does not change the results
+  machines2, scores2 = cross_validate(trainer, data, folds, n_threads=1)
+  assert numpy.allclose(scores, scores2)
+
+
+def test_cross_validate_lda():
+
+  numpy.random.seed(42)
+  classes = [numpy.random.normal(float(k), 1. + k, (20, 5)) for k in range(3)]
+  folds = [numpy.arange(20) % 5 for k in range(3)]
+
+  trainer = FisherLDATrainer()
+  machines, scores = cross_validate(trainer, classes, folds)
+  nose.tools.eq_(len(machines), 5)
+  nose.tools.eq_(len(scores), 3)
+  for k, machine in enumerate(machines):
+    reference, _ = trainer.train([c[f != k] for c, f in zip(classes, folds)])
+    assert numpy.allclose(abs(machine.weights), abs(reference.weights))
+    for c, f, s in zip(classes, folds, scores):
+      assert numpy.allclose(s[f == k], machine(c[f == k]))
+
+
+def test_cross_validate_logreg():
+
+  numpy.random.seed(3)
+  negatives = numpy.random.normal(0., 1., (100, 3))
+  positives = numpy.random.normal(0.8, 1., (80, 3))
+  folds = (numpy.arange(100) % 3, numpy.arange(80) % 3)
+
+  trainer = CGLogRegTrainer(0.5, 1e-10, 10000, 0.1, True, 'lbfgs')
+  machines, (negative_scores, positive_scores) = cross_validate(trainer, (negatives, positives), folds)
+  nose.tools.eq_(len(machines), 3)
+  nose.tools.eq_(negative_scores.shape, (100,))
+  for k, machine in enumerate(machines):
+    reference = trainer.train(negatives[folds[0] != k], positives[folds[1] != k])
+    assert numpy.allclose(machine.weights, reference.weights)
+    assert numpy.allclose(machine.biases, reference.biases)
+    assert numpy.allclose(negative_scores[folds[0] == k], machine(negatives[folds[0] == k])[:,0])
+    assert numpy.allclose(positive_scores[folds[1] == k], machine(positives[folds[1] == k])[:,0])
+
+
+def test_cross_validate_errors():
+
+  data = numpy.random.normal(0., 1., (10, 3))
+  trainer = PCATrainer()
+  nose.tools.assert_raises(RuntimeError, cross_validate, trainer, data, numpy.zeros(10, int))
+  nose.tools.assert_raises(RuntimeError, cross_validate, trainer, data, numpy.arange(10) - 1)
+  nose.tools.assert_raises(RuntimeError, cross_validate, trainer, data, numpy.arange(9) % 2)
+  nose.tools.assert_raises(TypeError, cross_validate, object(), data, numpy.arange(10) % 2)
+  nose.tools.assert_raises(RuntimeError, cross_validate, CGLogRegTrainer(), [data], [numpy.arange(10) % 2])
@@ -181,3 +181,110 @@ def test_load_save():
     reference = 2.4674011002723324
     assert abs(gfk_machine.compute_principal_angles()-reference) < 0.00001
     assert abs(gfk_machine.compute_binetcouchy_distance() - 0) < 0.00001
+
+
+def test_kernel():
+    """
+
+    Testing the batched kernel evaluation
+    """
+    import numpy
+    numpy.random.seed(10)
+
+    train_source_data = numpy.random.normal(0, 1, size=(100, 5))
+    train_target_data = numpy.random.normal(2, 1, size=(100, 5))
+
+    test_source_data = numpy.random.normal(0, 1, size=(7, 5))
+    test_target_data = numpy.random.normal(3, 1, size=(9, 5))
+
+    gfk_trainer = GFKTrainer(2, subspace_dim_source=2, subspace_dim_target=2)
+    gfk_machine = gfk_trainer.train(train_source_data, train_target_data)
+
+    # reference computed with the dense kernel matrix
+    source = (test_source_data - gfk_machine.source_machine.input_subtract) / gfk_machine.source_machine.input_divide
+    target = (test_target_data - gfk_machine.target_machine.input_subtract) / gfk_machine.target_machine.input_divide
+    reference = numpy.dot(numpy.dot(source, gfk_machine.G), target.T)
+
+    # factored kernel
+    kernel = gfk_machine.kernel(test_source_data, test_target_data)
+    assert kernel.shape == (7, 9)
+    assert numpy.allclose(kernel, reference)
+    assert numpy.allclose(gfk_machine(test_source_data, test_target_data), reference[0])
+
+    # single samples give single products, as with numpy.dot
+    products = gfk_machine(test_source_data[2], test_target_data)
+    assert numpy.ndim(products) == 0
+    assert numpy.allclose(products, reference[2, 0])
+    products = gfk_machine(test_source_data, test_target_data[4])
+    assert numpy.ndim(products) == 0
+    assert numpy.allclose(products, reference[0, 4])
+
+    # dense kernel
+    kernel = bob.learn.linear.gfk_kernel(gfk_machine.source_machine, gfk_machine.target_machine, test_source_data, test_target_data, gfk_machine.G)
+    assert numpy.allclose(kernel, reference)
+
+
+def test_factored():
+    """
+
+    Testing the factored storage of the kernel matrix
+    """
+    import numpy
+    numpy.random.seed(10)
+
+    train_source_data = numpy.random.normal(0, 1, size=(100, 5))
+    train_target_data = numpy.random.normal(2, 1, size=(100, 5))
+
+    test_source_data = numpy.random.normal(0, 1, size=(7, 5))
+    test_target_data = numpy.random.normal(3, 1, size=(9, 5))
+
+    dense_machine = GFKTrainer(2, subspace_dim_source=2, subspace_dim_target=2).train(train_source_data, train_target_data)
+    gfk_machine = GFKTrainer(2, subspace_dim_source=2, subspace_dim_target=2, factored=True).train(train_source_data, train_target_data)
+
+    assert gfk_machine.factored
+    assert not dense_machine.factored
+    assert gfk_machine.basis.shape == (5, 4)
+    assert gfk_machine.shape() == (5, 5)
+    assert numpy.allclose(gfk_machine.G, dense_machine.G)
+
+    hdf5_file = "gfk_factored.hdf5"
+    hdf5 = bob.io.base.HDF5File(hdf5_file, 'w')
+    gfk_machine.save(hdf5)
+    del hdf5
+
+    hdf5 = bob.io.base.HDF5File(hdf5_file)
+    assert not hdf5.has_dataset("G")
+    loaded = GFKMachine(hdf5)
+    del hdf5
+    os.remove(hdf5_file)
+
+    assert loaded.factored
+    assert numpy.allclose(loaded.core, gfk_machine.core)
+    assert numpy.allclose(loaded.kernel(test_source_data, test_target_data), dense_machine.kernel(test_source_data, test_target_data))
+
+
+def test_fused_normalization():
+    """
+
+    Testing the PCA on the z-normalized data against numpy
+    """
+    import numpy
+    numpy.random.seed(10)
+
+    train_source_data = numpy.random.normal(0, 1, size=(100, 5)) * [1., 2., 3., 4., 5.]
+    train_target_data = numpy.random.normal(2, 1, size=(80, 5))
+
+    gfk_machine = GFKTrainer(2, subspace_dim_source=3, subspace_dim_target=2).train(train_source_data, train_target_data)
+
+    for data, machine in ((train_source_data, gfk_machine.source_machine), (train_target_data, gfk_machine.target_machine)):
+        assert numpy.allclose(machine.input_subtract, numpy.mean(data, axis=0))
+        assert numpy.allclose(machine.input_divide, numpy.std(data, axis=0))
+
+        # the projection spans the leading eigenvectors of the normalized covariance
+        normalized = (data - machine.input_subtract) / machine.input_divide
+        eigenvalues, eigenvectors = numpy.linalg.eigh(numpy.cov(normalized, rowvar=False))
+        reference = eigenvectors[:, ::-1][:, :machine.shape[1]]
+        assert numpy.allclose(numpy.abs(numpy.dot(reference.T, machine.weights)), numpy.eye(machine.shape[1]))
+
+    # copies compare equal
+    assert GFKMachine(gfk_machine) == gfk_machine
@@ -2,7 +2,8 @@
 # vim: set fileencoding=utf-8 :
 # Tiago de Freitas Pereira <tiago.pereira@idiap.ch>
 
-from bob.learn.linear import Machine
+from bob.learn.linear import Machine, PCATrainer, BICTrainer, BICMachine
+from bob.learn.activation import HyperbolicTangent
 import numpy
 import pickle
 
@@ -17,4 +18,47 @@ def test_machine():
     
     assert numpy.allclose(machine.weights, machine_after_pickle.weights, 10e-3)
     assert numpy.allclose(machine.input_div, machine_after_pickle.input_div, 10e-3)
-    assert numpy.allclose(machine.input_sub, machine_after_pickle.input_sub, 10e-3)
\ No newline at end of file
+    assert numpy.allclose(machine.input_sub, machine_after_pickle.input_sub, 10e-3)
+
+def test_protocols():
+    numpy.random.seed(42)
+    data = numpy.random.normal(0., 1., (20, 5))
+    trained = PCATrainer().train(data)[0]
+    trained.activation = HyperbolicTangent()
+    for machine in (trained, Machine(trained)):
+        for protocol in range(2, pickle.HIGHEST_PROTOCOL + 1):
+            machine_after_pickle = pickle.loads(pickle.dumps(machine, protocol))
+            assert machine_after_pickle == machine
+            assert isinstance(machine_after_pickle, Machine)
+
+
+def test_out_of_band():
+    if pickle.HIGHEST_PROTOCOL < 5:
+        return
+    numpy.random.seed(42)
+    machine = Machine(numpy.random.normal(0., 1., (100, 30)))
+    machine.biases = numpy.random.normal(0., 1., (30,))
+
+    # the weights and the vectors are handed over without copies
+    buffers = []
+    data = pickle.dumps(machine, 5, buffer_callback=buffers.append)
+    assert len(buffers) == 4
+    assert len(data) < machine.weights.nbytes
+    assert any(numpy.shares_memory(numpy.asarray(b), machine.weights) for b in buffers)
+
+    machine_after_pickle = pickle.loads(data, buffers=buffers)
+    assert machine_after_pickle == machine
+    assert not numpy.shares_memory(machine_after_pickle.weights, machine.weights)
+
+
+def test_bic():
+    numpy.random.seed(42)
+    intra = numpy.random.normal(0., 1., (20, 5))
+    extra = numpy.random.normal(0., 3., (20, 5))
+    for trainer, use_dffs in ((BICTrainer(), False), (BICTrainer(2, 2), True)):
+        machine = trainer.train(intra, extra, BICMachine(use_dffs))
+        for protocol in range(2, pickle.HIGHEST_PROTOCOL + 1):
+            machine_after_pickle = pickle.loads(pickle.dumps(machine, protocol))
+            assert machine_after_pickle == machine
+            assert machine_after_pickle.use_DFFS == use_dffs
+            assert machine_after_pickle(intra[0]) == machine(intra[0])
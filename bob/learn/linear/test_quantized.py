@@ -0,0 +1,106 @@
+#!/usr/bin/env python
+# vim: set fileencoding=utf-8 :
+# Sun Oct 18 19:05:12 CEST 2026
+#
+# Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+
+"""Test the linear machine with 8-bit integer weights
+"""
+
+import os
+import numpy
+import nose.tools
+import bob.io.base
+import bob.learn.activation
+from bob.io.base.test_utils import temporary_filename
+
+from . import Machine, QuantizedMachine
+
+
+def machine(n_inputs=20, n_outputs=5):
+  """Creates a machine with random parameters"""
+  numpy.random.seed(42)
+  m = Machine(n_inputs, n_outputs)
+  m.weights = numpy.random.normal(0., 1., (n_inputs, n_outputs))
+  m.biases = numpy.random.normal(0., 1., n_outputs)
+  m.input_subtract = numpy.random.normal(0., 1., n_inputs)
+  m.input_divide = numpy.random.uniform(0.5, 2., n_inputs)
+  return m
+
+
+def test_quantize():
+
+  m = machine()
+  q = QuantizedMachine(m)
+  nose.tools.eq_(q.shape, m.shape)
+  nose.tools.eq_(q.weights.dtype, numpy.int8)
+  nose.tools.eq_(q.weights.shape, m.weights.shape)
+  assert abs(q.weights).max() == 127
+  assert numpy.allclose(q.weights * q.scales, m.weights, atol=q.scales.max() / 2.)
+  assert numpy.allclose(q.biases, m.biases)
+  assert numpy.allclose(q.input_subtract, m.input_subtract)
+  assert numpy.allclose(q.input_divide, m.input_divide)
+  assert QuantizedMachine(q) == q
+
+
+def test_forward():
+
+  m = machine()
+  q = QuantizedMachine(m)
+  data = numpy.random.normal(0., 1., (200, 20))
+
+  # the batch projection gives the same results as the one of each sample
+  output = q(data)
+  nose.tools.eq_(output.shape, (200, 5))
+  for sample, expected in zip(data, output):
+    assert numpy.allclose(q(sample), expected)
+  output2 = numpy.ndarray((200, 5))
+  q.forward(data, output2)
+  assert numpy.allclose(output, output2)
+
+  # the outputs are close to the ones of the original machine
+  reference = m(data)
+  assert abs(output - reference).max() < 0.02 * abs(reference).max()
+
+  nose.tools.assert_raises(RuntimeError, q.forward, data[:, :10])
+
+
+def test_accuracy():
+
+  m = machine()
+  data = numpy.random.normal(0., 1., (200, 20))
+  report = QuantizedMachine(m).accuracy(m, data)
+  error = abs(QuantizedMachine(m)(data) - m(data))
+  assert numpy.allclose(report['max_error'], error.max())
+  assert numpy.allclose(report['mean_error'], error.mean())
+  assert numpy.allclose(report['rms_error'], numpy.sqrt((error ** 2).mean()))
+  assert numpy.allclose(report['max_reference'], abs(m(data)).max())
+  assert report['agreement'] > 0.95
+
+  # a single output with an activation compares the side of the threshold
+  m = machine(20, 1)
+  m.activation = bob.learn.activation.Logistic()
+  report = QuantizedMachine(m).accuracy(m, data)
+  assert report['max_error'] < 0.05
+  assert report['agreement'] > 0.95
+
+  nose.tools.assert_raises(RuntimeError, QuantizedMachine(m).accuracy, machine(), data)
+
+
+def test_save_load():
+
+  m = machine()
+  m.activation = bob.learn.activation.HyperbolicTangent()
+  q = QuantizedMachine(m)
+  filename = temporary_filename()
+  try:
+    q.save(bob.io.base.HDF5File(filename, 'w'))
+    q2 = QuantizedMachine(bob.io.base.HDF5File(filename))
+    assert q2 == q
+    assert q2.activation == q.activation
+    nose.tools.eq_(bob.io.base.HDF5File(filename).read('weights').dtype, numpy.int8)
+
+    data = numpy.random.normal(0., 1., (10, 20))
+    assert numpy.array_equal(q2(data), q(data))
+  finally:
+    os.unlink(filename)
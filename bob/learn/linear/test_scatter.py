@@ -0,0 +1,209 @@
+#!/usr/bin/env python
+# vim: set fileencoding=utf-8 :
+# Sun Oct 18 10:12:41 CEST 2026
+#
+# Copyright (C) 2011-2014 Idiap Research Institute, Martigny, Switzerland
+
+"""Test the scatter accumulator and the training from accumulated statistics
+"""
+
+import os
+import numpy
+import nose.tools
+import bob.io.base
+from bob.io.base.test_utils import temporary_filename
+
+from . import ScatterAccumulator, PCATrainer, FisherLDATrainer, \
+    WhiteningTrainer, WCCNTrainer, BICTrainer, BICMachine
+
+
+def accumulate(data, shards):
+  """Accumulates the statistics of the given data in several shards, writes
+  them to HDF5 and merges the loaded statistics again"""
+  filenames = []
+  for block in numpy.array_split(data, shards):
+    acc = ScatterAccumulator()
+    for chunk in numpy.array_split(block, 2):
+      acc.update(chunk)
+    filename = temporary_filename()
+    acc.save(bob.io.base.HDF5File(filename, 'w'))
+    filenames.append(filename)
+
+  merged = ScatterAccumulator(data.shape[1])
+  for filename in filenames:
+    merged.merge(ScatterAccumulator(bob.io.base.HDF5File(filename)))
+    os.unlink(filename)
+  return merged
+
+
+def test_accumulator():
+
+  numpy.random.seed(42)
+  data = numpy.random.normal(0., 2., (50, 4))
+
+  acc = ScatterAccumulator()
+  assert acc.n_samples == 0
+  for sample in data[:10]:
+    acc.update(sample)
+  acc.update(data[10:])
+  assert acc.n_samples == 50
+  assert acc.n_features == 4
+
+  centered = data - data.mean(axis=0)
+  assert numpy.allclose(acc.mean, data.mean(axis=0))
+  assert numpy.allclose(acc.scatter, numpy.dot(centered.T, centered))
+  assert numpy.allclose(acc.covariance, numpy.cov(data, rowvar=False))
+
+  # strided blocks and single rows are read as well
+  for block in (data[::2], numpy.asfortranarray(data), data[:1]):
+    strided = ScatterAccumulator()
+    strided.update(block)
+    centered = block - block.mean(axis=0)
+    assert numpy.allclose(strided.mean, block.mean(axis=0))
+    assert numpy.allclose(strided.scatter, numpy.dot(centered.T, centered))
+
+  # merging sharded statistics gives the same result
+  merged = accumulate(data, 3)
+  assert merged.is_similar_to(acc)
+  assert ScatterAccumulator(merged) == merged
+
+  merged.reset()
+  assert merged.n_samples == 0
+  assert merged.n_features == 4
+  assert merged != acc
+
+
+def test_accumulator_subtract():
+
+  numpy.random.seed(42)
+  data = numpy.random.normal(0., 2., (50, 4)) + [1., -2., 3., 0.]
+  weights = numpy.random.uniform(0.5, 2., 50)
+
+  # subtracting a part of the data leaves the statistics of the rest
+  for w in (None, weights):
+    total, part, rest = ScatterAccumulator(), ScatterAccumulator(), ScatterAccumulator()
+    if w is None:
+      total.update(data); part.update(data[:15]); rest.update(data[15:])
+    else:
+      total.update(data, w); part.update(data[:15], w[:15]); rest.update(data[15:], w[15:])
+    total.subtract(part)
+    assert total.n_samples == 35
+    assert total.is_similar_to(rest)
+    assert numpy.allclose(total.scatter, rest.scatter)
+
+    # which can be merged again
+    total.merge(part)
+    assert total.n_samples == 50
+    rest.merge(part)
+    assert total.is_similar_to(rest)
+
+  total.subtract(total)
+  assert total.n_samples == 0
+  assert total.n_features == 4
+  nose.tools.assert_raises(RuntimeError, part.subtract, rest)
+
+
+@nose.tools.raises(RuntimeError)
+def test_accumulator_dimension():
+  acc = ScatterAccumulator(3)
+  acc.update(numpy.ones((2, 4)))
+
+
+def test_distributed_training():
+
+  numpy.random.seed(42)
+  classes = [numpy.random.normal(float(k), 1. + k, (20, 5)) for k in range(3)]
+  data = numpy.vstack(classes)
+  stats = [accumulate(c, 2) for c in classes]
+  total = accumulate(data, 3)
+
+  # PCA
+  trainer = PCATrainer()
+  trainer.use_svd = False
+  machine, eigenvalues = trainer.train(data)
+  assert trainer.output_size(total) == trainer.output_size(data)
+  machine2, eigenvalues2 = trainer.train(total)
+  assert numpy.allclose(eigenvalues, eigenvalues2)
+  assert numpy.allclose(abs(machine.weights), abs(machine2.weights))
+  assert numpy.allclose(machine.input_subtract, machine2.input_subtract)
+
+  # Whitening
+  trainer = WhiteningTrainer()
+  assert trainer.train(data).is_similar_to(trainer.train(total))
+
+  # LDA
+  trainer = FisherLDATrainer()
+  machine, eigenvalues = trainer.train(classes)
+  assert trainer.output_size(stats) == trainer.output_size(classes)
+  machine2, eigenvalues2 = trainer.train(stats)
+  assert numpy.allclose(eigenvalues, eigenvalues2)
+  assert numpy.allclose(abs(machine.weights), abs(machine2.weights))
+
+  # WCCN
+  trainer = WCCNTrainer()
+  assert trainer.train(classes).is_similar_to(trainer.train(stats))
+
+  # BIC, with and without DFFS
+  intra = numpy.vstack([c[1:] - c[:-1] for c in classes])
+  extra = numpy.vstack([classes[k][:10] - classes[(k+1) % 3][:10] for k in range(3)])
+  for trainer, use_dffs in ((BICTrainer(), False), (BICTrainer(2, 3), True)):
+    machine = trainer.train(intra, extra, BICMachine(use_dffs))
+    machine2 = trainer.train(accumulate(intra, 2), accumulate(extra, 2), BICMachine(use_dffs))
+    for probe in data[:5]:
+      assert abs(machine(probe) - machine2(probe)) < 1e-8 * max(1., abs(machine(probe)))
+
+
+@nose.tools.raises(TypeError)
+def test_distributed_training_mixed():
+  numpy.random.seed(42)
+  classes = [numpy.random.normal(float(k), 1., (10, 3)) for k in range(2)]
+  FisherLDATrainer().train([classes[0], accumulate(classes[1], 1)])
+
+
+def test_weighted_training():
+
+  # integer weights must give the same results as repeating the samples
+  numpy.random.seed(42)
+  classes = [numpy.random.normal(float(k), 1. + k, (15, 4)) for k in range(3)]
+  weights = [numpy.random.randint(0, 4, 15).astype(numpy.float64) for k in range(3)]
+  repeated = [numpy.repeat(c, w.astype(int), axis=0) for c, w in zip(classes, weights)]
+
+  acc = ScatterAccumulator()
+  acc.update(classes[0], weights[0])
+  reference = ScatterAccumulator()
+  reference.update(repeated[0])
+  assert acc.sum_of_weights == weights[0].sum()
+  assert numpy.allclose(acc.mean, reference.mean)
+  assert numpy.allclose(acc.scatter, reference.scatter)
+  assert numpy.allclose(acc.covariance, reference.covariance)
+
+  # PCA, with both methods
+  for use_svd in (True, False):
+    trainer = PCATrainer(use_svd)
+    machine, eigenvalues = trainer.train(classes[0], weights=weights[0])
+    reference, reference_eigenvalues = trainer.train(repeated[0])
+    rank = min(len(eigenvalues), len(reference_eigenvalues))
+    assert numpy.allclose(eigenvalues[:rank], reference_eigenvalues[:rank])
+    assert numpy.allclose(abs(machine.weights[:,:rank]), abs(reference.weights[:,:rank]))
+    assert numpy.allclose(machine.input_subtract, reference.input_subtract)
+
+  # Whitening
+  trainer = WhiteningTrainer()
+  assert trainer.train(classes[0], weights=weights[0]).is_similar_to(trainer.train(repeated[0]))
+
+  # LDA
+  trainer = FisherLDATrainer()
+  machine, eigenvalues = trainer.train(classes, weights=weights)
+  reference, reference_eigenvalues = trainer.train(repeated)
+  assert numpy.allclose(eigenvalues, reference_eigenvalues)
+  assert numpy.allclose(abs(machine.weights), abs(reference.weights))
+
+  # WCCN
+  trainer = WCCNTrainer()
+  assert trainer.train(classes, weights=weights).is_similar_to(trainer.train(repeated))
+
+
+@nose.tools.raises(RuntimeError)
+def test_weighted_training_negative():
+  data = numpy.random.normal(0., 1., (5, 3))
+  PCATrainer().train(data, weights=numpy.array([1., 1., -1., 1., 1.]))
@@ -12,9 +12,12 @@
 #include <bob.blitz/cleanup.h>
 #include <bob.core/config.h>
 #include <bob.learn.linear/api.h>
+#include <boost/make_shared.hpp>
 #include <bob.extension/documentation.h>
 #include <structmember.h>
 
+extern PyObject* PyBobLearnLinear_TrainingStats(const boost::shared_ptr<bob::learn::linear::TrainingStats>& stats);
+
 /*************************************************
  * Implementation of WCCNTrainer base class *
  *************************************************/
@@ -40,14 +43,22 @@ static auto WCCN_doc = bob::extension::ClassDoc(
   "WCCNTrainer",
   "Constructs a new trainer to train a linear machine to perform WCCN"
 )
-.add_prototype("","")
+.add_prototype("[eigenvalue_floor]","")
 .add_prototype("other","")
+.add_parameter("eigenvalue_floor", "float", "[Default: ``0.``] If positive, the eigenvalues of the covariance matrix are floored to this value and the transform is computed from its eigendecomposition, :math:`W = U \\operatorname{diag}(1/\\sqrt{\\max(e, floor)})`, which also handles singular covariance matrices; otherwise, the Cholesky factorization is used")
 .add_parameter("other", ":py:class:`WCCNTrainer`", "Another WCCN trainer to copy")
 );
 static int PyBobLearnLinearWCCNTrainer_init_default
 (PyBobLearnLinearWCCNTrainerObject* self, PyObject* args, PyObject* kwds) {
 BOB_TRY
-  self->cxx = new bob::learn::linear::WCCNTrainer();
+  /* Parses input arguments in a single shot */
+  char** kwlist = WCCN_doc.kwlist(0);
+
+  double eigenvalue_floor = 0.;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "|d", kwlist, &eigenvalue_floor)) return -1;
+
+  self->cxx = new bob::learn::linear::WCCNTrainer(eigenvalue_floor);
   return 0;
 BOB_CATCH_MEMBER("constructor", -1)
 }
@@ -76,7 +87,14 @@ static int PyBobLearnLinearWCCNTrainer_init(PyBobLearnLinearWCCNTrainerObject* s
   Py_ssize_t nargs = (args?PyTuple_Size(args):0) + (kwds?PyDict_Size(kwds):0);
 
   if (nargs == 1) {
-    return PyBobLearnLinearWCCNTrainer_init_copy(self, args, kwds);
+    PyObject* arg = 0; ///< borrowed (don't delete)
+    if (args && PyTuple_Size(args)) arg = PyTuple_GET_ITEM(args, 0);
+    else {
+      PyObject* tmp = PyDict_Values(kwds);
+      auto tmp_ = make_safe(tmp);
+      arg = PyList_GET_ITEM(tmp, 0);
+    }
+    if (PyBobLearnLinearWCCNTrainer_Check(arg)) return PyBobLearnLinearWCCNTrainer_init_copy(self, args, kwds);
   }
 
   return PyBobLearnLinearWCCNTrainer_init_default(self, args, kwds);
@@ -117,7 +135,9 @@ static auto train = bob::extension::FunctionDoc(
   "Trains a linear machine using WCCN",
   "The value of ``X`` should be a sequence over as many 2D 64-bit floating point number arrays as classes in the problem. "
   "All arrays will be checked for conformance (identical number of columns). "
-  "To accomplish this, either prepare a list with all your class observations organized in 2D arrays or pass a 3D array in which the first dimension (depth) contains as many elements as classes you want to train for.\n\n"
+  "To accomplish this, either prepare a list with all your class observations organized in 2D arrays or pass a 3D array in which the first dimension (depth) contains as many elements as classes you want to train for. "
+  "Instead of the data, a list with one :py:class:`bob.learn.linear.ScatterAccumulator` per class can be given. "
+  "Optionally, the samples can be weighted with non-negative frequency ``weights``, given as a sequence with one 1D array per class.\n\n"
   "The resulting machine will have the same number of inputs **and** outputs as columns in any of ``X``'s matrices.\n\n"
   "The user may provide or not an object of type :py:class:`bob.learn.linear.Machine` that will be set by this method. "
   "In such a case, the machine should have a shape that matches ``(X.shape[1], X.shape[1])``. "
@@ -125,9 +145,10 @@ static auto train = bob::extension::FunctionDoc(
   "In both cases, the resulting machine is always returned.",
   true
 )
-.add_prototype("X, [machine]", "machine")
-.add_parameter("X", "[array_like(2D,float)] or array_like(3D, float)", "The training data arranged by class")
+.add_prototype("X, [machine], [weights]", "machine")
+.add_parameter("X", "[array_like(2D,float)] or array_like(3D, float) or [:py:class:`bob.learn.linear.ScatterAccumulator`]", "The training data arranged by class, or the statistics accumulated per class")
 .add_parameter("machine", ":py:class:`bob.learn.linear.Machine`", "A pre-allocated machine to be trained; may be omitted")
+.add_parameter("weights", "[array_like(1D, float)]", "[optional] The frequency weights of the samples, one array per class")
 .add_return("machine", ":py:class:`bob.learn.linear.Machine`", "The trained machine; identical to the ``machine`` parameter, if specified")
 ;
 static PyObject* PyBobLearnLinearWCCNTrainer_Train
@@ -138,9 +159,10 @@ BOB_TRY
 
   PyObject* X = 0;
   PyBobLearnLinearMachineObject* machine = 0;
+  PyObject* weights = 0;
 
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O!", kwlist,
-        &X, &PyBobLearnLinearMachine_Type, &machine)) return 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O!O", kwlist,
+        &X, &PyBobLearnLinearMachine_Type, &machine, &weights)) return 0;
 
   /**
   // Note: strangely, if you pass dict.values(), this check does not work
@@ -153,6 +175,7 @@ BOB_TRY
   /* Checks and converts all entries */
   std::vector<blitz::Array<double,2> > Xseq;
   std::vector<boost::shared_ptr<PyBlitzArrayObject>> Xseq_;
+  std::vector<bob::learn::linear::ScatterAccumulator> stats;
 
   PyObject* iterator = PyObject_GetIter(X);
   if (!iterator) return 0;
@@ -161,6 +184,19 @@ BOB_TRY
   while (PyObject* item = PyIter_Next(iterator)) {
     auto item_ = make_safe(item);
 
+    if (PyBobLearnLinearScatterAccumulator_Check(item)) {
+      if (!Xseq.empty()) {
+        PyErr_Format(PyExc_TypeError, "`%s' cannot mix arrays and accumulated statistics in input sequence `X', but at position %" PY_FORMAT_SIZE_T "d I have found a `%s'", Py_TYPE(self)->tp_name, Xseq.size(), Py_TYPE(item)->tp_name);
+        return 0;
+      }
+      stats.push_back(*reinterpret_cast<PyBobLearnLinearScatterAccumulatorObject*>(item)->cxx);
+      continue;
+    }
+    if (!stats.empty()) {
+      PyErr_Format(PyExc_TypeError, "`%s' cannot mix arrays and accumulated statistics in input sequence `X', but at position %" PY_FORMAT_SIZE_T "d I have found a `%s'", Py_TYPE(self)->tp_name, stats.size(), Py_TYPE(item)->tp_name);
+      return 0;
+    }
+
     PyBlitzArrayObject* bz = 0;
 
     if (!PyBlitzArray_Converter(item, &bz)) {
@@ -180,11 +216,54 @@ BOB_TRY
 
   if (PyErr_Occurred()) return 0;
 
-  if (Xseq.size() < 2) {
-    PyErr_Format(PyExc_RuntimeError, "`%s' requires an iterable for parameter `X' leading to, at least, two entries (representing two classes), but you have passed something that has only %" PY_FORMAT_SIZE_T "d entries", Py_TYPE(self)->tp_name, Xseq.size());
+  const size_t n_classes = stats.empty() ? Xseq.size() : stats.size();
+  if (n_classes < 2) {
+    PyErr_Format(PyExc_RuntimeError, "`%s' requires an iterable for parameter `X' leading to, at least, two entries (representing two classes), but you have passed something that has only %" PY_FORMAT_SIZE_T "d entries", Py_TYPE(self)->tp_name, n_classes);
     return 0;
   }
 
+  /* Checks and converts the weights of all classes */
+  std::vector<blitz::Array<double,1> > Wseq;
+  std::vector<boost::shared_ptr<PyBlitzArrayObject>> Wseq_;
+  if (weights) {
+    if (!stats.empty()) {
+      PyErr_Format(PyExc_TypeError, "`%s' cannot apply `weights' to accumulated statistics; weight the samples when accumulating them instead", Py_TYPE(self)->tp_name);
+      return 0;
+    }
+
+    PyObject* witerator = PyObject_GetIter(weights);
+    if (!witerator) return 0;
+    auto witerator_ = make_safe(witerator);
+
+    while (PyObject* item = PyIter_Next(witerator)) {
+      auto item_ = make_safe(item);
+
+      PyBlitzArrayObject* bz = 0;
+      if (!PyBlitzArray_Converter(item, &bz)) return 0;
+      Wseq_.push_back(make_safe(bz)); ///< prevents data deletion
+
+      if (bz->ndim != 1 || bz->type_num != NPY_FLOAT64) {
+        PyErr_Format(PyExc_TypeError, "`%s' only supports 1D 64-bit float arrays for input sequence `weights', but at position %" PY_FORMAT_SIZE_T "d I have found an object with %" PY_FORMAT_SIZE_T "d dimensions and with type `%s' which is not compatible - check your input", Py_TYPE(self)->tp_name, Wseq.size(), bz->ndim, PyBlitzArray_TypenumAsString(bz->type_num));
+        return 0;
+      }
+      Wseq.push_back(*PyBlitzArrayCxx_AsBlitz<double,1>(bz)); ///< only a view!
+    }
+
+    if (PyErr_Occurred()) return 0;
+  }
+
+  // the dimensionality of the accumulated statistics is checked while training
+  if (!stats.empty()) {
+    Py_ssize_t ncol = stats[0].numberOfFeatures();
+    boost::shared_ptr<PyBobLearnLinearMachineObject> machine_;
+    if (!machine) {
+      machine = reinterpret_cast<PyBobLearnLinearMachineObject*>(PyBobLearnLinearMachine_NewFromSize(ncol, ncol));
+      machine_ = make_safe(machine); ///< auto-delete in case of problems
+    }
+    self->cxx->train(*machine->cxx, stats);
+    return Py_BuildValue("O", machine);
+  }
+
   // checks all elements in X have the same number of columns
   Py_ssize_t ncol = Xseq_[0]->shape[1];
   for (Py_ssize_t k=1; k<(Py_ssize_t)Xseq.size(); ++k) {
@@ -201,12 +280,105 @@ BOB_TRY
     machine_ = make_safe(machine); ///< auto-delete in case of problems
   }
 
-  self->cxx->train(*machine->cxx, Xseq);
+  if (weights) self->cxx->train(*machine->cxx, Xseq, Wseq);
+  else self->cxx->train(*machine->cxx, Xseq);
 
   return Py_BuildValue("O", machine);
 BOB_CATCH_MEMBER("train", 0)
 }
 
+static auto eigenvalue_floor = bob::extension::VariableDoc(
+  "eigenvalue_floor",
+  "float",
+  "The lower bound for the eigenvalues of the covariance matrix",
+  "If set to a positive value, the transform is computed from the eigendecomposition of the covariance matrix with floored eigenvalues. "
+  "If set to ``0`` (the default), the Cholesky factorization of the covariance matrix is used, which fails for singular covariance matrices."
+);
+static PyObject* PyBobLearnLinearWCCNTrainer_getEigenvalueFloor
+(PyBobLearnLinearWCCNTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return Py_BuildValue("d", self->cxx->getEigenvalueFloor());
+BOB_CATCH_MEMBER("eigenvalue_floor", 0)
+}
+
+static int PyBobLearnLinearWCCNTrainer_setEigenvalueFloor
+(PyBobLearnLinearWCCNTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  double value = PyFloat_AsDouble(o);
+  if (PyErr_Occurred()) return -1;
+  self->cxx->setEigenvalueFloor(value);
+  return 0;
+BOB_CATCH_MEMBER("eigenvalue_floor", -1)
+}
+
+static auto collect_stats = bob::extension::VariableDoc(
+  "collect_stats",
+  "bool",
+  "Collect timing statistics of the trainings?",
+  "If enabled, each call to :py:meth:`train` records the wall time and the estimated size of the arrays of its phases in :py:attr:`stats`. "
+  "The statistics are shared by all calls, so that the trainer must not be used by several threads at once while they are collected. "
+  "By default, no statistics are collected."
+);
+static PyObject* PyBobLearnLinearWCCNTrainer_getCollectStats
+(PyBobLearnLinearWCCNTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  if (self->cxx->getStats()) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+BOB_CATCH_MEMBER("collect_stats", 0)
+}
+
+static int PyBobLearnLinearWCCNTrainer_setCollectStats
+(PyBobLearnLinearWCCNTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  int istrue = PyObject_IsTrue(o);
+
+  if (istrue == -1) return -1;
+  if (!istrue) self->cxx->setStats(boost::shared_ptr<bob::learn::linear::TrainingStats>());
+  else if (!self->cxx->getStats()) self->cxx->setStats(boost::make_shared<bob::learn::linear::TrainingStats>());
+  return 0;
+BOB_CATCH_MEMBER("collect_stats", -1)
+}
+
+static auto stats = bob::extension::VariableDoc(
+  "stats",
+  "[dict] or None",
+  "The timing statistics of the last training",
+  "A list with one dictionary per phase of the last call to :py:meth:`train`, in the order of execution, i.e., ``scatter``, ``decomposition``, ``truncation`` (if any) and ``machine update``. "
+  "Each dictionary contains the ``phase`` name, its wall time in ``seconds`` and the size of the arrays that the trainer allocated in the phase in ``estimated_bytes``, as computed from their shapes; this is not a measurement of the memory of the process, e.g., memory allocated inside LAPACK is not included. "
+  "``None`` if :py:attr:`collect_stats` is disabled."
+);
+static PyObject* PyBobLearnLinearWCCNTrainer_getStats
+(PyBobLearnLinearWCCNTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return PyBobLearnLinear_TrainingStats(self->cxx->getStats());
+BOB_CATCH_MEMBER("stats", 0)
+}
+
+static PyGetSetDef PyBobLearnLinearWCCNTrainer_getseters[] = {
+  {
+    eigenvalue_floor.name(),
+    (getter)PyBobLearnLinearWCCNTrainer_getEigenvalueFloor,
+    (setter)PyBobLearnLinearWCCNTrainer_setEigenvalueFloor,
+    eigenvalue_floor.doc(),
+    0
+  },
+  {
+    collect_stats.name(),
+    (getter)PyBobLearnLinearWCCNTrainer_getCollectStats,
+    (setter)PyBobLearnLinearWCCNTrainer_setCollectStats,
+    collect_stats.doc(),
+    0
+  },
+  {
+    stats.name(),
+    (getter)PyBobLearnLinearWCCNTrainer_getStats,
+    0,
+    stats.doc(),
+    0
+  },
+  {0} /* Sentinel */
+};
+
 static PyMethodDef PyBobLearnLinearWCCNTrainer_methods[] = {
   {
     train.name(),
@@ -237,6 +409,7 @@ bool init_BobLearnLinearWCCN(PyObject* module)
   PyBobLearnLinearWCCNTrainer_Type.tp_init = reinterpret_cast<initproc>(PyBobLearnLinearWCCNTrainer_init);
   PyBobLearnLinearWCCNTrainer_Type.tp_dealloc = reinterpret_cast<destructor>(PyBobLearnLinearWCCNTrainer_delete);
   PyBobLearnLinearWCCNTrainer_Type.tp_methods = PyBobLearnLinearWCCNTrainer_methods;
+  PyBobLearnLinearWCCNTrainer_Type.tp_getset = PyBobLearnLinearWCCNTrainer_getseters;
   PyBobLearnLinearWCCNTrainer_Type.tp_richcompare = reinterpret_cast<richcmpfunc>(PyBobLearnLinearWCCNTrainer_RichCompare);
 
   // check that everyting is fine
@@ -12,9 +12,12 @@
 #include <bob.blitz/cleanup.h>
 #include <bob.core/config.h>
 #include <bob.learn.linear/api.h>
+#include <boost/make_shared.hpp>
 #include <bob.extension/documentation.h>
 #include <structmember.h>
 
+extern PyObject* PyBobLearnLinear_TrainingStats(const boost::shared_ptr<bob::learn::linear::TrainingStats>& stats);
+
 /*************************************************
  * Implementation of WhiteningTrainer base class *
  *************************************************/
@@ -33,6 +36,11 @@ static auto Whitening_doc = bob::extension::ClassDoc(
   ".. math::\n\n   Cov(X) = W W^T\n\n"
   ":math:`W` is computed using Cholesky decomposition:\n\n"
   ".. math::\n\n   W = cholesky([Cov(X)]^{-1})\n\n"
+  "Alternatively, :math:`W` is computed from the eigendecomposition :math:`Cov(X) = U \\operatorname{diag}(e) U^T`. "
+  "In ``'pca'`` mode, only the ``n_components`` leading eigenvectors are kept, which reduces the dimensionality of the whitened data:\n\n"
+  ".. math::\n\n   W = U_k \\operatorname{diag}(1/\\sqrt{e_k})\n\n"
+  "In ``'zca'`` mode, the whitened data is rotated back into the input space, so that it stays as close as possible to the input data:\n\n"
+  ".. math::\n\n   W = U \\operatorname{diag}(1/\\sqrt{e}) U^T\n\n"
   "References:\n\n"
   "1. https://rtmath.net/help/html/e9c12dc0-e813-4ca9-aaa3-82340f1c5d24.htm\n"
   "2. http://en.wikipedia.org/wiki/Cholesky_decomposition"
@@ -40,15 +48,54 @@ static auto Whitening_doc = bob::extension::ClassDoc(
   "WhiteningTrainer",
   "Constructs a new whitening trainer"
 )
-.add_prototype("","")
+.add_prototype("[eigenvalue_floor], [mode], [n_components]","")
 .add_prototype("other","")
+.add_parameter("eigenvalue_floor", "float", "[Default: ``0.``] If positive, the eigenvalues of the covariance matrix are floored to this value and the transform is computed from its eigendecomposition, :math:`W = U \\operatorname{diag}(1/\\sqrt{\\max(e, floor)})`, which also handles singular covariance matrices; otherwise, the Cholesky factorization is used")
+.add_parameter("mode", "str", "[Default: ``'cholesky'``] The whitening transform to compute; one of ``'cholesky'``, ``'pca'`` or ``'zca'``")
+.add_parameter("n_components", "int", "[Default: ``0``] The number of output dimensions in ``'pca'`` mode; ``0`` keeps all dimensions")
 .add_parameter("other", ":py:class:`WhiteningTrainer`", "Another whitening trainer to copy")
 );
 
+static const char* mode_name(bob::learn::linear::WhiteningTrainer::Mode mode) {
+  switch (mode) {
+    case bob::learn::linear::WhiteningTrainer::PCA: return "pca";
+    case bob::learn::linear::WhiteningTrainer::ZCA: return "zca";
+    default: return "cholesky";
+  }
+}
+
+static bool mode_from_name(const char* name, bob::learn::linear::WhiteningTrainer::Mode& mode) {
+  std::string n(name);
+  if (n == "cholesky") mode = bob::learn::linear::WhiteningTrainer::CHOLESKY;
+  else if (n == "pca") mode = bob::learn::linear::WhiteningTrainer::PCA;
+  else if (n == "zca") mode = bob::learn::linear::WhiteningTrainer::ZCA;
+  else {
+    PyErr_Format(PyExc_ValueError, "whitening mode `%s' is not known; use one of 'cholesky', 'pca' or 'zca'", name);
+    return false;
+  }
+  return true;
+}
+
 static int PyBobLearnLinearWhiteningTrainer_init_default
 (PyBobLearnLinearWhiteningTrainerObject* self, PyObject* args, PyObject* kwds) {
 BOB_TRY
-  self->cxx = new bob::learn::linear::WhiteningTrainer();
+  /* Parses input arguments in a single shot */
+  char** kwlist = Whitening_doc.kwlist(0);
+
+  double eigenvalue_floor = 0.;
+  const char* name = "cholesky";
+  Py_ssize_t n_components = 0;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "|dsn", kwlist, &eigenvalue_floor, &name, &n_components)) return -1;
+
+  bob::learn::linear::WhiteningTrainer::Mode mode;
+  if (!mode_from_name(name, mode)) return -1;
+  if (n_components < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of components", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+
+  self->cxx = new bob::learn::linear::WhiteningTrainer(eigenvalue_floor, mode, n_components);
   return 0;
 BOB_CATCH_MEMBER("constructor",-1)
 }
@@ -79,7 +126,14 @@ static int PyBobLearnLinearWhiteningTrainer_init
   Py_ssize_t nargs = (args?PyTuple_Size(args):0) + (kwds?PyDict_Size(kwds):0);
 
   if (nargs == 1) {
-    return PyBobLearnLinearWhiteningTrainer_init_copy(self, args, kwds);
+    PyObject* arg = 0; ///< borrowed (don't delete)
+    if (args && PyTuple_Size(args)) arg = PyTuple_GET_ITEM(args, 0);
+    else {
+      PyObject* tmp = PyDict_Values(kwds);
+      auto tmp_ = make_safe(tmp);
+      arg = PyList_GET_ITEM(tmp, 0);
+    }
+    if (PyBobLearnLinearWhiteningTrainer_Check(arg)) return PyBobLearnLinearWhiteningTrainer_init_copy(self, args, kwds);
   }
 
   return PyBobLearnLinearWhiteningTrainer_init_default(self, args, kwds);
@@ -125,15 +179,18 @@ static auto train = bob::extension::FunctionDoc(
   "train",
   "Trains a linear machine to perform Cholesky whitening",
   "The user may provide or not an object of type :py:class:`bob.learn.linear.Machine` that will be set by this method. "
-  "In such a case, the machine should have a shape that matches ``(X.shape[1], X.shape[1])``. "
+  "In such a case, the machine should have a shape that matches ``(X.shape[1], X.shape[1])``, or ``(X.shape[1], n_components)`` in ``'pca'`` mode with a positive number of components. "
   "If the user does not provide a machine to be set, then a new one will be allocated internally. "
   "In both cases, the resulting machine is always returned by this method.\n\n"
-  "The input data matrix :math:`X` should correspond to a 64-bit floating point 2D array organized in such a way that every row corresponds to a new observation of the phenomena (i.e., a new sample) and every column corresponds to a different feature.",
+  "The input data matrix :math:`X` should correspond to a 64-bit floating point 2D array organized in such a way that every row corresponds to a new observation of the phenomena (i.e., a new sample) and every column corresponds to a different feature. "
+  "Alternatively, the statistics accumulated on the data in a :py:class:`bob.learn.linear.ScatterAccumulator` can be given.\n\n"
+  "Optionally, each row of ``X`` can be weighted with a non-negative frequency ``weight``, as if the row was repeated accordingly.",
   true
 )
-.add_prototype("X, [machine]", "machine")
-.add_parameter("X", "array_like(2D, float)", "The training data")
+.add_prototype("X, [machine], [weights]", "machine")
+.add_parameter("X", "array_like(2D, float) or :py:class:`bob.learn.linear.ScatterAccumulator`", "The training data, or the statistics accumulated on it")
 .add_parameter("machine", ":py:class:`bob.learn.linear.Machine`", "A pre-allocated machine to be trained; may be omitted")
+.add_parameter("weights", "array_like(1D, float)", "[optional] The frequency weights of the rows of ``X``")
 .add_return("machine", ":py:class:`bob.learn.linear.Machine`", "The trained machine; identical to the ``machine`` parameter, if specified")
 ;
 static PyObject* PyBobLearnLinearWhiteningTrainer_Train
@@ -142,35 +199,215 @@ BOB_TRY
   /* Parses input arguments in a single shot */
   char** kwlist = train.kwlist();
 
-  PyBlitzArrayObject* X;
+  PyObject* X;
   PyBobLearnLinearMachineObject* machine = 0;
+  PyBlitzArrayObject* weights = 0;
 
-  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O&|O!", kwlist,
-        &PyBlitzArray_Converter, &X,
-        &PyBobLearnLinearMachine_Type, &machine
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|O!O&", kwlist,
+        &X,
+        &PyBobLearnLinearMachine_Type, &machine,
+        &PyBlitzArray_Converter, &weights
         ))
     return 0;
 
-  auto X_ = make_safe(X); ///< auto-delete in case of problems
+  auto weights_ = make_xsafe(weights); ///< auto-delete in case of problems
 
-  if (X->ndim != 2 || X->type_num != NPY_FLOAT64) {
+  // the data is either given as accumulated statistics or as a 2D array
+  bob::learn::linear::ScatterAccumulator* stats = 0;
+  PyBlitzArrayObject* data = 0;
+  if (PyBobLearnLinearScatterAccumulator_Check(X)) {
+    stats = reinterpret_cast<PyBobLearnLinearScatterAccumulatorObject*>(X)->cxx.get();
+  }
+  else if (!PyBlitzArray_Converter(X, &data)) return 0;
+  auto data_ = make_xsafe(data); ///< auto-delete in case of problems
+
+  if (data && (data->ndim != 2 || data->type_num != NPY_FLOAT64)) {
     PyErr_Format(PyExc_TypeError, "`%s' only supports 2D 64-bit float arrays for input array `X'", Py_TYPE(self)->tp_name);
     return 0;
   }
+  if (weights && stats) {
+    PyErr_Format(PyExc_TypeError, "`%s' cannot apply `weights' to accumulated statistics; weight the samples when accumulating them instead", Py_TYPE(self)->tp_name);
+    return 0;
+  }
+  if (weights && (weights->ndim != 1 || weights->type_num != NPY_FLOAT64)) {
+    PyErr_Format(PyExc_TypeError, "`%s' only supports 1D 64-bit float arrays for `weights'", Py_TYPE(self)->tp_name);
+    return 0;
+  }
 
   // allocates a new machine if that was not given by the user
+  const Py_ssize_t n_features = stats ? (Py_ssize_t)stats->numberOfFeatures() : data->shape[1];
   boost::shared_ptr<PyBobLearnLinearMachineObject> machine_;
   if (!machine) {
-    machine = reinterpret_cast<PyBobLearnLinearMachineObject*>(PyBobLearnLinearMachine_NewFromSize(X->shape[1], X->shape[1]));
+    machine = reinterpret_cast<PyBobLearnLinearMachineObject*>(PyBobLearnLinearMachine_NewFromSize(n_features, self->cxx->outputSize(n_features)));
     machine_ = make_safe(machine); ///< auto-delete in case of problems
   }
 
   // perform training
-  self->cxx->train(*machine->cxx, *PyBlitzArrayCxx_AsBlitz<double,2>(X));
+  if (stats) self->cxx->train(*machine->cxx, *stats);
+  else if (weights) self->cxx->train(*machine->cxx, *PyBlitzArrayCxx_AsBlitz<double,2>(data), *PyBlitzArrayCxx_AsBlitz<double,1>(weights));
+  else self->cxx->train(*machine->cxx, *PyBlitzArrayCxx_AsBlitz<double,2>(data));
   return Py_BuildValue("O", machine);
 BOB_CATCH_MEMBER("train", 0)
 }
 
+static auto eigenvalue_floor = bob::extension::VariableDoc(
+  "eigenvalue_floor",
+  "float",
+  "The lower bound for the eigenvalues of the covariance matrix",
+  "If set to a positive value, the transform is computed from the eigendecomposition of the covariance matrix with floored eigenvalues. "
+  "If set to ``0`` (the default), the Cholesky factorization of the covariance matrix is used, which fails for singular covariance matrices."
+);
+static PyObject* PyBobLearnLinearWhiteningTrainer_getEigenvalueFloor
+(PyBobLearnLinearWhiteningTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return Py_BuildValue("d", self->cxx->getEigenvalueFloor());
+BOB_CATCH_MEMBER("eigenvalue_floor", 0)
+}
+
+static int PyBobLearnLinearWhiteningTrainer_setEigenvalueFloor
+(PyBobLearnLinearWhiteningTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  double value = PyFloat_AsDouble(o);
+  if (PyErr_Occurred()) return -1;
+  self->cxx->setEigenvalueFloor(value);
+  return 0;
+BOB_CATCH_MEMBER("eigenvalue_floor", -1)
+}
+
+static auto mode = bob::extension::VariableDoc(
+  "mode",
+  "str",
+  "The whitening transform to compute; one of ``'cholesky'``, ``'pca'`` or ``'zca'``"
+);
+static PyObject* PyBobLearnLinearWhiteningTrainer_getMode
+(PyBobLearnLinearWhiteningTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return Py_BuildValue("s", mode_name(self->cxx->getMode()));
+BOB_CATCH_MEMBER("mode", 0)
+}
+
+static int PyBobLearnLinearWhiteningTrainer_setMode
+(PyBobLearnLinearWhiteningTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  const char* name;
+  if (!PyArg_Parse(o, "s", &name)) return -1;
+  bob::learn::linear::WhiteningTrainer::Mode value;
+  if (!mode_from_name(name, value)) return -1;
+  self->cxx->setMode(value);
+  return 0;
+BOB_CATCH_MEMBER("mode", -1)
+}
+
+static auto n_components = bob::extension::VariableDoc(
+  "n_components",
+  "int",
+  "The number of output dimensions in ``'pca'`` mode",
+  "If set to ``0`` (the default), all dimensions are kept. "
+  "This value is ignored in the other modes."
+);
+static PyObject* PyBobLearnLinearWhiteningTrainer_getNComponents
+(PyBobLearnLinearWhiteningTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return Py_BuildValue("n", self->cxx->getNComponents());
+BOB_CATCH_MEMBER("n_components", 0)
+}
+
+static int PyBobLearnLinearWhiteningTrainer_setNComponents
+(PyBobLearnLinearWhiteningTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  Py_ssize_t value = PyNumber_AsSsize_t(o, PyExc_OverflowError);
+  if (PyErr_Occurred()) return -1;
+  if (value < 0) {
+    PyErr_Format(PyExc_ValueError, "`%s' requires a non-negative number of components", Py_TYPE(self)->tp_name);
+    return -1;
+  }
+  self->cxx->setNComponents(value);
+  return 0;
+BOB_CATCH_MEMBER("n_components", -1)
+}
+
+static auto collect_stats = bob::extension::VariableDoc(
+  "collect_stats",
+  "bool",
+  "Collect timing statistics of the trainings?",
+  "If enabled, each call to :py:meth:`train` records the wall time and the estimated size of the arrays of its phases in :py:attr:`stats`. "
+  "The statistics are shared by all calls, so that the trainer must not be used by several threads at once while they are collected. "
+  "By default, no statistics are collected."
+);
+static PyObject* PyBobLearnLinearWhiteningTrainer_getCollectStats
+(PyBobLearnLinearWhiteningTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  if (self->cxx->getStats()) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+BOB_CATCH_MEMBER("collect_stats", 0)
+}
+
+static int PyBobLearnLinearWhiteningTrainer_setCollectStats
+(PyBobLearnLinearWhiteningTrainerObject* self, PyObject* o, void* /*closure*/) {
+BOB_TRY
+  int istrue = PyObject_IsTrue(o);
+
+  if (istrue == -1) return -1;
+  if (!istrue) self->cxx->setStats(boost::shared_ptr<bob::learn::linear::TrainingStats>());
+  else if (!self->cxx->getStats()) self->cxx->setStats(boost::make_shared<bob::learn::linear::TrainingStats>());
+  return 0;
+BOB_CATCH_MEMBER("collect_stats", -1)
+}
+
+static auto stats = bob::extension::VariableDoc(
+  "stats",
+  "[dict] or None",
+  "The timing statistics of the last training",
+  "A list with one dictionary per phase of the last call to :py:meth:`train`, in the order of execution, i.e., ``scatter``, ``decomposition``, ``truncation`` (if any) and ``machine update``. "
+  "Each dictionary contains the ``phase`` name, its wall time in ``seconds`` and the size of the arrays that the trainer allocated in the phase in ``estimated_bytes``, as computed from their shapes; this is not a measurement of the memory of the process, e.g., memory allocated inside LAPACK is not included. "
+  "``None`` if :py:attr:`collect_stats` is disabled."
+);
+static PyObject* PyBobLearnLinearWhiteningTrainer_getStats
+(PyBobLearnLinearWhiteningTrainerObject* self, void* /*closure*/) {
+BOB_TRY
+  return PyBobLearnLinear_TrainingStats(self->cxx->getStats());
+BOB_CATCH_MEMBER("stats", 0)
+}
+
+static PyGetSetDef PyBobLearnLinearWhiteningTrainer_getseters[] = {
+  {
+    eigenvalue_floor.name(),
+    (getter)PyBobLearnLinearWhiteningTrainer_getEigenvalueFloor,
+    (setter)PyBobLearnLinearWhiteningTrainer_setEigenvalueFloor,
+    eigenvalue_floor.doc(),
+    0
+  },
+  {
+    mode.name(),
+    (getter)PyBobLearnLinearWhiteningTrainer_getMode,
+    (setter)PyBobLearnLinearWhiteningTrainer_setMode,
+    mode.doc(),
+    0
+  },
+  {
+    n_components.name(),
+    (getter)PyBobLearnLinearWhiteningTrainer_getNComponents,
+    (setter)PyBobLearnLinearWhiteningTrainer_setNComponents,
+    n_components.doc(),
+    0
+  },
+  {
+    collect_stats.name(),
+    (getter)PyBobLearnLinearWhiteningTrainer_getCollectStats,
+    (setter)PyBobLearnLinearWhiteningTrainer_setCollectStats,
+    collect_stats.doc(),
+    0
+  },
+  {
+    stats.name(),
+    (getter)PyBobLearnLinearWhiteningTrainer_getStats,
+    0,
+    stats.doc(),
+    0
+  },
+  {0} /* Sentinel */
+};
+
 static PyMethodDef PyBobLearnLinearWhiteningTrainer_methods[] = {
   {
     train.name(),
@@ -201,6 +438,7 @@ bool init_BobLearnLinearWhitening(PyObject* module)
   PyBobLearnLinearWhiteningTrainer_Type.tp_init = reinterpret_cast<initproc>(PyBobLearnLinearWhiteningTrainer_init);
   PyBobLearnLinearWhiteningTrainer_Type.tp_dealloc = reinterpret_cast<destructor>(PyBobLearnLinearWhiteningTrainer_delete);
   PyBobLearnLinearWhiteningTrainer_Type.tp_methods = PyBobLearnLinearWhiteningTrainer_methods;
+  PyBobLearnLinearWhiteningTrainer_Type.tp_getset = PyBobLearnLinearWhiteningTrainer_getseters;
   PyBobLearnLinearWhiteningTrainer_Type.tp_richcompare = reinterpret_cast<richcmpfunc>(PyBobLearnLinearWhiteningTrainer_RichCompare);
 
   // check that everyting is fine
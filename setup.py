@@ -59,6 +59,13 @@ setup(
           "bob/learn/linear/cpp/whitening.cpp",
           "bob/learn/linear/cpp/wccn.cpp",
           "bob/learn/linear/cpp/bic.cpp",
+          "bob/learn/linear/cpp/gfk.cpp",
+          "bob/learn/linear/cpp/scatter.cpp",
+          "bob/learn/linear/cpp/bundle.cpp",
+          "bob/learn/linear/cpp/profile.cpp",
+          "bob/learn/linear/cpp/sparse.cpp",
+          "bob/learn/linear/cpp/crossval.cpp",
+          "bob/learn/linear/cpp/quantized.cpp",
         ],
         bob_packages = bob_packages,
         version = version,
@@ -75,6 +82,11 @@ setup(
           "bob/learn/linear/whitening.cpp",
           "bob/learn/linear/wccn.cpp",
           "bob/learn/linear/bic.cpp",
+          "bob/learn/linear/gfk.cpp",
+          "bob/learn/linear/scatter.cpp",
+          "bob/learn/linear/bundle.cpp",
+          "bob/learn/linear/crossval.cpp",
+          "bob/learn/linear/quantized.cpp",
           "bob/learn/linear/main.cpp",
           ],
         bob_packages = bob_packages,
@@ -90,6 +102,7 @@ setup(
 
     entry_points={
       'console_scripts': [
+        'bob_linear_benchmark.py = bob.learn.linear.script.benchmark:main',
       ],
     },
 